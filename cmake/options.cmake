@@ -40,6 +40,7 @@ OPTION(USE_INTERNAL_POPT "Always use the internal copy of popt." 0)
 # Frontends.
 OPTION(ENABLE_GENS_QT4 "Enable the Qt4 UI. (EXPERIMENTAL; has frame dropping issues)" 0)
 OPTION(ENABLE_GENS_SDL "Enable the SDL2 UI. (Technical Preview)" 1)
+OPTION(ENABLE_GENS_BENCH "Enable the headless benchmark runner." 1)
 
 # Additional stuff.
 OPTION(BUILD_DOC "Build documentation." 1)
@@ -10,17 +10,38 @@ ENDIF()
 # Don't embed rpaths in the executables.
 SET(CMAKE_SKIP_RPATH ON)
 
-# If we're not using x86, disable emulation functionality.
-# TODO: Port everything from asm to C/C++!
-# TODO: Add configuration option.
+# CPU emulation is always enabled.
+# The 68000 uses Starscream on i386 and mdM68K elsewhere.
+# The Z80 uses the mdZ80 assembly executor on i386 and
+# the C executor elsewhere.
 INCLUDE(CheckSystemX8632)
 CHECK_SYSTEM_X86_32(GENS_CPU_X86_32)
+SET(GENS_ENABLE_EMULATION 1)
 IF(GENS_CPU_X86_32)
-	SET(GENS_ENABLE_EMULATION 1)
+	OPTION(USE_STARSCREAM "Use the Starscream 68000 emulator. (i386 only)" 1)
+	OPTION(USE_MDZ80_ASM "Use the mdZ80 assembly executor. (i386 only)" 1)
+ELSE(GENS_CPU_X86_32)
+	# Starscream and mdZ80_x86.asm are i386 assembly.
+	SET(USE_STARSCREAM 0)
+	SET(USE_MDZ80_ASM 0)
 ENDIF(GENS_CPU_X86_32)
-IF(NOT GENS_ENABLE_EMULATION)
-	MESSAGE(WARNING "System is not X86_32; CPU emulation will be disabled. (FOR DEBUGGING ONLY)")
-ENDIF(NOT GENS_ENABLE_EMULATION)
+IF(NOT USE_STARSCREAM)
+	SET(GENS_USE_MDM68K 1)
+ENDIF(NOT USE_STARSCREAM)
+
+# Multi-context support.
+# The emulation state is kept in thread-local storage,
+# so each thread can run its own emulation context.
+# Starscream and mdZ80_x86.asm access their state directly,
+# so this requires the portable CPU cores.
+IF(NOT USE_STARSCREAM AND NOT USE_MDZ80_ASM)
+	OPTION(ENABLE_MULTI_CONTEXT "Allow one emulation context per thread. (Requires the portable CPU cores.)" 0)
+ELSE(NOT USE_STARSCREAM AND NOT USE_MDZ80_ASM)
+	SET(ENABLE_MULTI_CONTEXT 0)
+ENDIF(NOT USE_STARSCREAM AND NOT USE_MDZ80_ASM)
+IF(ENABLE_MULTI_CONTEXT)
+	SET(GENS_ENABLE_MULTI_CONTEXT 1)
+ENDIF(ENABLE_MULTI_CONTEXT)
 
 # Common flag variables:
 # [common]
@@ -0,0 +1,81 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * FrameStats.cpp: Frame time statistics.                                  *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "FrameStats.hpp"
+
+// C includes. (C++ namespace)
+#include <cmath>
+
+// C++ includes.
+#include <algorithm>
+
+namespace GensBench {
+
+FrameStats::FrameStats()
+	: m_total(0)
+	, m_sorted(true)
+{ }
+
+/**
+ * Reserve space for frame times.
+ * @param frames Number of frames.
+ */
+void FrameStats::reserve(unsigned int frames)
+{
+	m_times.reserve(frames);
+}
+
+/**
+ * Add all frame times from another FrameStats.
+ * @param other FrameStats.
+ */
+void FrameStats::merge(const FrameStats &other)
+{
+	m_times.insert(m_times.end(), other.m_times.begin(), other.m_times.end());
+	m_total += other.m_total;
+	m_sorted = false;
+}
+
+/**
+ * Get a frame time percentile. (nearest-rank)
+ * @param pct Percentile. [0, 100]
+ * @return Frame time, in microseconds.
+ */
+uint64_t FrameStats::percentile(double pct)
+{
+	if (m_times.empty())
+		return 0;
+
+	if (!m_sorted) {
+		std::sort(m_times.begin(), m_times.end());
+		m_sorted = true;
+	}
+
+	// Nearest-rank method: ceil(P/100 * N), 1-based.
+	size_t rank = (size_t)ceil(pct / 100.0 * m_times.size());
+	if (rank < 1)
+		rank = 1;
+	else if (rank > m_times.size())
+		rank = m_times.size();
+	return m_times[rank - 1];
+}
+
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * FrameStats.hpp: Frame time statistics.                                  *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __GENS_BENCH_FRAMESTATS_HPP__
+#define __GENS_BENCH_FRAMESTATS_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// C++ includes.
+#include <vector>
+
+namespace GensBench {
+
+/**
+ * Frame time statistics.
+ * Frame times are in microseconds.
+ */
+class FrameStats
+{
+	public:
+		FrameStats();
+
+	public:
+		/**
+		 * Reserve space for frame times.
+		 * @param frames Number of frames.
+		 */
+		void reserve(unsigned int frames);
+
+		/**
+		 * Add a frame time.
+		 * @param usec Frame time, in microseconds.
+		 */
+		inline void add(uint64_t usec)
+		{
+			m_times.push_back(usec);
+			m_total += usec;
+			m_sorted = false;
+		}
+
+		/**
+		 * Add all frame times from another FrameStats.
+		 * @param other FrameStats.
+		 */
+		void merge(const FrameStats &other);
+
+		/**
+		 * Get the number of frames.
+		 * @return Number of frames.
+		 */
+		inline unsigned int count(void) const
+			{ return (unsigned int)m_times.size(); }
+
+		/**
+		 * Get the total time of all frames.
+		 * @return Total time, in microseconds.
+		 */
+		inline uint64_t total(void) const
+			{ return m_total; }
+
+		/**
+		 * Get a frame time percentile. (nearest-rank)
+		 * @param pct Percentile. [0, 100]
+		 * @return Frame time, in microseconds.
+		 */
+		uint64_t percentile(double pct);
+
+		/**
+		 * Get the maximum frame time.
+		 * @return Maximum frame time, in microseconds.
+		 */
+		inline uint64_t max(void)
+			{ return percentile(100.0); }
+
+	private:
+		std::vector<uint64_t> m_times;
+		uint64_t m_total;
+		bool m_sorted;
+};
+
+}
+
+#endif /* __GENS_BENCH_FRAMESTATS_HPP__ */
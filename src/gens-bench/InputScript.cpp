@@ -0,0 +1,168 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * InputScript.cpp: Scripted controller input.                             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "InputScript.hpp"
+
+// LibGens
+#include "libgens/IO/IoManager.hpp"
+using LibGens::IoManager;
+
+// C includes. (C++ namespace)
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+
+namespace GensBench {
+
+InputScript::InputScript()
+	: m_cur(0)
+{ }
+
+/**
+ * Parse a button string.
+ * @param str Button string.
+ * @param buttons Output button state. (active high)
+ * @return 0 on success; non-zero on error.
+ */
+int InputScript::parseButtons(const char *str, uint32_t *buttons)
+{
+	*buttons = 0;
+	if (str[0] == '-' && str[1] == 0) {
+		// No buttons.
+		return 0;
+	}
+
+	for (; *str != 0; str++) {
+		int btn;
+		switch (toupper(*str)) {
+			case 'U':	btn = IoManager::BTNNAME_UP; break;
+			case 'D':	btn = IoManager::BTNNAME_DOWN; break;
+			case 'L':	btn = IoManager::BTNNAME_LEFT; break;
+			case 'R':	btn = IoManager::BTNNAME_RIGHT; break;
+			case 'A':	btn = IoManager::BTNNAME_A; break;
+			case 'B':	btn = IoManager::BTNNAME_B; break;
+			case 'C':	btn = IoManager::BTNNAME_C; break;
+			case 'S':	btn = IoManager::BTNNAME_START; break;
+			case 'X':	btn = IoManager::BTNNAME_X; break;
+			case 'Y':	btn = IoManager::BTNNAME_Y; break;
+			case 'Z':	btn = IoManager::BTNNAME_Z; break;
+			case 'M':	btn = IoManager::BTNNAME_MODE; break;
+			default:
+				// Invalid button.
+				return -1;
+		}
+		*buttons |= (1U << btn);
+	}
+
+	return 0;
+}
+
+/**
+ * Load an input script.
+ * @param filename Script filename.
+ * @return 0 on success; negative errno on error.
+ */
+int InputScript::load(const char *filename)
+{
+	m_entries.clear();
+	m_cur = 0;
+
+	FILE *f = fopen(filename, "r");
+	if (!f)
+		return -errno;
+
+	char line[256];
+	int line_num = 0;
+	while (fgets(line, sizeof(line), f)) {
+		line_num++;
+
+		// Skip leading whitespace.
+		const char *p = line;
+		while (isspace((unsigned char)*p))
+			p++;
+		if (*p == 0 || *p == '#') {
+			// Empty line or comment.
+			continue;
+		}
+
+		unsigned int frame;
+		char btn_str[2][32];
+		int count = sscanf(p, "%u %31s %31s", &frame, btn_str[0], btn_str[1]);
+		if (count < 2) {
+			fprintf(stderr, "%s:%d: syntax error\n", filename, line_num);
+			fclose(f);
+			return -EINVAL;
+		}
+
+		Entry entry;
+		entry.frame = frame;
+		entry.buttons[1] = 0;
+		for (int port = 0; port < count - 1; port++) {
+			if (parseButtons(btn_str[port], &entry.buttons[port]) != 0) {
+				fprintf(stderr, "%s:%d: invalid buttons '%s'\n",
+					filename, line_num, btn_str[port]);
+				fclose(f);
+				return -EINVAL;
+			}
+		}
+
+		if (!m_entries.empty() && frame < m_entries.back().frame) {
+			fprintf(stderr, "%s:%d: frame %u is out of order\n",
+				filename, line_num, frame);
+			fclose(f);
+			return -EINVAL;
+		}
+		m_entries.push_back(entry);
+	}
+
+	fclose(f);
+	return 0;
+}
+
+/**
+ * Get the button state for a given frame.
+ * Frames should be requested in ascending order.
+ * @param frame Frame number.
+ * @param port Port number. (0 or 1)
+ * @return Button state for IoManager::update(). (active low)
+ */
+uint32_t InputScript::buttons(unsigned int frame, int port)
+{
+	if (m_entries.empty() || frame < m_entries[0].frame) {
+		// No buttons pressed yet.
+		return ~0U;
+	}
+
+	if (frame < m_entries[m_cur].frame) {
+		// Going backwards. Start over.
+		m_cur = 0;
+	}
+	while (m_cur + 1 < m_entries.size() &&
+	       m_entries[m_cur + 1].frame <= frame)
+	{
+		m_cur++;
+	}
+
+	// Buttons are active-low.
+	return ~m_entries[m_cur].buttons[port & 1];
+}
+
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * InputScript.hpp: Scripted controller input.                             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __GENS_BENCH_INPUTSCRIPT_HPP__
+#define __GENS_BENCH_INPUTSCRIPT_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// C++ includes.
+#include <vector>
+
+namespace GensBench {
+
+/**
+ * Scripted controller input.
+ *
+ * Script format: One entry per line.
+ * FRAME BUTTONS1 [BUTTONS2]
+ * - FRAME: Frame number. Entries must be in ascending order.
+ * - BUTTONS1, BUTTONS2: Buttons held on ports 1 and 2,
+ *   starting at FRAME, until the next entry.
+ *   Buttons are any of "UDLRABCSXYZM"; '-' means none.
+ * Lines starting with '#' are comments.
+ */
+class InputScript
+{
+	public:
+		InputScript();
+
+	private:
+		// Q_DISABLE_COPY() equivalent.
+		// TODO: Add GensBench-specific version of Q_DISABLE_COPY().
+		InputScript(const InputScript &);
+		InputScript &operator=(const InputScript &);
+
+	public:
+		/**
+		 * Load an input script.
+		 * @param filename Script filename.
+		 * @return 0 on success; negative errno on error.
+		 */
+		int load(const char *filename);
+
+		/**
+		 * Get the button state for a given frame.
+		 * Frames should be requested in ascending order.
+		 * @param frame Frame number.
+		 * @param port Port number. (0 or 1)
+		 * @return Button state for IoManager::update(). (active low)
+		 */
+		uint32_t buttons(unsigned int frame, int port);
+
+	private:
+		/**
+		 * Parse a button string.
+		 * @param str Button string.
+		 * @param buttons Output button state. (active high)
+		 * @return 0 on success; non-zero on error.
+		 */
+		static int parseButtons(const char *str, uint32_t *buttons);
+
+		struct Entry {
+			unsigned int frame;
+			uint32_t buttons[2];	// active high
+		};
+		std::vector<Entry> m_entries;
+
+		// Index of the current entry.
+		unsigned int m_cur;
+};
+
+}
+
+#endif /* __GENS_BENCH_INPUTSCRIPT_HPP__ */
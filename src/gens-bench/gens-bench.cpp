@@ -0,0 +1,675 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * gens-bench.cpp: Main program.                                           *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include <libgens/config.libgens.h>
+
+// LibGens
+#include "libgens/lg_main.hpp"
+#include "libgens/Rom.hpp"
+#include "libgens/EmuContext/EmuContext.hpp"
+#include "libgens/EmuContext/EmuContextFactory.hpp"
+#include "libgens/EmuContext/SysVersion.hpp"
+#include "libgens/IO/IoManager.hpp"
+#include "libgens/sound/SoundMgr.hpp"
+#include "libgens/Util/Timing.hpp"
+#include "libgens/cpu/M68K.hpp"
+#include "libgens/cpu/Z80.hpp"
+#include "libgens/Vdp/Vdp.hpp"
+#include "libgens/Vdp/VdpTrace.hpp"
+using LibGens::Rom;
+using LibGens::EmuContext;
+using LibGens::EmuContextFactory;
+using LibGens::SysVersion;
+using LibGens::IoManager;
+using LibGens::SoundMgr;
+using LibGens::Timing;
+using LibGens::M68K;
+using LibGens::Z80;
+
+#include "InputScript.hpp"
+#include "FrameStats.hpp"
+
+// OS-specific includes.
+#ifdef _WIN32
+// Win32 Unicode Translation Layer.
+// Needed for proper Unicode filename support on Windows.
+#include "libcompat/W32U/W32U_mini.h"
+#include "libcompat/W32U/W32U_argv.h"
+#endif
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+
+// C++ includes.
+#include <algorithm>
+#include <thread>
+#include <vector>
+using std::vector;
+
+// popt
+#include <popt.h>
+
+namespace GensBench {
+
+/** Command line parameters. **/
+static struct {
+	const char *rom_filename;	// ROM to load.
+	const char *input_filename;	// Input script.
+
+	int frames;		// Number of frames to measure.
+	int warmup;		// Number of frames to run before measuring.
+	int fast;		// Use execFrameFast()?
+	int threads;		// Number of emulation contexts. (one per thread)
+	int idle_skip;		// Skip 68000 and Z80 idle loops?
+	int threaded_vdp;	// Render VDP lines on a worker thread?
+	const char *vdp_trace_filename;	// VDP port write trace file.
+
+	// Audio options.
+	int audio;		// Write audio output?
+	int sound_freq;		// Sound frequency.
+	int stereo;		// Stereo audio?
+	int batched_ym;		// Synthesize YM2612 audio in batches?
+	int simd_fm;		// Use the SIMD FM engine?
+	int native_rate;	// Synthesize audio at the native rate and resample?
+	int blep_psg;		// Use band-limited step synthesis for the PSG?
+
+	// Emulation options.
+	SysVersion::RegionCode_t region;	// Region code.
+} options;
+
+/**
+ * Benchmark results for a single emulation context.
+ */
+struct BenchResult {
+	FrameStats stats;	// Frame times.
+	double time;		// Total time for the measured frames, in seconds.
+	unsigned int idle_hits;	// 68000 idle loops skipped.
+	uint64_t idle_cycles;	// 68000 cycles skipped.
+	unsigned int z80_idle_hits;	// Z80 idle loops skipped.
+	uint64_t z80_idle_cycles;	// Z80 cycles skipped.
+	int vdp_trace;		// VDP trace entries saved.
+	int ret;		// Return value. (0 on success)
+};
+
+static void print_prg_info(void)
+{
+	fprintf(stderr, "gens-bench: Gens/GS II headless benchmark runner.\n");
+}
+
+static void print_gpl(void)
+{
+	fprintf(stderr,
+		"This program is free software; you can redistribute it and/or modify it\n"
+		"under the terms of the GNU General Public License as published by the\n"
+		"Free Software Foundation; either version 2 of the License, or (at your\n"
+		"option) any later version.\n"
+		"\n"
+		"This program is distributed in the hope that it will be useful, but\n"
+		"WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+		"MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+		"GNU General Public License for more details.\n"
+		"\n"
+		"You should have received a copy of the GNU General Public License along\n"
+		"with this program; if not, write to the Free Software Foundation, Inc.,\n"
+		"51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.\n");
+}
+
+static void print_help(const poptContext con)
+{
+	print_prg_info();
+	fputc('\n', stderr);
+	// NOTE: poptPrintHelp() only prints the filename portion of argv[0].
+	poptPrintHelp(con, stderr, 0);
+}
+
+/**
+ * Parse a region code.
+ * @param str Region code string.
+ * @param region Output region code.
+ * @return 0 on success; non-zero on error.
+ */
+static int parse_region(const char *str, SysVersion::RegionCode_t *region)
+{
+	if (!strcasecmp(str, "u") || !strcasecmp(str, "usa")) {
+		*region = SysVersion::REGION_US_NTSC;
+	} else if (!strcasecmp(str, "j") || !strcasecmp(str, "jp") ||
+		   !strcasecmp(str, "japan"))
+	{
+		*region = SysVersion::REGION_JP_NTSC;
+	} else if (!strcasecmp(str, "e") || !strcasecmp(str, "eu") ||
+		   !strcasecmp(str, "europe") || !strcasecmp(str, "pal"))
+	{
+		*region = SysVersion::REGION_EU_PAL;
+	} else if (!strcasecmp(str, "asia")) {
+		*region = SysVersion::REGION_ASIA_PAL;
+	} else if (!strcasecmp(str, "auto")) {
+		*region = SysVersion::REGION_AUTO;
+	} else {
+		// Invalid region code.
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Run the benchmark on a new emulation context.
+ * In multi-context builds, this may be called from
+ * multiple threads at once.
+ * @param result Benchmark results.
+ */
+static void run_context(BenchResult *result)
+{
+	result->time = 0;
+	result->idle_hits = 0;
+	result->idle_cycles = 0;
+	result->z80_idle_hits = 0;
+	result->z80_idle_cycles = 0;
+	result->vdp_trace = 0;
+	result->ret = EXIT_FAILURE;
+
+	// Initialize LibGens for this thread.
+	LibGens::InitThread();
+
+	// Load the ROM image.
+	Rom *rom = new Rom(options.rom_filename);
+	if (!rom->isOpen()) {
+		// Error opening the ROM.
+		fprintf(stderr, "Error opening ROM file %s.\n", options.rom_filename);
+		delete rom;
+		LibGens::EndThread();
+		return;
+	}
+	if (rom->isMultiFile()) {
+		// Select the first file.
+		rom->select_z_entry(rom->get_z_entry_list());
+	}
+
+	if (!EmuContextFactory::isRomFormatSupported(rom) ||
+	    !EmuContextFactory::isRomSystemSupported(rom))
+	{
+		// ROM isn't supported.
+		fprintf(stderr, "Error loading ROM file %s: ROM is not supported.\n"
+			"Only plain binary and SMD-format Mega Drive and Pico ROMs are supported.\n",
+			options.rom_filename);
+		delete rom;
+		LibGens::EndThread();
+		return;
+	}
+	const bool isPico = (rom->sysId() == Rom::MDP_SYSTEM_PICO);
+
+	// Detect the ROM region.
+	SysVersion::RegionCode_t region = options.region;
+	if (region == SysVersion::REGION_AUTO) {
+		// Auto-detect the region code.
+		// Using region code order 0x4812.
+		// (US, Europe, Japan, Asia)
+		region = SysVersion::DetectRegion(rom->regionCode(), 0x4812);
+		if (region == SysVersion::REGION_AUTO) {
+			// Detection failed.
+			// Default to US/NTSC.
+			region = SysVersion::REGION_US_NTSC;
+		}
+	}
+
+	// Set the audio rate before creating the context,
+	// since the context sets the audio region.
+	SoundMgr::SetNativeRate(!!options.native_rate, false);
+	SoundMgr::SetRate(options.sound_freq, false);
+
+	// Create the emulation context.
+	EmuContext *context = EmuContextFactory::createContext(rom, region);
+	if (!context || !context->isRomOpened()) {
+		// Error loading the ROM into EmuMD.
+		fprintf(stderr, "Error initializing EmuContext for %s.\n",
+			options.rom_filename);
+		delete context;
+		delete rom;
+		LibGens::EndThread();
+		return;
+	}
+
+	// Idle loop skipping.
+	M68K::SetIdleSkip(!!options.idle_skip);
+	Z80::SetIdleSkip(!!options.idle_skip);
+
+	// Threaded VDP rendering.
+	context->m_vdp->setThreadedRendering(!!options.threaded_vdp);
+
+	// VDP port write trace.
+	context->m_vdp->setTracing(options.vdp_trace_filename != nullptr);
+
+	// Batched YM2612 synthesis.
+	SoundMgr::ms_Ym2612.setBatched(!!options.batched_ym);
+
+	// SIMD FM engine.
+	SoundMgr::ms_Ym2612.setSimdEngine(!!options.simd_fm);
+
+	// Band-limited step synthesis for the PSG.
+	SoundMgr::ms_Psg.setBandLimited(!!options.blep_psg);
+
+	// Load the input script.
+	InputScript script;
+	if (options.input_filename) {
+		int ret = script.load(options.input_filename);
+		if (ret != 0) {
+			fprintf(stderr, "Error loading input script %s: %s\n",
+				options.input_filename, strerror(-ret));
+			delete context;
+			delete rom;
+			LibGens::EndThread();
+			return;
+		}
+	}
+
+	// Initialize the controllers.
+	IoManager *const ioManager = context->m_ioManager;
+	if (!isPico) {
+		// Standard Mega Drive controllers.
+		ioManager->setDevType(IoManager::VIRTPORT_1, IoManager::IOT_6BTN);
+		ioManager->setDevType(IoManager::VIRTPORT_2, IoManager::IOT_6BTN);
+	} else {
+		// Sega Pico controller.
+		ioManager->setDevType(IoManager::VIRTPORT_1, IoManager::IOT_PICO);
+		ioManager->setDevType(IoManager::VIRTPORT_2, IoManager::IOT_NONE);
+	}
+
+	// Audio buffer. (stereo)
+	int16_t audio_buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+
+	// Run the frames.
+	Timing timing;
+	const unsigned int frames = (unsigned int)options.frames;
+	const unsigned int warmup = (unsigned int)options.warmup;
+	result->stats.reserve(frames);
+	uint64_t start = timing.getTime();
+	for (unsigned int frame = 0; frame < warmup + frames; frame++) {
+		if (frame == warmup) {
+			// Start measuring.
+			start = timing.getTime();
+		}
+
+		// Update the controllers.
+		if (options.input_filename) {
+			ioManager->update(IoManager::VIRTPORT_1, script.buttons(frame, 0));
+			ioManager->update(IoManager::VIRTPORT_2, script.buttons(frame, 1));
+		}
+
+		const uint64_t frame_start = timing.getTime();
+		if (!options.fast) {
+			context->execFrame();
+		} else {
+			context->execFrameFast();
+		}
+
+		// Write the audio output.
+		// If audio is disabled, the segment buffer
+		// still needs to be cleared.
+		if (!options.audio) {
+			SoundMgr::clearBuffers();
+		} else if (options.stereo) {
+			SoundMgr::writeStereo(audio_buf, SoundMgr::MAX_SEGMENT_SIZE);
+		} else {
+			SoundMgr::writeMono(audio_buf, SoundMgr::MAX_SEGMENT_SIZE);
+		}
+		const uint64_t frame_end = timing.getTime();
+
+		if (frame >= warmup) {
+			result->stats.add(frame_end - frame_start);
+		}
+	}
+	result->time = (double)(timing.getTime() - start) / 1000000.0;
+	result->idle_hits = M68K::IdleHits();
+	result->idle_cycles = M68K::IdleCycles();
+	result->z80_idle_hits = Z80::IdleHits();
+	result->z80_idle_cycles = Z80::IdleCycles();
+	result->ret = EXIT_SUCCESS;
+
+	// Save the VDP port write trace.
+	if (options.vdp_trace_filename) {
+		result->vdp_trace = context->m_vdp->trace()->save(options.vdp_trace_filename);
+		if (result->vdp_trace < 0) {
+			fprintf(stderr, "Error saving VDP trace file %s.\n",
+				options.vdp_trace_filename);
+			result->ret = EXIT_FAILURE;
+		}
+	}
+
+	delete context;
+	delete rom;
+	LibGens::EndThread();
+}
+
+/**
+ * Run the benchmark and print the results.
+ * @return Exit code.
+ */
+static int run(void)
+{
+	// Initialize LibGens.
+	LibGens::Init();
+
+	vector<BenchResult> results(options.threads);
+	Timing timing;
+	if (options.threads == 1) {
+		// Single context. Run it on this thread.
+		run_context(&results[0]);
+	} else {
+		// One context per thread.
+		vector<std::thread> threads;
+		for (int i = 0; i < options.threads; i++) {
+			threads.push_back(std::thread(run_context, &results[i]));
+		}
+		for (int i = 0; i < options.threads; i++) {
+			threads[i].join();
+		}
+	}
+	const double wall = timing.getTimeD();
+
+	// Combine the results.
+	FrameStats stats;
+	double time = 0;
+	unsigned int idle_hits = 0;
+	uint64_t idle_cycles = 0;
+	unsigned int z80_idle_hits = 0;
+	uint64_t z80_idle_cycles = 0;
+	for (int i = 0; i < options.threads; i++) {
+		if (results[i].ret != EXIT_SUCCESS) {
+			LibGens::End();
+			return results[i].ret;
+		}
+		stats.merge(results[i].stats);
+		idle_hits += results[i].idle_hits;
+		idle_cycles += results[i].idle_cycles;
+		z80_idle_hits += results[i].z80_idle_hits;
+		z80_idle_cycles += results[i].z80_idle_cycles;
+		time = std::max(time, results[i].time);
+	}
+	if (options.threads > 1) {
+		// The measured frames don't overlap exactly,
+		// so use the wall-clock time.
+		time = wall;
+	}
+
+	printf("ROM: %s\n", options.rom_filename);
+	printf("Mode: %s, audio: %s\n",
+		(options.fast ? "execFrameFast()" : "execFrame()"),
+		(!options.audio ? "off" : (options.stereo ? "stereo" : "mono")));
+	printf("Contexts: %d, VDP rendering: %s\n", options.threads,
+		(options.threaded_vdp ? "threaded" : "serial"));
+	printf("Frames: %d per context (+%d warmup)\n", options.frames, options.warmup);
+	if (options.threads > 1) {
+		for (int i = 0; i < options.threads; i++) {
+			printf("Context %d: %.1f fps\n", i,
+				(results[i].time > 0 ? options.frames / results[i].time : 0.0));
+		}
+	}
+	printf("Total time: %.3f s\n", time);
+	printf("Frames/sec: %.1f\n", (time > 0 ? stats.count() / time : 0.0));
+	printf("Frame time: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		(stats.count() > 0 ? (double)stats.total() / stats.count() / 1000.0 : 0.0),
+		stats.percentile(50) / 1000.0,
+		stats.percentile(99) / 1000.0,
+		stats.max() / 1000.0);
+	if (options.idle_skip) {
+		printf("Idle loops skipped: %u (%llu 68000 cycles)\n",
+			idle_hits, (unsigned long long)idle_cycles);
+		printf("Z80 idle loops skipped: %u (%llu Z80 cycles)\n",
+			z80_idle_hits, (unsigned long long)z80_idle_cycles);
+	}
+	if (options.vdp_trace_filename) {
+		printf("VDP trace: %d entries saved to %s\n",
+			results[0].vdp_trace, options.vdp_trace_filename);
+	}
+
+	LibGens::End();
+	return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	using GensBench::options;
+
+#ifdef _WIN32
+	// Convert command line parameters to UTF-8.
+	if (W32U_GetArgvU(&argc, &argv, nullptr) != 0) {
+		// ERROR!
+		return EXIT_FAILURE;
+	}
+#endif /* _WIN32 */
+
+	// Initialize locale settings.
+	setlocale(LC_ALL, "");
+
+	// Default options.
+	memset(&options, 0, sizeof(options));
+	options.frames = 3600;
+	options.warmup = 0;
+	options.fast = false;
+	options.threads = 1;
+	options.idle_skip = false;
+	options.threaded_vdp = false;
+	options.audio = true;
+	options.sound_freq = 44100;
+	options.stereo = true;
+	options.batched_ym = false;
+	options.simd_fm = true;
+	options.native_rate = false;
+	options.blep_psg = false;
+	options.region = SysVersion::REGION_AUTO;
+	const char *region = nullptr;
+
+	// popt: help options table.
+	struct poptOption helpOptionsTable[] = {
+		{"help", '?', POPT_ARG_NONE, NULL, '?', "Show this help message", NULL},
+		{"usage", '\0', POPT_ARG_NONE, NULL, 'u', "Display brief usage message", NULL},
+		{"version", 'V', POPT_ARG_NONE, NULL, 'V', "Display version information", NULL},
+		POPT_TABLEEND
+	};
+
+	// popt: audio options table.
+	struct poptOption audioOptionsTable[] = {
+		{"audio", '\0', POPT_ARG_VAL, &options.audio, 1,
+			"* Write audio output.", NULL},
+		{"no-audio", '\0', POPT_ARG_VAL, &options.audio, 0,
+			"  Don't write audio output.", NULL},
+		{"frequency", '\0', POPT_ARG_INT, &options.sound_freq, 0,
+			"  Audio frequency. (default is 44100)", "FREQ"},
+		{"mono", '\0', POPT_ARG_VAL, &options.stereo, 0,
+			"  Use monaural audio.", NULL},
+		{"stereo", '\0', POPT_ARG_VAL, &options.stereo, 1,
+			"* Use stereo audio.", NULL},
+		{"batched-ym", '\0', POPT_ARG_VAL, &options.batched_ym, 1,
+			"  Synthesize YM2612 audio in batches between register writes.", NULL},
+		{"simd-fm", '\0', POPT_ARG_VAL, &options.simd_fm, 1,
+			"* Use the SIMD FM engine if the CPU supports it.", NULL},
+		{"scalar-fm", '\0', POPT_ARG_VAL, &options.simd_fm, 0,
+			"  Use the scalar FM engine.", NULL},
+		{"native-rate", '\0', POPT_ARG_VAL, &options.native_rate, 1,
+			"  Synthesize audio at the YM2612's native rate and resample it.", NULL},
+		{"blep-psg", '\0', POPT_ARG_VAL, &options.blep_psg, 1,
+			"  Use band-limited step synthesis for the PSG.", NULL},
+		POPT_TABLEEND
+	};
+
+	// popt: main options table.
+	struct poptOption optionsTable[] = {
+		{"frames", 'n', POPT_ARG_INT, &options.frames, 0,
+			"Number of frames to measure. (default is 3600)", "N"},
+		{"warmup", 'w', POPT_ARG_INT, &options.warmup, 0,
+			"Number of frames to run before measuring. (default is 0)", "N"},
+		{"fast", 'f', POPT_ARG_VAL, &options.fast, 1,
+			"Run execFrameFast() instead of execFrame().", NULL},
+		{"input", 'i', POPT_ARG_STRING, &options.input_filename, 0,
+			"Input script. (FRAME BUTTONS1 [BUTTONS2] per line)", "FILENAME"},
+		{"region", '\0', POPT_ARG_STRING, &region, 0,
+			"Set the region code: J,U,E,Asia,Auto (default is auto)", "REGION"},
+		{"threads", 't', POPT_ARG_INT, &options.threads, 0,
+			"Number of emulation contexts, one per thread. (default is 1)", "N"},
+		{"idle-skip", '\0', POPT_ARG_VAL, &options.idle_skip, 1,
+			"Skip 68000 and Z80 idle loops. (portable CPU cores only)", NULL},
+		{"threaded-vdp", '\0', POPT_ARG_VAL, &options.threaded_vdp, 1,
+			"Render VDP lines on a worker thread.", NULL},
+		{"vdp-trace", '\0', POPT_ARG_STRING, &options.vdp_trace_filename, 0,
+			"Save a trace of the last 65,536 VDP port writes.", "FILENAME"},
+		{NULL, '\0', POPT_ARG_INCLUDE_TABLE, audioOptionsTable, 0,
+			"Audio options: (* indicates default)", NULL},
+		{NULL, '\0', POPT_ARG_INCLUDE_TABLE, helpOptionsTable, 0,
+			"Help options:", NULL},
+		POPT_TABLEEND
+	};
+
+	// Initialize the popt context.
+	poptContext optCon = poptGetContext(NULL, argc, (const char**)argv, optionsTable, 0);
+	poptSetOtherOptionHelp(optCon, "[OPTIONS...] <rom>");
+
+	// popt: Alias '-h' to '-?'.
+	// NOTE: help_argv must be free()able, so it
+	// can't be static or allocated on the stack.
+	{
+		const char **help_argv = (const char**)malloc(sizeof(const char*) * 2);
+		struct poptAlias help_alias = {NULL, 'h', 1, help_argv};
+		help_argv[0] = "-?";
+		help_argv[1] = NULL;
+		poptAddAlias(optCon, help_alias, 0);
+	}
+
+	// Process options.
+	int c;
+	while ((c = poptGetNextOpt(optCon)) >= 0) {
+		switch (c) {
+			case 'V':
+				GensBench::print_prg_info();
+				fputc('\n', stderr);
+				GensBench::print_gpl();
+				poptFreeContext(optCon);
+				return EXIT_SUCCESS;
+
+			case '?':
+				GensBench::print_help(optCon);
+				poptFreeContext(optCon);
+				return EXIT_SUCCESS;
+
+			case 'u':
+				poptPrintUsage(optCon, stderr, 0);
+				poptFreeContext(optCon);
+				return EXIT_SUCCESS;
+
+			default:
+				break;
+		}
+	}
+
+	if (c < -1) {
+		// An error occurred during option processing.
+		switch (c) {
+			case POPT_ERROR_BADOPT:
+				// Unrecognized option.
+				fprintf(stderr, "%s: unrecognized option '%s'\n"
+					"Try `%s --help` for more information.\n",
+					argv[0], poptBadOption(optCon, POPT_BADOPTION_NOALIAS), argv[0]);
+				break;
+			default:
+				// Other error.
+				fprintf(stderr, "%s: '%s': %s\n"
+					"Try `%s --help` for more information.\n",
+					argv[0], poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+					poptStrerror(c), argv[0]);
+				break;
+		}
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+
+	// Verify the options.
+	if (region && GensBench::parse_region(region, &options.region) != 0) {
+		// Invalid region code.
+		fprintf(stderr, "%s: '--region=%s': invalid region code\n"
+			"Valid options are J, U, E, Asia, and Auto.\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], region, argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+	if (options.frames <= 0 || options.warmup < 0) {
+		fprintf(stderr, "%s: invalid frame count\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+	if (options.sound_freq <= 0 || options.sound_freq > SoundMgr::MAX_SAMPLING_RATE) {
+		fprintf(stderr, "%s: '--frequency=%d': frequency must be between 1 and %d Hz\n",
+			argv[0], options.sound_freq, SoundMgr::MAX_SAMPLING_RATE);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+	if (options.vdp_trace_filename && options.threads != 1) {
+		fprintf(stderr, "%s: '--vdp-trace' requires a single context\n",
+			argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+#ifdef GENS_ENABLE_MULTI_CONTEXT
+	if (options.threads <= 0) {
+		fprintf(stderr, "%s: '--threads=%d': invalid thread count\n",
+			argv[0], options.threads);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+#else /* !GENS_ENABLE_MULTI_CONTEXT */
+	if (options.threads != 1) {
+		fprintf(stderr, "%s: '--threads=%d': multiple contexts require "
+			"a multi-context build (ENABLE_MULTI_CONTEXT)\n",
+			argv[0], options.threads);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+#endif /* GENS_ENABLE_MULTI_CONTEXT */
+
+	// Get the ROM filename.
+	options.rom_filename = poptGetArg(optCon);
+	if (options.rom_filename == NULL) {
+		// No ROM filename specified.
+		fprintf(stderr, "%s: no ROM filename specified\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	} else if (poptPeekArg(optCon) != NULL) {
+		// Too many parameters specified.
+		fprintf(stderr, "%s: too many parameters\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+
+	// NOTE: The popt context owns the option strings,
+	// so it can't be freed until the benchmark is done.
+	int ret = GensBench::run();
+	poptFreeContext(optCon);
+	return ret;
+}
@@ -0,0 +1,543 @@
+/***************************************************************************
+ * gens-bench: Gens/GS II headless benchmark runner.                       *
+ * vdp-bench.cpp: VDP renderer benchmark.                                  *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+/**
+ * vdp-bench renders synthetic Mode 5 scenes without running
+ * any CPU emulation, so only the VDP renderer is measured.
+ *
+ * Scenes:
+ * - tiles: Both scroll planes are filled with random tiles
+ *   using all combinations of H/V flip, palette, and priority.
+ * - sprites: 80 randomly-placed 4x4 sprites.
+ * - all: Both of the above.
+ *
+ * Each frame, the scroll planes are moved and a number of
+ * VRAM pattern words can be rewritten through the data port,
+ * which simulates animated tiles.
+ *
+ * CRAM entries can also be rewritten before every line,
+ * which simulates mid-frame palette cycling (raster effects).
+ *
+ * The number of dirty framebuffer lines per frame is reported,
+ * optionally with per-line hashing to skip unchanged lines.
+ */
+
+#include <libgens/config.libgens.h>
+
+// LibGens
+#include "libgens/lg_main.hpp"
+#include "libgens/Util/MdFb.hpp"
+#include "libgens/Util/Timing.hpp"
+#include "libgens/Vdp/Vdp.hpp"
+using LibGens::MdFb;
+using LibGens::Timing;
+using LibGens::Vdp;
+
+#include "FrameStats.hpp"
+
+// OS-specific includes.
+#ifdef _WIN32
+// Win32 Unicode Translation Layer.
+// Needed for proper Unicode filename support on Windows.
+#include "libcompat/W32U/W32U_mini.h"
+#include "libcompat/W32U/W32U_argv.h"
+#endif
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+
+// popt
+#include <popt.h>
+
+namespace GensBench {
+
+/** Command line parameters. **/
+static struct {
+	const char *scene;	// Scene name.
+	int frames;		// Number of frames to measure.
+	int warmup;		// Number of frames to render before measuring.
+	int vram_writes;	// VRAM pattern words to rewrite per frame.
+	int cram_writes;	// CRAM entries to rewrite per line.
+	int h40;		// H40 mode?
+	int interlaced;		// Interlaced Mode 2?
+	int shadow_hilite;	// Shadow/Highlight?
+	int threaded_vdp;	// Render VDP lines on a worker thread?
+	int layer_composite;	// Use Mode 5 layer compositing?
+	int line_hashing;	// Hash lines to detect unchanged lines?
+} options;
+
+// Scene flags.
+enum SceneFlags {
+	SCENE_TILES	= (1 << 0),
+	SCENE_SPRITES	= (1 << 1),
+};
+
+// VRAM layout.
+static const uint32_t PATTERN_END = 0xA000;	// Patterns: 0x0000-0x9FFF
+static const uint32_t SCRB_ADDR = 0xA000;	// Scroll B: 64x32
+static const uint32_t SCRA_ADDR = 0xC000;	// Scroll A: 64x32
+static const uint32_t SPR_ADDR = 0xE000;	// Sprite Attribute Table
+static const uint32_t HSCROLL_ADDR = 0xFC00;	// Horizontal Scroll Table
+
+/**
+ * Simple PRNG. (xorshift32)
+ * The sequence is fixed so checksums can be compared between builds.
+ */
+static uint32_t rng_state = 0x12345678;
+static inline uint32_t rng(void)
+{
+	uint32_t x = rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+static void print_prg_info(void)
+{
+	fprintf(stderr, "vdp-bench: Gens/GS II VDP renderer benchmark.\n");
+}
+
+static void print_help(const poptContext con)
+{
+	print_prg_info();
+	fputc('\n', stderr);
+	// NOTE: poptPrintHelp() only prints the filename portion of argv[0].
+	poptPrintHelp(con, stderr, 0);
+}
+
+/**
+ * Parse a scene name.
+ * @param str Scene name.
+ * @return Scene flags, or 0 on error.
+ */
+static int parse_scene(const char *str)
+{
+	if (!strcasecmp(str, "tiles")) {
+		return SCENE_TILES;
+	} else if (!strcasecmp(str, "sprites")) {
+		return SCENE_SPRITES;
+	} else if (!strcasecmp(str, "all")) {
+		return (SCENE_TILES | SCENE_SPRITES);
+	}
+
+	// Invalid scene name.
+	return 0;
+}
+
+/**
+ * Set the VDP address for data port writes.
+ * @param vdp VDP.
+ * @param address VRAM address.
+ */
+static inline void set_vram_write(Vdp *vdp, uint32_t address)
+{
+	vdp->writeCtrlMD(0x4000 | (address & 0x3FFF));
+	vdp->writeCtrlMD((address >> 14) & 3);
+}
+
+/**
+ * Set the VDP address for CRAM data port writes.
+ * @param vdp VDP.
+ * @param address CRAM address.
+ */
+static inline void set_cram_write(Vdp *vdp, uint32_t address)
+{
+	vdp->writeCtrlMD(0xC000 | (address & 0x7F));
+	vdp->writeCtrlMD(0x0000);
+}
+
+/**
+ * Initialize the VDP with a synthetic scene.
+ * @param vdp VDP.
+ * @param scene Scene flags.
+ */
+static void init_scene(Vdp *vdp, int scene)
+{
+	vdp->setNtsc();
+	vdp->MD_Screen->setBpp(MdFb::BPP_32);
+
+	uint8_t reg0C = (options.h40 ? 0x81 : 0x00);
+	if (options.interlaced)
+		reg0C |= 0x06;
+	if (options.shadow_hilite)
+		reg0C |= 0x08;
+
+	vdp->dbg_setReg(0x00, 0x04);	// Enable the palette.
+	vdp->dbg_setReg(0x01, 0x44);	// Enable the display, set Mode 5.
+	vdp->dbg_setReg(0x02, SCRA_ADDR >> 10);
+	vdp->dbg_setReg(0x03, 0x00);	// Window isn't used.
+	vdp->dbg_setReg(0x04, SCRB_ADDR >> 13);
+	vdp->dbg_setReg(0x05, SPR_ADDR >> 9);
+	vdp->dbg_setReg(0x0B, 0x00);	// Full-screen scrolling.
+	vdp->dbg_setReg(0x0C, reg0C);
+	vdp->dbg_setReg(0x0D, HSCROLL_ADDR >> 10);
+	vdp->dbg_setReg(0x0F, 0x02);	// Auto-increment: 2
+	vdp->dbg_setReg(0x10, 0x01);	// Scroll size: V32 H64
+	vdp->dbg_setReg(0x11, 0x00);	// Window H position.
+	vdp->dbg_setReg(0x12, 0x00);	// Window V position.
+
+	// Random CRam.
+	uint16_t cram[64];
+	for (int i = 0; i < 64; i++) {
+		cram[i] = (rng() & 0x0EEE);
+	}
+	vdp->dbg_writeCRam_16(0, cram, 64);
+
+	// Clear VSRam.
+	uint16_t vsram[40];
+	memset(vsram, 0, sizeof(vsram));
+	vdp->dbg_writeVSRam_16(0, vsram, 40);
+
+	// VRAM image.
+	static uint16_t vram[0x8000];
+	memset(vram, 0, sizeof(vram));
+
+	// Random patterns. Tile 0 is left blank.
+	for (uint32_t i = (32 >> 1); i < (PATTERN_END >> 1); i++) {
+		vram[i] = (uint16_t)rng();
+	}
+
+	if (scene & SCENE_TILES) {
+		// Random nametables.
+		// Tile numbers are limited to the pattern area.
+		const unsigned int tile_count = (PATTERN_END >> (options.interlaced ? 6 : 5));
+		for (int i = 0; i < 64*32; i++) {
+			const uint32_t r1 = rng(), r2 = rng();
+			vram[(SCRA_ADDR >> 1) + i] = (r1 & 0xF800) | ((r1 & 0xFFFF) % tile_count);
+			vram[(SCRB_ADDR >> 1) + i] = (r2 & 0xF800) | ((r2 & 0xFFFF) % tile_count);
+		}
+	}
+
+	if (scene & SCENE_SPRITES) {
+		// 80 sprites, 4x4 cells each.
+		const unsigned int tile_count = (PATTERN_END >> (options.interlaced ? 6 : 5)) - 16;
+		const int v_max = (options.interlaced ? 448 : 224);
+		const int h_max = (options.h40 ? 320 : 256);
+		uint16_t *spr = &vram[SPR_ADDR >> 1];
+		for (int i = 0; i < 80; i++, spr += 4) {
+			const uint32_t r = rng();
+			spr[0] = 128 + (rng() % (v_max + 32)) - 32;
+			spr[1] = 0x0F00 | (i < 79 ? i + 1 : 0);
+			spr[2] = (r & 0xF800) | ((r & 0xFFFF) % tile_count);
+			spr[3] = 128 + (rng() % (h_max + 32)) - 32;
+		}
+	}
+
+	vdp->dbg_writeVRam_16(0, vram, sizeof(vram));
+}
+
+/**
+ * Update the scene for the next frame.
+ * @param vdp VDP.
+ * @param frame Frame number.
+ */
+static void update_scene(Vdp *vdp, unsigned int frame)
+{
+	// Scroll the planes.
+	set_vram_write(vdp, HSCROLL_ADDR);
+	vdp->writeDataMD((uint16_t)(frame * 3));
+	vdp->writeDataMD((uint16_t)(-(int)frame));
+
+	// Rewrite some pattern data.
+	for (int i = options.vram_writes; i > 0; i--) {
+		set_vram_write(vdp, (32 + (rng() % (PATTERN_END - 32))) & ~1);
+		vdp->writeDataMD((uint16_t)rng());
+	}
+}
+
+/**
+ * Rewrite CRAM entries for palette cycling.
+ * A different set of entries is rewritten on each line.
+ * @param vdp VDP.
+ * @param frame Frame number.
+ * @param line Line number.
+ */
+static inline void cycle_palette(Vdp *vdp, unsigned int frame, int line)
+{
+	const unsigned int first = ((unsigned int)line * options.cram_writes) & 0x3F;
+	set_cram_write(vdp, first << 1);
+	for (int i = 0; i < options.cram_writes; i++) {
+		vdp->writeDataMD((uint16_t)(((frame + line + i) * 0x246) & 0x0EEE));
+	}
+}
+
+/**
+ * Render one frame.
+ * @param vdp VDP.
+ * @param frame Frame number.
+ */
+static inline void render_frame(Vdp *vdp, unsigned int frame)
+{
+	vdp->updateVdpLines(true);
+	for (; vdp->VDP_Lines.currentLine < vdp->VDP_Lines.totalDisplayLines;
+	     vdp->VDP_Lines.currentLine++)
+	{
+		if (options.cram_writes > 0) {
+			cycle_palette(vdp, frame, vdp->VDP_Lines.currentLine);
+		}
+		vdp->renderLine();
+	}
+}
+
+/**
+ * Calculate a checksum of the framebuffer. (FNV-1a)
+ * @param vdp VDP.
+ * @return Checksum.
+ */
+static uint32_t fb_checksum(const Vdp *vdp)
+{
+	const MdFb *fb = vdp->MD_Screen;
+	uint32_t crc = 2166136261U;
+	for (int y = 0; y < fb->numLines(); y++) {
+		const uint32_t *line = fb->lineBuf32(y);
+		for (int x = 0; x < fb->pxPerLine(); x++) {
+			crc ^= line[x];
+			crc *= 16777619U;
+		}
+	}
+	return crc;
+}
+
+/**
+ * Count the dirty lines in the framebuffer.
+ * @param fb MdFb.
+ * @return Number of dirty lines.
+ */
+static unsigned int count_dirty_lines(const MdFb *fb)
+{
+	unsigned int count = 0;
+	for (int y = 0; y < fb->numLines(); y++) {
+		count += fb->isLineDirty(y);
+	}
+	return count;
+}
+
+/**
+ * Run the benchmark and print the results.
+ * @param scene Scene flags.
+ * @return Exit code.
+ */
+static int run(int scene)
+{
+	// Initialize LibGens.
+	LibGens::Init();
+
+	Vdp *vdp = new Vdp();
+	init_scene(vdp, scene);
+	if (options.threaded_vdp) {
+		vdp->setThreadedRendering(true);
+	}
+	if (options.layer_composite) {
+		vdp->options.layerCompositing = true;
+	}
+	if (options.line_hashing) {
+		vdp->MD_Screen->setLineHashing(true);
+	}
+
+	Timing timing;
+	FrameStats stats;
+	const unsigned int frames = (unsigned int)options.frames;
+	const unsigned int warmup = (unsigned int)options.warmup;
+	stats.reserve(frames);
+	unsigned int lines = 0;
+	unsigned int dirtyLines = 0;
+	for (unsigned int frame = 0; frame < warmup + frames; frame++) {
+		update_scene(vdp, frame);
+
+		const uint64_t frame_start = timing.getTime();
+		render_frame(vdp, frame);
+		const uint64_t frame_end = timing.getTime();
+
+		if (frame >= warmup) {
+			stats.add(frame_end - frame_start);
+			lines += vdp->VDP_Lines.totalDisplayLines;
+			dirtyLines += count_dirty_lines(vdp->MD_Screen);
+		}
+		vdp->MD_Screen->clearDirtyLines();
+	}
+
+	const double time = (double)stats.total() / 1000000.0;
+	printf("Scene: %s (%s%s%s)\n", options.scene,
+		(options.h40 ? "H40" : "H32"),
+		(options.interlaced ? ", interlaced" : ""),
+		(options.shadow_hilite ? ", shadow/highlight" : ""));
+	printf("VRAM writes: %d per frame, CRAM writes: %d per line\n",
+		options.vram_writes, options.cram_writes);
+	printf("VDP rendering: %s%s\n",
+		(options.threaded_vdp ? "threaded" : "serial"),
+		(options.layer_composite ? ", layer compositing" : ""));
+	printf("Dirty lines: %.1f per frame%s\n",
+		(stats.count() > 0 ? (double)dirtyLines / stats.count() : 0.0),
+		(options.line_hashing ? " (line hashing)" : ""));
+	printf("Frames: %d (+%d warmup)\n", options.frames, options.warmup);
+	printf("Total time: %.3f s\n", time);
+	printf("Frames/sec: %.1f\n", (time > 0 ? stats.count() / time : 0.0));
+	printf("Line time: %.1f ns\n", (lines > 0 ? (time * 1.0e9) / lines : 0.0));
+	printf("Frame time: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		(stats.count() > 0 ? (double)stats.total() / stats.count() / 1000.0 : 0.0),
+		stats.percentile(50) / 1000.0,
+		stats.percentile(99) / 1000.0,
+		stats.max() / 1000.0);
+	printf("Checksum: %08X\n", fb_checksum(vdp));
+
+	delete vdp;
+	LibGens::End();
+	return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	using GensBench::options;
+
+#ifdef _WIN32
+	// Convert command line parameters to UTF-8.
+	if (W32U_GetArgvU(&argc, &argv, nullptr) != 0) {
+		// ERROR!
+		return EXIT_FAILURE;
+	}
+#endif /* _WIN32 */
+
+	// Initialize locale settings.
+	setlocale(LC_ALL, "");
+
+	// Default options.
+	memset(&options, 0, sizeof(options));
+	options.scene = "all";
+	options.frames = 3600;
+	options.warmup = 60;
+	options.vram_writes = 0;
+	options.cram_writes = 0;
+	options.h40 = true;
+	options.interlaced = false;
+	options.shadow_hilite = false;
+	options.threaded_vdp = false;
+	options.layer_composite = false;
+	options.line_hashing = false;
+
+	// popt: help options table.
+	struct poptOption helpOptionsTable[] = {
+		{"help", '?', POPT_ARG_NONE, NULL, '?', "Show this help message", NULL},
+		{"usage", '\0', POPT_ARG_NONE, NULL, 'u', "Display brief usage message", NULL},
+		POPT_TABLEEND
+	};
+
+	// popt: main options table.
+	struct poptOption optionsTable[] = {
+		{"scene", 's', POPT_ARG_STRING, &options.scene, 0,
+			"Scene: tiles, sprites, all (default is all)", "SCENE"},
+		{"frames", 'n', POPT_ARG_INT, &options.frames, 0,
+			"Number of frames to measure. (default is 3600)", "N"},
+		{"warmup", 'w', POPT_ARG_INT, &options.warmup, 0,
+			"Number of frames to render before measuring. (default is 60)", "N"},
+		{"vram-writes", '\0', POPT_ARG_INT, &options.vram_writes, 0,
+			"VRAM pattern words to rewrite per frame. (default is 0)", "N"},
+		{"cram-writes", '\0', POPT_ARG_INT, &options.cram_writes, 0,
+			"CRAM entries to rewrite per line. (default is 0)", "N"},
+		{"h32", '\0', POPT_ARG_VAL, &options.h40, 0,
+			"Use H32 mode instead of H40.", NULL},
+		{"interlaced", '\0', POPT_ARG_VAL, &options.interlaced, 1,
+			"Use Interlaced Mode 2.", NULL},
+		{"shadow-hilite", '\0', POPT_ARG_VAL, &options.shadow_hilite, 1,
+			"Enable Shadow/Highlight.", NULL},
+		{"threaded-vdp", '\0', POPT_ARG_VAL, &options.threaded_vdp, 1,
+			"Render VDP lines on a worker thread.", NULL},
+		{"layer-composite", '\0', POPT_ARG_VAL, &options.layer_composite, 1,
+			"Render Mode 5 layers separately, then composite them.", NULL},
+		{"line-hashing", '\0', POPT_ARG_VAL, &options.line_hashing, 1,
+			"Hash framebuffer lines to skip unchanged lines.", NULL},
+		{NULL, '\0', POPT_ARG_INCLUDE_TABLE, helpOptionsTable, 0,
+			"Help options:", NULL},
+		POPT_TABLEEND
+	};
+
+	// Initialize the popt context.
+	poptContext optCon = poptGetContext(NULL, argc, (const char**)argv, optionsTable, 0);
+	poptSetOtherOptionHelp(optCon, "[OPTIONS...]");
+
+	// Process options.
+	int c;
+	while ((c = poptGetNextOpt(optCon)) >= 0) {
+		switch (c) {
+			case '?':
+				GensBench::print_help(optCon);
+				poptFreeContext(optCon);
+				return EXIT_SUCCESS;
+
+			case 'u':
+				poptPrintUsage(optCon, stderr, 0);
+				poptFreeContext(optCon);
+				return EXIT_SUCCESS;
+
+			default:
+				break;
+		}
+	}
+
+	if (c < -1) {
+		// An error occurred during option processing.
+		fprintf(stderr, "%s: '%s': %s\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+			poptStrerror(c), argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+
+	// Verify the options.
+	const int scene = GensBench::parse_scene(options.scene);
+	if (scene == 0) {
+		fprintf(stderr, "%s: '--scene=%s': invalid scene\n"
+			"Valid options are tiles, sprites, and all.\n",
+			argv[0], options.scene);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+	if (options.frames <= 0 || options.warmup < 0 ||
+	    options.vram_writes < 0 || options.cram_writes < 0 || options.cram_writes > 64)
+	{
+		fprintf(stderr, "%s: invalid frame, VRAM write, or CRAM write count\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+	if (poptPeekArg(optCon) != NULL) {
+		// Too many parameters specified.
+		fprintf(stderr, "%s: too many parameters\n"
+			"Try `%s --help` for more information.\n",
+			argv[0], argv[0]);
+		poptFreeContext(optCon);
+		return EXIT_FAILURE;
+	}
+
+	// NOTE: The popt context owns the option strings,
+	// so it can't be freed until the benchmark is done.
+	int ret = GensBench::run(scene);
+	poptFreeContext(optCon);
+	return ret;
+}
@@ -104,9 +104,9 @@ class ARingBuffer
 		/**
 		 * Segment buffer.
 		 * Stores up to NUM_SEGMENTS segments.
-		 * Up to 1024 samples. (1024*2 for stereo)
+		 * Up to MAX_SEGMENT_SIZE samples. (MAX_SEGMENT_SIZE*2 for stereo)
 		 */
-		int16_t m_buffer[NUM_SEGMENTS][1024*2];
+		int16_t m_buffer[NUM_SEGMENTS][MAX_SEGMENT_SIZE*2];
 
 		// Buffer segment locks.
 		QMutex m_bufLock[NUM_SEGMENTS];
@@ -110,6 +110,12 @@ class GLBackendPrivate {
 		 */
 		const MdFb *applySoftwareEffects(void);
 
+		/**
+		 * Upload the dirty lines from m_fb to the texture.
+		 * Consecutive dirty lines are uploaded together.
+		 */
+		void uploadDirtyLines(void);
+
 		/**
 		 * Start applying shader effects.
 		 */
@@ -352,6 +358,39 @@ const MdFb *GLBackendPrivate::applySoftwareEffects(void)
 	return fb;
 }
 
+/**
+ * Upload the dirty lines from m_fb to the texture.
+ * Consecutive dirty lines are uploaded together.
+ */
+void GLBackendPrivate::uploadDirtyLines(void)
+{
+	const MdFb *fb = q->m_fb;
+	const int numLines = fb->numLines();
+	const bool is32 = (fb->bpp() == MdFb::BPP_32);
+
+	int y = 0;
+	while (y < numLines) {
+		// Find the start of the next run of dirty lines.
+		if (!fb->isLineDirty(y)) {
+			y++;
+			continue;
+		}
+		const int start = y;
+		while (y < numLines && fb->isLineDirty(y)) {
+			y++;
+		}
+
+		const GLvoid *screen;
+		if (is32) {
+			screen = fb->lineBuf32(start);
+		} else {
+			screen = fb->lineBuf16(start);
+		}
+		tex.subImage2D(start, fb->pxPerLine(), y - start,
+				fb->pxPitch(), screen);
+	}
+}
+
 /**
  * Start applying shader effects.
  */
@@ -427,26 +466,40 @@ void GLBackend::update(bool fb_dirty)
 	if (m_fb && (fb_dirty || isForceFbDirty())) {
 		// Check if the bpp or texture size has changed.
 		// TODO: texVisSizeChanged?
+		bool fullUpload = isForceFbDirty();
 		if (m_fb->bpp() != d->lastBpp /*|| d->texVisSizeChanged*/) {
 			// Bpp has changed. reallocate the texture.
 			// VDP palettes will be recalculated on the next frame.
 			d->reallocTexture();
+			fullUpload = true;
 		}
 
 		// Apply software framebuffer effects.
 		const MdFb *fb = d->applySoftwareEffects();
+		if (fb != m_fb) {
+			// Software effects modify the entire framebuffer.
+			fullUpload = true;
+		}
 
-		// Get the screen buffer.
-		const GLvoid *screen;
-		if (fb->bpp() != MdFb::BPP_32) {
-			screen = fb->fb16();
+		if (fullUpload) {
+			// Get the screen buffer.
+			const GLvoid *screen;
+			if (fb->bpp() != MdFb::BPP_32) {
+				screen = fb->fb16();
+			} else {
+				screen = fb->fb32();
+			}
+
+			// (Re-)Upload the texture.
+			d->tex.subImage2D(fb->pxPerLine(), fb->numLines(),
+					fb->pxPitch(), screen);
 		} else {
-			screen = fb->fb32();
+			// Only upload lines that have changed.
+			d->uploadDirtyLines();
 		}
 
-		// (Re-)Upload the texture.
-		d->tex.subImage2D(fb->pxPerLine(), fb->numLines(),
-				fb->pxPitch(), screen);
+		// The texture is now up to date.
+		m_fb->clearDirtyLines();
 	}
 
 	// Bind the texture.
@@ -76,6 +76,17 @@ class GLTex
 		 */
 		void subImage2D(int w, int h, int pxPitch, const void *data);
 
+		/**
+		 * Upload a range of lines of a sub-image.
+		 * Image data must be in the format allocated in alloc().
+		 * @param y First line to upload.
+		 * @param w Width.
+		 * @param h Number of lines to upload.
+		 * @param pxPitch Pitch, in pixels.
+		 * @param data Image data for line y.
+		 */
+		void subImage2D(int y, int w, int h, int pxPitch, const void *data);
+
 	public:
 		/**
 		 * Convert x/y/width/height to texture or vertex coordinates.
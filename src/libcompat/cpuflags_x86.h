@@ -135,6 +135,33 @@
 #error Missing 'cpuid' asm implementation for this compiler.
 #endif
 
+// XCR0 bits. (XGETBV function 0)
+#define XCR0_SSE_STATE			((uint32_t)(1U << 1))
+#define XCR0_AVX_STATE			((uint32_t)(1U << 2))
+
+#if defined(__GNUC__)
+// XGETBV macro. Only valid if CPUID reports OSXSAVE.
+// NOTE: Using the opcode bytes, since older assemblers
+// don't recognize 'xgetbv'.
+#define XGETBV(xcr, lo, hi) do {				\
+	__asm__ (						\
+		".byte 0x0F, 0x01, 0xD0\n"			\
+		: "=a" (lo), "=d" (hi)				\
+		: "c" (xcr)					\
+		);						\
+	} while (0)
+#elif defined(_MSC_VER) && _MSC_FULL_VER >= 160040219
+// XGETBV macro for MSVC 2010 SP1+.
+#include <immintrin.h>
+#define XGETBV(xcr, lo, hi) do {				\
+	unsigned __int64 xcr_val = _xgetbv(xcr);		\
+	(lo) = (unsigned int)(xcr_val);				\
+	(hi) = (unsigned int)(xcr_val >> 32);			\
+} while (0)
+#else
+// XGETBV isn't available. AVX will not be detected.
+#endif
+
 /**
  * Force a function to be marked as inline.
  * FORCE_INLINE: Release builds only.
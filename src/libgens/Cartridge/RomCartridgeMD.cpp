@@ -499,7 +499,6 @@ int RomCartridgeMD::updateSysBanking(STARSCREAM_PROGRAMREGION *M68K_Fetch, int b
 	if (banks > ARRAY_SIZE(m_cartBanks))
 		banks = ARRAY_SIZE(m_cartBanks);
 
-	// TODO: This is not 64-bit clean!
 	for (int i = 0; i < banks; i++) {
 		if (/*m_cartBanks[i] >= BANK_ROM_00 &&*/
 		    m_cartBanks[i] <= BANK_ROM_3F) {
@@ -510,7 +509,7 @@ int RomCartridgeMD::updateSysBanking(STARSCREAM_PROGRAMREGION *M68K_Fetch, int b
 				// Valid bank. Map it.
 				M68K_Fetch->lowaddr = romAddrStart;
 				M68K_Fetch->highaddr = (romAddrStart + 0x7FFFF);
-				M68K_Fetch->offset = ((uint32_t)m_romData);
+				M68K_Fetch->offset = ((uintptr_t)m_romData);
 				M68K_Fetch++;
 				banksUpdated++;
 			}
@@ -878,6 +877,63 @@ inline uint16_t RomCartridgeMD::readWord_REGISTERS_RO(uint32_t address)
 
 /** Cartridge access functions. ($000000-$9FFFFF) **/
 
+/**
+ * Get a pointer to ROM data for a DMA block transfer.
+ * The returned run never crosses a 512 KB bank boundary,
+ * the end of the ROM image, or the start of SRam.
+ * @param address	[in] Cartridge address. (must be even)
+ * @param words		[in/out] Maximum number of words; returns the number of contiguous words.
+ * @return Pointer to host-endian ROM words, or nullptr if readWord() must be used.
+ */
+const uint16_t *RomCartridgeMD::dmaReadPtr(uint32_t address, unsigned int *words) const
+{
+	address &= 0xFFFFFF;
+
+	// Check for save data access.
+	if (EmuContext::GetSaveDataEnable()) {
+		if (m_EEPRom.isEEPRomTypeSet()) {
+			// EEPRom is enabled.
+			// The EEPRom ports can be anywhere, so use readWord().
+			return nullptr;
+		} else if (m_SRam.canRead()) {
+			if (m_SRam.isAddressInRange(address)) {
+				// SRam data request.
+				return nullptr;
+			} else if (address < m_SRam.start()) {
+				// Stop before the start of SRam.
+				const unsigned int max_words = ((m_SRam.start() - address + 1) >> 1);
+				if (*words > max_words)
+					*words = max_words;
+			}
+		}
+	}
+
+	const uint8_t phys_bank = ((address >> 19) & 0x1F);
+	if (phys_bank >= ARRAY_SIZE(m_cartBanks))
+		return nullptr;
+	const uint8_t bank = m_cartBanks[phys_bank];
+	if (bank > BANK_ROM_3F) {
+		// Not a physical ROM bank.
+		return nullptr;
+	}
+
+	// Get the physical ROM address.
+	const uint32_t rom_address = ((address & 0x7FFFF) | (bank << 19));
+	if (rom_address >= m_romData_size)
+		return nullptr;
+
+	// Limit the run to the current bank and the ROM size.
+	unsigned int max_words = ((0x80000 - (address & 0x7FFFF)) >> 1);
+	if (max_words > ((m_romData_size - rom_address) >> 1))
+		max_words = ((m_romData_size - rom_address) >> 1);
+	if (max_words == 0)
+		return nullptr;
+	if (*words > max_words)
+		*words = max_words;
+
+	return &(reinterpret_cast<const uint16_t*>(m_romData))[rom_address >> 1];
+}
+
 /**
  * Read a byte from the standard cartridge area. ($000000-$9FFFFF)
  * @param address Cartridge address.
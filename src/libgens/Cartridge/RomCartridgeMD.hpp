@@ -159,6 +159,14 @@ class RomCartridgeMD
 		void writeByte(uint32_t address, uint8_t data);
 		void writeWord(uint32_t address, uint16_t data);
 
+		/**
+		 * Get a pointer to ROM data for a DMA block transfer.
+		 * @param address	[in] Cartridge address. (must be even)
+		 * @param words		[in/out] Maximum number of words; returns the number of contiguous words.
+		 * @return Pointer to host-endian ROM words, or nullptr if readWord() must be used.
+		 */
+		const uint16_t *dmaReadPtr(uint32_t address, unsigned int *words) const;
+
 		// /TIME register access functions. ($A130xx)
 		// Only the low byte of the address is needed here.
 		uint8_t readByte_TIME(uint8_t address);
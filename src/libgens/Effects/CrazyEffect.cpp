@@ -299,6 +299,9 @@ void CrazyEffect::run(MdFb *fb)
 				fb->fb32(), pxCount, fb->pxPitch());
 			break;
 	}
+
+	// The entire framebuffer has changed.
+	fb->markAllLinesDirty();
 }
 
 }
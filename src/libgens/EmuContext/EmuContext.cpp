@@ -44,15 +44,16 @@ namespace LibGens
 {
 
 // Reference counter.
-// We're only allowing one emulation context at the moment.
-int EmuContext::ms_RefCount = 0;
+// We're only allowing one emulation context per thread.
+// (Multi-context builds only; otherwise, one per process.)
+EMU_THREAD_LOCAL int EmuContext::ms_RefCount = 0;
 
 // Controller I/O manager.
 // TODO: Make this non-static!
-IoManager *EmuContext::m_ioManager;
+EMU_THREAD_LOCAL IoManager *EmuContext::m_ioManager;
 
 // Static pointer. Temporarily needed for SRam/EEPRom.
-EmuContext *EmuContext::m_instance = nullptr;
+EMU_THREAD_LOCAL EmuContext *EmuContext::m_instance = nullptr;
 
 /**
  * Global settings.
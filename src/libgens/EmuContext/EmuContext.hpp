@@ -37,6 +37,9 @@
 // VDP.
 #include "../Vdp/Vdp.hpp"
 
+// Thread-local storage for multi-context builds.
+#include "libgens/macros/tls.h"
+
 // C++ includes.
 #include <string>
 
@@ -104,7 +107,7 @@ class EmuContext
 
 		// Controller I/O manager.
 		// TODO: Make this non-static!
-		static IoManager *m_ioManager;
+		static EMU_THREAD_LOCAL IoManager *m_ioManager;
 
 		/**
 		 * Read the system version register. (MD)
@@ -185,7 +188,7 @@ class EmuContext
 		SysVersion m_sysVersion;
 
 		// Static pointer. Temporarily needed for SRam/EEPRom.
-		static EmuContext *m_instance;
+		static EMU_THREAD_LOCAL EmuContext *m_instance;
 
 		/**
 		 * Global settings.
@@ -196,7 +199,7 @@ class EmuContext
 		static bool ms_TmssEnabled;
 
 	private:
-		static int ms_RefCount;
+		static EMU_THREAD_LOCAL int ms_RefCount;
 };
 
 // Get the current EmuContext instance.
@@ -22,6 +22,7 @@
  ***************************************************************************/
 
 #include "EmuMD.hpp"
+#include "Scheduler.hpp"
 
 // VDP.
 #include "Vdp/Vdp.hpp"
@@ -255,7 +256,9 @@ int EmuMD::setRegion_int(SysVersion::RegionCode_t region, bool preserveState)
 	 * Use the old "Round_Double" implementation like in old Gens.
 	 * [rint() uses banker's rounding, which rounds 0.5 to 0 and 1.5 to 2.]
 	 * [Round_Double() rounds 0.5 to 0 and 1.5 to 1.] */
-	// TODO: Jorge says CPL is always 3420 master clock cycles...
+	// NOTE: CPU timeslices are based on the Scheduler's
+	// 3420 master clock cycles per line. CPL is only used
+	// for DMA timing.
 	if (m_sysVersion.isPal()) {
 		M68K_Mem::CPL_M68K = Round_Double((((double)CLOCK_PAL / 7.0) / 50.0) / 312.0);
 		M68K_Mem::CPL_Z80 = Round_Double((((double)CLOCK_PAL / 15.0) / 50.0) / 312.0);
@@ -329,24 +332,24 @@ template<EmuMD::LineType_t LineType, bool VDP>
 FORCE_INLINE void EmuMD::T_execLine(void)
 {
 	int writePos = SoundMgr::GetWritePos(m_vdp->VDP_Lines.currentLine);
-	int32_t *bufL = &SoundMgr::ms_SegBufL[writePos];
-	int32_t *bufR = &SoundMgr::ms_SegBufR[writePos];
+	int32_t *buf = &SoundMgr::ms_SegBuf[writePos * 2];
 
 	// Update the sound chips.
 	int writeLen = SoundMgr::GetWriteLen(m_vdp->VDP_Lines.currentLine);
-	SoundMgr::ms_Ym2612.updateDacAndTimers(bufL, bufR, writeLen);
+	SoundMgr::ms_Ym2612.updateDacAndTimers(buf, writeLen);
 	SoundMgr::ms_Ym2612.addWriteLen(writeLen);
 	SoundMgr::ms_Psg.addWriteLen(writeLen);
 
 	// Notify controllers that a new scanline is being drawn.
 	m_ioManager->doScanline();
 
-	// Increment the cycles counter.
+	// Start the new line.
 	// These values are the "last cycle to execute".
 	// e.g. if Cycles_M68K is 5000, then we'll execute instructions
 	// until the 68000's "odometer" reaches 5000.
-	M68K_Mem::Cycles_M68K += M68K_Mem::CPL_M68K;
-	M68K_Mem::Cycles_Z80 += M68K_Mem::CPL_Z80;
+	Scheduler::StartLine(m_vdp->VDP_Lines.currentLine);
+	M68K_Mem::Cycles_M68K = Scheduler::ToM68K(Scheduler::LineEnd());
+	M68K_Mem::Cycles_Z80 = Scheduler::ToZ80(Scheduler::LineEnd());
 
 	if (m_vdp->DMAT_Length)
 		M68K::AddCycles(m_vdp->updateDMA());
@@ -354,14 +357,18 @@ FORCE_INLINE void EmuMD::T_execLine(void)
 	switch (LineType) {
 		case LINETYPE_ACTIVEDISPLAY:
 			// In visible area.
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, true);	// HBlank = 1
-			M68K::Exec(M68K_Mem::Cycles_M68K - 404);
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
+			m_vdp->startHBlank(Scheduler::ToM68K(
+				Scheduler::LineStart() + Scheduler::MCLK_HBLANK_END));
 
 			// Decrement the HInt counter.
-			// If it goes below 0, an HBLANK interrupt will occur.
-			// The counter will then be reloaded.
-			m_vdp->decrementHIntCounter(true);
+			// If it goes below 0, an HBLANK interrupt will occur
+			// at the end of HBlank. Otherwise, the 68000 doesn't
+			// need to be stopped on this line.
+			if (m_vdp->isHIntCounterExpiring()) {
+				Scheduler::Schedule(Scheduler::EVENT_HINT, Scheduler::MCLK_HBLANK_END);
+			} else {
+				m_vdp->decrementHIntCounter(true);
+			}
 			break;
 
 		case LINETYPE_VBLANKLINE: {
@@ -375,7 +382,8 @@ FORCE_INLINE void EmuMD::T_execLine(void)
 			CONGRATULATIONS_PRECHECK();
 #endif
 			// VBlank = 1 et HBlank = 1 (retour de balayage vertical en cours)
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, true);
+			m_vdp->startHBlank(Scheduler::ToM68K(
+				Scheduler::LineStart() + Scheduler::MCLK_VINT));
 			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_VBLANK, true);
 
 			// If we're using NTSC V30 and this is an "even" frame,
@@ -383,24 +391,8 @@ FORCE_INLINE void EmuMD::T_execLine(void)
 			if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div != 0)
 				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_VBLANK, false);
 
-			M68K::Exec(M68K_Mem::Cycles_M68K - 360);
-			Z80::Exec(168);
-#if 0
-			// TODO: Congratulations! (LibGens)
-			CONGRATULATIONS_POSTCHECK();
-#endif
-
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
-			if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div == 0) {
-				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_F, true);	// V Int happened
-				m_vdp->updateIRQLine(0x8);
-
-				// Z80 interrupt.
-				// TODO: Does this trigger on all VBlanks,
-				// or only if VINTs are enabled in the VDP?
-				Z80::Interrupt(0xFF);
-			}
-
+			Scheduler::Schedule(Scheduler::EVENT_VINT, Scheduler::MCLK_VINT);
+			Scheduler::Schedule(Scheduler::EVENT_VINT_Z80, Scheduler::MCLK_VINT_Z80);
 			break;
 		}
 
@@ -409,6 +401,44 @@ FORCE_INLINE void EmuMD::T_execLine(void)
 			break;
 	}
 
+	// Run the CPUs up to each event on this line.
+	Scheduler::Event_t event;
+	int mclk;
+	while ((event = Scheduler::NextEvent(&mclk)) != Scheduler::EVENT_NONE) {
+		switch (event) {
+			case Scheduler::EVENT_HINT:
+				M68K::Exec(Scheduler::ToM68K(mclk));
+				m_vdp->decrementHIntCounter(true);
+				break;
+
+			case Scheduler::EVENT_VINT:
+				M68K::Exec(Scheduler::ToM68K(mclk));
+#if 0
+				// TODO: Congratulations! (LibGens)
+				CONGRATULATIONS_POSTCHECK();
+#endif
+				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
+				if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div == 0) {
+					m_vdp->setStatusBit(VdpStatus::VDP_STATUS_F, true);	// V Int happened
+					m_vdp->updateIRQLine(0x8);
+				}
+				break;
+
+			case Scheduler::EVENT_VINT_Z80:
+				Z80::Exec(M68K_Mem::Cycles_Z80 - Scheduler::ToZ80(mclk));
+				if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div == 0) {
+					// Z80 interrupt.
+					// TODO: Does this trigger on all VBlanks,
+					// or only if VINTs are enabled in the VDP?
+					Z80::Interrupt(0xFF);
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
 	if (VDP) {
 		// VDP needs to be updated.
 		m_vdp->renderLine();
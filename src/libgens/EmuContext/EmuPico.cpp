@@ -28,6 +28,7 @@
 // - $800000 I/O range with Pico-specific hardware.
 
 #include "EmuPico.hpp"
+#include "Scheduler.hpp"
 
 #include "Cartridge/RomCartridgeMD.hpp"
 #include "Vdp/Vdp.hpp"
@@ -227,7 +228,9 @@ int EmuPico::setRegion_int(SysVersion::RegionCode_t region, bool preserveState)
 	 * Use the old "Round_Double" implementation like in old Gens.
 	 * [rint() uses banker's rounding, which rounds 0.5 to 0 and 1.5 to 2.]
 	 * [Round_Double() rounds 0.5 to 0 and 1.5 to 1.] */
-	// TODO: Jorge says CPL is always 3420 master clock cycles...
+	// NOTE: CPU timeslices are based on the Scheduler's
+	// 3420 master clock cycles per line. CPL is only used
+	// for DMA timing.
 	if (m_sysVersion.isPal()) {
 		M68K_Mem::CPL_M68K = Round_Double((((double)CLOCK_PAL / 7.0) / 50.0) / 312.0);
 	} else {
@@ -290,11 +293,12 @@ FORCE_INLINE void EmuPico::T_execLine(void)
 	// Notify controllers that a new scanline is being drawn.
 	m_ioManager->doScanline();
 
-	// Increment the cycles counter.
+	// Start the new line.
 	// These values are the "last cycle to execute".
 	// e.g. if Cycles_M68K is 5000, then we'll execute instructions
 	// until the 68000's "odometer" reaches 5000.
-	M68K_Mem::Cycles_M68K += M68K_Mem::CPL_M68K;
+	Scheduler::StartLine(m_vdp->VDP_Lines.currentLine);
+	M68K_Mem::Cycles_M68K = Scheduler::ToM68K(Scheduler::LineEnd());
 
 	if (m_vdp->DMAT_Length)
 		M68K::AddCycles(m_vdp->updateDMA());
@@ -302,14 +306,18 @@ FORCE_INLINE void EmuPico::T_execLine(void)
 	switch (LineType) {
 		case LINETYPE_ACTIVEDISPLAY:
 			// In visible area.
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, true);	// HBlank = 1
-			M68K::Exec(M68K_Mem::Cycles_M68K - 404);
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
+			m_vdp->startHBlank(Scheduler::ToM68K(
+				Scheduler::LineStart() + Scheduler::MCLK_HBLANK_END));
 
 			// Decrement the HInt counter.
-			// If it goes below 0, an HBLANK interrupt will occur.
-			// The counter will then be reloaded.
-			m_vdp->decrementHIntCounter(true);
+			// If it goes below 0, an HBLANK interrupt will occur
+			// at the end of HBlank. Otherwise, the 68000 doesn't
+			// need to be stopped on this line.
+			if (m_vdp->isHIntCounterExpiring()) {
+				Scheduler::Schedule(Scheduler::EVENT_HINT, Scheduler::MCLK_HBLANK_END);
+			} else {
+				m_vdp->decrementHIntCounter(true);
+			}
 			break;
 
 		case LINETYPE_VBLANKLINE: {
@@ -323,7 +331,8 @@ FORCE_INLINE void EmuPico::T_execLine(void)
 			CONGRATULATIONS_PRECHECK();
 #endif
 			// VBlank = 1 et HBlank = 1 (retour de balayage vertical en cours)
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, true);
+			m_vdp->startHBlank(Scheduler::ToM68K(
+				Scheduler::LineStart() + Scheduler::MCLK_VINT));
 			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_VBLANK, true);
 
 			// If we're using NTSC V30 and this is an "even" frame,
@@ -331,18 +340,7 @@ FORCE_INLINE void EmuPico::T_execLine(void)
 			if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div != 0)
 				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_VBLANK, false);
 
-			M68K::Exec(M68K_Mem::Cycles_M68K - 360);
-#if 0
-			// TODO: Congratulations! (LibGens)
-			CONGRATULATIONS_POSTCHECK();
-#endif
-
-			m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
-			if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div == 0) {
-				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_F, true);	// V Int happened
-				m_vdp->updateIRQLine(0x8);
-			}
-
+			Scheduler::Schedule(Scheduler::EVENT_VINT, Scheduler::MCLK_VINT);
 			break;
 		}
 
@@ -351,6 +349,34 @@ FORCE_INLINE void EmuPico::T_execLine(void)
 			break;
 	}
 
+	// Run the 68000 up to each event on this line.
+	Scheduler::Event_t event;
+	int mclk;
+	while ((event = Scheduler::NextEvent(&mclk)) != Scheduler::EVENT_NONE) {
+		switch (event) {
+			case Scheduler::EVENT_HINT:
+				M68K::Exec(Scheduler::ToM68K(mclk));
+				m_vdp->decrementHIntCounter(true);
+				break;
+
+			case Scheduler::EVENT_VINT:
+				M68K::Exec(Scheduler::ToM68K(mclk));
+#if 0
+				// TODO: Congratulations! (LibGens)
+				CONGRATULATIONS_POSTCHECK();
+#endif
+				m_vdp->setStatusBit(VdpStatus::VDP_STATUS_HBLANK, false);	// HBlank = 0
+				if (m_vdp->VDP_Lines.NTSC_V30.VBlank_Div == 0) {
+					m_vdp->setStatusBit(VdpStatus::VDP_STATUS_F, true);	// V Int happened
+					m_vdp->updateIRQLine(0x8);
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
 	if (VDP) {
 		// VDP needs to be updated.
 		m_vdp->renderLine();
@@ -0,0 +1,69 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Scheduler.cpp: Master clock event scheduler.                            *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "Scheduler.hpp"
+
+namespace LibGens {
+
+EMU_THREAD_LOCAL int Scheduler::ms_LineStart = 0;
+EMU_THREAD_LOCAL int Scheduler::ms_Events[Scheduler::EVENT_MAX] = {-1, -1, -1};
+
+/**
+ * Start a new scanline.
+ * All pending events are cancelled.
+ * @param line Line number, relative to the start of the frame.
+ */
+void Scheduler::StartLine(int line)
+{
+	ms_LineStart = line * MCLK_PER_LINE;
+	for (int i = 0; i < EVENT_MAX; i++) {
+		ms_Events[i] = -1;
+	}
+}
+
+/**
+ * Get the next pending event on the current line.
+ * The event is removed from the schedule.
+ * @param mclk Output: Timestamp, in master clock cycles from the start of the frame.
+ * @return Next event, or EVENT_NONE if no events are pending.
+ */
+Scheduler::Event_t Scheduler::NextEvent(int *mclk)
+{
+	// Find the earliest event.
+	// If two events have the same timestamp,
+	// the one with the lower ID is returned first.
+	int next = EVENT_NONE;
+	for (int i = 0; i < EVENT_MAX; i++) {
+		if (ms_Events[i] >= 0 &&
+		    (next == EVENT_NONE || ms_Events[i] < ms_Events[next]))
+		{
+			next = i;
+		}
+	}
+
+	if (next != EVENT_NONE) {
+		*mclk = ms_LineStart + ms_Events[next];
+		ms_Events[next] = -1;
+	}
+	return (Event_t)next;
+}
+
+}
@@ -0,0 +1,192 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Scheduler.hpp: Master clock event scheduler.                            *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __LIBGENS_EMUCONTEXT_SCHEDULER_HPP__
+#define __LIBGENS_EMUCONTEXT_SCHEDULER_HPP__
+
+// Thread-local storage for multi-context builds.
+#include "libgens/macros/tls.h"
+
+namespace LibGens {
+
+/**
+ * Master clock event scheduler.
+ *
+ * All timing is based on the master clock, with 3420
+ * master clock cycles per scanline. The 68000 runs at
+ * MCLK/7, and the Z80 runs at MCLK/15.
+ *
+ * Events are scheduled relative to the start of the current
+ * line. The emulation loop runs each CPU up to the next event
+ * that affects it, handles the event, and then runs the CPUs
+ * to the end of the line. Lines with no events are run in a
+ * single timeslice per CPU.
+ *
+ * Scope: The scheduler only handles interrupts, and timeslices
+ * never cross a line boundary. Everything else is still updated
+ * once per line by EmuMD/EmuPico::T_execLine():
+ * - DMA bandwidth is charged at the start of the line.
+ * - YM2612 timers and DAC are updated at the start of the line,
+ *   since the sound buffers are written per line.
+ * - Rendering and controller scanline callbacks are per line.
+ * Moving these onto the scheduler would require cross-line
+ * timeslices, so events would have to be kept in frame time.
+ *
+ * HBlank end and VINT are at fixed master clock offsets, so NTSC
+ * and PAL use the same timing. HINT/VINT lines and H/V counter
+ * values are the same as with the old per-line CPL timing, except
+ * that PAL VINT is one 68000 cycle later. (See IntTimingTest.)
+ */
+class Scheduler
+{
+	public:
+		// Master clock cycles per scanline.
+		static const int MCLK_PER_LINE = 3420;
+
+		// Master clock dividers.
+		static const int MCLK_DIV_M68K = 7;
+		static const int MCLK_DIV_Z80 = 15;
+
+		/**
+		 * Event timestamps, in master clock cycles
+		 * from the start of the line.
+		 */
+		static const int MCLK_HBLANK_END = (84 * MCLK_DIV_M68K);	// End of HBlank. (active display)
+		static const int MCLK_VINT = (128 * MCLK_DIV_M68K);		// 68000 VINT.
+		static const int MCLK_VINT_Z80 = (60 * MCLK_DIV_Z80);		// Z80 VINT.
+
+		/**
+		 * Events.
+		 */
+		enum Event_t {
+			EVENT_NONE = -1,
+
+			EVENT_HINT = 0,		// 68000 HINT.
+			EVENT_VINT,		// 68000 VINT.
+			EVENT_VINT_Z80,		// Z80 VINT.
+
+			EVENT_MAX
+		};
+
+		/**
+		 * Start a new scanline.
+		 * All pending events are cancelled.
+		 * @param line Line number, relative to the start of the frame.
+		 */
+		static void StartLine(int line);
+
+		/**
+		 * Schedule an event on the current line.
+		 * @param event Event.
+		 * @param mclk Timestamp, in master clock cycles from the start of the line.
+		 */
+		static inline void Schedule(Event_t event, int mclk);
+
+		/**
+		 * Get the next pending event on the current line.
+		 * The event is removed from the schedule.
+		 * @param mclk Output: Timestamp, in master clock cycles from the start of the frame.
+		 * @return Next event, or EVENT_NONE if no events are pending.
+		 */
+		static Event_t NextEvent(int *mclk);
+
+		/**
+		 * Convert a master clock timestamp to 68000 cycles.
+		 * @param mclk Timestamp, in master clock cycles from the start of the frame.
+		 * @return 68000 cycles from the start of the frame.
+		 */
+		static inline int ToM68K(int mclk);
+
+		/**
+		 * Convert a master clock timestamp to Z80 cycles.
+		 * @param mclk Timestamp, in master clock cycles from the start of the frame.
+		 * @return Z80 cycles from the start of the frame.
+		 */
+		static inline int ToZ80(int mclk);
+
+		/**
+		 * Get the start of the current line.
+		 * @return Start of the current line, in master clock cycles from the start of the frame.
+		 */
+		static inline int LineStart(void);
+
+		/**
+		 * Get the end of the current line.
+		 * @return End of the current line, in master clock cycles from the start of the frame.
+		 */
+		static inline int LineEnd(void);
+
+	private:
+		// Start of the current line.
+		static EMU_THREAD_LOCAL int ms_LineStart;
+
+		// Pending events, in master clock cycles from the start of the line.
+		// -1 if the event isn't scheduled.
+		static EMU_THREAD_LOCAL int ms_Events[EVENT_MAX];
+
+	private:
+		Scheduler() { }
+		~Scheduler() { }
+};
+
+/**
+ * Schedule an event on the current line.
+ * @param event Event.
+ * @param mclk Timestamp, in master clock cycles from the start of the line.
+ */
+inline void Scheduler::Schedule(Event_t event, int mclk)
+{
+	ms_Events[event] = mclk;
+}
+
+/**
+ * Convert a master clock timestamp to 68000 cycles.
+ * @param mclk Timestamp, in master clock cycles from the start of the frame.
+ * @return 68000 cycles from the start of the frame.
+ */
+inline int Scheduler::ToM68K(int mclk)
+	{ return (mclk / MCLK_DIV_M68K); }
+
+/**
+ * Convert a master clock timestamp to Z80 cycles.
+ * @param mclk Timestamp, in master clock cycles from the start of the frame.
+ * @return Z80 cycles from the start of the frame.
+ */
+inline int Scheduler::ToZ80(int mclk)
+	{ return (mclk / MCLK_DIV_Z80); }
+
+/**
+ * Get the start of the current line.
+ * @return Start of the current line, in master clock cycles from the start of the frame.
+ */
+inline int Scheduler::LineStart(void)
+	{ return ms_LineStart; }
+
+/**
+ * Get the end of the current line.
+ * @return End of the current line, in master clock cycles from the start of the frame.
+ */
+inline int Scheduler::LineEnd(void)
+	{ return ms_LineStart + MCLK_PER_LINE; }
+
+}
+
+#endif /* __LIBGENS_EMUCONTEXT_SCHEDULER_HPP__ */
@@ -45,6 +45,7 @@ MdFb::MdFb()
 	// Color depth.
 	, m_bpp(BPP_32)
 	, m_fb(nullptr)
+	, m_lineHashing(false)
 	// Image parameters.
 	, m_imgWidth(m_pxPerLine)
 	, m_imgHeight(m_numLines)
@@ -62,6 +63,12 @@ MdFb::~MdFb() {
  * Reinitialize the framebuffer.
  */
 void MdFb::reinitFb(void) {
+	// Dirty line tracking.
+	// The new framebuffer is entirely dirty.
+	m_dirtyLines.resize((m_numLines + 31) / 32);
+	m_lineHash.resize(m_numLines);
+	markAllLinesDirty();
+
 	// Free and reallocate the framebuffer.
 	// An extra 16 pixels are allocated to prevent overrunning
 	// the framebuffer if pxPitch is used at the first pixel.
@@ -86,6 +93,107 @@ void MdFb::reinitFb(void) {
 	}
 }
 
+/** Dirty line tracking. **/
+
+/**
+ * Mark all lines as dirty.
+ * This must be called if the framebuffer is modified
+ * without using markLineDirty(). Line hashes are
+ * invalidated, since they no longer match the contents.
+ */
+void MdFb::markAllLinesDirty(void)
+{
+	const int words = (int)m_dirtyLines.size();
+	for (int i = 0; i < words; i++) {
+		m_dirtyLines[i] = ~0U;
+	}
+
+	// Don't set bits past the last line.
+	if (m_numLines & 31) {
+		m_dirtyLines[words - 1] = (1U << (m_numLines & 31)) - 1;
+	}
+
+	// Invalidate the line hashes.
+	if (!m_lineHash.empty()) {
+		memset(m_lineHash.data(), 0, m_lineHash.size() * sizeof(uint32_t));
+	}
+}
+
+/**
+ * Is any line dirty?
+ * @return True if any line has changed since clearDirtyLines().
+ */
+bool MdFb::isAnyLineDirty(void) const
+{
+	uint32_t dirty = 0;
+	for (size_t i = 0; i < m_dirtyLines.size(); i++) {
+		dirty |= m_dirtyLines[i];
+	}
+	return (dirty != 0);
+}
+
+/**
+ * Enable or disable per-line hashing.
+ * If enabled, markLineDirty() hashes each rendered line
+ * and ignores lines that haven't changed, e.g. static
+ * menus and letterboxed areas.
+ * @param lineHashing If true, enable per-line hashing.
+ */
+void MdFb::setLineHashing(bool lineHashing)
+{
+	if (m_lineHashing == lineHashing)
+		return;
+	m_lineHashing = lineHashing;
+	markAllLinesDirty();
+}
+
+/**
+ * Hash a line and compare it to the previous hash.
+ * @param line Line number.
+ * @return True if the line has changed.
+ */
+bool MdFb::updateLineHash(int line)
+{
+	// Hash the visible part of the line using four independent
+	// multiply/xor lanes, 32 bytes per iteration.
+	// pxPerLine is a multiple of 16, so there's no tail.
+	const uint64_t *px;
+	unsigned int count;
+	if (m_bpp != BPP_32) {
+		px = reinterpret_cast<const uint64_t*>(lineBuf16(line));
+		count = (m_pxPerLine * sizeof(uint16_t)) / sizeof(uint64_t);
+	} else {
+		px = reinterpret_cast<const uint64_t*>(lineBuf32(line));
+		count = (m_pxPerLine * sizeof(uint32_t)) / sizeof(uint64_t);
+	}
+
+	static const uint64_t K = 0x9E3779B97F4A7C15ULL;
+	uint64_t h0 = 0, h1 = 1, h2 = 2, h3 = 3;
+	for (; count >= 4; count -= 4, px += 4) {
+		h0 = (h0 ^ px[0]) * K;
+		h1 = (h1 ^ px[1]) * K;
+		h2 = (h2 ^ px[2]) * K;
+		h3 = (h3 ^ px[3]) * K;
+	}
+	for (; count > 0; count--, px++) {
+		h0 = (h0 ^ px[0]) * K;
+	}
+
+	// Combine the lanes.
+	uint64_t h = h0;
+	h = (h ^ (h1 >> 7) ^ (h1 << 57)) * K;
+	h = (h ^ (h2 >> 13) ^ (h2 << 51)) * K;
+	h = (h ^ (h3 >> 19) ^ (h3 << 45)) * K;
+	h ^= (h >> 32);
+
+	// Bit 0 is always set so a valid hash is never 0.
+	const uint32_t hash = ((uint32_t)h | 1);
+	if (m_lineHash[line] == hash)
+		return false;
+	m_lineHash[line] = hash;
+	return true;
+}
+
 /** Convenience functions. **/
 
 /**
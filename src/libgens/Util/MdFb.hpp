@@ -66,6 +66,74 @@ class MdFb
 		ColorDepth bpp(void) const;
 		void setBpp(ColorDepth bpp);
 
+		/** Dirty line tracking. **/
+
+		/**
+		 * Mark a line as dirty.
+		 * Called by the VDP renderer after writing a line.
+		 * If line hashing is enabled, the line is only marked
+		 * as dirty if its contents have actually changed.
+		 * @param line Line number.
+		 */
+		void markLineDirty(int line);
+
+		/**
+		 * Mark all lines as dirty.
+		 * This must be called if the framebuffer is modified
+		 * without using markLineDirty(). Line hashes are
+		 * invalidated, since they no longer match the contents.
+		 */
+		void markAllLinesDirty(void);
+
+		/**
+		 * Is the specified line dirty?
+		 * @param line Line number.
+		 * @return True if the line has changed since clearDirtyLines().
+		 */
+		bool isLineDirty(int line) const;
+
+		/**
+		 * Is any line dirty?
+		 * @return True if any line has changed since clearDirtyLines().
+		 */
+		bool isAnyLineDirty(void) const;
+
+		/**
+		 * Clear the dirty line bitmap.
+		 * Called by the frontend after uploading the dirty lines.
+		 */
+		void clearDirtyLines(void);
+
+		/**
+		 * Get the dirty line bitmap.
+		 * Bit (line & 31) of word (line >> 5) is set if the line is dirty.
+		 * @return Dirty line bitmap, with (numLines() + 31) / 32 words.
+		 */
+		const uint32_t *dirtyLines(void) const;
+
+		/**
+		 * Is per-line hashing enabled?
+		 * @return True if per-line hashing is enabled.
+		 */
+		bool lineHashing(void) const;
+
+		/**
+		 * Enable or disable per-line hashing.
+		 * If enabled, markLineDirty() hashes each rendered line
+		 * and ignores lines that haven't changed, e.g. static
+		 * menus and letterboxed areas.
+		 * @param lineHashing If true, enable per-line hashing.
+		 */
+		void setLineHashing(bool lineHashing);
+
+		/**
+		 * Get the hash of the specified line.
+		 * Only valid if per-line hashing is enabled.
+		 * @param line Line number.
+		 * @return Hash of the line as of the last markLineDirty(), or 0 if unknown.
+		 */
+		uint32_t lineHash(int line) const;
+
 		// Line access.
 		uint16_t *lineBuf16(int line);
 		const uint16_t *lineBuf16(int line) const;
@@ -203,6 +271,27 @@ class MdFb
 		 */
 		std::vector<uint32_t> m_lineNumTable;
 
+		/**
+		 * Dirty line bitmap.
+		 * One bit per line; set by markLineDirty().
+		 */
+		std::vector<uint32_t> m_dirtyLines;
+
+		/**
+		 * Per-line hashes.
+		 * Only used if m_lineHashing is set.
+		 * 0 indicates the hash is unknown.
+		 */
+		std::vector<uint32_t> m_lineHash;
+		bool m_lineHashing;
+
+		/**
+		 * Hash a line and compare it to the previous hash.
+		 * @param line Line number.
+		 * @return True if the line has changed.
+		 */
+		bool updateLineHash(int line);
+
 		/**
 		 * Reinitialize the framebuffer.
 		 */
@@ -244,6 +333,7 @@ inline void MdFb::unref(void) const
 inline void MdFb::clear(void)
 {
 	memset(m_fb, 0x00, m_fb_sz);
+	markAllLinesDirty();
 }
 
 /** Color depth. **/
@@ -251,7 +341,61 @@ inline void MdFb::clear(void)
 inline MdFb::ColorDepth MdFb::bpp(void) const
 	{ return m_bpp; }
 inline void MdFb::setBpp(ColorDepth bpp)
-	{ m_bpp = bpp; }
+{
+	if (m_bpp == bpp)
+		return;
+	m_bpp = bpp;
+	markAllLinesDirty();
+}
+
+/** Dirty line tracking. **/
+
+/**
+ * Mark a line as dirty.
+ * Called by the VDP renderer after writing a line.
+ * If line hashing is enabled, the line is only marked
+ * as dirty if its contents have actually changed.
+ * @param line Line number.
+ */
+inline void MdFb::markLineDirty(int line)
+{
+	assert(line >= 0 && line < m_numLines);
+	if (m_lineHashing && !updateLineHash(line))
+		return;
+	m_dirtyLines[line >> 5] |= (1U << (line & 31));
+}
+
+/**
+ * Is the specified line dirty?
+ * @param line Line number.
+ * @return True if the line has changed since clearDirtyLines().
+ */
+inline bool MdFb::isLineDirty(int line) const
+{
+	assert(line >= 0 && line < m_numLines);
+	return !!(m_dirtyLines[line >> 5] & (1U << (line & 31)));
+}
+
+/**
+ * Clear the dirty line bitmap.
+ * Called by the frontend after uploading the dirty lines.
+ */
+inline void MdFb::clearDirtyLines(void)
+{
+	memset(m_dirtyLines.data(), 0, m_dirtyLines.size() * sizeof(uint32_t));
+}
+
+inline const uint32_t *MdFb::dirtyLines(void) const
+	{ return m_dirtyLines.data(); }
+
+inline bool MdFb::lineHashing(void) const
+	{ return m_lineHashing; }
+
+inline uint32_t MdFb::lineHash(int line) const
+{
+	assert(line >= 0 && line < m_numLines);
+	return (m_lineHashing ? m_lineHash[line] : 0);
+}
 
 /** Line access. **/
 // TODO: Assert on incorrect color depth.
@@ -38,6 +38,7 @@
 // Private classes.
 #include "Vdp_p.hpp"
 #include "VdpRend_Err_p.hpp"
+#include "VdpRendThread.hpp"
 
 namespace LibGens {
 
@@ -55,12 +56,15 @@ const VdpTypes::VdpEmuOptions_t VdpPrivate::def_vdpEmuOptions = {
 	true,				// vscrollBug
 	false,				// updatePaletteInVBlankOnly
 	true,				// enableInterlacedMode
+	false,				// layerCompositing
 };
 
 VdpPrivate::VdpPrivate(Vdp *q)
 	: q(q)
 	, VDP_Model(VdpTypes::VDP_MODEL_MD)	// TODO: Add support for more models.
 	, VRam_Mask(0xFFFF)	// Always ensure this mask is valid.
+	, rendThread(nullptr)
+	, trace(nullptr)
 	, d_err(new VdpRend_Err_Private(q))
 {
 	// TODO: Initialize all private variables.
@@ -116,6 +120,12 @@ Vdp::Vdp(MdFb *fb)
  */
 Vdp::~Vdp(void)
 {
+	// Stop the rendering thread.
+	delete d->rendThread;
+
+	// Delete the trace buffer.
+	delete d->trace;
+
 	// Shut down the VDP rendering subsystem.
 	d->rend_end();
 
@@ -128,14 +138,21 @@ Vdp::~Vdp(void)
  */
 void Vdp::reset(void)
 {
+	// Wait for the rendering thread.
+	// rend_reset() clears the framebuffer.
+	if (d->rendThread)
+		d->rendThread->sync();
+
 	// Reset the VDP rendering arrays.
 	d->rend_reset();
 
 	// Clear VRam and VSRam.
 	memset(&d->VRam, 0, sizeof(d->VRam));
 	memset(&d->VSRam, 0, sizeof(d->VSRam));
+	d->patternCache.invalidate();
 	// Clear the Sprite Attribute Table cache.
 	memset(&d->SprAttrTbl_m5.b, 0, sizeof(d->SprAttrTbl_m5.b));
+	d->markSprBinsDirty();
 	// Clear the sprite line cache.
 	memset(d->sprLineCache, 0, sizeof(d->sprLineCache));
 	memset(d->sprCountCache, 0, sizeof(d->sprCountCache));
@@ -164,6 +181,11 @@ void Vdp::reset(void)
 
 	// Initialize the Horizontal Interrupt counter.
 	d->HInt_Counter = d->VDP_Reg.m5.H_Int;
+	d->HBlank_End = 0;
+
+	// Reset the rendering thread's VDP state.
+	if (d->rendThread)
+		d->rendThread->resync();
 }
 
 /**
@@ -276,6 +298,10 @@ void Vdp::updateVdpLines(bool resetCurrent)
 		// Reset VDP_Lines.currentLine.
 		// NOTE: VDP starts at visible line 0.
 		VDP_Lines.currentLine = 0;
+
+		// New frame.
+		if (d->trace)
+			d->trace->nextFrame();
 	}
 
 	// Check interlaced mode.
@@ -369,6 +395,29 @@ void Vdp::decrementHIntCounter(bool reload)
 	}
 }
 
+/**
+ * Check if the HINT counter will expire on the next decrement.
+ * @return True if decrementHIntCounter() will raise an HBLANK interrupt.
+ */
+bool Vdp::isHIntCounterExpiring(void) const
+{
+	return (d->HInt_Counter <= 0);
+}
+
+/**
+ * Start HBlank on the current line.
+ * This sets the HBLANK flag. The flag is cleared on the
+ * first status register read after the 68000 reaches
+ * the end of HBlank, so the 68000 doesn't need to be
+ * stopped there.
+ * @param end 68000 cycle at which HBlank ends.
+ */
+void Vdp::startHBlank(unsigned int end)
+{
+	d->Reg_Status.setBit(VdpStatus::VDP_STATUS_HBLANK, true);
+	d->HBlank_End = end;
+}
+
 /** ZOMG!!1! **/
 
 /**
@@ -381,6 +430,10 @@ void Vdp::zomgSaveMD(LibZomg::Zomg *zomg) const
 	// TODO: Assert if called when not emulating MD VDP.
 	// TODO: Error handling.
 
+	// Make sure the status register is up to date.
+	if (d->rendThread)
+		d->rendThread->sync();
+
 	// Save the user-accessible VDP registers.
 	// TODO: Move "24" to a const somewhere.
 	zomg->saveVdpReg(d->VDP_Reg.reg, 24);
@@ -485,6 +538,7 @@ void Vdp::zomgRestoreMD(LibZomg::Zomg *zomg)
 
 	// Load VRam.
 	zomg->loadVRam(d->VRam.u16, sizeof(d->VRam.u16), ZOMG_BYTEORDER_16H);
+	d->patternCache.invalidate();
 
 	// Load CRam.
 	Zomg_CRam_t cram;
@@ -524,6 +578,8 @@ void Vdp::zomgRestoreMD(LibZomg::Zomg *zomg)
 		}
 	}
 
+	d->markSprBinsDirty();
+
 	// Clear the sprite dot overflow flag.
 	d->sprDotOverflow = false;
 
@@ -546,6 +602,50 @@ void Vdp::zomgRestoreMD(LibZomg::Zomg *zomg)
 		// Sprite overflow!
 		d->Reg_Status.setBit(VdpStatus::VDP_STATUS_SOVR, true);
 	}
+
+	// Reload the rendering thread's VDP state.
+	if (d->rendThread)
+		d->rendThread->resync();
+}
+
+/** Port write trace. **/
+
+/**
+ * Enable or disable the port write trace.
+ * If enabled, control port writes, data port writes,
+ * and DMA triggers are recorded in a ring buffer.
+ * Disabling the trace discards the recorded entries.
+ * @param enable True to enable; false to disable.
+ */
+void Vdp::setTracing(bool enable)
+{
+	if (enable == !!d->trace)
+		return;
+
+	if (enable) {
+		d->trace = new VdpTrace();
+	} else {
+		delete d->trace;
+		d->trace = nullptr;
+	}
+}
+
+/**
+ * Is the port write trace enabled?
+ * @return True if the port write trace is enabled.
+ */
+bool Vdp::isTracing(void) const
+{
+	return !!d->trace;
+}
+
+/**
+ * Get the port write trace buffer.
+ * @return Trace buffer, or nullptr if tracing is disabled.
+ */
+const VdpTrace *Vdp::trace(void) const
+{
+	return d->trace;
 }
 
 }
@@ -42,6 +42,7 @@ namespace LibZomg {
 namespace LibGens {
 
 class VdpPrivate;
+class VdpTrace;
 class Vdp
 {
 	public:
@@ -51,6 +52,7 @@ class Vdp
 
 	protected:
 		friend class VdpPrivate;
+		friend class VdpRendThread;
 		VdpPrivate *const d;
 	private:
 		// Q_DISABLE_COPY() equivalent.
@@ -132,6 +134,22 @@ class Vdp
 		 */
 		void decrementHIntCounter(bool reload);
 
+		/**
+		 * Check if the HINT counter will expire on the next decrement.
+		 * @return True if decrementHIntCounter() will raise an HBLANK interrupt.
+		 */
+		bool isHIntCounterExpiring(void) const;
+
+		/**
+		 * Start HBlank on the current line.
+		 * This sets the HBLANK flag. The flag is cleared on the
+		 * first status register read after the 68000 reaches
+		 * the end of HBlank, so the 68000 doesn't need to be
+		 * stopped there.
+		 * @param end 68000 cycle at which HBlank ends.
+		 */
+		void startHBlank(unsigned int end);
+
 		/**
 		 * Set a bit in the status register.
 		 * Wrapper for VdpStatus::setBit().
@@ -154,6 +172,41 @@ class Vdp
 		 */
 		void renderLine(void);
 
+		/**
+		 * Enable or disable threaded rendering.
+		 * If enabled, lines are rendered by a worker thread.
+		 * The framebuffer is complete at the end of each frame.
+		 * @param enable True to enable; false to disable.
+		 */
+		void setThreadedRendering(bool enable);
+
+		/**
+		 * Is threaded rendering enabled?
+		 * @return True if threaded rendering is enabled.
+		 */
+		bool isThreadedRendering(void) const;
+
+		/**
+		 * Enable or disable the port write trace.
+		 * If enabled, control port writes, data port writes,
+		 * and DMA triggers are recorded in a ring buffer.
+		 * Disabling the trace discards the recorded entries.
+		 * @param enable True to enable; false to disable.
+		 */
+		void setTracing(bool enable);
+
+		/**
+		 * Is the port write trace enabled?
+		 * @return True if the port write trace is enabled.
+		 */
+		bool isTracing(void) const;
+
+		/**
+		 * Get the port write trace buffer.
+		 * @return Trace buffer, or nullptr if tracing is disabled.
+		 */
+		const VdpTrace *trace(void) const;
+
 	public:
 		/** MD-side interface. **/
 		// NOTE: Byte-wide MD ctrl/data functions are
@@ -166,6 +219,7 @@ class Vdp
 
 		// Control port; $C00004 [mirror: 06]
 		uint16_t readCtrlMD(void);	// status register
+		bool isStatusStable(void) const;	// idle loop detection
 		void writeCtrlMD(uint16_t ctrl);
 		void writeCtrlMD_8(uint8_t ctrl);
 
@@ -30,6 +30,9 @@ using namespace LibGens::VdpTypes;
 
 namespace LibGens {
 
+// Mode 4 lookup table.
+uint32_t VdpCache::m4_lut[65536];
+
 VdpCache::VdpCache()
 	: dirty_idx(0)
 {
@@ -41,9 +44,15 @@ VdpCache::VdpCache()
 	// only checked if dirty_idx > 0.
 
 	// Initialize the Mode 4 lookup table.
-	init_m4_lut();
+	// NOTE: The table is shared by all threads.
+	// A function-local static is initialized exactly once.
+	static const bool isInit = (init_m4_lut(), true);
+	((void)isInit);
 }
 
+VdpCache::~VdpCache()
+{ }
+
 /**
  * Initialize the Mode 4 lookup table.
  */
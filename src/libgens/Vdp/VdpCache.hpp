@@ -40,8 +40,7 @@ namespace VdpTypes {
 }
 
 class VdpCache {
-	// NOTE: This class isn't currently in use.
-	private:
+	public:
 		VdpCache();
 		~VdpCache();
 
@@ -59,6 +58,26 @@ class VdpCache {
 		 */
 		void invalidate(void);
 
+		/**
+		 * Mark a VRAM address as dirty. (Mode 5)
+		 * @param address VRAM byte address.
+		 */
+		inline void mark_dirty_m5(uint32_t address);
+
+		/**
+		 * Mark a range of VRAM addresses as dirty. (Mode 5)
+		 * @param address VRAM byte address.
+		 * @param length Length, in bytes. (must not wrap around)
+		 */
+		inline void mark_dirty_m5_range(uint32_t address, uint32_t length);
+
+		/**
+		 * Check if any patterns need to be updated.
+		 * @return True if the cache is dirty.
+		 */
+		inline bool is_dirty(void) const
+			{ return (dirty_idx > 0); }
+
 		/**
 		 * Update the pattern cache. (Mode 4)
 		 * @param vram VRAM source data.
@@ -113,6 +132,15 @@ class VdpCache {
 		 */
 		inline uint32_t pattern_line_m5_spr_8x16(uint16_t attr, int y);
 
+		/**
+		 * Get a pattern line by VRAM address. (Mode 5)
+		 * Used for sprites, since multi-cell sprites
+		 * are addressed by VRAM offset instead of tile.
+		 * @param address VRAM byte address.
+		 * @param hflip If true, get the H-flipped line.
+		 */
+		inline uint32_t pattern_line_m5_addr(uint32_t address, bool hflip);
+
 	protected:
 		/**
 		 * Mode 4 lookup table.
@@ -122,13 +150,15 @@ class VdpCache {
 		 *
 		 * By looking up two bytes at a time, we can convert
 		 * two bitplanes into a partial packed pixel.
+		 *
+		 * NOTE: The table is shared by all VdpCache instances.
 		 */
-		uint32_t m4_lut[65536];
+		static uint32_t m4_lut[65536];
 
 		/**
 		 * Initialize the Mode 4 lookup table.
 		 */
-		void init_m4_lut(void);
+		static void init_m4_lut(void);
 
 		/**
 		 * Convert a Mode 4 pattern to Mode 5.
@@ -186,6 +216,45 @@ class VdpCache {
 		unsigned int dirty_idx;
 };
 
+/**
+ * Mark a VRAM address as dirty. (Mode 5)
+ * @param address VRAM byte address.
+ */
+inline void VdpCache::mark_dirty_m5(uint32_t address)
+{
+	// TODO: 128 KB support.
+	const unsigned int tile = (address >> 5) & 0x7FF;
+	if (dirty_flags[tile] == 0) {
+		// Tile isn't in the dirty list yet.
+		dirty_list[dirty_idx++] = tile;
+	}
+	dirty_flags[tile] |= (1 << ((address >> 2) & 7));
+}
+
+/**
+ * Mark a range of VRAM addresses as dirty. (Mode 5)
+ * @param address VRAM byte address.
+ * @param length Length, in bytes. (must not wrap around)
+ */
+inline void VdpCache::mark_dirty_m5_range(uint32_t address, uint32_t length)
+{
+	// TODO: 128 KB support.
+	const uint32_t end = address + length;
+	while (address < end) {
+		// Mark all lines in this tile that are within the range.
+		const uint32_t tile_end = ((address | 31) + 1 < end ? (address | 31) + 1 : end);
+		const unsigned int first = ((address >> 2) & 7);
+		const unsigned int last = (((tile_end - 1) >> 2) & 7);
+		const unsigned int tile = (address >> 5) & 0x7FF;
+		if (dirty_flags[tile] == 0) {
+			// Tile isn't in the dirty list yet.
+			dirty_list[dirty_idx++] = tile;
+		}
+		dirty_flags[tile] |= (uint8_t)((0xFF << first) & (0xFF >> (7 - last)));
+		address = tile_end;
+	}
+}
+
 /**
  * Get a pattern line. (Mode 4, nametable, 8x8 cell)
  * @param attr Nametable attribute word.
@@ -301,6 +370,19 @@ inline uint32_t VdpCache::pattern_line_m5_spr_8x16(uint16_t attr, int y)
 	return cache.x8[(attr >> 11) & 1][tile][y & 7];
 }
 
+/**
+ * Get a pattern line by VRAM address. (Mode 5)
+ * Used for sprites, since multi-cell sprites
+ * are addressed by VRAM offset instead of tile.
+ * @param address VRAM byte address.
+ * @param hflip If true, get the H-flipped line.
+ */
+inline uint32_t VdpCache::pattern_line_m5_addr(uint32_t address, bool hflip)
+{
+	// TODO: 128 KB support.
+	return cache.d[hflip][(address >> 2) & 0x3FFF];
+}
+
 }
 
 #endif /* __LIBGENS_MD_VDPCACHE_HPP__ */
@@ -24,6 +24,7 @@
 
 #include "Vdp.hpp"
 #include "Vdp_p.hpp"
+#include "VdpRendThread.hpp"
 
 // C includes. (C++ namespace)
 #include <stdlib.h>
@@ -177,6 +178,7 @@ int Vdp::dbg_writeVRam_16(uint32_t address, const uint16_t *vram, int length)
 	}
 
 	memcpy(&d->VRam.u16[address>>1], vram, length);
+	d->patternCache.invalidate();
 
 	// Check if the VRAM write overlaps the Sprite Attribute Table.
 	// TODO: Optimize this into a few calculations and a memcpy.
@@ -184,6 +186,7 @@ int Vdp::dbg_writeVRam_16(uint32_t address, const uint16_t *vram, int length)
 		if ((address & d->Spr_Tbl_Mask) == d->Spr_Tbl_Addr) {
 			// Sprite Attribute Table.
 			d->SprAttrTbl_m5.w[(address & ~d->Spr_Tbl_Mask) >> 1] = *vram;
+			d->markSprBinsDirty();
 		}
 	}
 
@@ -193,6 +196,8 @@ int Vdp::dbg_writeVRam_16(uint32_t address, const uint16_t *vram, int length)
 	uint32_t SAT_max = SAT_min + ~d->Spr_Tbl_Mask;
 	*/
 
+	if (d->rendThread)
+		d->rendThread->resync();
 	return 0;
 }
 
@@ -217,6 +222,9 @@ int Vdp::dbg_writeCRam_16(uint8_t address, const uint16_t *cram, int length)
 	for (; length > 0; address += 2, length -= 2, cram++) {
 		d->palette.writeCRam_16(address, *cram);
 	}
+
+	if (d->rendThread)
+		d->rendThread->resync();
 	return 0;
 }
 
@@ -240,6 +248,9 @@ int Vdp::dbg_writeVSRam_16(uint8_t address, const uint16_t *vsram, int length)
 	}
 
 	memcpy(&d->VSRam.u16[address>>1], vsram, length);
+
+	if (d->rendThread)
+		d->rendThread->resync();
 	return 0;
 }
 
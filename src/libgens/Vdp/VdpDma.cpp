@@ -25,6 +25,7 @@
 
 #include "Vdp.hpp"
 #include "Vdp_p.hpp"
+#include "VdpRendThread.hpp"
 
 // LOG_MSG() subsystem.
 #include "macros/log_msg.h"
@@ -71,16 +72,7 @@ void VdpPrivate::DMA_Fill(uint16_t data)
 	switch (VDP_Ctrl.code & VdpTypes::CD_DEST_MODE_MASK) {
 		case VdpTypes::CD_DEST_VRAM_WRITE:
 			// Write to VRAM.
-			do {
-				// NOTE: DMA FILL writes to the adjacent byte.
-				VRam.u8[address ^ 1 ^ U16DATA_U8_INVERT] = fill_hi;
-				if ((address & Spr_Tbl_Mask) == Spr_Tbl_Addr) {
-					// Sprite Attribute Table.
-					SprAttrTbl_m5.b[(address & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT] = fill_hi;
-				}
-				address += VDP_Reg.m5.Auto_Inc;
-				address &= VRam_Mask;
-			} while (--length != 0);
+			address = DMA_Fill_VRam(address, q->DMAT_Length, fill_hi);
 			break;
 
 		case VdpTypes::CD_DEST_CRAM_WRITE:
@@ -88,6 +80,8 @@ void VdpPrivate::DMA_Fill(uint16_t data)
 			// TODO: FIFO emulation.
 			do {
 				palette.writeCRam_16((address & 0x7E), data);
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_CRAM_16, (address & 0x7E), data);
 				address += VDP_Reg.m5.Auto_Inc;
 				address &= VRam_Mask;
 			} while (--length != 0);
@@ -98,6 +92,8 @@ void VdpPrivate::DMA_Fill(uint16_t data)
 			// TODO: FIFO emulation.
 			do {
 				VSRam.u16[(address & 0x7E) >> 1] = data;
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_VSRAM_16, (address & 0x7E) >> 1, data);
 				address += VDP_Reg.m5.Auto_Inc;
 				address &= VRam_Mask;
 			} while (--length != 0);
@@ -119,6 +115,343 @@ void VdpPrivate::DMA_Fill(uint16_t data)
 	inc_DMA_Src_Adr(q->DMAT_Length);
 }
 
+/**
+ * Update the Sprite Attribute Table cache after a VRam DMA block write.
+ * Byte k of the block was written for VRam address (address + (inc * k)).
+ * The block must not wrap around.
+ * @param address First VRam address.
+ * @param inc Address increment.
+ * @param count Number of bytes written.
+ * @param vram_xor XOR value for the VRam.u8[] index of each byte.
+ */
+void VdpPrivate::DMA_Update_SAT_8(uint32_t address, unsigned int inc, unsigned int count, unsigned int vram_xor)
+{
+	const uint32_t spr_start = Spr_Tbl_Addr;
+	const uint32_t spr_end = spr_start + ((~Spr_Tbl_Mask) & 0xFFFF) + 1;
+
+	// Determine which bytes are within the SAT.
+	unsigned int k_first = 0, k_last = count;
+	if (address < spr_start)
+		k_first = ((spr_start - address) + inc - 1) / inc;
+	if (address >= spr_end) {
+		k_last = 0;
+	} else {
+		const unsigned int k_end = ((spr_end - address) + inc - 1) / inc;
+		if (k_last > k_end)
+			k_last = k_end;
+	}
+	if (k_first >= k_last)
+		return;
+
+	for (unsigned int k = k_first; k < k_last; k++) {
+		const uint32_t cur = address + (inc * k);
+		const uint8_t data = VRam.u8[cur ^ vram_xor];
+		SprAttrTbl_m5.b[(cur & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT] = data;
+		if (rendThread)
+			rendThread->logWrite(VdpRendThread::LOG_SAT_8, (cur & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT, data);
+	}
+	markSprBinsDirty();
+}
+
+/**
+ * Log a range of VRam words to the rendering thread.
+ * @param first First VRam.u8[] index.
+ * @param last Last VRam.u8[] index. (inclusive)
+ */
+void VdpPrivate::DMA_Log_VRam_Range(uint32_t first, uint32_t last)
+{
+	for (uint32_t w = (first >> 1); w <= (last >> 1); w++) {
+		rendThread->logWrite(VdpRendThread::LOG_VRAM_16, w, VRam.u16[w]);
+	}
+}
+
+/**
+ * DMA FILL to VRam.
+ * Auto-increment values of 1, 2, and 0x80 are handled in blocks.
+ * Other values are handled one byte at a time.
+ * @param address VRam address.
+ * @param length Number of bytes to write.
+ * @param fill Fill byte.
+ * @return New VRam address.
+ */
+uint32_t VdpPrivate::DMA_Fill_VRam(uint32_t address, unsigned int length, uint8_t fill)
+{
+	const unsigned int inc = VDP_Reg.m5.Auto_Inc;
+	while (length != 0) {
+		// Determine the number of bytes to write in this chunk.
+		// Blocks must not wrap around the end of VRam.
+		unsigned int n = length;
+		bool block = false;
+		if (inc == 1 || inc == 2 || inc == 0x80) {
+			n = ((VRam_Mask - address) / inc) + 1;
+			if (n > length)
+				n = length;
+			block = (n >= 8);
+			if (inc == 1) {
+				// Byte pairs are swapped, so blocks
+				// must start and end on word boundaries.
+				if (address & 1) {
+					n = 1;
+					block = false;
+				} else if (n & 1) {
+					n &= ~1;
+					if (n == 0)
+						n = 1;
+				}
+			}
+		}
+
+		if (!block) {
+			// Write one byte at a time.
+			for (unsigned int k = n; k != 0; k--) {
+				// NOTE: DMA FILL writes to the adjacent byte.
+				VRam.u8[address ^ 1 ^ U16DATA_U8_INVERT] = fill;
+				patternCache.mark_dirty_m5(address);
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_VRAM_8, address ^ 1 ^ U16DATA_U8_INVERT, fill);
+				if ((address & Spr_Tbl_Mask) == Spr_Tbl_Addr) {
+					// Sprite Attribute Table.
+					SprAttrTbl_m5.b[(address & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT] = fill;
+					markSprBinsDirty();
+					if (rendThread)
+						rendThread->logWrite(VdpRendThread::LOG_SAT_8, (address & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT, fill);
+				}
+				address += inc;
+				address &= VRam_Mask;
+			}
+			length -= n;
+			continue;
+		}
+
+		// NOTE: DMA FILL writes to the adjacent byte.
+		const uint32_t first = (address ^ 1 ^ U16DATA_U8_INVERT);
+		switch (inc) {
+			case 1:
+				// Contiguous words.
+				memset(&VRam.u8[address], fill, n);
+				patternCache.mark_dirty_m5_range(address, n);
+				if (rendThread)
+					DMA_Log_VRam_Range(address, address + n - 1);
+				break;
+
+			case 2: {
+				// Every other byte.
+				// Write 4 bytes at a time using 64-bit masking.
+				static const uint8_t mask_b[8] = {0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0};
+				const uint8_t fill_b[8] = {fill, 0, fill, 0, fill, 0, fill, 0};
+				uint64_t mask, fill64;
+				memcpy(&mask, mask_b, sizeof(mask));
+				memcpy(&fill64, fill_b, sizeof(fill64));
+
+				uint8_t *p = &VRam.u8[first];
+				unsigned int k = 0;
+				for (; (k + 4) < n; k += 4, p += 8) {
+					uint64_t tmp;
+					memcpy(&tmp, p, sizeof(tmp));
+					tmp = (tmp & ~mask) | fill64;
+					memcpy(p, &tmp, sizeof(tmp));
+				}
+				for (; k < n; k++, p += 2) {
+					*p = fill;
+				}
+
+				patternCache.mark_dirty_m5_range(address, (n * 2) - 1);
+				if (rendThread)
+					DMA_Log_VRam_Range(address, address + ((n - 1) * 2));
+				break;
+			}
+
+			default:
+				// 0x80: One byte per line.
+				for (unsigned int k = 0; k < n; k++) {
+					const uint32_t cur = address + (k * 0x80);
+					VRam.u8[first + (k * 0x80)] = fill;
+					patternCache.mark_dirty_m5(cur);
+					if (rendThread)
+						rendThread->logWrite(VdpRendThread::LOG_VRAM_8, first + (k * 0x80), fill);
+				}
+				break;
+		}
+
+		// Sprite Attribute Table.
+		DMA_Update_SAT_8(address, inc, n, 1 ^ U16DATA_U8_INVERT);
+
+		address += (inc * n);
+		address &= VRam_Mask;
+		length -= n;
+	}
+
+	return address;
+}
+
+/**
+ * DMA COPY within VRam.
+ * Auto-increment values of 1, 2, and 0x80 are handled in blocks
+ * if the source and destination don't overlap.
+ * Other values are handled one byte at a time.
+ * @param src_address	[in/out] Source address.
+ * @param dest_address	[in/out] Destination address.
+ * @param length	[in] Number of bytes to copy.
+ */
+void VdpPrivate::DMA_Copy_VRam(uint32_t *src_address, uint32_t *dest_address, unsigned int length)
+{
+	const unsigned int inc = VDP_Reg.m5.Auto_Inc;
+	uint32_t src = *src_address;
+	uint32_t dest = *dest_address;
+
+	while (length != 0) {
+		// Determine the number of bytes to copy in this chunk.
+		// Blocks must not wrap around the end of VRam.
+		unsigned int n = length;
+		bool block = false;
+		if (inc == 1 || inc == 2 || inc == 0x80) {
+			n = ((VRam_Mask - dest) / inc) + 1;
+			if (n > (VRam_Mask - src) + 1)
+				n = (VRam_Mask - src) + 1;
+			if (n > length)
+				n = length;
+			block = (n >= 8);
+
+			// The source and destination must not overlap,
+			// since later bytes may be copied from earlier bytes.
+			// Exception: A contiguous copy to a lower address
+			// is equivalent to memmove().
+			const uint32_t dest_last = dest + (inc * (n - 1));
+			if (dest <= (src + n - 1) && src <= dest_last &&
+			    !(inc == 1 && dest < src))
+			{
+				block = false;
+			}
+		}
+
+		if (!block) {
+			// Copy one byte at a time.
+			// TODO: Is this correct with regards to endianness?
+			for (unsigned int k = n; k != 0; k--) {
+				const uint8_t data = VRam.u8[src];
+				VRam.u8[dest] = data;
+				patternCache.mark_dirty_m5(dest);
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_VRAM_8, dest, data);
+				if ((dest & Spr_Tbl_Mask) == Spr_Tbl_Addr) {
+					// Sprite Attribute Table.
+					SprAttrTbl_m5.b[(dest & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT] = data;
+					markSprBinsDirty();
+					if (rendThread)
+						rendThread->logWrite(VdpRendThread::LOG_SAT_8, (dest & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT, data);
+				}
+
+				// Increment the addresses.
+				src = (src + 1) & VRam_Mask;
+				dest = (dest + inc) & VRam_Mask;
+			}
+			length -= n;
+			continue;
+		}
+
+		const uint8_t *p_src = &VRam.u8[src];
+		switch (inc) {
+			case 1:
+				memmove(&VRam.u8[dest], p_src, n);
+				patternCache.mark_dirty_m5_range(dest, n);
+				if (rendThread)
+					DMA_Log_VRam_Range(dest, dest + n - 1);
+				break;
+
+			case 2: {
+				uint8_t *p_dest = &VRam.u8[dest];
+				for (unsigned int k = 0; k < n; k++, p_dest += 2) {
+					*p_dest = p_src[k];
+				}
+				patternCache.mark_dirty_m5_range(dest, (n * 2) - 1);
+				if (rendThread)
+					DMA_Log_VRam_Range(dest, dest + ((n - 1) * 2));
+				break;
+			}
+
+			default:
+				// 0x80: One byte per line.
+				for (unsigned int k = 0; k < n; k++) {
+					const uint32_t cur = dest + (k * 0x80);
+					VRam.u8[cur] = p_src[k];
+					patternCache.mark_dirty_m5(cur);
+					if (rendThread)
+						rendThread->logWrite(VdpRendThread::LOG_VRAM_8, cur, p_src[k]);
+				}
+				break;
+		}
+
+		// Sprite Attribute Table.
+		DMA_Update_SAT_8(dest, inc, n, 0);
+
+		src = (src + n) & VRam_Mask;
+		dest = (dest + (inc * n)) & VRam_Mask;
+		length -= n;
+	}
+
+	*src_address = src;
+	*dest_address = dest;
+}
+
+/**
+ * Write a block of words from a DMA source.
+ * This is equivalent to calling vdpDataWrite_int() for each word.
+ * @param dest_component Destination component.
+ * @param src Source words. (host-endian)
+ * @param words Number of words.
+ */
+template<VdpPrivate::DMA_Dest_t dest_component>
+inline void VdpPrivate::T_DMA_Write_Block(const uint16_t *src, unsigned int words)
+{
+	uint32_t address = (VDP_Ctrl.address & VRam_Mask);
+	if (dest_component != DMA_DEST_VRAM || VDP_Reg.m5.Auto_Inc != 2 || (address & 1)) {
+		// CRam, VSRam, or an unusual VRam transfer.
+		// Write the words one at a time.
+		for (; words != 0; words--, src++) {
+			vdpDataWrite_int(*src);
+		}
+		return;
+	}
+
+	// VRam: Contiguous words, even address.
+	// Copy runs until the VRam address wraps around.
+	const uint32_t spr_start = Spr_Tbl_Addr;
+	const uint32_t spr_end = spr_start + ((~Spr_Tbl_Mask) & 0xFFFF) + 1;
+	while (words != 0) {
+		unsigned int n = ((VRam_Mask + 1 - address) >> 1);
+		if (n > words)
+			n = words;
+		const uint32_t end = address + (n * 2);
+
+		memcpy(&VRam.u16[address >> 1], src, n * 2);
+		patternCache.mark_dirty_m5_range(address, n * 2);
+		if (rendThread) {
+			for (unsigned int i = 0; i < n; i++) {
+				rendThread->logWrite(VdpRendThread::LOG_VRAM_16, (address >> 1) + i, src[i]);
+			}
+		}
+
+		// Check for Sprite Attribute Table writes.
+		const uint32_t spr_a = (address > spr_start ? address : spr_start);
+		const uint32_t spr_b = (end < spr_end ? end : spr_end);
+		if (spr_a < spr_b) {
+			for (uint32_t a = spr_a; a < spr_b; a += 2) {
+				const uint16_t data = VRam.u16[a >> 1];
+				SprAttrTbl_m5.w[(a & ~Spr_Tbl_Mask) >> 1] = data;
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_SAT_16, (a & ~Spr_Tbl_Mask) >> 1, data);
+			}
+			markSprBinsDirty();
+		}
+
+		src += n;
+		words -= n;
+		address = (end & VRam_Mask);
+	}
+
+	VDP_Ctrl.address = address;
+}
+
 /**
  * Mem-to-DMA loop.
  * @param src_component Source component.
@@ -211,71 +544,110 @@ inline void VdpPrivate::T_DMA_Loop(void)
 	unsigned int src_base_address = ((src_address & 0xFE0000) >> 1);
 
 	// TODO: Do DMA MEM-to-VRAM line-by-line instead of all at once.
-	do {
-		// Get the word.
-		uint16_t w;
-		switch (src_component) {
-			case DMA_SRC_ROM: {
-				// TODO: Banking is done in 512 KB segments.
-				// Optimize this by getting a pointer to the segment?
+	if (src_component == DMA_SRC_ROM || src_component == DMA_SRC_M68K_RAM) {
+		// Block transfer.
+		// Contiguous runs are written directly to the destination.
+		// DMAT_Length is not changed, so updateDMA() is unaffected.
+		do {
+			// Runs can't cross a 128 KB boundary.
+			unsigned int words = (0x10000 - src_word_address);
+			if (words > (unsigned int)length)
+				words = length;
+
+			const uint16_t *src;
+			if (src_component == DMA_SRC_ROM) {
 				const uint32_t req_addr = ((src_word_address | src_base_address) << 1);
-				w = M68K_Mem::ms_RomCartridge->readWord(req_addr);
-				break;
+				src = M68K_Mem::ms_RomCartridge->dmaReadPtr(req_addr, &words);
+				if (!src) {
+					// Not a plain ROM address. Read a single word.
+					vdpDataWrite_int(M68K_Mem::ms_RomCartridge->readWord(req_addr));
+					src_word_address++;
+					length--;
+					continue;
+				}
+			} else {
+				// M68K RAM is 64 KB, mirrored within the 128 KB window.
+				// A transfer that crosses $FFFFFF wraps to $FE0000,
+				// which is a mirror of $FF0000.
+				// NOTE: The per-word loop read past the end of
+				// Ram_68k here instead of mirroring.
+				const unsigned int ram_word_address = (src_word_address & 0x7FFF);
+				if (words > (0x8000 - ram_word_address))
+					words = (0x8000 - ram_word_address);
+				src = &Ram_68k.u16[ram_word_address];
 			}
 
-			case DMA_SRC_M68K_RAM:
-				//w = M68K_Mem::Ram_68k.u16[src_word_address];
-				w = Ram_68k.u16[src_word_address];
-				break;
-
-			// TODO: Port to LibGens.
-#if 0
-			case DMA_SRC_PRG_RAM:
-				// TODO: This is untested!
-				w = Ram_Prg.u16[src_word_address];
-				break;
-
-			case DMA_SRC_WORD_RAM_2M:
-				w = Ram_Word_2M.u16[src_word_address];
-				break;
-
-			case DMA_SRC_WORD_RAM_1M_0:
-				// TODO: This is untested!
-				w = Ram_Word_1M.u16[src_word_address];
-				break;
-
-			case DMA_SRC_WORD_RAM_1M_1:
-				// TODO: This is untested!
-				w = Ram_Word_1M.u16[src_word_address + (0x20000 >> 1)];
-				break;
+			T_DMA_Write_Block<dest_component>(src, words);
+			src_word_address += words;
+			length -= words;
+		} while (length != 0);
+	} else {
+		do {
+			// Get the word.
+			uint16_t w;
+			switch (src_component) {
+				case DMA_SRC_ROM: {
+					// TODO: Banking is done in 512 KB segments.
+					// Optimize this by getting a pointer to the segment?
+					const uint32_t req_addr = ((src_word_address | src_base_address) << 1);
+					w = M68K_Mem::ms_RomCartridge->readWord(req_addr);
+					break;
+				}
 
-			case DMA_SRC_WORD_RAM_CELL_1M_0:
-				// TODO: This is untested!
-				// Cell conversion is required.
-				w = Cell_Conv_Tab[src_word_address];
-				w = Ram_Word_1M.u16[w];
-				break;
+				case DMA_SRC_M68K_RAM:
+					//w = M68K_Mem::Ram_68k.u16[src_word_address];
+					w = Ram_68k.u16[src_word_address];
+					break;
 
-			case DMA_SRC_WORD_RAM_CELL_1M_1:
-				// TODO: This is untested!
-				// Cell conversion is required.
-				w = Cell_Conv_Tab[src_word_address];
-				w = Ram_Word_1M.u16[w + (0x20000 >> 1)];
-				break;
+				// TODO: Port to LibGens.
+#if 0
+				case DMA_SRC_PRG_RAM:
+					// TODO: This is untested!
+					w = Ram_Prg.u16[src_word_address];
+					break;
+
+				case DMA_SRC_WORD_RAM_2M:
+					w = Ram_Word_2M.u16[src_word_address];
+					break;
+
+				case DMA_SRC_WORD_RAM_1M_0:
+					// TODO: This is untested!
+					w = Ram_Word_1M.u16[src_word_address];
+					break;
+
+				case DMA_SRC_WORD_RAM_1M_1:
+					// TODO: This is untested!
+					w = Ram_Word_1M.u16[src_word_address + (0x20000 >> 1)];
+					break;
+
+				case DMA_SRC_WORD_RAM_CELL_1M_0:
+					// TODO: This is untested!
+					// Cell conversion is required.
+					w = Cell_Conv_Tab[src_word_address];
+					w = Ram_Word_1M.u16[w];
+					break;
+
+				case DMA_SRC_WORD_RAM_CELL_1M_1:
+					// TODO: This is untested!
+					// Cell conversion is required.
+					w = Cell_Conv_Tab[src_word_address];
+					w = Ram_Word_1M.u16[w + (0x20000 >> 1)];
+					break;
 #endif
 
-			default:	// to make gcc shut up
-				w = 0;	// NOTE: Remove this once everything is ported to LibGens.
-				break;
-		}
+				default:	// to make gcc shut up
+					w = 0;	// NOTE: Remove this once everything is ported to LibGens.
+					break;
+			}
 
-		// Increment the source word address.
-		src_word_address++;
+			// Increment the source word address.
+			src_word_address++;
 
-		// Write the word.
-		// TODO: Might not work if Auto_Inc is odd...
-		vdpDataWrite_int(w);
-	} while (--length != 0);
+			// Write the word.
+			// TODO: Might not work if Auto_Inc is odd...
+			vdpDataWrite_int(w);
+		} while (--length != 0);
+	}
 
 	// DMA is done.
 	VDP_Ctrl.code &= ~VdpTypes::CD_DMA_ENABLE;
@@ -364,24 +736,8 @@ void VdpPrivate::processDmaCtrlWrite(void)
 		DMAT_Type = VdpPrivate::DMAT_COPY;
 		set_DMA_Length(0);
 
-		// TODO: Is this correct with regards to endianness?
 		// TODO: Do DMA COPY line-by-line instead of all at once.
-		do {
-			uint8_t src = VRam.u8[src_address];
-			VRam.u8[dest_address] = src;
-			if ((dest_address & Spr_Tbl_Mask) == Spr_Tbl_Addr) {
-				// Sprite Attribute Table.
-				SprAttrTbl_m5.b[(dest_address & ~Spr_Tbl_Mask) ^ U16DATA_U8_INVERT] = src;
-			}
-
-			// Increment the addresses.
-			src_address++;
-			dest_address += VDP_Reg.m5.Auto_Inc;
-
-			// Mask the addresses.
-			src_address &= VRam_Mask;
-			dest_address &= VRam_Mask;
-		} while (--length != 0);
+		DMA_Copy_VRam(&src_address, &dest_address, length);
 
 		// Save the new addresses.
 		// NOTE: DMA COPY uses bytes, not words.
@@ -401,7 +757,6 @@ void VdpPrivate::processDmaCtrlWrite(void)
 
 	// Determine the source component.
 	VdpPrivate::DMA_Src_t src_component = VdpPrivate::DMA_SRC_ROM;	// TODO: Determine a better default.
-	int WRam_Mode;
 
 	// Maximum ROM source address: 4 MB for Sega CD or 32X, 10 MB for standard MD.
 	const uint32_t maxRomSrcAddress =
@@ -430,7 +785,7 @@ void VdpPrivate::processDmaCtrlWrite(void)
 			// TODO: Determine how this works.
 			// TODO: Port to LibGens.
 #if 0
-			WRam_Mode = (Ram_Word_State & 0x03) + 3;
+			const int WRam_Mode = (Ram_Word_State & 0x03) + 3;
 			if (WRam_Mode < 5 || src_address < 0x220000) {
 				src_component = (VdpPrivate::DMA_Src_t)WRam_Mode;
 			} else {
@@ -25,6 +25,7 @@
 
 #include "Vdp.hpp"
 #include "Vdp_p.hpp"
+#include "VdpRendThread.hpp"
 
 // LOG_MSG() subsystem.
 #include "macros/log_msg.h"
@@ -39,6 +40,7 @@
 
 // Emulation Context.
 #include "EmuContext/EmuContext.hpp"
+#include "EmuContext/Scheduler.hpp"
 
 // C wrapper functions for Starscream.
 #ifdef __cplusplus
@@ -47,7 +49,7 @@ extern "C" {
 
 uint8_t VDP_Int_Ack(void)
 {
-	// TODO: This won't work with multiple contexts...
+	// NOTE: Multi-context builds have one instance per thread.
 	LibGens::EmuContext *instance = LibGens::EmuContext::Instance();
 	if (instance != nullptr)
 		return instance->m_vdp->Int_Ack();
@@ -56,6 +58,15 @@ uint8_t VDP_Int_Ack(void)
 	return 0;
 }
 
+uint8_t VDP_Status_Stable(void)
+{
+	// NOTE: Multi-context builds have one instance per thread.
+	LibGens::EmuContext *instance = LibGens::EmuContext::Instance();
+	if (instance != nullptr)
+		return instance->m_vdp->isStatusStable();
+	return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -122,7 +133,7 @@ void Vdp::updateIRQLine(int interrupt)
 uint8_t Vdp::readHCounter(void)
 {
 	unsigned int odo_68K = M68K::ReadOdometer();
-	odo_68K -= (M68K_Mem::Cycles_M68K - M68K_Mem::CPL_M68K);
+	odo_68K -= Scheduler::ToM68K(Scheduler::LineStart());
 	odo_68K &= 0x1FF;
 
 	// H_Counter_Table[][0] == H32.
@@ -141,7 +152,7 @@ uint8_t Vdp::readHCounter(void)
 uint8_t Vdp::readVCounter(void)
 {
 	unsigned int odo_68K = M68K::ReadOdometer();
-	odo_68K -= (M68K_Mem::Cycles_M68K - M68K_Mem::CPL_M68K);
+	odo_68K -= Scheduler::ToM68K(Scheduler::LineStart());
 	odo_68K &= 0x1FF;
 
 	unsigned int H_Counter;
@@ -227,6 +238,23 @@ void Vdp::writeTestRegMD_8(uint8_t data)
 	writeTestRegMD(data | (data << 8));
 }
 
+/**
+ * Check if reading the status register only toggles the FIFO flags.
+ * Used for idle loop detection.
+ * @return True if HBLANK, SOVR, and C are clear.
+ */
+bool Vdp::isStatusStable(void) const
+{
+	// The renderer may set C.
+	if (d->rendThread)
+		d->rendThread->syncStatus();
+
+	return !(d->Reg_Status.read_raw() &
+		(VdpStatus::VDP_STATUS_HBLANK |
+		 VdpStatus::VDP_STATUS_SOVR |
+		 VdpStatus::VDP_STATUS_COLLISION));
+}
+
 /**
  * Read the VDP control port. (M5)
  * This returns the status register.
@@ -234,6 +262,15 @@ void Vdp::writeTestRegMD_8(uint8_t data)
  */
 uint16_t Vdp::readCtrlMD(void)
 {
+	// The renderer may set C.
+	if (d->rendThread)
+		d->rendThread->syncStatus();
+
+	// The 68000 isn't stopped at the end of HBlank
+	// unless an HINT is due, so check it here.
+	if (M68K::ReadOdometer() >= d->HBlank_End)
+		d->Reg_Status.setBit(VdpStatus::VDP_STATUS_HBLANK, false);
+
 	const uint16_t status = d->Reg_Status.read();
 
 	// Reading the control port clears the control word latch.
@@ -310,6 +347,18 @@ uint16_t Vdp::readDataMD(void)
 }
 
 
+/**
+ * Record a port write in the trace buffer.
+ * Only call this if trace is set.
+ * @param port Port.
+ * @param value Value.
+ */
+inline void VdpPrivate::traceWrite(VdpTrace::Port_t port, uint32_t value)
+{
+	trace->record(port, VDP_Ctrl.code, q->VDP_Lines.currentLine,
+		M68K::ReadOdometer() * Scheduler::MCLK_DIV_M68K, value);
+}
+
 /**
  * Write to the VDP data port. (M5, 8-bit)
  * Convenience function. This function doubles the bytes
@@ -343,6 +392,9 @@ void Vdp::writeDataMD(uint16_t data)
 		"VDP_Ctrl.code == %02X, VDP_Ctrl.address == %04X, data == %04X",
 		d->VDP_Ctrl.code, d->VDP_Ctrl.address, data);
 
+	if (d->trace)
+		d->traceWrite(VdpTrace::PORT_DATA, data);
+
 	// Writing to the data port clears the control word latch.
 	d->VDP_Ctrl.ctrl_latch = 0;
 
@@ -354,6 +406,10 @@ void Vdp::writeDataMD(uint16_t data)
 	    (d->VDP_Ctrl.DMA_Mode == 0x80))
 	{
 		// DMA Fill operation is in progress.
+		if (d->trace) {
+			d->traceWrite(VdpTrace::PORT_DMA,
+				((uint32_t)d->VDP_Ctrl.DMA_Mode << 24) | d->DMA_Length());
+		}
 		d->DMA_Fill(data);
 	}
 }
@@ -383,9 +439,15 @@ void VdpPrivate::vdpDataWrite_int(uint16_t data)
 				tmp_data = data;
 			}
 			VRam.u16[address>>1] = tmp_data;
+			patternCache.mark_dirty_m5(address);
+			if (rendThread)
+				rendThread->logWrite(VdpRendThread::LOG_VRAM_16, address>>1, tmp_data);
 			if ((address & Spr_Tbl_Mask) == Spr_Tbl_Addr) {
 				// Sprite Attribute Table.
 				SprAttrTbl_m5.w[(address & ~Spr_Tbl_Mask) >> 1] = tmp_data;
+				markSprBinsDirty();
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_SAT_16, (address & ~Spr_Tbl_Mask) >> 1, tmp_data);
 			}
 			break;
 		}
@@ -406,6 +468,8 @@ void VdpPrivate::vdpDataWrite_int(uint16_t data)
 			// CRam is 128 bytes. (64 words)
 			if (address < 0x80) {
 				palette.writeCRam_16((address & 0x7E), data);
+				if (rendThread)
+					rendThread->logWrite(VdpRendThread::LOG_CRAM_16, (address & 0x7E), data);
 			}
 			break;
 
@@ -419,6 +483,8 @@ void VdpPrivate::vdpDataWrite_int(uint16_t data)
 			// TODO: VSRam is 80 bytes, but we're allowing a maximum of 128 bytes here...
 			// TODO: Mask off high bits? (Only 10/11 bits are present.)
 			VSRam.u16[(address & 0x7E) >> 1] = data;
+			if (rendThread)
+				rendThread->logWrite(VdpRendThread::LOG_VSRAM_16, (address & 0x7E) >> 1, data);
 			break;
 
 		default:
@@ -459,6 +525,8 @@ void Vdp::writeCtrlMD_8(uint8_t ctrl)
 void Vdp::writeCtrlMD(uint16_t ctrl)
 {
 	// TODO: Check endianness with regards to the control words. (Wordswapping!)
+	if (d->trace)
+		d->traceWrite(VdpTrace::PORT_CTRL, ctrl);
 
 	// Check if this is the first or second control word.
 	if (!d->VDP_Ctrl.ctrl_latch) {
@@ -554,6 +622,10 @@ void Vdp::writeCtrlMD(uint16_t ctrl)
 		return;
 
 	// Process the DMA control write.
+	if (d->trace) {
+		d->traceWrite(VdpTrace::PORT_DMA,
+			((uint32_t)d->VDP_Ctrl.DMA_Mode << 24) | d->DMA_Length());
+	}
 	d->processDmaCtrlWrite();
 }
 
@@ -99,6 +99,8 @@ VdpPalette::VdpPalette()
 	, m_bpp(MdFb::BPP_32)
 {
 	// Set the dirty flags.
+	m_dirty.data = 0;
+	memset(&m_dirtyCRam, 0, sizeof(m_dirtyCRam));
 	m_dirty.active = true;
 	m_dirty.full = true;
 
@@ -221,10 +223,13 @@ void VdpPalette::setM5M4bits(uint8_t m5m4bits)
 		return;
 	d->m5m4bits = m5m4bits;
 
-	if (d->palMode == PALMODE_SMS || d->palMode == PALMODE_MD) {
+	if (d->palMode == PALMODE_SMS || d->palMode == PALMODE_MD ||
+	    d->palMode == PALMODE_32X)
+	{
 		// Mode bits have changed.
 		// Recalculate the active palette.
 		// NOTE: Game Gear does not have a hard-coded TMS palette.
+		// NOTE: 32X uses the MD palette, so it's affected too.
 		d->applyBgColorIdxMask();
 		m_dirty.active = true;
 	}
@@ -236,6 +236,24 @@ class VdpPalette
 			};
 		} m_dirty;
 
+		/**
+		 * Dirty CRam entries. (one byte per color)
+		 * Bytes are used instead of bits so CRam writes
+		 * don't have to read the previous value.
+		 * If m_dirty.active is set, the entire
+		 * active palette is recalculated instead.
+		 */
+		union {
+			uint8_t u8[64];
+			uint64_t u64[8];
+		} m_dirtyCRam;
+
+		/**
+		 * Check if any CRam entries are dirty.
+		 * @return True if any CRam entries are dirty.
+		 */
+		inline bool isCRamDirty(void) const;
+
 		/** Active palette recalculation functions. **/
 
 		template<typename pixel>
@@ -247,6 +265,10 @@ class VdpPalette
 					const pixel *palFullMD,
 					const pixel *palFullSMS);
 
+		template<typename pixel>
+		FORCE_INLINE void T_update_MD_dirty(pixel *palActiveMD,
+					const pixel *palFullMD);
+
 		// TODO: Needs testing.
 		template<typename pixel>
 		FORCE_INLINE void T_update_32X(pixel *palActive32X,
@@ -270,7 +292,19 @@ class VdpPalette
  * @return True if the palette is dirty.
  */
 inline bool VdpPalette::isDirty(void) const
-	{ return !!(m_dirty.data); }
+	{ return (m_dirty.data != 0 || isCRamDirty()); }
+
+/**
+ * Check if any CRam entries are dirty.
+ * @return True if any CRam entries are dirty.
+ */
+inline bool VdpPalette::isCRamDirty(void) const
+{
+	return ((m_dirtyCRam.u64[0] | m_dirtyCRam.u64[1] |
+		 m_dirtyCRam.u64[2] | m_dirtyCRam.u64[3] |
+		 m_dirtyCRam.u64[4] | m_dirtyCRam.u64[5] |
+		 m_dirtyCRam.u64[6] | m_dirtyCRam.u64[7]) != 0);
+}
 
 /** CRam functions. **/
 
@@ -312,8 +346,7 @@ inline void VdpPalette::writeCRam_8(uint8_t address, uint8_t data)
 	address &= cram_addr_mask;
 	// FIXME: Use U16DATA_U8_INVERT?
 	m_cram.u8[address] = data;
-	// TODO: Per-color dirty flag?
-	m_dirty.active = true;
+	m_dirtyCRam.u8[(address >> 1) & 0x3F] = 1;
 }
 
 /**
@@ -328,8 +361,7 @@ inline void VdpPalette::writeCRam_16(uint8_t address, uint16_t data)
 
 	address &= cram_addr_mask;
 	m_cram.u16[address >> 1] = data;
-	// TODO: Per-color dirty flag?
-	m_dirty.active = true;
+	m_dirtyCRam.u8[(address >> 1) & 0x3F] = 1;
 }
 
 /** 32X CRam functions. **/
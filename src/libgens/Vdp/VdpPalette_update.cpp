@@ -160,6 +160,54 @@ FORCE_INLINE void VdpPalette::T_update_MD(pixel *palActiveMD,
 	}
 }
 
+/**
+ * Recalculate dirty colors in the active palette. (Mega Drive, Mode 5)
+ * Only the colors marked in m_dirtyCRam are converted,
+ * along with their shadow and highlight colors.
+ * @param palActiveMD Active MD palette. (Must have 0x100 entries!)
+ * @param palFullMD Full MD palette. (Must have 0x1000 entries!)
+ */
+template<typename pixel>
+FORCE_INLINE void VdpPalette::T_update_MD_dirty(pixel *palActiveMD,
+					  const pixel *palFullMD)
+{
+	// Mode 5, PSEL=0: CRAM masks all but the LSB.
+	// Mode 5, PSEL=1: Normal operation.
+	const uint16_t mdColorMask = ((d->m5m4bits & 0x01) ? 0xEEE : 0x222);
+	const bool sh = d->mdShadowHighlight;
+
+	// Check 8 colors at a time.
+	for (int base = 0; base < 64; base += 8) {
+		if (m_dirtyCRam.u64[base >> 3] == 0)
+			continue;
+		for (int i = base; i < base + 8; i++) {
+			if (!m_dirtyCRam.u8[i])
+				continue;
+
+			const uint16_t color_raw = (m_cram.u16[i] & mdColorMask);
+			palActiveMD[i] = palFullMD[color_raw];
+			if (sh) {
+				// Shadow (64-127), highlight (128-191),
+				// and shadow+highlight (192-255) colors.
+				const uint16_t sh_raw = (color_raw >> 1);
+				palActiveMD[i + 64]  = palFullMD[sh_raw];
+				palActiveMD[i + 128] = palFullMD[(0x888 | sh_raw) - 0x111];
+				palActiveMD[i + 192] = palActiveMD[i];
+			}
+		}
+	}
+
+	// Update the background color.
+	// Color 0 may have been overwritten above.
+	const uint8_t bgIdx = d->maskedBgColorIdx;
+	palActiveMD[0] = palActiveMD[bgIdx];
+	if (sh) {
+		palActiveMD[64]  = palActiveMD[bgIdx + 64];	// Shadow color.
+		palActiveMD[128] = palActiveMD[bgIdx + 128];	// Highlight color.
+		palActiveMD[192] = palActiveMD[0];
+	}
+}
+
 /**
  * Recalculate the active palette. (32X)
  * TODO: Needs testing.
@@ -323,8 +371,33 @@ void VdpPalette::update(void)
 {
 	if (m_dirty.full)
 		d->recalcFull();
-	if (!m_dirty.active)
-		return;
+	if (!m_dirty.active) {
+		if (!isCRamDirty())
+			return;
+		if (d->isAppOs)
+			return;
+
+		// Only CRam entries have changed.
+		// In Mode 5, only the dirty colors need to be converted,
+		// unless more than 16 colors have changed.
+		// NOTE: 32X CRam writes mark the entire active palette as dirty.
+		unsigned int count = 0;
+		for (int i = 0; i < 8; i++) {
+			// Each dirty byte is 1, so this adds up the bytes.
+			count += (unsigned int)((m_dirtyCRam.u64[i] * 0x0101010101010101ULL) >> 56);
+		}
+		if ((d->palMode == PALMODE_MD || d->palMode == PALMODE_32X) &&
+		    (d->m5m4bits & 0x02) && count <= 16)
+		{
+			if (m_bpp != MdFb::BPP_32) {
+				T_update_MD_dirty<uint16_t>(m_palActive.u16, d->palFullMD.u16);
+			} else {
+				T_update_MD_dirty<uint32_t>(m_palActive.u32, d->palFullMD.u32);
+			}
+			memset(&m_dirtyCRam, 0, sizeof(m_dirtyCRam));
+			return;
+		}
+	}
 	if (d->isAppOs)
 		return;
 
@@ -381,8 +454,9 @@ void VdpPalette::update(void)
 		}
 	}
 
-	// Clear the active palette dirty bit.
+	// Clear the active palette dirty bits.
 	m_dirty.active = false;
+	memset(&m_dirtyCRam, 0, sizeof(m_dirtyCRam));
 }
 
 // TODO: Port to LibGens: T_update_32X()
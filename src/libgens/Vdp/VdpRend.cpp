@@ -28,6 +28,7 @@
 
 // Vdp private class.
 #include "Vdp_p.hpp"
+#include "VdpRendThread.hpp"
 
 namespace LibGens {
 
@@ -39,6 +40,9 @@ void VdpPrivate::rend_init(void)
 {
 	// Initialize the VDP rendering variables.
 	VDP_Layers = VdpTypes::VDP_LAYERS_DEFAULT;
+
+	// Blank line cache. (Mode 5)
+	blankLine.bpp = MdFb::BPP_MAX;
 }
 
 /**
@@ -68,6 +72,7 @@ void VdpPrivate::rend_reset(void)
 
 	// Sprite Attribute Table cache. (Mode 5)
 	memset(SprAttrTbl_m5.b, 0, sizeof(SprAttrTbl_m5.b));
+	markSprBinsDirty();
 
 	// Sprite line cache.
 	memset(sprLineCache, 0, sizeof(sprLineCache));
@@ -82,6 +87,12 @@ void VdpPrivate::rend_reset(void)
  */
 void Vdp::renderLine(void)
 {
+	if (d->rendThread) {
+		// Threaded rendering.
+		d->rendThread->queueLine();
+		return;
+	}
+
 	// TODO: 32X-specific function.
 	if (d->VDP_Mode & VdpTypes::VDP_MODE_M5) {
 		// Mode 5.
@@ -102,4 +113,32 @@ void Vdp::renderLine(void)
 	d->updateErr();
 }
 
+/**
+ * Enable or disable threaded rendering.
+ * If enabled, lines are rendered by a worker thread.
+ * The framebuffer is complete at the end of each frame.
+ * @param enable True to enable; false to disable.
+ */
+void Vdp::setThreadedRendering(bool enable)
+{
+	if (enable == !!d->rendThread)
+		return;
+
+	if (enable) {
+		d->rendThread = new VdpRendThread(this);
+	} else {
+		delete d->rendThread;
+		d->rendThread = nullptr;
+	}
+}
+
+/**
+ * Is threaded rendering enabled?
+ * @return True if threaded rendering is enabled.
+ */
+bool Vdp::isThreadedRendering(void) const
+{
+	return !!d->rendThread;
+}
+
 }
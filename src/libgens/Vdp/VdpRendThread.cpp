@@ -0,0 +1,402 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * VdpRendThread.cpp: Deferred VDP rendering thread.                       *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "VdpRendThread.hpp"
+
+#include "Vdp.hpp"
+#include "Vdp_p.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cstring>
+
+namespace LibGens {
+
+// Status register bits set by the renderer.
+// NOTE: SOVR is set by the emulation thread's sprite line cache.
+static const uint16_t REND_STATUS_MASK = VdpStatus::VDP_STATUS_COLLISION;
+
+VdpRendThread::VdpRendThread(Vdp *q)
+	: q(q)
+	, m_log(new LogEntry_t[LOG_SIZE])
+	, m_write(0)
+	, m_head(0)
+	, m_tail(0)
+	, m_lines(new LineState_t[LINE_SIZE])
+	, m_lineWrite(0)
+	, m_lineDone(0)
+	, m_status(0)
+	, m_colPending(false)
+	, m_shadow(new Vdp())
+	, m_quit(false)
+{
+	// The shadow VDP renders into the real VDP's framebuffer.
+	// NOTE: The shadow VDP is initially created with its own
+	// framebuffer so its reset() doesn't clear the real one.
+	m_shadow->MD_Screen->unref();
+	m_shadow->MD_Screen = q->MD_Screen->ref();
+
+	// Copy the current VDP state.
+	resync();
+
+	// Start the worker thread.
+	m_thread = std::thread(&VdpRendThread::run, this);
+}
+
+VdpRendThread::~VdpRendThread()
+{
+	// Wait for the worker to finish.
+	sync();
+
+	// Stop the worker thread.
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_cvWork.notify_one();
+	m_thread.join();
+
+	// The sprite line cache was only updated on the
+	// shadow VDP. Copy it back to the real VDP.
+	copyRendState(q, m_shadow);
+
+	delete m_shadow;
+	delete[] m_lines;
+	delete[] m_log;
+}
+
+/**
+ * Save the rendering state.
+ * @param state Line state.
+ * @param vdp Source VDP.
+ */
+void VdpRendThread::saveLineState(LineState_t *state, const Vdp *vdp)
+{
+	const VdpPrivate *const d = vdp->d;
+
+	// Vdp
+	state->VDP_Lines	= vdp->VDP_Lines;
+	state->options		= vdp->options;
+	state->SysStatus	= vdp->SysStatus.data;
+
+	// VdpPrivate
+	state->H_Cell		= d->H_Cell;
+	state->H_Pix		= d->H_Pix;
+	state->H_Pix_Begin	= d->H_Pix_Begin;
+	state->H_Win_Shift	= d->H_Win_Shift;
+	state->V_Scroll_MMask	= d->V_Scroll_MMask;
+	state->H_Scroll_Mask	= d->H_Scroll_Mask;
+	state->H_Scroll_CMul	= d->H_Scroll_CMul;
+	state->H_Scroll_CMask	= d->H_Scroll_CMask;
+	state->V_Scroll_CMask	= d->V_Scroll_CMask;
+	state->im2_flag		= d->im2_flag;
+	state->Win_X_Pos	= d->Win_X_Pos;
+	state->Win_Y_Pos	= d->Win_Y_Pos;
+	state->VDP_Mode		= d->VDP_Mode;
+	state->VDP_Model	= d->VDP_Model;
+	state->status		= d->Reg_Status.read_raw();
+	state->VDP_Reg		= d->VDP_Reg;
+	state->ScrA_Tbl_Addr	= d->ScrA_Tbl_Addr;
+	state->ScrB_Tbl_Addr	= d->ScrB_Tbl_Addr;
+	state->Win_Tbl_Addr	= d->Win_Tbl_Addr;
+	state->Spr_Tbl_Addr	= d->Spr_Tbl_Addr;
+	state->H_Scroll_Tbl_Addr = d->H_Scroll_Tbl_Addr;
+	state->ScrA_Gen_Addr	= d->ScrA_Gen_Addr;
+	state->ScrB_Gen_Addr	= d->ScrB_Gen_Addr;
+	state->Spr_Gen_Addr	= d->Spr_Gen_Addr;
+	state->VRam_Mask	= d->VRam_Mask;
+	state->ScrA_Tbl_Mask	= d->ScrA_Tbl_Mask;
+	state->ScrB_Tbl_Mask	= d->ScrB_Tbl_Mask;
+	state->Win_Tbl_Mask	= d->Win_Tbl_Mask;
+	state->Spr_Tbl_Mask	= d->Spr_Tbl_Mask;
+	state->H_Scroll_Tbl_Mask = d->H_Scroll_Tbl_Mask;
+	state->VDP_Layers	= d->VDP_Layers;
+
+	// VdpPalette
+	state->palMode		= d->palette.palMode();
+	state->bgColorIdx	= d->palette.bgColorIdx();
+	state->m5m4bits		= d->palette.m5m4bits();
+	state->mdShadowHighlight = d->palette.mdShadowHighlight();
+}
+
+/**
+ * Load the rendering state.
+ * @param vdp Destination VDP.
+ * @param state Line state.
+ */
+void VdpRendThread::loadLineState(Vdp *vdp, const LineState_t *state)
+{
+	VdpPrivate *const d = vdp->d;
+
+	// Vdp
+	vdp->VDP_Lines		= state->VDP_Lines;
+	vdp->options		= state->options;
+	vdp->SysStatus.data	= state->SysStatus;
+
+	// VdpPrivate
+	d->H_Cell		= state->H_Cell;
+	d->H_Pix		= state->H_Pix;
+	d->H_Pix_Begin		= state->H_Pix_Begin;
+	d->H_Win_Shift		= state->H_Win_Shift;
+	d->V_Scroll_MMask	= state->V_Scroll_MMask;
+	d->H_Scroll_Mask	= state->H_Scroll_Mask;
+	d->H_Scroll_CMul	= state->H_Scroll_CMul;
+	d->H_Scroll_CMask	= state->H_Scroll_CMask;
+	d->V_Scroll_CMask	= state->V_Scroll_CMask;
+	d->im2_flag		= state->im2_flag;
+	d->Win_X_Pos		= state->Win_X_Pos;
+	d->Win_Y_Pos		= state->Win_Y_Pos;
+	d->VDP_Mode		= state->VDP_Mode;
+	d->VDP_Model		= state->VDP_Model;
+	// Status bits set by the renderer are accumulated separately.
+	d->Reg_Status.write_raw(state->status & ~REND_STATUS_MASK);
+	d->VDP_Reg		= state->VDP_Reg;
+	d->ScrA_Tbl_Addr	= state->ScrA_Tbl_Addr;
+	d->ScrB_Tbl_Addr	= state->ScrB_Tbl_Addr;
+	d->Win_Tbl_Addr		= state->Win_Tbl_Addr;
+	d->Spr_Tbl_Addr		= state->Spr_Tbl_Addr;
+	d->H_Scroll_Tbl_Addr	= state->H_Scroll_Tbl_Addr;
+	d->ScrA_Gen_Addr	= state->ScrA_Gen_Addr;
+	d->ScrB_Gen_Addr	= state->ScrB_Gen_Addr;
+	d->Spr_Gen_Addr		= state->Spr_Gen_Addr;
+	d->VRam_Mask		= state->VRam_Mask;
+	d->ScrA_Tbl_Mask	= state->ScrA_Tbl_Mask;
+	d->ScrB_Tbl_Mask	= state->ScrB_Tbl_Mask;
+	d->Win_Tbl_Mask		= state->Win_Tbl_Mask;
+	d->Spr_Tbl_Mask		= state->Spr_Tbl_Mask;
+	d->H_Scroll_Tbl_Mask	= state->H_Scroll_Tbl_Mask;
+	d->VDP_Layers		= state->VDP_Layers;
+
+	// VdpPalette
+	// NOTE: The setters only mark the palette as dirty
+	// if the property has actually changed.
+	d->palette.setPalMode(state->palMode);
+	d->palette.setM5M4bits(state->m5m4bits);
+	d->palette.setBgColorIdx(state->bgColorIdx);
+	d->palette.setMdShadowHighlight(state->mdShadowHighlight);
+}
+
+/**
+ * Copy renderer-internal state between VDPs.
+ * @param dest Destination VDP.
+ * @param src Source VDP.
+ */
+void VdpRendThread::copyRendState(Vdp *dest, const Vdp *src)
+{
+	memcpy(dest->d->sprLineCache, src->d->sprLineCache, sizeof(dest->d->sprLineCache));
+	memcpy(dest->d->sprCountCache, src->d->sprCountCache, sizeof(dest->d->sprCountCache));
+	dest->d->sprDotOverflow = src->d->sprDotOverflow;
+}
+
+/**
+ * Publish the logged entries to the worker.
+ */
+void VdpRendThread::publish(void)
+{
+	if (m_head.load(std::memory_order_relaxed) == m_write)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_head.store(m_write, std::memory_order_release);
+	}
+	m_cvWork.notify_one();
+}
+
+/**
+ * Wait until the worker has processed at least
+ * the specified number of log entries.
+ * @param count Number of log entries.
+ */
+void VdpRendThread::waitLog(uint32_t count)
+{
+	// NOTE: The worker updates m_tail in batches,
+	// so it may skip past count.
+	if ((int32_t)(count - m_tail.load(std::memory_order_acquire)) <= 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while ((int32_t)(count - m_tail.load(std::memory_order_acquire)) > 0) {
+		m_cvDone.wait(lock);
+	}
+}
+
+/**
+ * Flush the log. Called if the log is full.
+ */
+void VdpRendThread::flush(void)
+{
+	publish();
+	waitLog(m_write - (LOG_SIZE / 2));
+}
+
+/**
+ * Queue the current line for rendering.
+ * Called by Vdp::renderLine().
+ */
+void VdpRendThread::queueLine(void)
+{
+	if (m_lineWrite - m_lineDone.load(std::memory_order_acquire) >= LINE_SIZE) {
+		// Line state buffer is full.
+		sync();
+	}
+
+	// Update the sprite line cache. This sets SOVR.
+	// NOTE: 32X rendering isn't implemented yet.
+	if ((q->d->VDP_Mode & VdpTypes::VDP_MODE_M5) && !q->SysStatus._32X) {
+		if (q->d->updateSprStatus_m5())
+			m_colPending = true;
+	}
+
+	const uint32_t idx = (m_lineWrite & (LINE_SIZE - 1));
+	saveLineState(&m_lines[idx], q);
+	m_lineWrite++;
+	logWrite(LOG_LINE, idx, 0);
+	publish();
+
+	if (q->VDP_Lines.currentLine == (q->VDP_Lines.totalDisplayLines - 1)) {
+		// Last line of the frame.
+		// Wait for the worker so the framebuffer is complete.
+		sync();
+	}
+}
+
+/**
+ * Wait for the worker to render all queued lines.
+ * Status bits set by the renderer are merged
+ * into the VDP status register.
+ */
+void VdpRendThread::sync(void)
+{
+	publish();
+	waitLog(m_write);
+	m_colPending = false;
+
+	if (m_status != 0) {
+		const uint16_t status = q->d->Reg_Status.read_raw();
+		q->d->Reg_Status.write_raw(status | m_status);
+		m_status = 0;
+	}
+}
+
+/**
+ * Wait for the worker, then copy the entire
+ * VDP memory state to the shadow VDP.
+ * Needed after reset and savestate loading.
+ */
+void VdpRendThread::resync(void)
+{
+	sync();
+
+	VdpPrivate *const sd = m_shadow->d;
+	const VdpPrivate *const d = q->d;
+	memcpy(&sd->VRam, &d->VRam, sizeof(sd->VRam));
+	sd->patternCache.invalidate();
+	memcpy(&sd->VSRam, &d->VSRam, sizeof(sd->VSRam));
+	memcpy(sd->SprAttrTbl_m5.b, d->SprAttrTbl_m5.b, sizeof(sd->SprAttrTbl_m5.b));
+	sd->markSprBinsDirty();
+	copyRendState(m_shadow, q);
+
+	Zomg_CRam_t cram;
+	d->palette.zomgSaveCRam(&cram);
+	sd->palette.zomgRestoreCRam(&cram);
+
+	LineState_t state;
+	saveLineState(&state, q);
+	loadLineState(m_shadow, &state);
+}
+
+/**
+ * Process a log entry.
+ * @param entry Log entry.
+ */
+void VdpRendThread::processEntry(const LogEntry_t *entry)
+{
+	VdpPrivate *const sd = m_shadow->d;
+	switch (entry->type) {
+		case LOG_VRAM_8:
+			sd->VRam.u8[entry->address] = (uint8_t)entry->data;
+			sd->patternCache.mark_dirty_m5(entry->address);
+			break;
+		case LOG_VRAM_16:
+			sd->VRam.u16[entry->address] = entry->data;
+			sd->patternCache.mark_dirty_m5(entry->address << 1);
+			break;
+		case LOG_SAT_8:
+			sd->SprAttrTbl_m5.b[entry->address] = (uint8_t)entry->data;
+			sd->markSprBinsDirty();
+			break;
+		case LOG_SAT_16:
+			sd->SprAttrTbl_m5.w[entry->address] = entry->data;
+			sd->markSprBinsDirty();
+			break;
+		case LOG_CRAM_16:
+			sd->palette.writeCRam_16((uint8_t)entry->address, entry->data);
+			break;
+		case LOG_VSRAM_16:
+			sd->VSRam.u16[entry->address] = entry->data;
+			break;
+
+		case LOG_LINE: {
+			loadLineState(m_shadow, &m_lines[entry->address]);
+			m_shadow->renderLine();
+
+			// Save the status bits set by the renderer.
+			m_status |= (sd->Reg_Status.read_raw() & REND_STATUS_MASK);
+			m_lineDone.fetch_add(1, std::memory_order_release);
+			break;
+		}
+
+		default:
+			assert(!"Invalid log entry type.");
+			break;
+	}
+}
+
+/**
+ * Worker thread function.
+ */
+void VdpRendThread::run(void)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		const uint32_t head = m_head.load(std::memory_order_acquire);
+		uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == head) {
+			if (m_quit)
+				break;
+			m_cvWork.wait(lock);
+			continue;
+		}
+
+		// Process the published log entries.
+		lock.unlock();
+		for (; tail != head; tail++) {
+			processEntry(&m_log[tail & (LOG_SIZE - 1)]);
+		}
+		lock.lock();
+
+		m_tail.store(tail, std::memory_order_release);
+		m_cvDone.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,294 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * VdpRendThread.hpp: Deferred VDP rendering thread.                       *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __LIBGENS_VDP_VDPRENDTHREAD_HPP__
+#define __LIBGENS_VDP_VDPRENDTHREAD_HPP__
+
+#include <stdint.h>
+
+// C++ includes.
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "VdpTypes.hpp"
+#include "VdpReg.hpp"
+#include "VdpPalette.hpp"
+
+namespace LibGens {
+
+/**
+ * Vdp: Deferred rendering thread.
+ *
+ * The emulation thread logs every VRAM, SAT, CRAM, and VSRAM
+ * write, plus a snapshot of the rendering state at the end
+ * of each line. A worker thread replays the log into a shadow
+ * Vdp and renders each line into the real VDP's framebuffer.
+ *
+ * The emulation thread updates its own sprite line cache for
+ * each line, so SOVR is set without the worker. Rendering can
+ * still set COL, so status register reads wait for the worker
+ * if a line queued since the last sync has overlapping sprites.
+ * The end of the frame always waits for the worker, so the
+ * framebuffer is complete when execFrame() returns.
+ */
+class Vdp;
+class VdpRendThread
+{
+	public:
+		VdpRendThread(Vdp *q);
+		~VdpRendThread();
+
+	private:
+		Vdp *const q;
+
+		// Q_DISABLE_COPY() equivalent.
+		// TODO: Add LibGens-specific version of Q_DISABLE_COPY().
+		VdpRendThread(const VdpRendThread &);
+		VdpRendThread &operator=(const VdpRendThread &);
+
+	public:
+		// Log entry types.
+		enum LogType_t {
+			LOG_VRAM_8,	// address: VRam.u8[] index
+			LOG_VRAM_16,	// address: VRam.u16[] index
+			LOG_SAT_8,	// address: SprAttrTbl_m5.b[] index
+			LOG_SAT_16,	// address: SprAttrTbl_m5.w[] index
+			LOG_CRAM_16,	// address: CRam byte address
+			LOG_VSRAM_16,	// address: VSRam.u16[] index
+			LOG_LINE,	// address: Line state index
+		};
+
+		/**
+		 * Log a VDP memory write.
+		 * @param type Log entry type.
+		 * @param address Address. (See LogType_t.)
+		 * @param data Data.
+		 */
+		inline void logWrite(LogType_t type, uint32_t address, uint16_t data);
+
+		/**
+		 * Queue the current line for rendering.
+		 * Called by Vdp::renderLine().
+		 */
+		void queueLine(void);
+
+		/**
+		 * Wait for the worker to render all queued lines.
+		 * Status bits set by the renderer are merged
+		 * into the VDP status register.
+		 */
+		void sync(void);
+
+		/**
+		 * Make sure the status register is up to date.
+		 * Only waits for the worker if it might set COL.
+		 */
+		inline void syncStatus(void);
+
+		/**
+		 * Wait for the worker, then copy the entire
+		 * VDP memory state to the shadow VDP.
+		 * Needed after reset and savestate loading.
+		 */
+		void resync(void);
+
+	private:
+		/**
+		 * Rendering state that isn't stored in VDP memory.
+		 * Saved at the end of each line.
+		 */
+		struct LineState_t {
+			// Vdp
+			VdpTypes::VdpLines_t VDP_Lines;
+			VdpTypes::VdpEmuOptions_t options;
+			unsigned int SysStatus;
+
+			// VdpPrivate
+			unsigned int H_Cell;
+			int H_Pix;
+			int H_Pix_Begin;
+			uint8_t H_Win_Shift;
+			uint8_t V_Scroll_MMask;
+			uint8_t H_Scroll_Mask;
+			uint8_t H_Scroll_CMul;
+			uint8_t H_Scroll_CMask;
+			uint8_t V_Scroll_CMask;
+			bool im2_flag;
+			unsigned int Win_X_Pos;
+			unsigned int Win_Y_Pos;
+			VdpTypes::VDP_Mode_t VDP_Mode;
+			VdpTypes::VDP_Model_t VDP_Model;
+			uint16_t status;
+			VdpTypes::VdpReg_t VDP_Reg;
+			uint32_t ScrA_Tbl_Addr;
+			uint32_t ScrB_Tbl_Addr;
+			uint32_t Win_Tbl_Addr;
+			uint32_t Spr_Tbl_Addr;
+			uint32_t H_Scroll_Tbl_Addr;
+			uint32_t ScrA_Gen_Addr;
+			uint32_t ScrB_Gen_Addr;
+			uint32_t Spr_Gen_Addr;
+			uint32_t VRam_Mask;
+			uint32_t ScrA_Tbl_Mask;
+			uint32_t ScrB_Tbl_Mask;
+			uint32_t Win_Tbl_Mask;
+			uint32_t Spr_Tbl_Mask;
+			uint32_t H_Scroll_Tbl_Mask;
+			unsigned int VDP_Layers;
+
+			// VdpPalette
+			VdpPalette::PalMode_t palMode;
+			uint8_t bgColorIdx;
+			uint8_t m5m4bits;
+			bool mdShadowHighlight;
+		};
+
+		/**
+		 * Save the rendering state.
+		 * @param state Line state.
+		 * @param vdp Source VDP.
+		 */
+		static void saveLineState(LineState_t *state, const Vdp *vdp);
+
+		/**
+		 * Load the rendering state.
+		 * @param vdp Destination VDP.
+		 * @param state Line state.
+		 */
+		static void loadLineState(Vdp *vdp, const LineState_t *state);
+
+		// Log entry.
+		struct LogEntry_t {
+			uint8_t type;
+			uint8_t reserved;
+			uint16_t data;
+			uint32_t address;
+		};
+
+		// Log ring buffer.
+		// m_write is only used by the emulation thread.
+		// m_head is published to the worker; m_tail is
+		// the worker's progress.
+		static const uint32_t LOG_SIZE = 65536;
+		LogEntry_t *m_log;
+		uint32_t m_write;
+		std::atomic<uint32_t> m_head;
+		std::atomic<uint32_t> m_tail;
+
+		// Line state ring buffer.
+		// Large enough for a full PAL frame.
+		static const uint32_t LINE_SIZE = 512;
+		LineState_t *m_lines;
+		uint32_t m_lineWrite;
+		std::atomic<uint32_t> m_lineDone;
+
+		// Status bits set by the renderer.
+		// Only accessed by the worker while it has
+		// unprocessed log entries, and by the
+		// emulation thread while it doesn't.
+		uint16_t m_status;
+
+		// If true, a line queued since the last sync
+		// has overlapping sprites, so it might set COL.
+		bool m_colPending;
+
+		/**
+		 * Publish the logged entries to the worker.
+		 */
+		void publish(void);
+
+		/**
+		 * Wait until the worker has processed at least
+		 * the specified number of log entries.
+		 * @param count Number of log entries.
+		 */
+		void waitLog(uint32_t count);
+
+		/**
+		 * Flush the log. Called if the log is full.
+		 */
+		void flush(void);
+
+		/**
+		 * Copy renderer-internal state between VDPs.
+		 * @param dest Destination VDP.
+		 * @param src Source VDP.
+		 */
+		static void copyRendState(Vdp *dest, const Vdp *src);
+
+		// Shadow VDP. Only used by the worker
+		// while the log isn't empty.
+		Vdp *m_shadow;
+
+		/**
+		 * Process a log entry.
+		 * @param entry Log entry.
+		 */
+		void processEntry(const LogEntry_t *entry);
+
+		/**
+		 * Worker thread function.
+		 */
+		void run(void);
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_cvWork;	// Worker: Log isn't empty.
+		std::condition_variable m_cvDone;	// Emulation: Worker made progress.
+		bool m_quit;
+};
+
+/**
+ * Log a VDP memory write.
+ * @param type Log entry type.
+ * @param address Address. (See LogType_t.)
+ * @param data Data.
+ */
+inline void VdpRendThread::logWrite(LogType_t type, uint32_t address, uint16_t data)
+{
+	if (m_write - m_tail.load(std::memory_order_acquire) >= LOG_SIZE) {
+		// Log is full.
+		flush();
+	}
+
+	LogEntry_t *const entry = &m_log[m_write & (LOG_SIZE - 1)];
+	entry->type = (uint8_t)type;
+	entry->reserved = 0;
+	entry->data = data;
+	entry->address = address;
+	m_write++;
+}
+
+/**
+ * Make sure the status register is up to date.
+ * Only waits for the worker if it might set COL.
+ */
+inline void VdpRendThread::syncStatus(void)
+{
+	if (m_colPending)
+		sync();
+}
+
+}
+
+#endif /* __LIBGENS_VDP_VDPRENDTHREAD_HPP__ */
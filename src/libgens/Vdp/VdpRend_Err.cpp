@@ -423,6 +423,7 @@ void VdpPrivate::renderLine_Err(void)
 				d_err->T_DrawVDPErrorMessage<uint32_t, 0xFFFFFF>(q->MD_Screen);
 				break;
 		}
+		q->MD_Screen->markAllLinesDirty();
 
 		// Update the borders.
 		updateBorders = true;
@@ -447,6 +448,7 @@ void VdpPrivate::renderLine_Err(void)
 				d_err->T_DrawColorBars_Border<uint16_t>(q->MD_Screen, (uint16_t)newBorderColor);
 			else
 				d_err->T_DrawColorBars_Border<uint32_t>(q->MD_Screen, newBorderColor);
+			q->MD_Screen->markAllLinesDirty();
 		}
 
 		// Save the new border color.
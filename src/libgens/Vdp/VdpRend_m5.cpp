@@ -27,6 +27,9 @@
 // M68K_Mem::ms_Region is needed for region detection.
 #include "cpu/M68K_Mem.hpp"
 
+// CPU flags. Used for SIMD line buffer rendering.
+#include "libcompat/cpuflags.h"
+
 // C includes. (C++ namespace)
 #include <cstring>
 
@@ -49,26 +52,8 @@
 #define LINEBUF_WIN_W	0x0200
 
 // Tile pixel positions.
-#include "libcompat/byteorder.h"
-
-#if SYS_BYTEORDER == SYS_LIL_ENDIAN
-#define TILE_PX0	0x0000F000
-#define TILE_PX1	0x00000F00
-#define TILE_PX2	0x000000F0
-#define TILE_PX3	0x0000000F
-#define TILE_PX4	0xF0000000
-#define TILE_PX5	0x0F000000
-#define TILE_PX6	0x00F00000
-#define TILE_PX7	0x000F0000
-#define TILE_SHIFT0	12
-#define TILE_SHIFT1	8
-#define TILE_SHIFT2	4
-#define TILE_SHIFT3	0
-#define TILE_SHIFT4	28
-#define TILE_SHIFT5	24
-#define TILE_SHIFT6	20
-#define TILE_SHIFT7	16
-#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+// Pattern lines are read from VdpCache, which stores
+// pixel 0 in the high nybble regardless of host byteorder.
 #define TILE_PX0	0xF0000000
 #define TILE_PX1	0x0F000000
 #define TILE_PX2	0x00F00000
@@ -85,7 +70,6 @@
 #define TILE_SHIFT5	8
 #define TILE_SHIFT6	4
 #define TILE_SHIFT7	0
-#endif
 
 // Vdp private class.
 #include "Vdp_p.hpp"
@@ -299,6 +283,78 @@ FORCE_INLINE uint8_t VdpPrivate::T_PutPixel_Sprite(int disp_pixnum, uint32_t pat
 	return 0;
 }
 
+/**
+ * Check if the background layers have a high-priority pixel.
+ * Used for layer compositing.
+ * @param pixnum Line buffer pixel number.
+ * @return True if Scroll A/Window or Scroll B has a high-priority pixel.
+ */
+FORCE_INLINE bool VdpPrivate::LayerBuf_isPlanePrio(unsigned int pixnum) const
+{
+	const uint8_t a = LayerBuf.scrollA[pixnum];
+	const uint8_t b = LayerBuf.scrollB[pixnum];
+	return ((a & LAYERBUF_PRIO) && (a & LAYERBUF_PX_MASK)) ||
+	       ((b & LAYERBUF_PRIO) && (b & LAYERBUF_PX_MASK));
+}
+
+/**
+ * Put a pixel in the sprite layer buffer.
+ * Used for layer compositing.
+ *
+ * Only the first opaque sprite pixel is saved. Priority is
+ * resolved by T_Composite_Layers_m5(). The remaining checks
+ * are only needed for sprite collision, which is identical
+ * to T_PutPixel_Sprite().
+ *
+ * @param priority	[in] Sprite priority.
+ * @param h_s		[in] Highlight/Shadow enable.
+ * @param pat_pixnum	[in] Pattern pixel number.
+ * @param mask		[in] Mask to isolate the good pixel.
+ * @param shift		[in] Shift.
+ * @param disp_pixnum	[in] Display pixel number.
+ * @param pattern	[in] Pattern data.
+ * @param palette	[in] Palette number * 16.
+ * @return LINEBUF_SPR_B if a sprite collision occurred; otherwise, 0.
+ */
+template<bool priority, bool h_s, int pat_pixnum, uint32_t mask, int shift>
+FORCE_INLINE uint8_t VdpPrivate::T_PutPixel_SpriteLayer(int disp_pixnum, uint32_t pattern, unsigned int palette)
+{
+	// Check if this is a transparent pixel.
+	unsigned int px = (pattern & mask);
+	if (px == 0)
+		return 0;
+
+	// Get the pixel number in the linebuffer.
+	const unsigned int LineBuf_pixnum = (disp_pixnum + pat_pixnum + 8);
+	const uint8_t spr = LayerBuf.sprite[LineBuf_pixnum];
+
+	if (spr == 0) {
+		// First sprite pixel.
+		px = ((px >> shift) | palette);
+		if (priority)
+			px |= LAYERBUF_PRIO;
+		LayerBuf.sprite[LineBuf_pixnum] = (uint8_t)px;
+		return 0;
+	}
+
+	if (h_s && (spr & 0x3E) == 0x3E) {
+		// First sprite pixel is an S/H operator.
+		if ((spr & LAYERBUF_PRIO) || !LayerBuf_isPlanePrio(LineBuf_pixnum)) {
+			// The operator was applied. Later sprites are masked,
+			// but a low-priority sprite hidden by a high-priority
+			// plane still sets the sprite bit.
+			if (spr & LAYERBUF_SPR_HIDDEN)
+				return LINEBUF_SPR_B;
+			if (!priority && LayerBuf_isPlanePrio(LineBuf_pixnum))
+				LayerBuf.sprite[LineBuf_pixnum] = (spr | LAYERBUF_SPR_HIDDEN);
+			return 0;
+		}
+	}
+
+	// Sprite collision.
+	return LINEBUF_SPR_B;
+}
+
 #define LINEBUF_HIGH_D	0x80808080
 #define LINEBUF_SHAD_D	0x40404040
 #define LINEBUF_PRIO_D	0x01000100
@@ -309,12 +365,11 @@ FORCE_INLINE uint8_t VdpPrivate::T_PutPixel_Sprite(int disp_pixnum, uint32_t pat
  * Put a line in background graphics layer 0. (low-priority)
  * @param plane		[in] True for Scroll A; false for Scroll B.
  * @param h_s		[in] Highlight/Shadow enable.
- * @param flip		[in] True to flip the line horizontally.
  * @param disp_pixnum	[in] Display pixel nmber.
  * @param pattern	[in] Pattern data.
  * @param palette	[in] Palette number * 16.
  */
-template<bool plane, bool h_s, bool flip>
+template<bool plane, bool h_s>
 FORCE_INLINE void VdpPrivate::T_PutLine_P0(int disp_pixnum, uint32_t pattern, int palette)
 {
 	if (!plane) {
@@ -334,39 +389,26 @@ FORCE_INLINE void VdpPrivate::T_PutLine_P0(int disp_pixnum, uint32_t pattern, in
 		return;
 
 	// Put the pixels.
-	if (!flip) {
-		// No flip.
-		T_PutPixel_P0<plane, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 3, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 4, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
-	} else {
-		// Horizontal flip.
-		T_PutPixel_P0<plane, h_s, 0, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 1, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 2, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 3, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 4, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 5, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 6, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
-		T_PutPixel_P0<plane, h_s, 7, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
-	}
+	// H-flip is handled by the pattern cache.
+	T_PutPixel_P0<plane, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 3, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 4, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
+	T_PutPixel_P0<plane, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
 }
 
 /**
  * Put a line in background graphics layer 1. (high-priority)
  * @param plane		[in] True for Scroll A; false for Scroll B.
  * @param h_s		[in] Highlight/Shadow enable.
- * @param flip		[in] True to flip the line horizontally.
  * @param disp_pixnum	[in] Display pixel nmber.
  * @param pattern	[in] Pattern data.
  * @param palette	[in] Palette number * 16.
  */
-template<bool plane, bool h_s, bool flip>
+template<bool plane, bool h_s>
 FORCE_INLINE void VdpPrivate::T_PutLine_P1(int disp_pixnum, uint32_t pattern, int palette)
 {
 	if (!plane) {
@@ -400,26 +442,120 @@ FORCE_INLINE void VdpPrivate::T_PutLine_P1(int disp_pixnum, uint32_t pattern, in
 		return;
 
 	// Put the pixels.
-	if (!flip) {
-		// No flip.
-		T_PutPixel_P1<plane, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 3, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 4, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
+	// H-flip is handled by the pattern cache.
+	T_PutPixel_P1<plane, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 3, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 4, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
+	T_PutPixel_P1<plane, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
+}
+
+/**
+ * Put a full cell in a background graphics layer.
+ * This is used by the T_Render_Line_Scroll() fast path.
+ * The output is identical to T_PutLine_P0() and T_PutLine_P1(),
+ * but all eight pixels are calculated at once and written
+ * to the line buffer with a single 16-byte copy.
+ *
+ * Requirements:
+ * - Scroll B: LineBuf must have been cleared for this line.
+ * - Scroll A: There must not be any Window pixels on this line.
+ *
+ * @param plane		[in] True for Scroll A; false for Scroll B.
+ * @param h_s		[in] Highlight/Shadow enable.
+ * @param disp_pixnum	[in] Display pixel nmber.
+ * @param pattern	[in] Pattern data.
+ * @param palette	[in] Palette number * 16.
+ * @param priority	[in] True for high priority.
+ */
+template<bool plane, bool h_s>
+FORCE_INLINE void VdpPrivate::T_PutLine_Cell(int disp_pixnum, uint32_t pattern, int palette, bool priority)
+{
+	if (!(VDP_Layers & (plane ? VdpTypes::VDP_LAYER_SCROLLA_LOW : VdpTypes::VDP_LAYER_SCROLLB_LOW))) {
+		// Layer is disabled.
+		// Scroll A: Don't do anything.
+		// Scroll B: High-priority cells still clear the line.
+		if (plane)
+			return;
+		pattern = 0;
+	}
+
+	uint16_t cell[8];
+	if (!plane) {
+		// Scroll B.
+		// LineBuf was cleared to LINEBUF_SHAD_W or 0,
+		// so the previous contents don't need to be read.
+		const uint16_t base = (priority ? 0 : (h_s ? LINEBUF_SHAD_W : 0));
+		const uint16_t prio = (priority ? LINEBUF_PRIO_W : 0);
+		for (int i = 0; i < 8; i++) {
+			const unsigned int px = (pattern >> (TILE_SHIFT0 - (i * 4))) & 0x0F;
+			cell[i] = (px ? (base | prio | palette | px) : base);
+		}
+	} else {
+		// Scroll A.
+		memcpy(cell, &LineBuf.u16[disp_pixnum], sizeof(cell));
+		if (priority) {
+			for (int i = 0; i < 8; i++) {
+				const unsigned int px = (pattern >> (TILE_SHIFT0 - (i * 4))) & 0x0F;
+				cell[i] = (px ? (LINEBUF_PRIO_W | palette | px) : (cell[i] & ~LINEBUF_SHAD_W));
+			}
+		} else {
+			for (int i = 0; i < 8; i++) {
+				const unsigned int px = (pattern >> (TILE_SHIFT0 - (i * 4))) & 0x0F;
+				// If the pixel has priority, Scroll A is masked.
+				// Otherwise, the shadow bit is copied from the layer bits.
+				const unsigned int shad = (h_s ? ((cell[i] >> 8) & LINEBUF_SHAD_B) : 0);
+				if (px && !(cell[i] & LINEBUF_PRIO_W))
+					cell[i] = (cell[i] & 0xFF00) | palette | shad | px;
+			}
+		}
+	}
+
+	memcpy(&LineBuf.u16[disp_pixnum], cell, sizeof(cell));
+}
+
+/**
+ * Put a line in a background layer buffer.
+ * Used for layer compositing.
+ * @param plane		[in] True for Scroll A / Window; false for Scroll B.
+ * @param window	[in] True for Window. (Scroll A must be drawn first.)
+ * @param disp_pixnum	[in] Display pixel nmber.
+ * @param pattern	[in] Pattern data.
+ * @param palette	[in] Palette number * 16.
+ * @param priority	[in] True for high priority.
+ */
+template<bool plane, bool window>
+FORCE_INLINE void VdpPrivate::T_PutLine_Layer(int disp_pixnum, uint32_t pattern, int palette, bool priority)
+{
+	if (!plane) {
+		// Scroll B.
+		// If ScrollB_Low is disabled, don't draw any pixels.
+		// High-priority cells still clear the line.
+		if (!(VDP_Layers & VdpTypes::VDP_LAYER_SCROLLB_LOW))
+			pattern = 0;
 	} else {
-		// Horizontal flip.
-		T_PutPixel_P1<plane, h_s, 0, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 1, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 2, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 3, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 4, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 5, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 6, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
-		T_PutPixel_P1<plane, h_s, 7, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
+		// Scroll A.
+		// If ScrollA Low is disabled. don't do anything.
+		if (!(VDP_Layers & VdpTypes::VDP_LAYER_SCROLLA_LOW))
+			return;
+	}
+
+	uint8_t *buf = (plane ? &LayerBuf.scrollA[disp_pixnum] : &LayerBuf.scrollB[disp_pixnum]);
+	const uint8_t prio = (priority ? LAYERBUF_PRIO : 0);
+
+	// Put the pixels.
+	// H-flip is handled by the pattern cache.
+	for (int i = 0; i < 8; i++, pattern <<= 4) {
+		const unsigned int px = (pattern >> TILE_SHIFT0);
+		uint8_t entry = (px ? (px | palette) : 0) | prio;
+		if (window && (buf[i] & LAYERBUF_PRIO)) {
+			// High-priority Scroll A cell overlaps this Window pixel.
+			entry |= LAYERBUF_WIN_PRIO;
+		}
+		buf[i] = entry;
 	}
 }
 
@@ -427,12 +563,12 @@ FORCE_INLINE void VdpPrivate::T_PutLine_P1(int disp_pixnum, uint32_t pattern, in
  * Put a line in the sprite layer.
  * @param priority	[in] Sprite priority. (false == low, true == high)
  * @param h_s		[in] Highlight/Shadow enable.
- * @param flip		[in] True to flip the line horizontally.
+ * @param layers	[in] If true, render to the sprite layer buffer.
  * @param disp_pixnum	[in] Display pixel nmber.
  * @param pattern	[in] Pattern data.
  * @param palette	[in] Palette number * 16.
  */
-template<bool priority, bool h_s, bool flip>
+template<bool priority, bool h_s, bool layers>
 FORCE_INLINE void VdpPrivate::T_PutLine_Sprite(int disp_pixnum, uint32_t pattern, int palette)
 {
 	// Check if the sprite layer is disabled.
@@ -445,9 +581,18 @@ FORCE_INLINE void VdpPrivate::T_PutLine_Sprite(int disp_pixnum, uint32_t pattern
 	}
 
 	// Put the sprite pixels.
+	// H-flip is handled by the pattern cache.
 	uint8_t status = 0;
-	if (!flip) {
-		// No flip.
+	if (layers) {
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 3, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 4, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
+		status |= T_PutPixel_SpriteLayer<priority, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
+	} else {
 		status |= T_PutPixel_Sprite<priority, h_s, 0, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
 		status |= T_PutPixel_Sprite<priority, h_s, 1, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
 		status |= T_PutPixel_Sprite<priority, h_s, 2, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
@@ -456,16 +601,6 @@ FORCE_INLINE void VdpPrivate::T_PutLine_Sprite(int disp_pixnum, uint32_t pattern
 		status |= T_PutPixel_Sprite<priority, h_s, 5, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
 		status |= T_PutPixel_Sprite<priority, h_s, 6, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
 		status |= T_PutPixel_Sprite<priority, h_s, 7, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
-	} else {
-		// Horizontal flip.
-		status |= T_PutPixel_Sprite<priority, h_s, 0, TILE_PX7, TILE_SHIFT7>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 1, TILE_PX6, TILE_SHIFT6>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 2, TILE_PX5, TILE_SHIFT5>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 3, TILE_PX4, TILE_SHIFT4>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 4, TILE_PX3, TILE_SHIFT3>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 5, TILE_PX2, TILE_SHIFT2>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 6, TILE_PX1, TILE_SHIFT1>(disp_pixnum, pattern, palette);
-		status |= T_PutPixel_Sprite<priority, h_s, 7, TILE_PX0, TILE_SHIFT0>(disp_pixnum, pattern, palette);
 	}
 
 	// Check for sprite collision.
@@ -634,28 +769,14 @@ FORCE_INLINE uint16_t VdpPrivate::T_Get_Nametable_Word(unsigned int x, unsigned
 template<bool interlaced>
 FORCE_INLINE uint32_t VdpPrivate::T_Get_Pattern_Data(uint16_t pattern, unsigned int y_fine_offset)
 {
-	// Get the tile address.
-	unsigned int TileAddr;
+	// The pattern cache handles V-flip and H-flip.
+	// FIXME: Rebase to upper 64 KB if necessary. (128 KB VRAM mode)
 	if (interlaced) {
-		// FIXME: High bit may be usable for 128 KB mode.
-		TileAddr = (pattern & 0x3FF) << 6;
+		return patternCache.pattern_line_m5_nt_8x16(pattern, y_fine_offset);
 	} else {
 		// Non-interlaced, or Interlaced Mode 1.
-		TileAddr = (pattern & 0x7FF) << 5;
+		return patternCache.pattern_line_m5_nt_8x8(pattern, y_fine_offset);
 	}
-
-	if (pattern & 0x1000) {
-		// V Flip enabled. Flip the tile vertically.
-		if (interlaced) {
-			y_fine_offset ^= 15;
-		} else {
-			y_fine_offset ^= 7;
-		}
-	}
-
-	// Return the pattern data.
-	// FIXME: Rebase to upper 64 KB if necessary. (128 KB VRAM mode)
-	return VRam.u32[(TileAddr + (y_fine_offset * 4)) >> 2];
 }
 
 /**
@@ -664,10 +785,11 @@ FORCE_INLINE uint32_t VdpPrivate::T_Get_Pattern_Data(uint16_t pattern, unsigned
  * @param interlaced	[in] True for interlaced; false for non-interlaced.
  * @param vscroll	[in] True for 2-cell mode; false for full scroll.
  * @param h_s		[in] Highlight/Shadow enable.
+ * @param layers	[in] If true, render to the layer buffer.
  * @param cell_start	[in] (Scroll A) First cell to draw.
  * @param cell_length	[in] (Scroll A) Number of cells to draw.
  */
-template<bool plane, bool interlaced, bool vscroll, bool h_s>
+template<bool plane, bool interlaced, bool vscroll, bool h_s, bool layers>
 FORCE_INLINE void VdpPrivate::T_Render_Line_Scroll(int cell_start, int cell_length)
 {
 	// Get the horizontal scroll offset. (cell and fine offset)
@@ -717,6 +839,29 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Scroll(int cell_start, int cell_leng
 		y_offset = T_Get_Y_Offset<plane, interlaced>(0);
 		y_cell_offset = T_Get_Y_Cell_Offset<interlaced, true>(y_offset);
 		y_fine_offset = T_Get_Y_Fine_Offset<interlaced>(y_offset);
+
+		if (!layers && (!plane || (cell_start == 0 && cell_length >= (int)H_Cell))) {
+			// Fast path: Full vertical scrolling with no Window on this line.
+			// The Y offset is constant, and the Left Window bug and the
+			// VScroll bug can't apply, so each cell only needs a nametable
+			// fetch and a pattern fetch.
+			for (int x = cell_length; x >= 0; x--) {
+				uint16_t nametable_word = T_Get_Nametable_Word<plane>(x_cell_offset, y_cell_offset);
+				const uint32_t pattern_data = T_Get_Pattern_Data<interlaced>(nametable_word, y_fine_offset);
+				const unsigned int palette = (nametable_word >> 9) & 0x30;
+
+				// Check for swapped Scroll B priority.
+				if (VDP_Layers & VdpTypes::VDP_LAYER_SCROLLB_SWAP)
+					nametable_word ^= 0x8000;
+
+				T_PutLine_Cell<plane, h_s>(disp_pixnum, pattern_data, palette, !!(nametable_word & 0x8000));
+
+				// Go to the next H cell.
+				x_cell_offset = (x_cell_offset + 1) & H_Scroll_CMask;
+				disp_pixnum += 8;
+			}
+			return;
+		}
 	}
 
 	// Loop through the cells.
@@ -758,20 +903,13 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Scroll(int cell_start, int cell_leng
 		if (VDP_Layers & VdpTypes::VDP_LAYER_SCROLLB_SWAP)
 			nametable_word ^= 0x8000;
 
-		// Check for horizontal flip.
-		if (nametable_word & 0x0800) {
-			// Pattern has H-Flip enabled.
-			if (nametable_word & 0x8000)
-				T_PutLine_P1<plane, h_s, true>(disp_pixnum, pattern_data, palette);
-			else
-				T_PutLine_P0<plane, h_s, true>(disp_pixnum, pattern_data, palette);
-		} else {
-			// Pattern doesn't have flip enabled.
-			if (nametable_word & 0x8000)
-				T_PutLine_P1<plane, h_s, false>(disp_pixnum, pattern_data, palette);
-			else
-				T_PutLine_P0<plane, h_s, false>(disp_pixnum, pattern_data, palette);
-		}
+		// Check for high priority.
+		if (layers)
+			T_PutLine_Layer<plane, false>(disp_pixnum, pattern_data, palette, !!(nametable_word & 0x8000));
+		else if (nametable_word & 0x8000)
+			T_PutLine_P1<plane, h_s>(disp_pixnum, pattern_data, palette);
+		else
+			T_PutLine_P0<plane, h_s>(disp_pixnum, pattern_data, palette);
 
 		// Go to the next H cell.
 		x_cell_offset = (x_cell_offset + 1) & H_Scroll_CMask;
@@ -786,8 +924,9 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Scroll(int cell_start, int cell_leng
  * @param interlaced	[in] True for interlaced; false for non-interlaced.
  * @param vscroll	[in] True for 2-cell mode; false for full scroll.
  * @param h_s		[in] Highlight/Shadow enable.
+ * @param layers	[in] If true, render to the layer buffer.
  */
-template<bool interlaced, bool vscroll, bool h_s>
+template<bool interlaced, bool vscroll, bool h_s, bool layers>
 FORCE_INLINE void VdpPrivate::T_Render_Line_ScrollA_Window(void)
 {
 	// Cell counts for Scroll A.
@@ -833,6 +972,13 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_ScrollA_Window(void)
 		}
 	}
 
+	if (layers && ScrA_Length > 0) {
+		// Layer buffer: Draw the scroll area first.
+		// Window pixels replace Scroll A pixels, but they
+		// need to know if Scroll A has high priority.
+		T_Render_Line_Scroll<true, interlaced, vscroll, h_s, true>(ScrA_Start, ScrA_Length);
+	}
+
 	if (Win_Length > 0) {
 		// Draw the window.
 
@@ -867,25 +1013,18 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_ScrollA_Window(void)
 			if (VDP_Layers & VdpTypes::VDP_LAYER_SCROLLA_SWAP)
 				pattern_info ^= 0x8000;
 
-			// Check for horizontal flip.
-			if (pattern_info & 0x0800) {
-				// Pattern has H-Flip enabled.
-				if (pattern_info & 0x8000)
-					T_PutLine_P1<true, h_s, true>(disp_pixnum, pattern_data, palette);
-				else
-					T_PutLine_P0<true, h_s, true>(disp_pixnum, pattern_data, palette);
-			} else {
-				// Pattern doesn't have flip enabled.
-				if (pattern_info & 0x8000)
-					T_PutLine_P1<true, h_s, false>(disp_pixnum, pattern_data, palette);
-				else
-					T_PutLine_P0<true, h_s, false>(disp_pixnum, pattern_data, palette);
-			}
+			// Check for high priority.
+			if (layers)
+				T_PutLine_Layer<true, true>(disp_pixnum, pattern_data, palette, !!(pattern_info & 0x8000));
+			else if (pattern_info & 0x8000)
+				T_PutLine_P1<true, h_s>(disp_pixnum, pattern_data, palette);
+			else
+				T_PutLine_P0<true, h_s>(disp_pixnum, pattern_data, palette);
 		}
 
 		// Mark window pixels.
 		// TODO: Do this in the Window drawing code!
-		if (ScrA_Length > 0) {
+		if (!layers && ScrA_Length > 0) {
 			const int StartPx = ((Win_Start * 8) + 8) / 2;
 			const int EndPx = StartPx + ((Win_Length * 8) / 2);
 
@@ -894,9 +1033,9 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_ScrollA_Window(void)
 		}
 	}
 
-	if (ScrA_Length > 0) {
+	if (!layers && ScrA_Length > 0) {
 		// Draw the scroll area.
-		T_Render_Line_Scroll<true, interlaced, vscroll, h_s>(ScrA_Start, ScrA_Length);
+		T_Render_Line_Scroll<true, interlaced, vscroll, h_s, false>(ScrA_Start, ScrA_Length);
 	}
 }
 
@@ -933,7 +1072,6 @@ unsigned int VdpPrivate::T_Update_Sprite_Line_Cache_m5(int line)
 	// is used in Vdp.cpp. gcc-5.1 fails in release builds due to
 	// the function definition not being available there.
 	unsigned int ret = 0;
-	uint8_t link = 0;
 
 	// Determine the maximum number of sprites.
 	// NOTE: Max sprites per frame is always limited
@@ -978,22 +1116,99 @@ unsigned int VdpPrivate::T_Update_Sprite_Line_Cache_m5(int line)
 		cacheId = line & 1;
 	}
 	SprLineCache_t *cache = &sprLineCache[cacheId][0];
-	uint8_t count = 0;
 
-	/**
-	 * The following values are read from the cached
-	 * Sprite Attribute Table instead of VRAM:
-	 * - Y position
-	 * - Sprite size
-	 * - Link number
-	 */
-	const VdpStructs::SprEntry_m5 *spr_SAT = &SprAttrTbl_m5.spr[0];
+	// Make sure the sprite bins are up to date.
+	if (sprBins.dirty || sprBins.interlaced != interlaced ||
+	    sprBins.max_spr_frame != max_spr_frame)
+	{
+		T_Update_Sprite_Bins_m5<interlaced>(max_spr_frame);
+	}
+
+	// Get the sprites on this line.
+	// NOTE: Lines outside of the bins are never displayed.
+	const uint8_t *bin = nullptr;
+	uint8_t count = 0;
+	if (line >= 0 && line < SPR_BIN_LINES) {
+		bin = &sprBins.spr[line][0];
+		count = sprBins.count[line];
+	}
 
 	// Process up to max_spr_line sprites.
 	// (16 in H32, 20 in H40.)
+	if (count > max_spr_line) {
+		// Sprite overflow!
+		ret = VdpStatus::VDP_STATUS_SOVR;
+		count = max_spr_line;
+	}
+
+	for (int i = 0; i < count; i++, cache++) {
+		const uint8_t link = bin[i];
+
+		/**
+		 * The following values are read from the cached
+		 * Sprite Attribute Table instead of VRAM:
+		 * - Y position
+		 * - Sprite size
+		 */
+		const VdpStructs::SprEntry_m5 *spr_SAT = &SprAttrTbl_m5.spr[link];
+		int y = spr_SAT->y;
+		if (interlaced) {
+			y = (y & 0x3FF) - 256;
+		} else {
+			y = (y & 0x1FF) - 128;
+		}
+
+		// Calculate the sprite's height.
+		const uint8_t sz = spr_SAT->sz;
+		int height = (sz & 3);
+		if (interlaced) {
+			height = (height * 16) + 15;
+		} else {
+			height = (height * 8) + 7;
+		}
+
+		// Get the remaining sprite information from VRAM.
+		const VdpStructs::SprEntry_m5 *spr_VRam = Spr_Tbl_Addr_PtrM5(link);
+
+		// Save the sprite information in the line cache.
+		cache->Pos_X = (spr_VRam->x & 0x1FF) - 128;
+		cache->Pos_Y = y;
+		// NOTE: Size_? is in units of cells, not pixels.
+		cache->Size_X = ((sz >> 2) & 3) + 1;	// 1 more than the original value.
+		cache->Size_Y = (sz & 3);		// Exactly the original value.
+		// Pos_Y_Max is in units of pixels.
+		cache->Pos_Y_Max = y + height;	// height is already -1
+		// Tile number. (Also includes palette, priority, and flip bits.)
+		cache->Num_Tile = spr_VRam->attr;
+	}
+
+	// Save the sprite count for the next line.
+	sprCountCache[cacheId] = count;
+
+	// Return the SOVR flag.
+	return ret;
+}
+
+/**
+ * Rebuild the sprite scanline bins.
+ * The SAT cache's link list is walked once, and each
+ * sprite is added to the bins for the lines it covers.
+ * @param interlaced If true, using Interlaced Mode 2. (2x res)
+ * @param max_spr_frame Maximum number of sprites per frame.
+ */
+template<bool interlaced>
+void VdpPrivate::T_Update_Sprite_Bins_m5(uint8_t max_spr_frame)
+{
+	memset(sprBins.count, 0, sizeof(sprBins.count));
+
+	// NOTE: If the link list has a loop, sprites are added
+	// once per visit, as with a per-line walk. The total number
+	// of visits is limited to max_spr_frame, so bins can't overflow.
+	const VdpStructs::SprEntry_m5 *spr_SAT = &SprAttrTbl_m5.spr[0];
+	uint8_t link = 0;
 	int total_spr_count = max_spr_frame;
 	do {
-		// Check the Y position.
+		// Get the Y position.
 		int y = spr_SAT->y;
 		if (interlaced) {
 			y = (y & 0x3FF) - 256;
@@ -1001,44 +1216,22 @@ unsigned int VdpPrivate::T_Update_Sprite_Line_Cache_m5(int line)
 			y = (y & 0x1FF) - 128;
 		}
 
-		if (line >= y) {
-			// Calculate the sprite's height.
-			const uint8_t sz = spr_SAT->sz;
-			int height = (sz & 3);
-			if (interlaced) {
-				height = (height * 16) + 15;
-			} else {
-				height = (height * 8) + 7;
-			}
-
-			// Check if the bottom of the sprite is in range.
-			const int y_max = y + height;	// height is already -1
-			if (line <= y_max) {
-				// Sprite is in range.
-				if (count == max_spr_line) {
-					// Sprite overflow!
-					ret = VdpStatus::VDP_STATUS_SOVR;
-					break;
-				}
+		// Calculate the sprite's height.
+		int height = (spr_SAT->sz & 3);
+		if (interlaced) {
+			height = (height * 16) + 15;
+		} else {
+			height = (height * 8) + 7;
+		}
 
-				// Get the remaining sprite information from VRAM.
-				const VdpStructs::SprEntry_m5 *spr_VRam = Spr_Tbl_Addr_PtrM5(link);
-
-				// Save the sprite information in the line cache.
-				cache->Pos_X = (spr_VRam->x & 0x1FF) - 128;
-				cache->Pos_Y = y;
-				// NOTE: Size_? is in units of cells, not pixels.
-				cache->Size_X = ((sz >> 2) & 3) + 1;	// 1 more than the original value.
-				cache->Size_Y = (sz & 3);		// Exactly the original value.
-				// Pos_Y_Max is in units of pixels.
-				cache->Pos_Y_Max = y_max;
-				// Tile number. (Also includes palette, priority, and flip bits.)
-				cache->Num_Tile = spr_VRam->attr;
-
-				// Added a sprite.
-				count++;
-				cache++;
-			}
+		// Add the sprite to each line it covers.
+		int y_max = y + height;	// height is already -1
+		if (y < 0)
+			y = 0;
+		if (y_max >= SPR_BIN_LINES)
+			y_max = SPR_BIN_LINES - 1;
+		for (; y <= y_max; y++) {
+			sprBins.spr[y][sprBins.count[y]++] = link;
 		}
 
 		// Link field.
@@ -1054,19 +1247,18 @@ unsigned int VdpPrivate::T_Update_Sprite_Line_Cache_m5(int line)
 		spr_SAT = &SprAttrTbl_m5.spr[link];
 	} while (--total_spr_count);
 
-	// Save the sprite count for the next line.
-	sprCountCache[cacheId] = count;
-
-	// Return the SOVR flag.
-	return ret;
+	sprBins.max_spr_frame = max_spr_frame;
+	sprBins.interlaced = interlaced;
+	sprBins.dirty = false;
 }
 
 /**
  * Render a sprite line.
  * @param interlaced	[in] True for interlaced; false for non-interlaced.
  * @param h_s		[in] Highlight/Shadow enable.
+ * @param layers	[in] If true, render to the sprite layer buffer.
  */
-template<bool interlaced, bool h_s>
+template<bool interlaced, bool h_s, bool layers>
 FORCE_INLINE void VdpPrivate::T_Render_Line_Sprite(void)
 {
 	// Current line number, adjusting for Interlaced Mode 2.
@@ -1204,15 +1396,15 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Sprite(void)
 			if ((VDP_Layers & VdpTypes::VDP_LAYER_SPRITE_ALWAYSONTOP) || (spr_info & 0x8000)) {
 				// High priority.
 				for (; H_Pos_Max >= H_Pos_Min; H_Pos_Max -= 8) {
-					uint32_t pattern = Spr_Gen_Addr_u32(tile_num);
-					T_PutLine_Sprite<true, h_s, true>(H_Pos_Max, pattern, palette);
+					uint32_t pattern = Spr_Gen_Addr_Cache(tile_num, true);
+					T_PutLine_Sprite<true, h_s, layers>(H_Pos_Max, pattern, palette);
 					tile_num += Y_cell_size;
 				}
 			} else {
 				// Low priority.
 				for (; H_Pos_Max >= H_Pos_Min; H_Pos_Max -= 8) {
-					uint32_t pattern = Spr_Gen_Addr_u32(tile_num);
-					T_PutLine_Sprite<false, h_s, true>(H_Pos_Max, pattern, palette);
+					uint32_t pattern = Spr_Gen_Addr_Cache(tile_num, true);
+					T_PutLine_Sprite<false, h_s, layers>(H_Pos_Max, pattern, palette);
 					tile_num += Y_cell_size;
 				}
 			}
@@ -1230,15 +1422,15 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Sprite(void)
 			if ((VDP_Layers & VdpTypes::VDP_LAYER_SPRITE_ALWAYSONTOP) || (spr_info & 0x8000)) {
 				// High priority.
 				for (; H_Pos_Min < H_Pos_Max; H_Pos_Min += 8) {
-					uint32_t pattern = Spr_Gen_Addr_u32(tile_num);
-					T_PutLine_Sprite<true, h_s, false>(H_Pos_Min, pattern, palette);
+					uint32_t pattern = Spr_Gen_Addr_Cache(tile_num, false);
+					T_PutLine_Sprite<true, h_s, layers>(H_Pos_Min, pattern, palette);
 					tile_num += Y_cell_size;
 				}
 			} else {
 				// Low priority.
 				for (; H_Pos_Min < H_Pos_Max; H_Pos_Min += 8) {
-					uint32_t pattern = Spr_Gen_Addr_u32(tile_num);
-					T_PutLine_Sprite<false, h_s, false>(H_Pos_Min, pattern, palette);
+					uint32_t pattern = Spr_Gen_Addr_Cache(tile_num, false);
+					T_PutLine_Sprite<false, h_s, layers>(H_Pos_Min, pattern, palette);
 					tile_num += Y_cell_size;
 				}
 			}
@@ -1262,20 +1454,117 @@ FORCE_INLINE void VdpPrivate::T_Render_Line_Sprite(void)
 template<bool interlaced, bool h_s>
 FORCE_INLINE void VdpPrivate::T_Render_Line_m5(void)
 {
+	// Update the pattern cache.
+	if (patternCache.is_dirty())
+		patternCache.update_m5(&VRam);
+
+	if (q->options.layerCompositing) {
+		// Render each layer into its own buffer,
+		// then composite them into the line buffer.
+		memset(&LayerBuf, 0, sizeof(LayerBuf));
+
+		if (VDP_Reg.m5.Set3 & VDP_REG_M5_SET3_VSCR) {
+			// 2-cell VScroll.
+			T_Render_Line_Scroll<false, interlaced, true, h_s, true>(0, H_Cell);	// Scroll B
+			T_Render_Line_ScrollA_Window<interlaced, true, h_s, true>();		// Scroll A
+		} else {
+			// Full VScroll.
+			T_Render_Line_Scroll<false, interlaced, false, h_s, true>(0, H_Cell);	// Scroll B
+			T_Render_Line_ScrollA_Window<interlaced, false, h_s, true>();		// Scroll A
+		}
+
+		T_Render_Line_Sprite<interlaced, h_s, true>();
+		T_Composite_Layers_m5<h_s>();
+		return;
+	}
+
 	// Clear the line first.
 	memset(&LineBuf, (h_s ? LINEBUF_SHAD_B : 0), sizeof(LineBuf));
 
 	if (VDP_Reg.m5.Set3 & VDP_REG_M5_SET3_VSCR) {
 		// 2-cell VScroll.
-		T_Render_Line_Scroll<false, interlaced, true, h_s>(0, H_Cell);	// Scroll B
-		T_Render_Line_ScrollA_Window<interlaced, true, h_s>();		// Scroll A
+		T_Render_Line_Scroll<false, interlaced, true, h_s, false>(0, H_Cell);	// Scroll B
+		T_Render_Line_ScrollA_Window<interlaced, true, h_s, false>();		// Scroll A
 	} else {
 		// Full VScroll.
-		T_Render_Line_Scroll<false, interlaced, false, h_s>(0, H_Cell);	// Scroll B
-		T_Render_Line_ScrollA_Window<interlaced, false, h_s>();		// Scroll A
+		T_Render_Line_Scroll<false, interlaced, false, h_s, false>(0, H_Cell);	// Scroll B
+		T_Render_Line_ScrollA_Window<interlaced, false, h_s, false>();		// Scroll A
 	}
 
-	T_Render_Line_Sprite<interlaced, h_s>();
+	T_Render_Line_Sprite<interlaced, h_s, false>();
+}
+
+/**
+ * Composite the layer buffers into the line buffer.
+ * The result is identical to rendering with T_PutPixel_P0(),
+ * T_PutPixel_P1(), and T_PutPixel_Sprite() in the visible area.
+ * @param h_s Highlight/Shadow enable.
+ */
+template<bool h_s>
+FORCE_INLINE void VdpPrivate::T_Composite_Layers_m5(void)
+{
+#ifdef VDP_RENDER_HAS_X86_SIMD
+	if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+		Composite_Layers_SSE2(&LineBuf.px[8], &LayerBuf.scrollB[8],
+			&LayerBuf.scrollA[8], &LayerBuf.sprite[8], H_Pix, h_s);
+		return;
+	}
+#endif /* VDP_RENDER_HAS_X86_SIMD */
+
+	// Reference implementation.
+	const uint8_t sh = (h_s ? LINEBUF_SHAD_B : 0);
+	for (int x = 8; x < H_Pix + 8; x++) {
+		uint8_t px, layer;
+
+		// Scroll B.
+		const uint8_t b = LayerBuf.scrollB[x];
+		if (b & LAYERBUF_PRIO) {
+			// High priority. The background is never shadowed.
+			px = (b & LAYERBUF_PX_MASK);
+			layer = (px ? LINEBUF_PRIO_B : 0);
+		} else {
+			px = (b | sh);
+			layer = sh;
+		}
+
+		// Scroll A / Window.
+		const uint8_t a = LayerBuf.scrollA[x];
+		const uint8_t a_px = (a & LAYERBUF_PX_MASK);
+		if (a & LAYERBUF_PRIO) {
+			if (a_px) {
+				px = a_px;
+				layer = LINEBUF_PRIO_B;
+			} else {
+				px &= ~sh;
+				layer &= ~sh;
+			}
+		} else {
+			if (a_px && !(layer & LINEBUF_PRIO_B))
+				px = (a_px | (layer & sh));
+			if (a & LAYERBUF_WIN_PRIO) {
+				px &= ~sh;
+				layer &= ~sh;
+			}
+		}
+
+		// Sprite.
+		const uint8_t spr = LayerBuf.sprite[x];
+		const uint8_t spr_px = (spr & LAYERBUF_PX_MASK);
+		if (spr_px && ((spr & LAYERBUF_PRIO) || !(layer & LINEBUF_PRIO_B))) {
+			if (h_s && (spr_px & 0x3E) == 0x3E) {
+				// Palette 3, color 14/15: Highlight/Shadow operator.
+				px |= (spr_px == 0x3E ? LINEBUF_HIGH_B : LINEBUF_SHAD_B);
+			} else if (h_s && !(spr & LAYERBUF_PRIO) && (spr_px & 0x0F) != 0x0E) {
+				// Low priority. Shadowed if the background is shadowed.
+				// Color 14 in palettes 0-2 are never shadowed.
+				px = (spr_px | (layer & sh));
+			} else {
+				px = spr_px;
+			}
+		}
+
+		LineBuf.u16[x] = px;
+	}
 }
 
 /**
@@ -1292,15 +1581,27 @@ FORCE_INLINE void VdpPrivate::T_Render_LineBuf(pixel *dest, pixel *md_palette)
 	// Render the line buffer to the destination surface.
 	dest += H_Pix_Begin;
 	const pixel *dest_end = dest + H_Pix;
-	for (; dest < dest_end; dest += 8, src += 8) {
-		*(dest+0) = md_palette[src->pixel];
-		*(dest+1) = md_palette[(src+1)->pixel];
-		*(dest+2) = md_palette[(src+2)->pixel];
-		*(dest+3) = md_palette[(src+3)->pixel];
-		*(dest+4) = md_palette[(src+4)->pixel];
-		*(dest+5) = md_palette[(src+5)->pixel];
-		*(dest+6) = md_palette[(src+6)->pixel];
-		*(dest+7) = md_palette[(src+7)->pixel];
+#ifdef VDP_RENDER_HAS_X86_SIMD
+	if (CPU_Flags & MDP_CPUFLAG_X86_AVX2) {
+		Render_LineBuf_AVX2(dest, src, md_palette, H_Pix);
+		dest += H_Pix;
+	} else if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+		Render_LineBuf_SSE2(dest, src, md_palette, H_Pix);
+		dest += H_Pix;
+	} else
+#endif /* VDP_RENDER_HAS_X86_SIMD */
+	{
+		// Reference implementation.
+		for (; dest < dest_end; dest += 8, src += 8) {
+			*(dest+0) = md_palette[src->pixel];
+			*(dest+1) = md_palette[(src+1)->pixel];
+			*(dest+2) = md_palette[(src+2)->pixel];
+			*(dest+3) = md_palette[(src+3)->pixel];
+			*(dest+4) = md_palette[(src+4)->pixel];
+			*(dest+5) = md_palette[(src+5)->pixel];
+			*(dest+6) = md_palette[(src+6)->pixel];
+			*(dest+7) = md_palette[(src+7)->pixel];
+		}
 	}
 
 	if (H_Pix_Begin == 0)
@@ -1366,6 +1667,48 @@ FORCE_INLINE void VdpPrivate::T_Apply_SMS_LCB(pixel *dest, pixel border_color)
 	*(dest+7) = border_color;
 }
 
+/**
+ * Draw a blank line using the background color.
+ * This is equivalent to rendering an empty line buffer
+ * with T_Render_LineBuf() and T_Apply_SMS_LCB().
+ * @param pixel Type of pixel.
+ * @param dest Destination surface.
+ * @param md_palette MD palette buffer.
+ */
+template<typename pixel>
+FORCE_INLINE void VdpPrivate::T_Render_BlankLine(pixel *dest, const pixel *md_palette)
+{
+	const pixel bg_color = md_palette[0];
+	const pixel border_color = (q->options.borderColorEmulation ? bg_color : 0);
+	const bool lcb = !!(VDP_Reg.m5.Set1 & VDP_REG_M5_SET1_LCB);
+	const MdFb::ColorDepth bpp = q->MD_Screen->bpp();
+	pixel *const blank = (sizeof(pixel) == 4
+		? reinterpret_cast<pixel*>(blankLine.u32)
+		: reinterpret_cast<pixel*>(blankLine.u16));
+	const int width = H_Pix + (H_Pix_Begin * 2);
+
+	if (blankLine.bpp != bpp || blankLine.bg_color != bg_color ||
+	    blankLine.border_color != border_color ||
+	    blankLine.h_pix != H_Pix || blankLine.lcb != lcb)
+	{
+		// Rebuild the cached blank line.
+		for (int x = 0; x < width; x++) {
+			blank[x] = border_color;
+		}
+		for (int x = H_Pix_Begin + (lcb ? 8 : 0); x < H_Pix_Begin + H_Pix; x++) {
+			blank[x] = bg_color;
+		}
+
+		blankLine.bpp = bpp;
+		blankLine.bg_color = bg_color;
+		blankLine.border_color = border_color;
+		blankLine.h_pix = H_Pix;
+		blankLine.lcb = lcb;
+	}
+
+	memcpy(dest, blank, width * sizeof(pixel));
+}
+
 /**
  * Render a line. (Mode 5)
  */
@@ -1434,19 +1777,18 @@ void VdpPrivate::renderLine_m5(void)
 			memset(q->MD_Screen->lineBuf32(lineNum), 0x00,
 				(q->MD_Screen->pxPerLine() * sizeof(uint32_t)));
 		}
+		q->MD_Screen->markLineDirty(lineNum);
 
 		// ...and we're done here.
 		return;
 	}
 
 	// Check if the VDP is enabled.
-	if (!(VDP_Reg.m5.Set2 & VDP_REG_M5_SET2_DISP) || in_border) {
+	const bool blank = (!(VDP_Reg.m5.Set2 & VDP_REG_M5_SET2_DISP) || in_border);
+	if (blank) {
 		// VDP is disabled, or this is the border region.
-		// Clear the line buffer.
-
-		// NOTE: S/H is ignored if the VDP is disabled or if
-		// we're in the border region.
-		memset(LineBuf.u8, 0x00, sizeof(LineBuf.u8));
+		// The line is drawn using the background color below,
+		// so the line buffer doesn't need to be rendered.
 
 		// Clear the sprite dot overflow variable.
 		sprDotOverflow = false;
@@ -1500,6 +1842,21 @@ void VdpPrivate::renderLine_m5(void)
 		}
 	}
 
+	if (blank) {
+		// Draw the line using the background color.
+		// NOTE: S/H is ignored if the VDP is disabled or if
+		// we're in the border region.
+		if (q->MD_Screen->bpp() != MdFb::BPP_32) {
+			T_Render_BlankLine<uint16_t>(q->MD_Screen->lineBuf16(lineNum),
+				palette.m_palActive.u16);
+		} else {
+			T_Render_BlankLine<uint32_t>(q->MD_Screen->lineBuf32(lineNum),
+				palette.m_palActive.u32);
+		}
+		q->MD_Screen->markLineDirty(lineNum);
+		return;
+	}
+
 	// Render the image.
 	// TODO: Optimize SMS LCB handling. (maybe use Linux's unlikely() macro?)
 	if (q->MD_Screen->bpp() != MdFb::BPP_32) {
@@ -1523,6 +1880,70 @@ void VdpPrivate::renderLine_m5(void)
 				(q->options.borderColorEmulation ? palette.m_palActive.u32[0] : 0));
 		}
 	}
+
+	// Let the frontend know this line has changed.
+	q->MD_Screen->markLineDirty(lineNum);
+}
+
+/**
+ * Update the sprite line cache without rendering the line. (Mode 5)
+ * Used with threaded rendering. The emulation thread keeps its
+ * own sprite line cache, following the same steps as renderLine_m5(),
+ * so SOVR is set here instead of by the worker.
+ * @return True if two sprites on this line overlap, so the worker might set COL.
+ */
+bool VdpPrivate::updateSprStatus_m5(void)
+{
+	const int lineNum = q->VDP_Lines.currentLine;
+	const bool disp = !!(VDP_Reg.m5.Set2 & VDP_REG_M5_SET2_DISP);
+
+	if (lineNum == (q->VDP_Lines.totalDisplayLines - 1) && disp) {
+		// Line -1, and display is on.
+		// Update the sprite line cache.
+		Update_Sprite_Line_Cache_m5(-1);
+	}
+
+	// Sprites aren't drawn if the display is disabled,
+	// in the border region, or off screen.
+	if (!disp || lineNum >= q->VDP_Lines.totalVisibleLines)
+		return false;
+	if ((lineNum >= q->VDP_Lines.Border.borderStartBottom &&
+	     lineNum <= q->VDP_Lines.Border.borderEndBottom) ||
+	    (lineNum >= q->VDP_Lines.Border.borderStartTop &&
+	     lineNum <= q->VDP_Lines.Border.borderEndTop))
+	{
+		return false;
+	}
+
+	// Check if any two sprites on this line overlap.
+	// NOTE: This ignores transparent pixels, sprite masking,
+	// and dot overflow, so it may report overlaps that
+	// don't actually set COL, but it never misses one.
+	const int line = (im2_flag ? T_GetLineNumber<true>() : T_GetLineNumber<false>());
+	const int cacheId = (im2_flag ? (line >> 1) : line) & 1;
+	const SprLineCache_t *const cache = &sprLineCache[cacheId][0];
+	const int count = sprCountCache[cacheId];
+	bool overlap = false;
+	for (int i = 1; i < count && !overlap; i++) {
+		const int i_min = cache[i].Pos_X;
+		const int i_max = i_min + (cache[i].Size_X * 8);
+		for (int j = 0; j < i; j++) {
+			const int j_min = cache[j].Pos_X;
+			const int j_max = j_min + (cache[j].Size_X * 8);
+			if (i_min < j_max && j_min < i_max) {
+				overlap = true;
+				break;
+			}
+		}
+	}
+
+	// Update the sprite line cache for the next line.
+	if (q->VDP_Lines.currentLine < (q->VDP_Lines.totalDisplayLines - 1)) {
+		// Update only for visible lines.
+		Update_Sprite_Line_Cache_m5(line);
+	}
+
+	return overlap;
 }
 
 // TODO: 32X stuff.
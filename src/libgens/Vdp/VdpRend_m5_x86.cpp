@@ -0,0 +1,261 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * VdpRend_m5_x86.cpp: VDP Mode 5 rendering code. (x86 SIMD functions)     *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Vdp private class.
+#include "Vdp_p.hpp"
+
+#ifdef VDP_RENDER_HAS_X86_SIMD
+
+// SSE2 and AVX2 intrinsics.
+// Each function is compiled with its own target attribute,
+// so the rest of libgens doesn't require SSE2 or AVX2.
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/**
+ * Line buffer format:
+ * Each entry is 16-bit, with the palette index in the low byte.
+ * The palette index includes the shadow/highlight bits,
+ * so the palette lookup handles shadow/highlight.
+ */
+
+namespace LibGens {
+
+/**
+ * Render the line buffer to the destination surface. (SSE2, 15/16-bit color)
+ * SSE2 doesn't have gather instructions, so the palette lookups are
+ * scalar, but the indexes are extracted from vector registers and the
+ * pixels are stored eight at a time.
+ * @param dest Destination surface.
+ * @param src Line buffer.
+ * @param md_palette MD palette buffer. (VdpPalette::m_palActive)
+ * @param count Number of pixels. Must be a multiple of 16.
+ */
+__attribute__ ((target ("sse2")))
+void VdpPrivate::Render_LineBuf_SSE2(uint16_t *dest, const LineBuf_t::LineBuf_px_t *src,
+				     const uint16_t *md_palette, int count)
+{
+	const __m128i *src_v = reinterpret_cast<const __m128i*>(src);
+	const __m128i idx_mask = _mm_set1_epi16(0x00FF);
+
+	for (; count > 0; count -= 8, dest += 8, src_v++) {
+		const __m128i idx = _mm_and_si128(_mm_loadu_si128(src_v), idx_mask);
+		__m128i px = _mm_cvtsi32_si128(md_palette[_mm_extract_epi16(idx, 0)]);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 1)], 1);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 2)], 2);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 3)], 3);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 4)], 4);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 5)], 5);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 6)], 6);
+		px = _mm_insert_epi16(px, md_palette[_mm_extract_epi16(idx, 7)], 7);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), px);
+	}
+}
+
+/**
+ * Render the line buffer to the destination surface. (SSE2, 32-bit color)
+ * SSE2 doesn't have gather instructions, so the palette lookups are
+ * scalar, but the indexes are extracted from vector registers and the
+ * pixels are stored four at a time.
+ * @param dest Destination surface.
+ * @param src Line buffer.
+ * @param md_palette MD palette buffer. (VdpPalette::m_palActive)
+ * @param count Number of pixels. Must be a multiple of 16.
+ */
+__attribute__ ((target ("sse2")))
+void VdpPrivate::Render_LineBuf_SSE2(uint32_t *dest, const LineBuf_t::LineBuf_px_t *src,
+				     const uint32_t *md_palette, int count)
+{
+	const __m128i *src_v = reinterpret_cast<const __m128i*>(src);
+	const __m128i idx_mask = _mm_set1_epi16(0x00FF);
+
+	for (; count > 0; count -= 8, dest += 8, src_v++) {
+		const __m128i idx = _mm_and_si128(_mm_loadu_si128(src_v), idx_mask);
+		const __m128i px_lo = _mm_set_epi32(
+			md_palette[_mm_extract_epi16(idx, 3)],
+			md_palette[_mm_extract_epi16(idx, 2)],
+			md_palette[_mm_extract_epi16(idx, 1)],
+			md_palette[_mm_extract_epi16(idx, 0)]);
+		const __m128i px_hi = _mm_set_epi32(
+			md_palette[_mm_extract_epi16(idx, 7)],
+			md_palette[_mm_extract_epi16(idx, 6)],
+			md_palette[_mm_extract_epi16(idx, 5)],
+			md_palette[_mm_extract_epi16(idx, 4)]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), px_lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), px_hi);
+	}
+}
+
+/**
+ * Render the line buffer to the destination surface. (AVX2, 15/16-bit color)
+ * @param dest Destination surface.
+ * @param src Line buffer.
+ * @param md_palette MD palette buffer. (VdpPalette::m_palActive)
+ * @param count Number of pixels. Must be a multiple of 16.
+ */
+__attribute__ ((target ("avx2")))
+void VdpPrivate::Render_LineBuf_AVX2(uint16_t *dest, const LineBuf_t::LineBuf_px_t *src,
+				     const uint16_t *md_palette, int count)
+{
+	const __m128i *src_v = reinterpret_cast<const __m128i*>(src);
+	const __m256i idx_mask = _mm256_set1_epi32(0x00FF);
+	const __m256i px_mask = _mm256_set1_epi32(0xFFFF);
+	const int *pal = reinterpret_cast<const int*>(md_palette);
+
+	for (; count > 0; count -= 16, dest += 16, src_v += 2) {
+		const __m256i idx_lo = _mm256_and_si256(
+			_mm256_cvtepu16_epi32(_mm_loadu_si128(src_v)), idx_mask);
+		const __m256i idx_hi = _mm256_and_si256(
+			_mm256_cvtepu16_epi32(_mm_loadu_si128(src_v + 1)), idx_mask);
+
+		// Gather 32 bits at each 16-bit palette entry, then mask off
+		// the next entry. Entry 255 reads past the end of the 16-bit
+		// palette, but m_palActive is a union with the 32-bit palette,
+		// so the read is still within the palette buffer.
+		const __m256i px_lo = _mm256_and_si256(
+			_mm256_i32gather_epi32(pal, idx_lo, 2), px_mask);
+		const __m256i px_hi = _mm256_and_si256(
+			_mm256_i32gather_epi32(pal, idx_hi, 2), px_mask);
+
+		// vpackusdw works within 128-bit lanes,
+		// so the 64-bit blocks have to be reordered.
+		__m256i px = _mm256_packus_epi32(px_lo, px_hi);
+		px = _mm256_permute4x64_epi64(px, 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), px);
+	}
+}
+
+/**
+ * Render the line buffer to the destination surface. (AVX2, 32-bit color)
+ * @param dest Destination surface.
+ * @param src Line buffer.
+ * @param md_palette MD palette buffer. (VdpPalette::m_palActive)
+ * @param count Number of pixels. Must be a multiple of 16.
+ */
+__attribute__ ((target ("avx2")))
+void VdpPrivate::Render_LineBuf_AVX2(uint32_t *dest, const LineBuf_t::LineBuf_px_t *src,
+				     const uint32_t *md_palette, int count)
+{
+	const __m128i *src_v = reinterpret_cast<const __m128i*>(src);
+	const __m256i idx_mask = _mm256_set1_epi32(0x00FF);
+	const int *pal = reinterpret_cast<const int*>(md_palette);
+
+	for (; count > 0; count -= 8, dest += 8, src_v++) {
+		const __m256i idx = _mm256_and_si256(
+			_mm256_cvtepu16_epi32(_mm_loadu_si128(src_v)), idx_mask);
+		const __m256i px = _mm256_i32gather_epi32(pal, idx, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), px);
+	}
+}
+
+/**
+ * Composite the layer buffers into the line buffer. (SSE2)
+ * See T_Composite_Layers_m5() for the reference implementation.
+ * @param dest Line buffer.
+ * @param scrollB Scroll B layer buffer.
+ * @param scrollA Scroll A / Window layer buffer.
+ * @param sprite Sprite layer buffer.
+ * @param count Number of pixels. Must be a multiple of 16.
+ * @param h_s Highlight/Shadow enable.
+ */
+__attribute__ ((target ("sse2")))
+void VdpPrivate::Composite_Layers_SSE2(LineBuf_t::LineBuf_px_t *dest,
+				       const uint8_t *scrollB, const uint8_t *scrollA,
+				       const uint8_t *sprite, int count, bool h_s)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i px_mask = _mm_set1_epi8(LAYERBUF_PX_MASK);
+	const __m128i prio = _mm_set1_epi8((char)LAYERBUF_PRIO);
+	const __m128i win_prio = _mm_set1_epi8(LAYERBUF_WIN_PRIO);
+	const __m128i sh = _mm_set1_epi8(h_s ? 0x40 : 0);
+	const __m128i op_mask = _mm_set1_epi8(0x3E);
+	const __m128i color_mask = _mm_set1_epi8(0x0F);
+	const __m128i color14 = _mm_set1_epi8(0x0E);
+	const __m128i high = _mm_set1_epi8((char)0x80);
+	const __m128i shad = _mm_set1_epi8(0x40);
+	__m128i *dest_v = reinterpret_cast<__m128i*>(dest);
+
+	// Pixel bits: 0x80 == highlight, 0x40 == shadow.
+	// The layer bits use 0x80 for priority, since bit 7
+	// can be tested with a signed comparison against 0.
+	#define BLEND(mask, a, b) _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+	for (; count > 0; count -= 16, scrollB += 16, scrollA += 16, sprite += 16, dest_v += 2) {
+		// Scroll B.
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scrollB));
+		const __m128i b_hi = _mm_cmplt_epi8(b, zero);
+		const __m128i b_px = _mm_and_si128(b, px_mask);
+		const __m128i b_clear = _mm_cmpeq_epi8(b_px, zero);
+		__m128i px = BLEND(b_hi, b_px, _mm_or_si128(b, sh));
+		__m128i layer = BLEND(b_hi, _mm_andnot_si128(b_clear, prio), sh);
+
+		// Scroll A / Window.
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scrollA));
+		const __m128i a_hi = _mm_cmplt_epi8(a, zero);
+		const __m128i a_px = _mm_and_si128(a, px_mask);
+		const __m128i a_clear = _mm_cmpeq_epi8(a_px, zero);
+		const __m128i a_low_draw = _mm_andnot_si128(_mm_or_si128(a_hi, a_clear),
+				_mm_cmpeq_epi8(_mm_cmplt_epi8(layer, zero), zero));
+		const __m128i a_hi_draw = _mm_andnot_si128(a_clear, a_hi);
+		const __m128i a_unshadow = _mm_or_si128(
+				_mm_and_si128(a_hi, a_clear),
+				_mm_andnot_si128(a_hi, _mm_cmpeq_epi8(_mm_and_si128(a, win_prio), win_prio)));
+		px = BLEND(a_low_draw, _mm_or_si128(a_px, _mm_and_si128(layer, sh)), px);
+		px = BLEND(a_hi_draw, a_px, px);
+		layer = BLEND(a_hi_draw, prio, layer);
+		const __m128i a_unshadow_bits = _mm_and_si128(a_unshadow, sh);
+		px = _mm_andnot_si128(a_unshadow_bits, px);
+		layer = _mm_andnot_si128(a_unshadow_bits, layer);
+
+		// Sprite.
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sprite));
+		const __m128i s_hi = _mm_cmplt_epi8(s, zero);
+		const __m128i s_px = _mm_and_si128(s, px_mask);
+		const __m128i s_draw = _mm_andnot_si128(_mm_cmpeq_epi8(s_px, zero),
+				_mm_or_si128(s_hi, _mm_cmpeq_epi8(_mm_cmplt_epi8(layer, zero), zero)));
+		__m128i s_new;
+		if (h_s) {
+			// Palette 3, color 14/15: Highlight/Shadow operator.
+			const __m128i s_op = _mm_cmpeq_epi8(_mm_and_si128(s_px, op_mask), op_mask);
+			const __m128i s_op_bits = BLEND(_mm_cmpeq_epi8(s_px, op_mask), high, shad);
+			// Low priority sprites are shadowed if the background is shadowed,
+			// except for color 14 in palettes 0-2.
+			const __m128i s_no_shadow = _mm_or_si128(s_hi,
+				_mm_cmpeq_epi8(_mm_and_si128(s_px, color_mask), color14));
+			const __m128i s_normal = _mm_or_si128(s_px,
+				_mm_andnot_si128(s_no_shadow, _mm_and_si128(layer, sh)));
+			s_new = BLEND(s_op, _mm_or_si128(px, s_op_bits), s_normal);
+		} else {
+			s_new = s_px;
+		}
+		px = BLEND(s_draw, s_new, px);
+
+		// Expand to the 16-bit line buffer. (layer bits are 0)
+		_mm_storeu_si128(dest_v, _mm_unpacklo_epi8(px, zero));
+		_mm_storeu_si128(dest_v + 1, _mm_unpackhi_epi8(px, zero));
+	}
+
+	#undef BLEND
+}
+
+}
+
+#endif /* VDP_RENDER_HAS_X86_SIMD */
@@ -0,0 +1,125 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * VdpTrace.cpp: VDP port write trace buffer.                              *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "VdpTrace.hpp"
+#include "libcompat/byteswap.h"
+
+#ifdef _WIN32
+// Win32 Unicode Translation Layer.
+// Needed for proper Unicode filename support on Windows.
+#include "libcompat/W32U/W32U_mini.h"
+#endif
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens {
+
+VdpTrace::VdpTrace()
+	: m_buf(new Entry_t[TRACE_SIZE])
+	, m_frame(0)
+	, m_head(0)
+{ }
+
+VdpTrace::~VdpTrace()
+{
+	delete[] m_buf;
+}
+
+/**
+ * Copy the most recent entries, oldest first.
+ * @param buf Destination buffer. (at least TRACE_SIZE entries)
+ * @return Number of entries copied.
+ */
+unsigned int VdpTrace::snapshot(Entry_t *buf) const
+{
+	const uint64_t end = m_head.load(std::memory_order_acquire);
+	uint64_t start = (end > TRACE_SIZE ? end - TRACE_SIZE : 0);
+	for (uint64_t i = start; i < end; i++) {
+		buf[i - start] = m_buf[i & (TRACE_SIZE - 1)];
+	}
+
+	// The emulation thread may have overwritten some of the
+	// entries while they were being copied. Entry (head - TRACE_SIZE)
+	// may be in the process of being overwritten, so it's also invalid.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t head = m_head.load(std::memory_order_relaxed);
+	const uint64_t valid = (head >= TRACE_SIZE ? head - TRACE_SIZE + 1 : 0);
+	if (valid >= end)
+		return 0;
+	if (valid > start) {
+		memmove(buf, &buf[valid - start], (size_t)(end - valid) * sizeof(*buf));
+		start = valid;
+	}
+
+	return (unsigned int)(end - start);
+}
+
+/**
+ * Save the most recent entries to a trace file.
+ * @param filename Trace filename.
+ * @return Number of entries saved on success; negative on error.
+ */
+int VdpTrace::save(const char *filename) const
+{
+	vector<Entry_t> entries(TRACE_SIZE);
+	const unsigned int count = snapshot(entries.data());
+
+	// Convert the entries to little-endian.
+	for (unsigned int i = 0; i < count; i++) {
+		Entry_t *const entry = &entries[i];
+		entry->frame = cpu_to_le32(entry->frame);
+		entry->line = cpu_to_le16(entry->line);
+		entry->mclk = cpu_to_le32(entry->mclk);
+		entry->value = cpu_to_le32(entry->value);
+	}
+
+	// File header.
+	uint32_t header[8];
+	memcpy(header, "GENSVDPT", 8);
+	header[2] = cpu_to_le32(1);
+	header[3] = cpu_to_le32((uint32_t)sizeof(Entry_t));
+	header[4] = cpu_to_le32(count);
+	header[5] = 0;
+	header[6] = 0;
+	header[7] = 0;
+
+	FILE *f = fopen(filename, "wb");
+	if (!f)
+		return -1;
+
+	int ret = (int)count;
+	if (fwrite(header, 1, sizeof(header), f) != sizeof(header) ||
+	    fwrite(entries.data(), sizeof(Entry_t), count, f) != count)
+	{
+		ret = -1;
+	}
+	if (fclose(f) != 0)
+		ret = -1;
+	return ret;
+}
+
+}
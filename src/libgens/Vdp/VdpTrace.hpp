@@ -0,0 +1,162 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * VdpTrace.hpp: VDP port write trace buffer.                              *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __LIBGENS_VDP_VDPTRACE_HPP__
+#define __LIBGENS_VDP_VDPTRACE_HPP__
+
+#include <stdint.h>
+
+// C++ includes.
+#include <atomic>
+
+namespace LibGens {
+
+/**
+ * Vdp: Port write trace buffer.
+ *
+ * Records VDP control port writes, data port writes, and
+ * DMA triggers into a fixed-size ring buffer. When the
+ * buffer is full, the oldest entries are overwritten.
+ *
+ * Only the emulation thread records entries. Other threads
+ * may take a snapshot at any time without locking; entries
+ * overwritten while the snapshot is being copied are discarded.
+ *
+ * Trace file format: (all values are little-endian)
+ * - Header: (32 bytes)
+ *   - char magic[8]: "GENSVDPT"
+ *   - uint32_t version: 1
+ *   - uint32_t entrySize: sizeof(Entry_t)
+ *   - uint32_t count: Number of entries.
+ *   - uint32_t reserved[3]
+ * - Entries: Entry_t[count], oldest first.
+ */
+class VdpTrace
+{
+	public:
+		VdpTrace();
+		~VdpTrace();
+
+	private:
+		// Q_DISABLE_COPY() equivalent.
+		// TODO: Add LibGens-specific version of Q_DISABLE_COPY().
+		VdpTrace(const VdpTrace &);
+		VdpTrace &operator=(const VdpTrace &);
+
+	public:
+		// Traced ports.
+		enum Port_t {
+			PORT_CTRL	= 0,	// Control port write. (value: control word)
+			PORT_DATA	= 1,	// Data port write. (value: data word)
+			PORT_DMA	= 2,	// DMA trigger. (value: DMA mode << 24 | length)
+		};
+
+		// Trace entry.
+		struct Entry_t {
+			uint32_t frame;		// Frame number.
+			uint16_t line;		// VDP line number.
+			uint8_t port;		// Port. (See Port_t.)
+			uint8_t code;		// VDP access code. (CD5-CD0)
+			uint32_t mclk;		// Master clock cycles from the start of the frame.
+			uint32_t value;		// Value. (See Port_t.)
+		};
+
+		// Number of entries in the ring buffer.
+		// Must be a power of two.
+		static const unsigned int TRACE_SIZE = 65536;
+
+		/**
+		 * Record an entry.
+		 * Only called by the emulation thread.
+		 * @param port Port. (See Port_t.)
+		 * @param code VDP access code.
+		 * @param line VDP line number.
+		 * @param mclk Master clock cycles from the start of the frame.
+		 * @param value Value.
+		 */
+		inline void record(Port_t port, uint8_t code, int line,
+				   uint32_t mclk, uint32_t value);
+
+		/**
+		 * Start a new frame.
+		 * Only called by the emulation thread.
+		 */
+		inline void nextFrame(void)
+			{ m_frame++; }
+
+		/**
+		 * Get the total number of entries recorded,
+		 * including entries that have been overwritten.
+		 * @return Total number of entries recorded.
+		 */
+		inline uint64_t recorded(void) const
+			{ return m_head.load(std::memory_order_acquire); }
+
+		/**
+		 * Copy the most recent entries, oldest first.
+		 * @param buf Destination buffer. (at least TRACE_SIZE entries)
+		 * @return Number of entries copied.
+		 */
+		unsigned int snapshot(Entry_t *buf) const;
+
+		/**
+		 * Save the most recent entries to a trace file.
+		 * @param filename Trace filename.
+		 * @return Number of entries saved on success; negative on error.
+		 */
+		int save(const char *filename) const;
+
+	private:
+		Entry_t *m_buf;
+		uint32_t m_frame;
+
+		// Total number of entries recorded.
+		// Published with release semantics after
+		// the entry has been written.
+		std::atomic<uint64_t> m_head;
+};
+
+/**
+ * Record an entry.
+ * Only called by the emulation thread.
+ * @param port Port. (See Port_t.)
+ * @param code VDP access code.
+ * @param line VDP line number.
+ * @param mclk Master clock cycles from the start of the frame.
+ * @param value Value.
+ */
+inline void VdpTrace::record(Port_t port, uint8_t code, int line,
+			     uint32_t mclk, uint32_t value)
+{
+	const uint64_t head = m_head.load(std::memory_order_relaxed);
+	Entry_t *const entry = &m_buf[head & (TRACE_SIZE - 1)];
+	entry->frame = m_frame;
+	entry->line = (uint16_t)line;
+	entry->port = (uint8_t)port;
+	entry->code = code;
+	entry->mclk = mclk;
+	entry->value = value;
+	m_head.store(head + 1, std::memory_order_release);
+}
+
+}
+
+#endif /* __LIBGENS_VDP_VDPTRACE_HPP__ */
@@ -182,6 +182,14 @@ namespace VdpTypes {
 		 * This is similar to Genecyst.
 		 */
 		bool enableInterlacedMode;
+
+		/**
+		 * Render Mode 5 layers into separate buffers,
+		 * then composite them in a single pass.
+		 * Output is identical to the default renderer;
+		 * this is mostly useful for benchmarking.
+		 */
+		bool layerCompositing;
 	};
 
 	// VDP layer flags.
@@ -36,12 +36,25 @@
 #include "VdpPalette.hpp"
 #include "VdpStatus.hpp"
 #include "VdpStructs.hpp"
+#include "VdpCache.hpp"
+#include "VdpTrace.hpp"
+
+// ALIGN()
+#include "libcompat/aligned_malloc.h"
 
 #include "VdpRend_Err_p.hpp"
 
+// x86 SIMD line buffer rendering.
+// Requires gcc-style target attributes.
+#if defined(__GNUC__) && \
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+#define VDP_RENDER_HAS_X86_SIMD 1
+#endif
+
 namespace LibGens {
 
 class Vdp;
+class VdpRendThread;
 class VdpPrivate
 {
 	public:
@@ -50,6 +63,7 @@ class VdpPrivate
 
 	protected:
 		friend class Vdp;
+		friend class VdpRendThread;
 		Vdp *const q;
 	private:
 		// Q_DISABLE_COPY() equivalent.
@@ -149,7 +163,12 @@ class VdpPrivate
 		VdpTypes::VRam_t VRam;
 		VdpTypes::VSRam_t VSRam;
 
+		// Pattern cache. (Mode 5)
+		// All VRam writes must mark the cache as dirty.
+		VdpCache patternCache;
+
 		int HInt_Counter;	// Horizontal Interrupt Counter.
+		unsigned int HBlank_End;	// 68000 cycle at which HBlank ends.
 		int VDP_Int;		// VDP interrupt state.
 		VdpStatus Reg_Status;	// VDP status register.
 		uint16_t testReg;	// Test register.
@@ -252,8 +271,8 @@ class VdpPrivate
 			{ return VRam.u16[((ScrB_Gen_Addr + offset) & VRam_Mask) >> 1]; }
 		inline uint16_t Win_Gen_Addr_u16(uint32_t offset) const	// Same as Scroll A.
 			{ return ScrA_Gen_Addr_u16(offset); }
-		inline uint32_t Spr_Gen_Addr_u32(uint32_t offset) const
-			{ return VRam.u32[((Spr_Gen_Addr + offset) & VRam_Mask) >> 2]; }
+		inline uint32_t Spr_Gen_Addr_Cache(uint32_t offset, bool hflip)
+			{ return patternCache.pattern_line_m5_addr((Spr_Gen_Addr + offset) & VRam_Mask, hflip); }
 
 		/**
 		 * Update the VDP address cache. (Mode 5)
@@ -386,6 +405,12 @@ class VdpPrivate
 
 		void DMA_Fill(uint16_t data);
 
+		// DMA FILL / DMA COPY block functions.
+		uint32_t DMA_Fill_VRam(uint32_t address, unsigned int length, uint8_t fill);
+		void DMA_Copy_VRam(uint32_t *src_address, uint32_t *dest_address, unsigned int length);
+		void DMA_Update_SAT_8(uint32_t address, unsigned int inc, unsigned int count, unsigned int vram_xor);
+		void DMA_Log_VRam_Range(uint32_t first, uint32_t last);
+
 		enum DMA_Dest_t {
 			DMA_DEST_VRAM	= 1,
 			DMA_DEST_CRAM	= 2,
@@ -409,6 +434,9 @@ class VdpPrivate
 		template<DMA_Src_t src_component, DMA_Dest_t dest_component>
 		inline void T_DMA_Loop(void);
 
+		template<DMA_Dest_t dest_component>
+		inline void T_DMA_Write_Block(const uint16_t *src, unsigned int words);
+
 		void processDmaCtrlWrite(void);
 
 	/*!**************************************************************
@@ -426,6 +454,23 @@ class VdpPrivate
 		// Palette manager.
 		VdpPalette palette;
 
+		// Deferred rendering thread.
+		// If nullptr, lines are rendered immediately.
+		VdpRendThread *rendThread;
+
+		// Port write trace buffer.
+		// If nullptr, port writes aren't traced.
+		VdpTrace *trace;
+
+		/**
+		 * Record a port write in the trace buffer.
+		 * Only call this if trace is set.
+		 * (VdpIo.cpp)
+		 * @param port Port.
+		 * @param value Value.
+		 */
+		inline void traceWrite(VdpTrace::Port_t port, uint32_t value);
+
 		// VDP layer control.
 		unsigned int VDP_Layers;
 
@@ -447,6 +492,36 @@ class VdpPrivate
 		};
 		LineBuf_t LineBuf;
 
+		/**
+		 * Layer buffers for the current line. (Mode 5)
+		 * Only used if VdpEmuOptions_t::layerCompositing is set.
+		 * Each layer is rendered into its own buffer, and then
+		 * T_Composite_Layers_m5() resolves priority, transparency,
+		 * and shadow/highlight into LineBuf.
+		 *
+		 * Entry format: (see LayerBufBits)
+		 * - Bit 7: High priority.
+		 * - Bit 6: Scroll A: A high-priority Scroll A cell overlaps this Window pixel.
+		 *          Sprite: A later sprite was hidden by a high-priority plane
+		 *                  after an S/H operator. (Used for collisions.)
+		 * - Bits 5-0: Palette index. 0 if transparent.
+		 *
+		 * Entries are indexed the same way as LineBuf.
+		 */
+		struct LayerBuf_t {
+			uint8_t ALIGN(16) scrollB[336];
+			uint8_t ALIGN(16) scrollA[336];	// Scroll A and Window.
+			uint8_t ALIGN(16) sprite[336];
+		};
+		LayerBuf_t LayerBuf;
+
+		enum LayerBufBits {
+			LAYERBUF_PRIO		= 0x80,	// High priority.
+			LAYERBUF_WIN_PRIO	= 0x40,	// Scroll A: High-priority Scroll A over Window.
+			LAYERBUF_SPR_HIDDEN	= 0x40,	// Sprite: Hidden sprite after an S/H operator.
+			LAYERBUF_PX_MASK	= 0x3F,	// Palette index.
+		};
+
 		template<bool hs, typename pixel>
 		inline void T_Update_Palette(pixel *MD_palette, const pixel *palette);
 
@@ -456,6 +531,7 @@ class VdpPrivate
 	public:
 		/** Line rendering functions. **/
 		void renderLine_m5(void);
+		bool updateSprStatus_m5(void);
 
 	private:
 		// Sprite Attribute Table cache. (Mode 5)
@@ -513,6 +589,33 @@ class VdpPrivate
 		// Includes both the current line and the next line.
 		uint8_t sprCountCache[2];
 
+		/**
+		 * Sprite scanline bins. (Mode 5)
+		 * Each bin lists the sprites that cover a line, in link
+		 * order, as sprite numbers. This is the same order that
+		 * a walk of the SAT cache's link list would find them.
+		 *
+		 * Bins only depend on the Y position, size, and link fields
+		 * in the SAT cache, plus the maximum sprites per frame (H_Cell)
+		 * and IM2. They're rebuilt on the next line cache update if
+		 * the SAT cache is modified or if either of those changes.
+		 */
+		static const int SPR_BIN_LINES = 512;
+		struct {
+			uint8_t count[SPR_BIN_LINES];
+			uint8_t spr[SPR_BIN_LINES][80];
+			uint8_t max_spr_frame;
+			bool interlaced;
+			bool dirty;
+		} sprBins;
+
+		/**
+		 * Mark the sprite scanline bins as dirty.
+		 * Must be called when the SAT cache is modified.
+		 */
+		inline void markSprBinsDirty(void)
+			{ sprBins.dirty = true; }
+
 	/*!*****************************************
 	 * VdpRend_m5: Mode 5 rendering functions. *
 	 *******************************************/
@@ -534,15 +637,26 @@ class VdpPrivate
 		template<bool priority, bool h_s, int pat_pixnum, uint32_t mask, int shift>
 		FORCE_INLINE uint8_t T_PutPixel_Sprite(int disp_pixnum, uint32_t pattern, unsigned int palette);
 
-		template<bool plane, bool h_s, bool flip>
+		template<bool plane, bool h_s>
 		FORCE_INLINE void T_PutLine_P0(int disp_pixnum, uint32_t pattern, int palette);
 
-		template<bool plane, bool h_s, bool flip>
+		template<bool plane, bool h_s>
 		FORCE_INLINE void T_PutLine_P1(int disp_pixnum, uint32_t pattern, int palette);
 
-		template<bool priority, bool h_s, bool flip>
+		template<bool plane, bool h_s>
+		FORCE_INLINE void T_PutLine_Cell(int disp_pixnum, uint32_t pattern, int palette, bool priority);
+
+		template<bool priority, bool h_s, bool layers>
 		FORCE_INLINE void T_PutLine_Sprite(int disp_pixnum, uint32_t pattern, int palette);
 
+		template<bool plane, bool window>
+		FORCE_INLINE void T_PutLine_Layer(int disp_pixnum, uint32_t pattern, int palette, bool priority);
+
+		FORCE_INLINE bool LayerBuf_isPlanePrio(unsigned int pixnum) const;
+
+		template<bool priority, bool h_s, int pat_pixnum, uint32_t mask, int shift>
+		FORCE_INLINE uint8_t T_PutPixel_SpriteLayer(int disp_pixnum, uint32_t pattern, unsigned int palette);
+
 		template<bool plane>
 		FORCE_INLINE uint16_t T_Get_X_Offset(void);
 
@@ -561,10 +675,10 @@ class VdpPrivate
 		template<bool interlaced>
 		FORCE_INLINE uint32_t T_Get_Pattern_Data(uint16_t pattern, unsigned int y_fine_offset);
 
-		template<bool plane, bool interlaced, bool vscroll, bool h_s>
+		template<bool plane, bool interlaced, bool vscroll, bool h_s, bool layers>
 		FORCE_INLINE void T_Render_Line_Scroll(int cell_start, int cell_length);
 
-		template<bool interlaced, bool vscroll, bool h_s>
+		template<bool interlaced, bool vscroll, bool h_s, bool layers>
 		FORCE_INLINE void T_Render_Line_ScrollA_Window(void);
 
 		FORCE_INLINE void Update_Sprite_Line_Cache_m5(int line);
@@ -575,18 +689,77 @@ class VdpPrivate
 		template<bool interlaced>
 		unsigned int T_Update_Sprite_Line_Cache_m5(int line);
 
-		template<bool interlaced, bool h_s>
+		template<bool interlaced>
+		void T_Update_Sprite_Bins_m5(uint8_t max_spr_frame);
+
+		template<bool interlaced, bool h_s, bool layers>
 		FORCE_INLINE void T_Render_Line_Sprite(void);
 
 		template<bool interlaced, bool h_s>
 		FORCE_INLINE void T_Render_Line_m5(void);
 
+		template<bool h_s>
+		FORCE_INLINE void T_Composite_Layers_m5(void);
+
 		template<typename pixel>
 		FORCE_INLINE void T_Render_LineBuf(pixel *dest, pixel *md_palette);
 
+#ifdef VDP_RENDER_HAS_X86_SIMD
+		/**
+		 * SIMD versions of T_Render_LineBuf()'s main loop.
+		 * (VdpRend_m5_x86.cpp)
+		 * @param dest Destination surface.
+		 * @param src Line buffer.
+		 * @param md_palette MD palette buffer. (VdpPalette::m_palActive)
+		 * @param count Number of pixels. Must be a multiple of 16.
+		 */
+		static void Render_LineBuf_SSE2(uint16_t *dest, const LineBuf_t::LineBuf_px_t *src,
+						const uint16_t *md_palette, int count);
+		static void Render_LineBuf_SSE2(uint32_t *dest, const LineBuf_t::LineBuf_px_t *src,
+						const uint32_t *md_palette, int count);
+		static void Render_LineBuf_AVX2(uint16_t *dest, const LineBuf_t::LineBuf_px_t *src,
+						const uint16_t *md_palette, int count);
+		static void Render_LineBuf_AVX2(uint32_t *dest, const LineBuf_t::LineBuf_px_t *src,
+						const uint32_t *md_palette, int count);
+
+		/**
+		 * SSE2 version of T_Composite_Layers_m5()'s main loop.
+		 * (VdpRend_m5_x86.cpp)
+		 * @param dest Line buffer.
+		 * @param scrollB Scroll B layer buffer.
+		 * @param scrollA Scroll A/Window layer buffer.
+		 * @param sprite Sprite layer buffer.
+		 * @param count Number of pixels. Must be a multiple of 16.
+		 * @param h_s Highlight/Shadow enable.
+		 */
+		static void Composite_Layers_SSE2(LineBuf_t::LineBuf_px_t *dest,
+				const uint8_t *scrollB, const uint8_t *scrollA,
+				const uint8_t *sprite, int count, bool h_s);
+#endif /* VDP_RENDER_HAS_X86_SIMD */
+
 		template<typename pixel>
 		FORCE_INLINE void T_Apply_SMS_LCB(pixel *dest, pixel border_color);
 
+		/**
+		 * Cached blank line. (display disabled, or border area)
+		 * Rebuilt if any of the parameters change; otherwise,
+		 * blank lines are copied from here with a single memcpy().
+		 */
+		struct {
+			union {
+				uint16_t u16[320];
+				uint32_t u32[320];
+			};
+			uint32_t bg_color;	// Background color.
+			uint32_t border_color;	// Border color.
+			int h_pix;		// Active display width.
+			MdFb::ColorDepth bpp;	// Color depth. (BPP_MAX if invalid)
+			bool lcb;		// SMS left-column blanking.
+		} blankLine;
+
+		template<typename pixel>
+		FORCE_INLINE void T_Render_BlankLine(pixel *dest, const pixel *md_palette);
+
 	/*!*****************************************
 	 * VdpRend_m4: Mode 4 rendering functions. *
 	 *******************************************/
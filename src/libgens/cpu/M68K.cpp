@@ -34,10 +34,10 @@
 
 namespace LibGens {
 
-S68000CONTEXT M68K::ms_Context;
+EMU_THREAD_LOCAL S68000CONTEXT M68K::ms_Context;
 
 // Instruction fetch.
-STARSCREAM_PROGRAMREGION M68K::M68K_Fetch[] =
+EMU_THREAD_LOCAL STARSCREAM_PROGRAMREGION M68K::M68K_Fetch[] =
 {
 #ifdef GENS_ENABLE_EMULATION
 	// 32 entries for RAM, including mirrors.
@@ -74,7 +74,7 @@ STARSCREAM_PROGRAMREGION M68K::M68K_Fetch[] =
 };
 
 // M68K Starscream has a hack for RAM mirroring for data read.
-STARSCREAM_DATAREGION M68K::M68K_Read_Byte[4] =
+EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K::M68K_Read_Byte[4] =
 {
 #ifdef GENS_ENABLE_EMULATION
 	// TODO: 0x9FFFFF is valid for MD only.
@@ -86,7 +86,7 @@ STARSCREAM_DATAREGION M68K::M68K_Read_Byte[4] =
 };
 
 // M68K Starscream has a hack for RAM mirroring for data read.
-STARSCREAM_DATAREGION M68K::M68K_Read_Word[4] =
+EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K::M68K_Read_Word[4] =
 {
 #ifdef GENS_ENABLE_EMULATION
 	// TODO: 0x9FFFFF is valid for MD only.
@@ -98,7 +98,7 @@ STARSCREAM_DATAREGION M68K::M68K_Read_Word[4] =
 };
 
 // M68K Starscream has a hack for RAM mirroring for data write.
-STARSCREAM_DATAREGION M68K::M68K_Write_Byte[3] =
+EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K::M68K_Write_Byte[3] =
 {
 #ifdef GENS_ENABLE_EMULATION
 	{0xFF0000, 0xFFFFFF, NULL, &Ram_68k.u8[0]},
@@ -108,7 +108,7 @@ STARSCREAM_DATAREGION M68K::M68K_Write_Byte[3] =
 };
 
 // M68K Starscream has a hack for RAM mirroring for data write.
-STARSCREAM_DATAREGION M68K::M68K_Write_Word[3] =
+EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K::M68K_Write_Word[3] =
 {
 #ifdef GENS_ENABLE_EMULATION
 	{0xFF0000, 0xFFFFFF, NULL, &Ram_68k.u8[0]},
@@ -118,7 +118,7 @@ STARSCREAM_DATAREGION M68K::M68K_Write_Word[3] =
 };
 
 // Last system ID.
-M68K::SysID M68K::ms_LastSysID = SYSID_NONE;
+EMU_THREAD_LOCAL M68K::SysID M68K::ms_LastSysID = SYSID_NONE;
 
 /**
  * Reset handler.
@@ -176,7 +176,6 @@ void M68K::End(void)
  */
 void M68K::InitSys(SysID system)
 {
-	// TODO: This is not 64-bit clean!
 	ms_LastSysID = system;
 
 	// Clear M68K RAM.
@@ -191,7 +190,7 @@ void M68K::InitSys(SysID system)
 		uint32_t ram_addr = (0xE00000 | (i << 16));
 		M68K_Fetch[i].lowaddr = ram_addr;
 		M68K_Fetch[i].highaddr = (ram_addr | 0xFFFF);
-		M68K_Fetch[i].offset = ((uint32_t)(&Ram_68k.u8[0]) - ram_addr);
+		M68K_Fetch[i].offset = ((uintptr_t)(&Ram_68k.u8[0]) - ram_addr);
 	}
 
 	// Update the system-specific banking setup.
@@ -199,6 +198,11 @@ void M68K::InitSys(SysID system)
 
 	// Reset the M68K CPU.
 	main68k_reset();
+
+#ifdef GENS_USE_MDM68K
+	// Idle loop counters are per-ROM.
+	mdM68K_idle_clear();
+#endif /* GENS_USE_MDM68K */
 #endif /* GENS_ENABLE_EMULATION */
 }
 
@@ -27,6 +27,9 @@
 #include <libgens/config.libgens.h>
 
 #include "star_68k.h"
+#ifdef GENS_USE_MDM68K
+#include "../mdM68K/mdM68K.h"
+#endif
 
 // ZOMG M68K structs.
 #include "libzomg/zomg_m68k.h"
@@ -78,15 +81,20 @@ class M68K
 		static inline unsigned int Exec(int n);
 		static inline unsigned int TripOdometer(void);
 		/** END: Starscream wrapper functions. **/
+
+		/** Idle loop skipping. (mdM68K only) **/
+		static inline void SetIdleSkip(bool enable);
+		static inline unsigned int IdleHits(void);
+		static inline uint64_t IdleCycles(void);
 	
 	protected:
-		static S68000CONTEXT ms_Context;
+		static EMU_THREAD_LOCAL S68000CONTEXT ms_Context;
 		
-		static STARSCREAM_PROGRAMREGION M68K_Fetch[];
-		static STARSCREAM_DATAREGION M68K_Read_Byte[4];
-		static STARSCREAM_DATAREGION M68K_Read_Word[4];
-		static STARSCREAM_DATAREGION M68K_Write_Byte[3];
-		static STARSCREAM_DATAREGION M68K_Write_Word[3];
+		static EMU_THREAD_LOCAL STARSCREAM_PROGRAMREGION M68K_Fetch[];
+		static EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K_Read_Byte[4];
+		static EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K_Read_Word[4];
+		static EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K_Write_Byte[3];
+		static EMU_THREAD_LOCAL STARSCREAM_DATAREGION M68K_Write_Word[3];
 		
 		// TODO: What does the Reset Handler function do?
 		static void M68K_Reset_Handler(void);
@@ -95,7 +103,7 @@ class M68K
 		M68K() { }
 		~M68K() { }
 
-		static SysID ms_LastSysID;
+		static EMU_THREAD_LOCAL SysID ms_LastSysID;
 };
 
 /** BEGIN: Starscream wrapper functions. **/
@@ -166,6 +174,52 @@ inline unsigned int M68K::TripOdometer(void)
 	return main68k_tripOdometer();
 }
 
+#ifdef GENS_USE_MDM68K
+/**
+ * Enable or disable idle loop skipping.
+ * Skipping is bit-identical to running the loop.
+ *
+ * Detected: a taken Bcc or BRA (including BRA to itself) that jumps
+ * back at most 16 bytes, where the loop body only reads 68000 RAM
+ * or the VDP status register, and the registers and flags repeat
+ * every two iterations. VDP status polls are only skipped while
+ * HBLANK, SOVR, and C are clear.
+ *
+ * Not detected: DBcc loops (the counter changes every iteration),
+ * JMP loops, longer loops, and loops that read other I/O,
+ * e.g. the Z80 bus or controller ports.
+ *
+ * @param enable If true, enable idle loop skipping.
+ */
+inline void M68K::SetIdleSkip(bool enable)
+{
+	mdM68K_idle_enable(enable);
+}
+
+/**
+ * Get the number of idle loops skipped since the ROM was loaded.
+ * @return Number of idle loops skipped.
+ */
+inline unsigned int M68K::IdleHits(void)
+{
+	return mdM68K_idle_hits();
+}
+
+/**
+ * Get the number of cycles skipped since the ROM was loaded.
+ * @return Number of cycles skipped.
+ */
+inline uint64_t M68K::IdleCycles(void)
+{
+	return mdM68K_idle_cycles();
+}
+#else /* !GENS_USE_MDM68K */
+// Starscream doesn't support idle loop skipping.
+inline void M68K::SetIdleSkip(bool enable) { ((void)enable); }
+inline unsigned int M68K::IdleHits(void) { return 0; }
+inline uint64_t M68K::IdleCycles(void) { return 0; }
+#endif /* GENS_USE_MDM68K */
+
 #else /* !GENS_ENABLE_EMULATION */
 
 inline void M68K::Reset(void) { }
@@ -175,6 +229,9 @@ inline void M68K::ReleaseCycles(int cycles) { ((void)cycles); }
 inline void M68K::AddCycles(int cycles) { ((void)cycles); }
 inline unsigned int M68K::Exec(int n) { ((void)n); return 0; }
 inline unsigned int M68K::TripOdometer(void) { return 0; }
+inline void M68K::SetIdleSkip(bool enable) { ((void)enable); }
+inline unsigned int M68K::IdleHits(void) { return 0; }
+inline uint64_t M68K::IdleCycles(void) { return 0; }
 
 #endif /* GENS_ENABLE_EMULATION */
 
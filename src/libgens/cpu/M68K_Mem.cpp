@@ -47,7 +47,7 @@
 
 // TODO: Starscream accesses Ram_68k directly.
 // Move Ram_68k back to M68K once Starscream is updated.
-Ram_68k_t Ram_68k;
+EMU_THREAD_LOCAL Ram_68k_t Ram_68k;
 
 // EmuContext
 #include "EmuContext/EmuContext.hpp"
@@ -93,33 +93,33 @@ namespace LibGens
 //M68K_Mem::Ram_68k_t M68K_Mem::Ram_68k;	// TODO: Fix Starscream!
 
 // ROM cartridge.
-RomCartridgeMD *M68K_Mem::ms_RomCartridge = nullptr;
+EMU_THREAD_LOCAL RomCartridgeMD *M68K_Mem::ms_RomCartridge = nullptr;
 
 // TMSS registers.
-TmssReg M68K_Mem::tmss_reg;
+EMU_THREAD_LOCAL TmssReg M68K_Mem::tmss_reg;
 
 /** Z80/M68K cycle table. **/
 int M68K_Mem::Z80_M68K_Cycle_Tab[512];
 
 // M68K static variables.
 // TODO: Improve some of these, especially the cycle counters!
-unsigned int M68K_Mem::Z80_State;
-int M68K_Mem::Last_BUS_REQ_Cnt;
-int M68K_Mem::Last_BUS_REQ_St;
-int M68K_Mem::Bank_M68K;
-int M68K_Mem::Fake_Fetch;
+EMU_THREAD_LOCAL unsigned int M68K_Mem::Z80_State;
+EMU_THREAD_LOCAL int M68K_Mem::Last_BUS_REQ_Cnt;
+EMU_THREAD_LOCAL int M68K_Mem::Last_BUS_REQ_St;
+EMU_THREAD_LOCAL int M68K_Mem::Bank_M68K;
+EMU_THREAD_LOCAL int M68K_Mem::Fake_Fetch;
 
-int M68K_Mem::CPL_M68K;
-int M68K_Mem::CPL_Z80;
-int M68K_Mem::Cycles_M68K;
-int M68K_Mem::Cycles_Z80;
+EMU_THREAD_LOCAL int M68K_Mem::CPL_M68K;
+EMU_THREAD_LOCAL int M68K_Mem::CPL_Z80;
+EMU_THREAD_LOCAL int M68K_Mem::Cycles_M68K;
+EMU_THREAD_LOCAL int M68K_Mem::Cycles_Z80;
 
 /**
  * M68K bank type identifiers.
  * These type identifiers indicate what's mapped to each virtual bank.
  * Banks are 2 MB each, for a total of 8 banks.
  */
-uint8_t M68K_Mem::ms_M68KBank_Type[8];
+EMU_THREAD_LOCAL uint8_t M68K_Mem::ms_M68KBank_Type[8];
 
 /**
  * Default M68K bank type IDs for MD.
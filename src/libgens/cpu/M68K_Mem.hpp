@@ -25,6 +25,7 @@
 #define __LIBGENS_CPU_M68K_MEM_HPP__
 
 #include <stdint.h>
+#include "libgens/macros/tls.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,7 +37,7 @@ typedef union {
 	uint16_t u16[(64*1024)>>1];
 	uint32_t u32[(64*1024)>>2];
 } Ram_68k_t;
-extern Ram_68k_t Ram_68k;
+extern EMU_THREAD_LOCAL Ram_68k_t Ram_68k;
 #ifdef __cplusplus
 }
 #endif
@@ -70,31 +71,33 @@ class M68K_Mem
 		static Ram_68k_t Ram_68k;
 #endif
 		// ROM cartridge.
-		static RomCartridgeMD *ms_RomCartridge;
+		static EMU_THREAD_LOCAL RomCartridgeMD *ms_RomCartridge;
 
 		/**
 		 * TMSS registers.
 		 * NOTE: Only effective if system version != 0.
 		 */
-		static TmssReg tmss_reg;
+		static EMU_THREAD_LOCAL TmssReg tmss_reg;
 
 		/** Z80 state. **/
 		#define Z80_STATE_ENABLED	(1 << 0)
 		#define Z80_STATE_BUSREQ	(1 << 1)
 		#define Z80_STATE_RESET		(1 << 2)
 
-		static unsigned int Z80_State;
-		static int Last_BUS_REQ_Cnt;
-		static int Last_BUS_REQ_St;
-		static int Bank_M68K; // NOTE: This is for Sega CD, not Z80!
-		static int Fake_Fetch;
+		static EMU_THREAD_LOCAL unsigned int Z80_State;
+		static EMU_THREAD_LOCAL int Last_BUS_REQ_Cnt;
+		static EMU_THREAD_LOCAL int Last_BUS_REQ_St;
+		static EMU_THREAD_LOCAL int Bank_M68K; // NOTE: This is for Sega CD, not Z80!
+		static EMU_THREAD_LOCAL int Fake_Fetch;
 
-		// Cycles per line.
-		// TODO: Replace with 3420 machine cycles per line.
-		static int CPL_M68K;
-		static int CPL_Z80;
-		static int Cycles_M68K;
-		static int Cycles_Z80;
+		// Cycles per line. (approximate; used for DMA timing)
+		// CPU timeslices are based on the Scheduler's master clock.
+		static EMU_THREAD_LOCAL int CPL_M68K;
+		static EMU_THREAD_LOCAL int CPL_Z80;
+
+		// Last cycle to execute on the current line.
+		static EMU_THREAD_LOCAL int Cycles_M68K;
+		static EMU_THREAD_LOCAL int Cycles_Z80;
 
 		/** System initialization functions. **/
 	public:
@@ -152,7 +155,7 @@ class M68K_Mem
 		 * These type identifiers indicate what's mapped to each virtual bank.
 		 * Banks are 2 MB each, for a total of 8 banks.
 		 */
-		static uint8_t ms_M68KBank_Type[8];
+		static EMU_THREAD_LOCAL uint8_t ms_M68KBank_Type[8];
 
 		/**
 		 * Default M68K bank type IDs for MD.
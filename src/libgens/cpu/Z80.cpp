@@ -35,7 +35,7 @@
 namespace LibGens {
 
 // Static class variables.
-mdZ80_context *Z80::ms_Z80 = NULL;
+EMU_THREAD_LOCAL mdZ80_context *Z80::ms_Z80 = NULL;
 
 /**
  * Initialize the Z80 CPU emulator.
@@ -97,6 +97,11 @@ void Z80::ReInit(void)
 
 	// Hard-reset the Z80.
 	HardReset();
+
+#ifdef GENS_ENABLE_EMULATION
+	// Idle loop counters are reset when emulation starts.
+	mdZ80_clear_idle(ms_Z80);
+#endif
 }
 
 /** ZOMG savestate functions. **/
@@ -28,6 +28,7 @@
 
 // mdZ80: Z80 CPU emulator.
 #include "../mdZ80/mdZ80.h"
+#include "../mdZ80/mdZ80_flags.h"
 
 // M68K_Mem is needed for Z80_State.
 #include "M68K_Mem.hpp"
@@ -65,10 +66,17 @@ class Z80
 		static inline void Interrupt(uint8_t irq);
 		static inline void ClearOdometer(void);
 		static inline void SetOdometer(unsigned int odo);
+		static inline unsigned int ReadOdometer(void);
+		static inline bool IsRunning(void);
 		/** END: mdZ80 wrapper functions. **/
+
+		/** Idle loop skipping. (C executor only) **/
+		static inline void SetIdleSkip(bool enable);
+		static inline unsigned int IdleHits(void);
+		static inline uint64_t IdleCycles(void);
 	
 	protected:
-		static mdZ80_context *ms_Z80;
+		static EMU_THREAD_LOCAL mdZ80_context *ms_Z80;
 	
 	private:
 		Z80() { }
@@ -138,6 +146,56 @@ inline void Z80::SetOdometer(unsigned int odo)
 	mdZ80_set_odo(ms_Z80, odo);
 }
 
+/**
+ * Read the odometer.
+ * While the Z80 is running, this is only valid
+ * in memory write and I/O handlers.
+ * @return Z80 cycles from the start of the frame.
+ */
+inline unsigned int Z80::ReadOdometer(void)
+{
+	return mdZ80_read_odo(ms_Z80);
+}
+
+/**
+ * Is the Z80 running?
+ * @return True if called from within Z80::Exec().
+ */
+inline bool Z80::IsRunning(void)
+{
+	return !!(mdZ80_get_Status(ms_Z80) & Z80_STATE_RUNNING);
+}
+
+/**
+ * Enable or disable idle loop skipping.
+ * Skipping is bit-identical to running the loop.
+ * @param enable If true, enable idle loop skipping.
+ */
+inline void Z80::SetIdleSkip(bool enable)
+{
+	// Z80 RAM (0x0000-0x3FFF) and the YM2612 status (0x4000-0x5FFF)
+	// can't change while the Z80 is running.
+	mdZ80_set_idle_skip(ms_Z80, enable, 0x003F);
+}
+
+/**
+ * Get the number of idle loops skipped since emulation started.
+ * @return Number of idle loops skipped.
+ */
+inline unsigned int Z80::IdleHits(void)
+{
+	return mdZ80_get_idle_hits(ms_Z80);
+}
+
+/**
+ * Get the number of cycles skipped since emulation started.
+ * @return Number of cycles skipped.
+ */
+inline uint64_t Z80::IdleCycles(void)
+{
+	return mdZ80_get_idle_cycles(ms_Z80);
+}
+
 #else /* !GENS_ENABLE_EMULATION */
 
 inline void Z80::HardReset(void) { }
@@ -146,6 +204,11 @@ inline void Z80::Exec(int cyclesSubtract) { ((void)cyclesSubtract); }
 inline void Z80::Interrupt(uint8_t irq) { ((void)irq); }
 inline void Z80::ClearOdometer(void) { }
 inline void Z80::SetOdometer(unsigned int odo) { ((void)odo); }
+inline unsigned int Z80::ReadOdometer(void) { return 0; }
+inline bool Z80::IsRunning(void) { return false; }
+inline void Z80::SetIdleSkip(bool enable) { ((void)enable); }
+inline unsigned int Z80::IdleHits(void) { return 0; }
+inline uint64_t Z80::IdleCycles(void) { return 0; }
 
 #endif /* GENS_ENABLE_EMULATION */
 
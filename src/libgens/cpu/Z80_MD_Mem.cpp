@@ -29,7 +29,10 @@
 
 // LibGens includes.
 #include "M68K_Mem.hpp"
+#include "M68K.hpp"
+#include "Z80.hpp"
 #include "Vdp/Vdp.hpp"
+#include "EmuContext/Scheduler.hpp"
 
 // Sound Manager.
 #include "sound/SoundMgr.hpp"
@@ -50,13 +53,13 @@
 
 // TODO: mdZ80 accesses Ram_Z80 directly.
 // Move Ram_Z80 back to Z80_MD_Mem once mdZ80 is updated.
-uint8_t Ram_Z80[8 * 1024];
+EMU_THREAD_LOCAL uint8_t Ram_Z80[8 * 1024];
 
 namespace LibGens
 {
 
 // Static class variables.
-int Z80_MD_Mem::Bank_Z80;
+EMU_THREAD_LOCAL int Z80_MD_Mem::Bank_Z80;
 
 void Z80_MD_Mem::Init(void)
 {
@@ -210,7 +213,26 @@ inline void Z80_MD_Mem::Z80_WriteB_YM2612(uint32_t address, uint8_t data)
 		return;
 	
 	// Write to the YM2612.
-	SoundMgr::ms_Ym2612.write(address & 0x03, data);
+	if (!SoundMgr::ms_Ym2612.batched()) {
+		SoundMgr::ms_Ym2612.write(address & 0x03, data);
+		return;
+	}
+
+	// TODO: Don't use EmuContext here...
+	EmuContext *context = EmuContext::Instance();
+	if (!context)
+		return;
+
+	// Batched synthesis. Timestamp the write.
+	// If the Z80 isn't running, the 68000 is accessing the Z80 bus.
+	int mclk;
+	if (Z80::IsRunning()) {
+		mclk = (int)Z80::ReadOdometer() * Scheduler::MCLK_DIV_Z80;
+	} else {
+		mclk = (int)M68K::ReadOdometer() * Scheduler::MCLK_DIV_M68K;
+	}
+	SoundMgr::ms_Ym2612.write(address & 0x03, data, mclk,
+		context->m_vdp->VDP_Lines.totalDisplayLines);
 }
 
 /**
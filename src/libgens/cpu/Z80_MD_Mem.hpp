@@ -25,6 +25,7 @@
 #define __LIBGENS_CPU_Z80_MEM_HPP__
 
 #include <stdint.h>
+#include "libgens/macros/tls.h"
 
 // NOTE: mdZ80 uses the FASTCALL calling convention.
 #include "macros/fastcall.h"
@@ -35,7 +36,7 @@ extern "C" {
 
 // TODO: mdZ80 accesses Ram_Z80 directly.
 // Move Ram_Z80 back to Z80_MD_Mem once mdZ80 is updated.
-extern uint8_t Ram_Z80[8 * 1024];
+extern EMU_THREAD_LOCAL uint8_t Ram_Z80[8 * 1024];
 
 #ifdef __cplusplus
 }
@@ -57,7 +58,7 @@ class Z80_MD_Mem
 #endif
 		
 		// M68K ROM banking address.
-		static int Bank_Z80;
+		static EMU_THREAD_LOCAL int Bank_Z80;
 
 		/** Public read/write functions. **/
 		// TODO: Make these inline!
@@ -9,6 +9,11 @@
 #ifndef __STARCPU_H__
 #define __STARCPU_H__
 
+#include <stdint.h>
+
+// Thread-local storage for multi-context builds.
+#include "libgens/macros/tls.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -17,7 +22,7 @@ extern "C" {
 struct STARSCREAM_PROGRAMREGION {
 	unsigned lowaddr;
 	unsigned highaddr;
-	unsigned offset;
+	uintptr_t offset;
 };
 
 struct STARSCREAM_DATAREGION {
@@ -108,7 +113,7 @@ struct S68000CONTEXT {
 
 #define STARSCREAM_IDENTIFIERS(SNC,SN)                        \
                                                               \
-extern struct SNC##CONTEXT SN##context;                       \
+extern EMU_THREAD_LOCAL struct SNC##CONTEXT SN##context;      \
                                                               \
 int      SN##init             (void);                         \
 unsigned SN##reset            (void);                         \
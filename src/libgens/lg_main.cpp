@@ -25,6 +25,7 @@
 
 #include "lg_main.hpp"
 #include "macros/git.h"
+#include "macros/tls.h"
 #include "libcompat/cpuflags.h"
 #include "Util/Timing.hpp"
 
@@ -50,6 +51,7 @@ using std::string;
 namespace LibGens {
 
 static bool ms_IsInit = false;
+static EMU_THREAD_LOCAL bool ms_IsThreadInit = false;
 
 // libgens version.
 // TODO: Use MDP version macros.
@@ -64,6 +66,38 @@ const char *const version_vcs = GENS_GIT_VERSION;
 const char *const version_vcs = nullptr;
 #endif
 
+/**
+ * Initialize the per-thread LibGens subsystems.
+ */
+static void InitThreadState(void)
+{
+	if (ms_IsThreadInit)
+		return;
+
+	M68K::Init();
+	Z80::Init();
+	Z80_MD_Mem::Init();
+	SoundMgr::Init();
+
+	ms_IsThreadInit = true;
+}
+
+/**
+ * Shut down the per-thread LibGens subsystems.
+ */
+static void EndThreadState(void)
+{
+	if (!ms_IsThreadInit)
+		return;
+
+	M68K::End();
+	Z80::End();
+	Z80_MD_Mem::End();
+	SoundMgr::End();
+
+	ms_IsThreadInit = false;
+}
+
 /**
  * Determines if LibGens is running.
  * @return True if the LibGens thread is running; false otherwise.
@@ -131,12 +165,10 @@ int Init(void)
 	LibCompat_GetCPUFlags();
 
 	// Initialize LibGens subsystems.
-	M68K::Init();
+	// Shared tables are initialized here;
+	// everything else is per-thread.
 	M68K_Mem::Init();
-	Z80::Init();
-	Z80_MD_Mem::Init();
-
-	SoundMgr::Init();
+	InitThreadState();
 
 	// Initialize LibZomg metadata.
 	LibZomg::Metadata::InitProgramMetadata("Gens/GS II",
@@ -163,15 +195,42 @@ int End(void)
 	CPU_Flags = 0;
 	
 	// Shut down LibGens subsystems.
-	M68K::End();
+	EndThreadState();
 	M68K_Mem::End();
-	Z80::End();
-	Z80_MD_Mem::End();
-	
-	SoundMgr::End();
 	
 	ms_IsInit = false;
 	return 0;
 }
 
+/**
+ * Initialize LibGens for the current thread.
+ * Multi-context builds only; otherwise, this is a no-op,
+ * since Init() initializes the process-global state.
+ * @return 0 on success; non-zero on error.
+ */
+int InitThread(void)
+{
+#ifdef GENS_ENABLE_MULTI_CONTEXT
+	if (!ms_IsInit)
+		return 1;
+	InitThreadState();
+#endif
+	return 0;
+}
+
+/**
+ * Shut down LibGens for the current thread.
+ * Multi-context builds only; otherwise, this is a no-op.
+ * @return 0 on success; non-zero on error.
+ */
+int EndThread(void)
+{
+#ifdef GENS_ENABLE_MULTI_CONTEXT
+	if (!ms_IsThreadInit)
+		return 1;
+	EndThreadState();
+#endif
+	return 0;
+}
+
 }
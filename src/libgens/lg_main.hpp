@@ -31,6 +31,13 @@ bool IsRunning(void);
 int Init(void);
 int End(void);
 
+// Per-thread initialization. (Multi-context builds only.)
+// Init() initializes the calling thread. Other threads
+// must call InitThread() before creating an EmuContext,
+// and EndThread() after deleting it.
+int InitThread(void);
+int EndThread(void);
+
 // libgens version. (TODO: Use MDP version macros.)
 extern const unsigned int version_mdp;	// Version number.
 extern const char *const version;	// Version string. (ASCII)
@@ -0,0 +1,69 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * tls.h: Thread-local storage macros.                                     *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth                                       *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __LIBGENS_MACROS_TLS_H__
+#define __LIBGENS_MACROS_TLS_H__
+
+#include <libgens/config.libgens.h>
+
+/**
+ * THREAD_LOCAL: Thread-local storage class.
+ */
+#ifndef THREAD_LOCAL
+#if defined(__cplusplus) && (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900))
+#define THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#elif __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#error Thread-local storage is not supported by this compiler.
+#endif
+#endif /* THREAD_LOCAL */
+
+/**
+ * EMU_THREAD_LOCAL: Storage class for emulation state.
+ *
+ * Multi-context builds keep the emulation state in thread-local
+ * storage, so each thread can run its own EmuContext.
+ * Otherwise, the emulation state is process-global.
+ *
+ * Limitations:
+ * - Only one EmuContext can exist per thread.
+ * - A context must be created, run, and deleted on the same
+ *   thread, since its CPU, memory, and sound state belong
+ *   to that thread rather than to the EmuContext object.
+ * - Starscream and mdZ80_x86.asm can't be used.
+ *
+ * (See MultiContextTest.)
+ *
+ * NOTE: This must be specified on both the declaration
+ * and the definition.
+ */
+#ifdef GENS_ENABLE_MULTI_CONTEXT
+#define EMU_THREAD_LOCAL THREAD_LOCAL
+#else
+#define EMU_THREAD_LOCAL
+#endif
+
+#endif /* __LIBGENS_MACROS_TLS_H__ */
@@ -0,0 +1,632 @@
+/***************************************************************************
+ * mdM68K: Gens Portable 68000 Emulator.                                   *
+ * mdM68K.cpp: Main 68000 emulation functions.                             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "mdM68K_p.hpp"
+
+// C includes. (C++ namespace)
+#include <cstddef>
+#include <cstring>
+
+// Starscream-compatible context.
+// Only interrupts[] and the memory maps are live;
+// everything else is updated by main68k_GetContext().
+EMU_THREAD_LOCAL struct S68000CONTEXT main68k_context;
+
+// Internal CPU state.
+EMU_THREAD_LOCAL mdM68K_state_t mdM68K;
+
+// Cycles used by an interrupt acknowledge.
+#define MDM68K_INT_CYCLES 44
+
+/** Internal functions. **/
+
+/**
+ * Find the fetch region for the specified address.
+ * @param address Address.
+ * @return True if a region was found; false if not.
+ */
+bool mdM68K_rebase(uint32_t address)
+{
+	address &= 0xFFFFFF;
+	const STARSCREAM_PROGRAMREGION *fetch = main68k_context.fetch;
+	if (fetch) {
+		for (; fetch->lowaddr != ~0U; fetch++) {
+			if (address >= fetch->lowaddr && address <= fetch->highaddr) {
+				mdM68K.fetch_base = fetch->offset;
+				mdM68K.fetch_lo = fetch->lowaddr;
+				mdM68K.fetch_span = (fetch->highaddr - fetch->lowaddr);
+				return true;
+			}
+		}
+	}
+
+	// Not found. Make sure the next fetch goes through the slow path.
+	mdM68K.fetch_base = 0;
+	mdM68K.fetch_lo = ~0U;
+	mdM68K.fetch_span = 0;
+	return false;
+}
+
+/**
+ * Force the current exec() timeslice to end.
+ * This makes the cycle counter negative enough that
+ * the leftover cycles won't make it positive again.
+ */
+static inline void mdM68K_force_context_switch(void)
+{
+	mdM68K.cycles -= mdM68K.cycles_needed;
+	mdM68K.cycles_needed = 0;
+}
+
+/**
+ * Instruction fetch from outside of the cached region.
+ * @param address Address. (24-bit)
+ * @return Word, or 0 if the PC is out of bounds.
+ */
+uint32_t mdM68K_fetch16_slow(uint32_t address)
+{
+	if (mdM68K_rebase(address))
+		return *(const uint16_t*)(mdM68K.fetch_base + address);
+
+	// PC is out of bounds.
+	// Starscream stops executing in this case.
+	if (!(mdM68K.execinfo & MDM68K_EXECINFO_BOUNDS)) {
+		mdM68K.execinfo |= MDM68K_EXECINFO_BOUNDS;
+		mdM68K_force_context_switch();
+	}
+	return 0;
+}
+
+/**
+ * Set the SR.
+ * Switches stack pointers if the S bit changes.
+ * @param sr New SR.
+ */
+void mdM68K_set_sr(uint32_t sr)
+{
+	sr &= 0xA71F;
+	mdM68K_set_ccr(sr);
+	sr &= ~0xFF;
+	if ((sr ^ mdM68K.sr) & MDM68K_SR_S) {
+		// Supervisor mode changed. Swap stack pointers.
+		const uint32_t tmp = REG_SP;
+		REG_SP = mdM68K.asp;
+		mdM68K.asp = tmp;
+	}
+	mdM68K.sr = sr;
+}
+
+/**
+ * Process a group 1 or group 2 exception.
+ * @param vector Vector address. (vector number * 4)
+ * @param pc PC to push onto the stack.
+ */
+void mdM68K_exception(uint32_t vector, uint32_t pc)
+{
+	// Exceptions always un-stop the CPU.
+	main68k_context.interrupts[0] &= ~MDM68K_INT_STOPPED;
+
+	const uint32_t new_pc = mdM68K_read32(vector);
+	const uint32_t old_sr = mdM68K_get_sr();
+
+	// Enter supervisor mode and disable tracing.
+	if (!(mdM68K.sr & MDM68K_SR_S)) {
+		const uint32_t tmp = REG_SP;
+		REG_SP = mdM68K.asp;
+		mdM68K.asp = tmp;
+	}
+	mdM68K.sr = (mdM68K.sr | MDM68K_SR_S) & ~MDM68K_SR_T;
+
+	mdM68K_push32(pc);
+	mdM68K_push16(old_sr);
+	REG_PC = new_pc;
+}
+
+/**
+ * Process the pending interrupt, if any.
+ * The caller must check if the interrupt is masked.
+ */
+static void mdM68K_flush_interrupts(void)
+{
+	const unsigned int level = (main68k_context.interrupts[0] & MDM68K_INT_LEVEL);
+	if (level == 0)
+		return;
+
+	// Autovectored interrupt.
+	mdM68K_exception((0x18 + level) * 4, REG_PC);
+	mdM68K.sr = (mdM68K.sr & ~MDM68K_SR_I) | (level << 8);
+	USE_CYCLES(MDM68K_INT_CYCLES);
+
+	// Acknowledge the interrupt.
+	// VDP_Int_Ack() returns the next pending interrupt level.
+	main68k_context.interrupts[0] = VDP_Int_Ack();
+}
+
+/**
+ * Check for interrupts after an instruction that modifies the PPL.
+ * Equivalent to Starscream's ret_timing_checkpoint().
+ */
+void mdM68K_checkpoint(void)
+{
+	if (mdM68K.cycles >= 0 && mdM68K_int_pending())
+		mdM68K_flush_interrupts();
+}
+
+/**
+ * Execute instructions until the cycle counter expires.
+ */
+static inline void mdM68K_run(void)
+{
+	while (mdM68K.cycles >= 0) {
+		if (mdM68K.sr & MDM68K_SR_T) {
+			// Trace mode.
+			const uint32_t op = mdM68K_fetch16();
+			if (mdM68K.execinfo & MDM68K_EXECINFO_BOUNDS)
+				break;
+			mdM68K_optable[op](op);
+			mdM68K_exception(0x24, REG_PC);
+			USE_CYCLES(34);
+			continue;
+		}
+
+		const uint32_t address = (REG_PC & 0xFFFFFF);
+		uint32_t op;
+		if ((address - mdM68K.fetch_lo) <= mdM68K.fetch_span) {
+			op = *(const uint16_t*)(mdM68K.fetch_base + address);
+			REG_PC += 2;
+		} else {
+			op = mdM68K_fetch16_slow(address);
+			if (mdM68K.execinfo & MDM68K_EXECINFO_BOUNDS)
+				break;
+			REG_PC += 2;
+		}
+
+		mdM68K_optable[op](op);
+	}
+}
+
+/** Idle loop detection. **/
+
+// The registers and flags must fit in idle_regs[].
+static_assert(offsetof(mdM68K_state_t, cycles) == sizeof(mdM68K.idle_regs),
+	"mdM68K.idle_regs[] doesn't match the register layout.");
+
+/**
+ * Start observing an idle loop candidate.
+ * Called at the loop head.
+ */
+static inline void mdM68K_idle_start(void)
+{
+	mdM68K.idle_pc = REG_PC;
+	mdM68K.idle_cycles = mdM68K.cycles;
+	mdM68K.idle_iter = 0;
+	memcpy(mdM68K.idle_regs, &mdM68K, sizeof(mdM68K.idle_regs));
+}
+
+/**
+ * A short backward branch was taken.
+ *
+ * Loops are observed for two iterations, since VDP status reads
+ * toggle the FIFO flags. If the registers and flags at the loop
+ * head are the same as two iterations ago, and nothing was written,
+ * the loop will keep doing the same thing until the timeslice ends.
+ * Whole double iterations are then skipped; the remaining cycles
+ * are executed normally so the timeslice ends on the same
+ * instruction as it would have without skipping.
+ */
+void mdM68K_idle_branch(void)
+{
+	if (!mdM68K.idle_enable || (mdM68K.sr & MDM68K_SR_T))
+		return;
+
+	if (mdM68K.idle_pc != REG_PC) {
+		// New candidate, or the previous observation was aborted.
+		mdM68K_idle_start();
+		return;
+	}
+
+	if (++mdM68K.idle_iter < 2)
+		return;
+
+	const int period = (mdM68K.idle_cycles - mdM68K.cycles);
+	if (period <= 0 || memcmp(mdM68K.idle_regs, &mdM68K, sizeof(mdM68K.idle_regs)) != 0) {
+		// Not an idle loop, or not yet.
+		mdM68K_idle_start();
+		return;
+	}
+
+	if (mdM68K.cycles >= period) {
+		// Skip whole double iterations.
+		const int skip = (mdM68K.cycles / period) * period;
+		mdM68K.cycles -= skip;
+		mdM68K.idle_hits++;
+		mdM68K.idle_skipped += skip;
+	}
+
+	// The timeslice will end within two iterations.
+	mdM68K_idle_abort();
+}
+
+/**
+ * Check a read outside of 68000 RAM while observing an idle loop.
+ * Only VDP status reads are allowed, and only if they
+ * don't change anything other than the FIFO flags.
+ * @param address Address. (24-bit)
+ */
+void mdM68K_idle_read(uint32_t address)
+{
+	if ((address & 0xE700FC) != 0xC00004 || !VDP_Status_Stable())
+		mdM68K_idle_abort();
+}
+
+/**
+ * Enable or disable idle loop skipping.
+ * @param enable If non-zero, enable idle loop skipping.
+ */
+void mdM68K_idle_enable(int enable)
+{
+	mdM68K.idle_enable = !!enable;
+	mdM68K_idle_abort();
+}
+
+/**
+ * Get the number of idle loops that were skipped.
+ * @return Number of idle loops skipped.
+ */
+unsigned int mdM68K_idle_hits(void)
+{
+	return mdM68K.idle_hits;
+}
+
+/**
+ * Get the number of cycles skipped by idle loop skipping.
+ * @return Number of cycles skipped.
+ */
+uint64_t mdM68K_idle_cycles(void)
+{
+	return mdM68K.idle_skipped;
+}
+
+/**
+ * Clear the idle loop counters.
+ */
+void mdM68K_idle_clear(void)
+{
+	mdM68K.idle_hits = 0;
+	mdM68K.idle_skipped = 0;
+}
+
+/** Starscream-compatible API. **/
+
+/**
+ * Initialize the 68000 emulator.
+ * @return 0 on success.
+ */
+int main68k_init(void)
+{
+	// The opcode table is shared by all threads.
+	// A function-local static is initialized exactly once.
+	static const bool optable_init = (mdM68K_init_optable(), true);
+	((void)optable_init);
+
+	// Nothing is executing.
+	mdM68K.cycles = -1;
+	mdM68K.cycles_needed = 0;
+	mdM68K.cycles_leftover = 0;
+	mdM68K.execinfo = 0;
+	mdM68K_rebase(~0U);
+	mdM68K_idle_abort();
+	return 0;
+}
+
+/**
+ * Reset the 68000.
+ * @return 0 on success; 1 if the reset vector isn't mapped; -1 on double fault.
+ */
+unsigned main68k_reset(void)
+{
+	if (mdM68K.execinfo & MDM68K_EXECINFO_RUNNING)
+		return 1;
+	if (!main68k_context.s_fetch)
+		return 1;
+	mdM68K.execinfo = 0;
+
+	memset(mdM68K.dar, 0x00, sizeof(mdM68K.dar));
+	mdM68K.asp = 0;
+	mdM68K.sr = 0x2700;
+	mdM68K_set_ccr(0);
+
+	// Stay stopped if the vectors can't be read.
+	REG_PC = 1;
+	main68k_context.interrupts[0] = MDM68K_INT_STOPPED;
+	if (!mdM68K_rebase(0))
+		return 1;
+
+	const uint16_t *vectors = (const uint16_t*)(mdM68K.fetch_base);
+	REG_SP = (vectors[0] << 16) | vectors[1];
+	REG_PC = (vectors[2] << 16) | vectors[3];
+	main68k_context.interrupts[0] = 0;
+
+	// An odd PC is a double fault.
+	return (REG_PC & 1) ? ~0U : 0;
+}
+
+/**
+ * Run the 68000 until the odometer reaches the specified value.
+ * @param n Odometer value.
+ * @return 0x80000000 on success; 0x80000001 if the PC is out of bounds;
+ *         0x80000003 if the odometer is already at n; 0x80000004 if stopped;
+ *         0xFFFFFFFF if the CPU is dead due to a double fault.
+ */
+unsigned main68k_exec(int n)
+{
+	const unsigned int needed = ((unsigned int)n - mdM68K.odometer);
+	if ((unsigned int)n <= mdM68K.odometer)
+		return 0x80000003;
+
+	if (main68k_context.interrupts[0] & MDM68K_INT_STOPPED) {
+		if (REG_PC & 1)
+			return ~0U;
+		mdM68K.odometer += needed;
+		return 0x80000004;
+	}
+
+	mdM68K.cycles_needed = needed;
+	mdM68K.cycles = (int)needed - 1;
+	mdM68K.cycles_leftover = 0;
+	mdM68K.execinfo = MDM68K_EXECINFO_RUNNING;
+
+	// Other hardware may have run since the last timeslice,
+	// so idle loops have to be observed again.
+	mdM68K_idle_abort();
+
+	// Uncached rebase. The fetch map may have changed.
+	unsigned int ret = 0x80000000;
+	if (!mdM68K_rebase(REG_PC)) {
+		mdM68K_force_context_switch();
+		ret = 0x80000001;
+		goto exit;
+	}
+
+	// Check for interrupts before executing anything.
+	if (mdM68K_int_pending())
+		mdM68K_flush_interrupts();
+
+	for (;;) {
+		mdM68K_run();
+		if (mdM68K.execinfo & MDM68K_EXECINFO_BOUNDS) {
+			ret = 0x80000001;
+			break;
+		}
+
+		// Out of cycles, or an interrupt was requested.
+		// Higher-priority interrupts are processed last
+		// so their ISR gets control first.
+		if (mdM68K_int_pending())
+			mdM68K_flush_interrupts();
+
+		// Incorporate leftover cycles.
+		mdM68K.cycles += mdM68K.cycles_leftover;
+		mdM68K.cycles_leftover = 0;
+		if (mdM68K.cycles < 0)
+			break;
+	}
+
+exit:
+	mdM68K.odometer += (mdM68K.cycles_needed - (unsigned int)(mdM68K.cycles + 1));
+	mdM68K.cycles_needed = 0;
+	mdM68K.cycles = -1;
+	mdM68K.execinfo = 0;
+	return ret;
+}
+
+/**
+ * Request an interrupt.
+ * @param level Interrupt level.
+ * @param vector Interrupt vector. (ignored; always autovectored)
+ * @return 0 on success.
+ */
+int main68k_interrupt(int level, int vector)
+{
+	((void)vector);
+
+	// HACK from Starscream: If the CPU is stopped and
+	// the interrupt is masked, don't do anything.
+	if (main68k_context.interrupts[0] & MDM68K_INT_STOPPED) {
+		if (level != 7 && (int)((mdM68K.sr >> 8) & 7) >= level)
+			return 0;
+	}
+
+	// This also clears the stopped bit.
+	main68k_context.interrupts[0] = (uint8_t)level;
+
+	// Stop after the current instruction so the interrupt
+	// can be processed. The remaining cycles are saved.
+	mdM68K.cycles_leftover += (mdM68K.cycles + 1);
+	mdM68K.cycles = -1;
+	return 0;
+}
+
+/**
+ * Process pending interrupts outside of exec().
+ */
+void main68k_flushInterrupts(void)
+{
+	if (mdM68K.execinfo & MDM68K_EXECINFO_RUNNING)
+		return;
+	if (!mdM68K_int_pending())
+		return;
+
+	// The acknowledge cycles go straight to the odometer.
+	mdM68K.cycles = 0;
+	mdM68K_flush_interrupts();
+	mdM68K.odometer -= mdM68K.cycles;
+	mdM68K.cycles = -1;
+}
+
+/**
+ * Get the size of the 68000 context.
+ * @return Size of S68000CONTEXT.
+ */
+int main68k_GetContextSize(void)
+{
+	return (int)sizeof(main68k_context);
+}
+
+/**
+ * Get the 68000 context.
+ * @param context Pointer to S68000CONTEXT.
+ */
+void main68k_GetContext(void *context)
+{
+	memcpy(main68k_context.dreg, &mdM68K.dar[0], sizeof(main68k_context.dreg));
+	memcpy(main68k_context.areg, &mdM68K.dar[8], sizeof(main68k_context.areg));
+	main68k_context.asp = mdM68K.asp;
+	main68k_context.pc = REG_PC;
+	main68k_context.sr = (unsigned short)mdM68K_get_sr();
+	main68k_context.xflag = (unsigned char)mdM68K.flag_x;
+	main68k_context.odometer = mdM68K.odometer;
+	main68k_context.cycles_needed = mdM68K.cycles_needed;
+	main68k_context.cycles_leftover = mdM68K.cycles_leftover;
+	main68k_context.io_cycle_counter = (unsigned int)mdM68K.cycles;
+	main68k_context.execinfo = mdM68K.execinfo;
+	main68k_context.fetch_region_start = mdM68K.fetch_lo;
+	main68k_context.fetch_region_end = mdM68K.fetch_lo + mdM68K.fetch_span;
+	memcpy(context, &main68k_context, sizeof(main68k_context));
+}
+
+/**
+ * Set the 68000 context.
+ * @param context Pointer to S68000CONTEXT.
+ */
+void main68k_SetContext(void *context)
+{
+	memcpy(&main68k_context, context, sizeof(main68k_context));
+	memcpy(&mdM68K.dar[0], main68k_context.dreg, sizeof(main68k_context.dreg));
+	memcpy(&mdM68K.dar[8], main68k_context.areg, sizeof(main68k_context.areg));
+	mdM68K.asp = main68k_context.asp;
+	REG_PC = main68k_context.pc;
+	mdM68K.sr = (main68k_context.sr & 0xA700);
+	mdM68K_set_ccr(main68k_context.sr);
+	mdM68K.odometer = main68k_context.odometer;
+	mdM68K.cycles_needed = main68k_context.cycles_needed;
+	mdM68K.cycles_leftover = main68k_context.cycles_leftover;
+	mdM68K.cycles = (int)main68k_context.io_cycle_counter;
+	mdM68K.execinfo = main68k_context.execinfo;
+
+	// Invalidate the fetch region cache.
+	mdM68K_rebase(~0U);
+}
+
+/**
+ * Read a word using the supervisor fetch map.
+ * @param address Address.
+ * @return Word, or -1 if the address isn't mapped.
+ */
+int main68k_fetch(unsigned address)
+{
+	// Save the fetch region cache.
+	const uintptr_t fetch_base = mdM68K.fetch_base;
+	const uint32_t fetch_lo = mdM68K.fetch_lo;
+	const uint32_t fetch_span = mdM68K.fetch_span;
+
+	int ret = -1;
+	address &= 0xFFFFFF;
+	if (mdM68K_rebase(address))
+		ret = *(const uint16_t*)(mdM68K.fetch_base + address);
+
+	mdM68K.fetch_base = fetch_base;
+	mdM68K.fetch_lo = fetch_lo;
+	mdM68K.fetch_span = fetch_span;
+	return ret;
+}
+
+/**
+ * Read the odometer.
+ * Works from anywhere, including memory handlers.
+ * @return Odometer.
+ */
+unsigned main68k_readOdometer(void)
+{
+	return (mdM68K.cycles_needed - (unsigned int)mdM68K.cycles - 1
+		- mdM68K.cycles_leftover + mdM68K.odometer);
+}
+
+/**
+ * Read and clear the odometer.
+ * @return Old odometer value.
+ */
+unsigned main68k_tripOdometer(void)
+{
+	mdM68K.odometer += (mdM68K.cycles_needed - (unsigned int)mdM68K.cycles - 1
+		- mdM68K.cycles_leftover);
+	mdM68K.cycles_needed = (unsigned int)(mdM68K.cycles + 1);
+
+	const unsigned int ret = mdM68K.odometer;
+	mdM68K.odometer = 0;
+	return ret;
+}
+
+/**
+ * Read the odometer, and clear it if n != 0.
+ * @param n If non-zero, clear the odometer.
+ * @return Old odometer value.
+ */
+unsigned main68k_controlOdometer(int n)
+{
+	return (n ? main68k_tripOdometer() : main68k_readOdometer());
+}
+
+/**
+ * End the current exec() timeslice early.
+ */
+void main68k_releaseTimeslice(void)
+{
+	mdM68K.cycles -= mdM68K.cycles_needed;
+	mdM68K.cycles_needed = 0;
+}
+
+/**
+ * Use cycles from the current timeslice. (e.g. for DMA)
+ * @param cycles Number of cycles.
+ */
+void main68k_releaseCycles(int cycles)
+{
+	mdM68K.cycles -= cycles;
+}
+
+/**
+ * Add cycles to the odometer.
+ * @param cycles Number of cycles.
+ */
+void main68k_addCycles(int cycles)
+{
+	mdM68K.odometer += cycles;
+}
+
+/**
+ * Get the current program counter.
+ * @return PC.
+ */
+unsigned main68k_readPC(void)
+{
+	return REG_PC;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+ * mdM68K: Gens Portable 68000 Emulator.                                   *
+ * mdM68K.h: Public functions.                                             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __MDM68K_H__
+#define __MDM68K_H__
+
+/**
+ * mdM68K-specific functions.
+ * The Starscream-compatible API is in cpu/star_68k.h.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Enable or disable idle loop skipping.
+ *
+ * An idle loop is a short backward branch whose body only reads
+ * 68000 RAM or the VDP status register, and leaves the CPU in the
+ * same state every two iterations. Once a loop is recognized, the
+ * rest of the timeslice is skipped in whole iterations, so the
+ * result is identical to running it.
+ *
+ * @param enable If non-zero, enable idle loop skipping.
+ */
+void mdM68K_idle_enable(int enable);
+
+/**
+ * Get the number of idle loops that were skipped.
+ * @return Number of idle loops skipped.
+ */
+unsigned int mdM68K_idle_hits(void);
+
+/**
+ * Get the number of cycles skipped by idle loop skipping.
+ * @return Number of cycles skipped.
+ */
+uint64_t mdM68K_idle_cycles(void);
+
+/**
+ * Clear the idle loop counters.
+ */
+void mdM68K_idle_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MDM68K_H__ */
@@ -0,0 +1,2132 @@
+/***************************************************************************
+ * mdM68K: Gens Portable 68000 Emulator.                                   *
+ * mdM68K_ops.cpp: 68000 instruction handlers.                             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+/**
+ * Instruction handlers are templates specialized on operand size
+ * and effective address mode, so each opcode gets a handler with
+ * no runtime EA decoding. Timing follows the 68000 User's Manual,
+ * with Starscream's values where Gens depends on them.
+ * (MULU/MULS: 38+2n; DIVU/DIVS: fixed 133/150; TAS doesn't write.)
+ */
+
+#include "mdM68K_p.hpp"
+
+// Opcode table.
+mdM68K_op_t mdM68K_optable[0x10000];
+
+/** Effective address modes. **/
+enum EaMode {
+	EA_DREG = 0,	// Dn
+	EA_AREG,	// An
+	EA_AIND,	// (An)
+	EA_AINC,	// (An)+
+	EA_ADEC,	// -(An)
+	EA_AD16,	// d16(An)
+	EA_AD8X,	// d8(An,Xn)
+	EA_ABSW,	// (xxx).W
+	EA_ABSL,	// (xxx).L
+	EA_PC16,	// d16(PC)
+	EA_PC8X,	// d8(PC,Xn)
+	EA_IMM,		// #imm
+
+	EA_MAX
+};
+
+/** EA mode masks. **/
+#define EAM(x)		(1U << (x))
+#define EAM_ALL		(EAM(EA_MAX) - 1)
+#define EAM_DATA	(EAM_ALL & ~EAM(EA_AREG))
+#define EAM_MEMORY	(EAM_ALL & ~(EAM(EA_DREG) | EAM(EA_AREG)))
+#define EAM_CONTROL	(EAM(EA_AIND) | EAM(EA_AD16) | EAM(EA_AD8X) | \
+			 EAM(EA_ABSW) | EAM(EA_ABSL) | EAM(EA_PC16) | EAM(EA_PC8X))
+#define EAM_ALTERABLE	(EAM_ALL & ~(EAM(EA_PC16) | EAM(EA_PC8X) | EAM(EA_IMM)))
+#define EAM_DATA_ALT	(EAM_ALTERABLE & ~EAM(EA_AREG))
+#define EAM_MEM_ALT	(EAM_ALTERABLE & ~(EAM(EA_DREG) | EAM(EA_AREG)))
+
+// EA calculation cycles. [mode]
+static const uint8_t ea_cycles_bw[EA_MAX] = {0, 0, 4, 4, 6, 8, 10, 8, 12, 8, 10, 4};
+static const uint8_t ea_cycles_l[EA_MAX]  = {0, 0, 8, 8, 10, 12, 14, 12, 16, 12, 14, 8};
+
+template<int Mode, int Size>
+static inline int ea_cycles(void)
+{
+	return (Size == 4 ? ea_cycles_l[Mode] : ea_cycles_bw[Mode]);
+}
+
+/** Operand sizes. **/
+
+template<int Size>
+static inline uint32_t size_mask(void)
+{
+	return (Size == 1 ? 0xFF : (Size == 2 ? 0xFFFF : 0xFFFFFFFF));
+}
+
+template<int Size>
+static inline uint32_t size_msb(void)
+{
+	return (Size == 1 ? 0x80 : (Size == 2 ? 0x8000 : 0x80000000));
+}
+
+template<int Size>
+static inline uint32_t size_sext(uint32_t data)
+{
+	return (Size == 1 ? SEXT8(data) : (Size == 2 ? SEXT16(data) : data));
+}
+
+/**
+ * Store a value in a data register, preserving the unused bits.
+ * @param reg Data register.
+ * @param data Value.
+ */
+template<int Size>
+static inline void set_dn(uint32_t &reg, uint32_t data)
+{
+	if (Size == 4)
+		reg = data;
+	else
+		reg = (reg & ~size_mask<Size>()) | (data & size_mask<Size>());
+}
+
+/** Memory access by size. **/
+
+template<int Size, bool Dec>
+static inline uint32_t mem_read(uint32_t address)
+{
+	if (Size == 1)
+		return mdM68K_read8(address);
+	else if (Size == 2)
+		return mdM68K_read16(address);
+	else if (Dec)
+		return mdM68K_read32_dec(address);
+	return mdM68K_read32(address);
+}
+
+template<int Size, bool Dec>
+static inline void mem_write(uint32_t address, uint32_t data)
+{
+	if (Size == 1)
+		mdM68K_write8(address, data);
+	else if (Size == 2)
+		mdM68K_write16(address, data);
+	else if (Dec)
+		mdM68K_write32_dec(address, data);
+	else
+		mdM68K_write32(address, data);
+}
+
+/** Effective address calculation. **/
+
+/**
+ * Calculate a d8(An,Xn) / d8(PC,Xn) address.
+ * @param base Base address.
+ * @return Address.
+ */
+static inline uint32_t ea_index(uint32_t base)
+{
+	const uint32_t ext = mdM68K_fetch16();
+	// Bits 15-12 of the extension word index dar[] directly.
+	uint32_t idx = mdM68K.dar[ext >> 12];
+	if (!(ext & 0x800))
+		idx = SEXT16(idx);
+	return base + idx + SEXT8(ext);
+}
+
+/**
+ * Calculate an effective address.
+ * (An)+ and -(An) update the address register.
+ * @param reg Register number.
+ * @return Address.
+ */
+template<int Mode, int Size>
+static inline uint32_t ea_address(uint32_t reg)
+{
+	// Byte accesses on A7 keep the stack word-aligned.
+	const uint32_t inc = ((Size == 1 && reg == 7) ? 2 : Size);
+
+	switch (Mode) {
+		case EA_AIND:
+			return REG_A(reg);
+		case EA_AINC: {
+			const uint32_t address = REG_A(reg);
+			REG_A(reg) += inc;
+			return address;
+		}
+		case EA_ADEC:
+			REG_A(reg) -= inc;
+			return REG_A(reg);
+		case EA_AD16:
+			return REG_A(reg) + SEXT16(mdM68K_fetch16());
+		case EA_AD8X:
+			return ea_index(REG_A(reg));
+		case EA_ABSW:
+			return SEXT16(mdM68K_fetch16());
+		case EA_ABSL:
+			return mdM68K_fetch32();
+		case EA_PC16: {
+			const uint32_t base = REG_PC;
+			return base + SEXT16(mdM68K_fetch16());
+		}
+		case EA_PC8X:
+			return ea_index(REG_PC);
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Read an operand.
+ * @param reg Register number.
+ * @return Operand. (zero-extended)
+ */
+template<int Mode, int Size>
+static inline uint32_t ea_read(uint32_t reg)
+{
+	switch (Mode) {
+		case EA_DREG:
+			return REG_D(reg) & size_mask<Size>();
+		case EA_AREG:
+			return REG_A(reg) & size_mask<Size>();
+		case EA_IMM:
+			if (Size == 4)
+				return mdM68K_fetch32();
+			return mdM68K_fetch16() & size_mask<Size>();
+		default:
+			return mem_read<Size, Mode == EA_ADEC>(ea_address<Mode, Size>(reg));
+	}
+}
+
+/**
+ * Write an operand. (Dn or memory)
+ * @param reg Register number.
+ * @param data Operand.
+ */
+template<int Mode, int Size>
+static inline void ea_write(uint32_t reg, uint32_t data)
+{
+	if (Mode == EA_DREG)
+		set_dn<Size>(REG_D(reg), data);
+	else
+		mem_write<Size, Mode == EA_ADEC>(ea_address<Mode, Size>(reg), data);
+}
+
+/** Condition codes. **/
+
+template<int Size>
+static inline void flags_logic(uint32_t res)
+{
+	mdM68K.flag_n = !!(res & size_msb<Size>());
+	mdM68K.flag_notz = (res & size_mask<Size>());
+	mdM68K.flag_v = 0;
+	mdM68K.flag_c = 0;
+}
+
+template<int Size>
+static inline uint32_t do_add(uint32_t src, uint32_t dst)
+{
+	const uint32_t res = (src + dst) & size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz = res;
+	mdM68K.flag_v = !!((src ^ res) & (dst ^ res) & msb);
+	mdM68K.flag_c = mdM68K.flag_x = !!(((src & dst) | (~res & (src | dst))) & msb);
+	return res;
+}
+
+template<int Size>
+static inline uint32_t do_sub(uint32_t src, uint32_t dst)
+{
+	const uint32_t res = (dst - src) & size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz = res;
+	mdM68K.flag_v = !!((src ^ dst) & (res ^ dst) & msb);
+	mdM68K.flag_c = mdM68K.flag_x = !!(((src & res) | (~dst & (src | res))) & msb);
+	return res;
+}
+
+template<int Size>
+static inline void do_cmp(uint32_t src, uint32_t dst)
+{
+	const uint32_t res = (dst - src) & size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz = res;
+	mdM68K.flag_v = !!((src ^ dst) & (res ^ dst) & msb);
+	mdM68K.flag_c = !!(((src & res) | (~dst & (src | res))) & msb);
+}
+
+template<int Size>
+static inline uint32_t do_addx(uint32_t src, uint32_t dst)
+{
+	const uint32_t res = (src + dst + mdM68K.flag_x) & size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz |= res;
+	mdM68K.flag_v = !!((src ^ res) & (dst ^ res) & msb);
+	mdM68K.flag_c = mdM68K.flag_x = !!(((src & dst) | (~res & (src | dst))) & msb);
+	return res;
+}
+
+template<int Size>
+static inline uint32_t do_subx(uint32_t src, uint32_t dst)
+{
+	const uint32_t res = (dst - src - mdM68K.flag_x) & size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz |= res;
+	mdM68K.flag_v = !!((src ^ dst) & (res ^ dst) & msb);
+	mdM68K.flag_c = mdM68K.flag_x = !!(((src & res) | (~dst & (src | res))) & msb);
+	return res;
+}
+
+/** ALU operations. **/
+enum AluOp {
+	ALU_ADD,
+	ALU_SUB,
+	ALU_AND,
+	ALU_OR,
+	ALU_EOR,
+	ALU_CMP,
+};
+
+template<int Op, int Size>
+static inline uint32_t do_alu(uint32_t src, uint32_t dst)
+{
+	switch (Op) {
+		case ALU_ADD:	return do_add<Size>(src, dst);
+		case ALU_SUB:	return do_sub<Size>(src, dst);
+		case ALU_AND:	flags_logic<Size>(src & dst); return (src & dst);
+		case ALU_OR:	flags_logic<Size>(src | dst); return (src | dst);
+		case ALU_EOR:	flags_logic<Size>(src ^ dst); return (src ^ dst);
+		case ALU_CMP:	do_cmp<Size>(src, dst); return dst;
+		default:	return dst;
+	}
+}
+
+/**
+ * Test a condition.
+ * @return True if the condition is true.
+ */
+template<int CC>
+static inline bool cond(void)
+{
+	switch (CC) {
+		case 0x0: return true;						// T
+		case 0x1: return false;						// F
+		case 0x2: return !mdM68K.flag_c && mdM68K.flag_notz;		// HI
+		case 0x3: return mdM68K.flag_c || !mdM68K.flag_notz;		// LS
+		case 0x4: return !mdM68K.flag_c;				// CC
+		case 0x5: return !!mdM68K.flag_c;				// CS
+		case 0x6: return !!mdM68K.flag_notz;				// NE
+		case 0x7: return !mdM68K.flag_notz;				// EQ
+		case 0x8: return !mdM68K.flag_v;				// VC
+		case 0x9: return !!mdM68K.flag_v;				// VS
+		case 0xA: return !mdM68K.flag_n;				// PL
+		case 0xB: return !!mdM68K.flag_n;				// MI
+		case 0xC: return mdM68K.flag_n == mdM68K.flag_v;		// GE
+		case 0xD: return mdM68K.flag_n != mdM68K.flag_v;		// LT
+		case 0xE: return mdM68K.flag_notz && mdM68K.flag_n == mdM68K.flag_v;	// GT
+		case 0xF: return !mdM68K.flag_notz || mdM68K.flag_n != mdM68K.flag_v;	// LE
+		default:  return false;
+	}
+}
+
+/** Exceptions. **/
+
+static void op_illegal(uint32_t op)
+{
+	((void)op);
+	mdM68K_exception(0x10, REG_PC - 2);
+	USE_CYCLES(34);
+}
+
+static void op_linea(uint32_t op)
+{
+	((void)op);
+	mdM68K_exception(0x28, REG_PC - 2);
+	USE_CYCLES(34);
+}
+
+static void op_linef(uint32_t op)
+{
+	((void)op);
+	mdM68K_exception(0x2C, REG_PC - 2);
+	USE_CYCLES(34);
+}
+
+/**
+ * Check for supervisor mode.
+ * Triggers a privilege violation if not in supervisor mode.
+ * @return True if in supervisor mode.
+ */
+static inline bool privileged(void)
+{
+	if (mdM68K.sr & MDM68K_SR_S)
+		return true;
+	mdM68K_exception(0x20, REG_PC - 2);
+	USE_CYCLES(34);
+	return false;
+}
+
+/** Arithmetic and logical instructions. **/
+
+/**
+ * ADD, SUB, AND, OR, CMP <ea>,Dn
+ */
+template<int Op, int Size, int Mode>
+static void op_alu_ea_dn(uint32_t op)
+{
+	const uint32_t src = ea_read<Mode, Size>(op & 7);
+	uint32_t &dn = REG_D((op >> 9) & 7);
+	const uint32_t res = do_alu<Op, Size>(src, dn & size_mask<Size>());
+	if (Op != ALU_CMP)
+		set_dn<Size>(dn, res);
+
+	if (Size != 4)
+		USE_CYCLES(4 + ea_cycles<Mode, Size>());
+	else if (Op != ALU_CMP && (Mode == EA_DREG || Mode == EA_AREG || Mode == EA_IMM))
+		USE_CYCLES(8 + ea_cycles<Mode, Size>());
+	else
+		USE_CYCLES(6 + ea_cycles<Mode, Size>());
+}
+
+/**
+ * ADD, SUB, AND, OR, EOR Dn,<ea>
+ */
+template<int Op, int Size, int Mode>
+static void op_alu_dn_ea(uint32_t op)
+{
+	const uint32_t src = REG_D((op >> 9) & 7) & size_mask<Size>();
+	if (Mode == EA_DREG) {
+		// EOR Dn,Dn
+		uint32_t &dn = REG_D(op & 7);
+		set_dn<Size>(dn, do_alu<Op, Size>(src, dn & size_mask<Size>()));
+		USE_CYCLES(Size == 4 ? 8 : 4);
+		return;
+	}
+
+	const uint32_t address = ea_address<Mode, Size>(op & 7);
+	const uint32_t dst = mem_read<Size, Mode == EA_ADEC>(address);
+	mem_write<Size, Mode == EA_ADEC>(address, do_alu<Op, Size>(src, dst));
+	USE_CYCLES((Size == 4 ? 12 : 8) + ea_cycles<Mode, Size>());
+}
+
+/**
+ * ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm,<ea>
+ */
+template<int Op, int Size, int Mode>
+static void op_alui(uint32_t op)
+{
+	const uint32_t src = ea_read<EA_IMM, Size>(0);
+	if (Mode == EA_DREG) {
+		uint32_t &dn = REG_D(op & 7);
+		const uint32_t res = do_alu<Op, Size>(src, dn & size_mask<Size>());
+		if (Op != ALU_CMP)
+			set_dn<Size>(dn, res);
+		if (Size != 4)
+			USE_CYCLES(8);
+		else if (Op == ALU_CMP || Op == ALU_AND)
+			USE_CYCLES(14);
+		else
+			USE_CYCLES(16);
+		return;
+	}
+
+	const uint32_t address = ea_address<Mode, Size>(op & 7);
+	const uint32_t dst = mem_read<Size, Mode == EA_ADEC>(address);
+	const uint32_t res = do_alu<Op, Size>(src, dst);
+	if (Op != ALU_CMP) {
+		mem_write<Size, Mode == EA_ADEC>(address, res);
+		USE_CYCLES((Size == 4 ? 20 : 12) + ea_cycles<Mode, Size>());
+	} else {
+		USE_CYCLES((Size == 4 ? 12 : 8) + ea_cycles<Mode, Size>());
+	}
+}
+
+/**
+ * ADDQ, SUBQ #imm,<ea>
+ */
+template<int Op, int Size, int Mode>
+static void op_addq(uint32_t op)
+{
+	uint32_t src = (op >> 9) & 7;
+	if (src == 0)
+		src = 8;
+
+	if (Mode == EA_AREG) {
+		// Address register. Always 32-bit; flags aren't affected.
+		if (Op == ALU_ADD)
+			REG_A(op & 7) += src;
+		else
+			REG_A(op & 7) -= src;
+		USE_CYCLES(8);
+	} else if (Mode == EA_DREG) {
+		uint32_t &dn = REG_D(op & 7);
+		set_dn<Size>(dn, do_alu<Op, Size>(src, dn & size_mask<Size>()));
+		USE_CYCLES(Size == 4 ? 8 : 4);
+	} else {
+		const uint32_t address = ea_address<Mode, Size>(op & 7);
+		const uint32_t dst = mem_read<Size, Mode == EA_ADEC>(address);
+		mem_write<Size, Mode == EA_ADEC>(address, do_alu<Op, Size>(src, dst));
+		USE_CYCLES((Size == 4 ? 12 : 8) + ea_cycles<Mode, Size>());
+	}
+}
+
+/**
+ * ADDA, SUBA <ea>,An
+ */
+template<int Op, int Size, int Mode>
+static void op_adda(uint32_t op)
+{
+	const uint32_t src = size_sext<Size>(ea_read<Mode, Size>(op & 7));
+	if (Op == ALU_ADD)
+		REG_A((op >> 9) & 7) += src;
+	else
+		REG_A((op >> 9) & 7) -= src;
+
+	if (Size == 4 && !(Mode == EA_DREG || Mode == EA_AREG || Mode == EA_IMM))
+		USE_CYCLES(6 + ea_cycles<Mode, Size>());
+	else
+		USE_CYCLES(8 + ea_cycles<Mode, Size>());
+}
+
+/**
+ * CMPA <ea>,An
+ */
+template<int Size, int Mode>
+static void op_cmpa(uint32_t op)
+{
+	const uint32_t src = size_sext<Size>(ea_read<Mode, Size>(op & 7));
+	do_cmp<4>(src, REG_A((op >> 9) & 7));
+	USE_CYCLES(6 + ea_cycles<Mode, Size>());
+}
+
+/**
+ * CMPM (Ay)+,(Ax)+
+ */
+template<int Size>
+static void op_cmpm(uint32_t op)
+{
+	const uint32_t src = mem_read<Size, false>(ea_address<EA_AINC, Size>(op & 7));
+	const uint32_t dst = mem_read<Size, false>(ea_address<EA_AINC, Size>((op >> 9) & 7));
+	do_cmp<Size>(src, dst);
+	USE_CYCLES(Size == 4 ? 20 : 12);
+}
+
+/**
+ * ADDX, SUBX Dy,Dx / -(Ay),-(Ax)
+ */
+template<int Op, int Size, bool Mem>
+static void op_addx(uint32_t op)
+{
+	if (!Mem) {
+		const uint32_t src = REG_D(op & 7) & size_mask<Size>();
+		uint32_t &dx = REG_D((op >> 9) & 7);
+		const uint32_t dst = dx & size_mask<Size>();
+		set_dn<Size>(dx, (Op == ALU_ADD ? do_addx<Size>(src, dst) : do_subx<Size>(src, dst)));
+		USE_CYCLES(Size == 4 ? 8 : 4);
+		return;
+	}
+
+	const uint32_t src = mem_read<Size, true>(ea_address<EA_ADEC, Size>(op & 7));
+	const uint32_t address = ea_address<EA_ADEC, Size>((op >> 9) & 7);
+	const uint32_t dst = mem_read<Size, true>(address);
+	mem_write<Size, true>(address, (Op == ALU_ADD ? do_addx<Size>(src, dst) : do_subx<Size>(src, dst)));
+	USE_CYCLES(Size == 4 ? 30 : 18);
+}
+
+/** Unary operations. **/
+enum UnaryOp {
+	UN_NEGX,
+	UN_CLR,
+	UN_NEG,
+	UN_NOT,
+};
+
+/**
+ * NEGX, CLR, NEG, NOT <ea>
+ */
+template<int Op, int Size, int Mode>
+static void op_unary(uint32_t op)
+{
+	uint32_t address = 0, dst = 0;
+	if (Mode == EA_DREG) {
+		dst = REG_D(op & 7) & size_mask<Size>();
+	} else {
+		address = ea_address<Mode, Size>(op & 7);
+		if (Op != UN_CLR)
+			dst = mem_read<Size, Mode == EA_ADEC>(address);
+	}
+
+	uint32_t res;
+	switch (Op) {
+		case UN_NEGX:	res = do_subx<Size>(dst, 0); break;
+		case UN_CLR:	res = 0; flags_logic<Size>(0); break;
+		case UN_NEG:	res = do_sub<Size>(dst, 0); break;
+		case UN_NOT:	res = ~dst & size_mask<Size>(); flags_logic<Size>(res); break;
+		default:	res = dst; break;
+	}
+
+	if (Mode == EA_DREG) {
+		set_dn<Size>(REG_D(op & 7), res);
+		USE_CYCLES(Size == 4 ? 6 : 4);
+	} else {
+		mem_write<Size, Mode == EA_ADEC>(address, res);
+		USE_CYCLES((Size == 4 ? 12 : 8) + ea_cycles<Mode, Size>());
+	}
+}
+
+/**
+ * TST <ea>
+ */
+template<int Size, int Mode>
+static void op_tst(uint32_t op)
+{
+	flags_logic<Size>(ea_read<Mode, Size>(op & 7));
+	USE_CYCLES(4 + ea_cycles<Mode, Size>());
+}
+
+/**
+ * TAS <ea>
+ * NOTE: The MD doesn't support TAS write-back to memory.
+ */
+template<int Mode>
+static void op_tas(uint32_t op)
+{
+	if (Mode == EA_DREG) {
+		uint32_t &dn = REG_D(op & 7);
+		flags_logic<1>(dn);
+		dn |= 0x80;
+		USE_CYCLES(4);
+	} else {
+		flags_logic<1>(ea_read<Mode, 1>(op & 7));
+		USE_CYCLES(14 + ea_cycles<Mode, 1>());
+	}
+}
+
+/** Multiply and divide. **/
+
+/**
+ * MULU, MULS <ea>,Dn
+ */
+template<bool Signed, int Mode>
+static void op_mul(uint32_t op)
+{
+	const uint32_t src = ea_read<Mode, 2>(op & 7);
+	uint32_t &dn = REG_D((op >> 9) & 7);
+
+	uint32_t res, bits;
+	if (Signed) {
+		res = (uint32_t)((int32_t)(int16_t)src * (int32_t)(int16_t)dn);
+		// Count the 01 and 10 bit pairs.
+		bits = ((src << 1) ^ src) & 0xFFFF;
+	} else {
+		res = (src * (dn & 0xFFFF));
+		bits = src;
+	}
+	dn = res;
+	flags_logic<4>(res);
+
+	int n = 0;
+	for (; bits != 0; bits &= (bits - 1))
+		n++;
+	USE_CYCLES(38 + (n * 2) + ea_cycles<Mode, 2>());
+}
+
+/**
+ * DIVU, DIVS <ea>,Dn
+ */
+template<bool Signed, int Mode>
+static void op_div(uint32_t op)
+{
+	const uint32_t src = ea_read<Mode, 2>(op & 7);
+	if (src == 0) {
+		// Division by zero.
+		mdM68K_exception(0x14, REG_PC);
+		USE_CYCLES(38 + ea_cycles<Mode, 2>());
+		return;
+	}
+
+	uint32_t &dn = REG_D((op >> 9) & 7);
+	bool overflow;
+	uint32_t quotient, remainder;
+	if (Signed) {
+		const int32_t dividend = (int32_t)dn;
+		const int32_t divisor = (int16_t)src;
+		if (dividend == (int32_t)0x80000000 && divisor == -1) {
+			overflow = true;
+			quotient = remainder = 0;
+		} else {
+			const int32_t q = dividend / divisor;
+			overflow = (q != (int16_t)q);
+			quotient = (uint32_t)q;
+			remainder = (uint32_t)(dividend % divisor);
+		}
+	} else {
+		quotient = dn / src;
+		remainder = dn % src;
+		overflow = (quotient > 0xFFFF);
+	}
+
+	if (!overflow) {
+		dn = ((remainder & 0xFFFF) << 16) | (quotient & 0xFFFF);
+		flags_logic<2>(quotient);
+	} else {
+		// Overflow. Dn isn't modified.
+		mdM68K.flag_n = 0;
+		mdM68K.flag_notz = 1;
+		mdM68K.flag_v = 1;
+		mdM68K.flag_c = 0;
+	}
+
+	USE_CYCLES((Signed ? 150 : 133) + ea_cycles<Mode, 2>());
+}
+
+/** BCD arithmetic. **/
+
+static inline uint32_t do_abcd(uint32_t src, uint32_t dst)
+{
+	uint32_t res = (src & 0x0F) + (dst & 0x0F) + mdM68K.flag_x;
+	uint32_t v = ~res;	// V is undefined.
+	if (res > 9)
+		res += 6;
+	res += (src & 0xF0) + (dst & 0xF0);
+	mdM68K.flag_c = mdM68K.flag_x = (res > 0x99);
+	if (mdM68K.flag_c)
+		res -= 0xA0;
+	v &= res;
+	mdM68K.flag_v = (v >> 7) & 1;
+	mdM68K.flag_n = (res >> 7) & 1;
+	res &= 0xFF;
+	mdM68K.flag_notz |= res;
+	return res;
+}
+
+static inline uint32_t do_sbcd(uint32_t src, uint32_t dst)
+{
+	uint32_t res = (dst & 0x0F) - (src & 0x0F) - mdM68K.flag_x;
+	uint32_t v = ~res;	// V is undefined.
+	if (res > 9)
+		res -= 6;
+	res += (dst & 0xF0) - (src & 0xF0);
+	mdM68K.flag_c = mdM68K.flag_x = (res > 0x99);
+	if (mdM68K.flag_c)
+		res += 0xA0;
+	res &= 0xFF;
+	v &= res;
+	mdM68K.flag_v = (v >> 7) & 1;
+	mdM68K.flag_n = (res >> 7) & 1;
+	mdM68K.flag_notz |= res;
+	return res;
+}
+
+/**
+ * ABCD, SBCD Dy,Dx / -(Ay),-(Ax)
+ */
+template<bool Sub, bool Mem>
+static void op_bcd(uint32_t op)
+{
+	if (!Mem) {
+		const uint32_t src = REG_D(op & 7) & 0xFF;
+		uint32_t &dx = REG_D((op >> 9) & 7);
+		set_dn<1>(dx, (Sub ? do_sbcd(src, dx & 0xFF) : do_abcd(src, dx & 0xFF)));
+		USE_CYCLES(6);
+		return;
+	}
+
+	const uint32_t src = mdM68K_read8(ea_address<EA_ADEC, 1>(op & 7));
+	const uint32_t address = ea_address<EA_ADEC, 1>((op >> 9) & 7);
+	const uint32_t dst = mdM68K_read8(address);
+	mdM68K_write8(address, (Sub ? do_sbcd(src, dst) : do_abcd(src, dst)));
+	USE_CYCLES(18);
+}
+
+/**
+ * NBCD <ea>
+ */
+template<int Mode>
+static void op_nbcd(uint32_t op)
+{
+	uint32_t address = 0, dst;
+	if (Mode == EA_DREG) {
+		dst = REG_D(op & 7) & 0xFF;
+	} else {
+		address = ea_address<Mode, 1>(op & 7);
+		dst = mdM68K_read8(address);
+	}
+
+	uint32_t res = (0x9A - dst - mdM68K.flag_x) & 0xFF;
+	if (res != 0x9A) {
+		uint32_t v = ~res;	// V is undefined.
+		if ((res & 0x0F) == 0x0A)
+			res = (res & 0xF0) + 0x10;
+		res &= 0xFF;
+		v &= res;
+		mdM68K.flag_v = (v >> 7) & 1;
+		mdM68K.flag_notz |= res;
+		mdM68K.flag_c = mdM68K.flag_x = 1;
+		mdM68K.flag_n = (res >> 7) & 1;
+
+		if (Mode == EA_DREG)
+			set_dn<1>(REG_D(op & 7), res);
+		else
+			mdM68K_write8(address, res);
+	} else {
+		mdM68K.flag_v = 0;
+		mdM68K.flag_c = mdM68K.flag_x = 0;
+		mdM68K.flag_n = (res >> 7) & 1;
+	}
+
+	USE_CYCLES(Mode == EA_DREG ? 6 : (8 + ea_cycles<Mode, 1>()));
+}
+
+/** Data movement. **/
+
+// MOVE destination cycles. [mode]
+static const uint8_t move_dst_cycles_bw[EA_MAX] = {0, 0, 4, 4, 4, 8, 10, 8, 12, 0, 0, 0};
+static const uint8_t move_dst_cycles_l[EA_MAX]  = {0, 0, 8, 8, 8, 12, 14, 12, 16, 0, 0, 0};
+
+/**
+ * MOVE <ea>,<ea>
+ */
+template<int Size, int Src, int Dst>
+static void op_move(uint32_t op)
+{
+	const uint32_t data = ea_read<Src, Size>(op & 7);
+	flags_logic<Size>(data);
+	ea_write<Dst, Size>((op >> 9) & 7, data);
+	USE_CYCLES(4 + ea_cycles<Src, Size>() +
+		(Size == 4 ? move_dst_cycles_l[Dst] : move_dst_cycles_bw[Dst]));
+}
+
+/**
+ * MOVEA <ea>,An
+ */
+template<int Size, int Mode>
+static void op_movea(uint32_t op)
+{
+	REG_A((op >> 9) & 7) = size_sext<Size>(ea_read<Mode, Size>(op & 7));
+	USE_CYCLES(4 + ea_cycles<Mode, Size>());
+}
+
+/**
+ * MOVEQ #imm,Dn
+ */
+static void op_moveq(uint32_t op)
+{
+	const uint32_t data = SEXT8(op);
+	REG_D((op >> 9) & 7) = data;
+	flags_logic<4>(data);
+	USE_CYCLES(4);
+}
+
+/**
+ * MOVEP d16(Ay),Dx / Dx,d16(Ay)
+ */
+template<bool ToMem, int Size>
+static void op_movep(uint32_t op)
+{
+	uint32_t address = REG_A(op & 7) + SEXT16(mdM68K_fetch16());
+	uint32_t &dx = REG_D((op >> 9) & 7);
+
+	if (ToMem) {
+		for (int shift = (Size * 8) - 8; shift >= 0; shift -= 8, address += 2)
+			mdM68K_write8(address, dx >> shift);
+	} else {
+		uint32_t data = 0;
+		for (int i = 0; i < Size; i++, address += 2)
+			data = (data << 8) | mdM68K_read8(address);
+		set_dn<Size>(dx, data);
+	}
+
+	USE_CYCLES(Size == 4 ? 24 : 16);
+}
+
+// MOVEM base cycles. [mode]
+static const uint8_t movem_r2m_cycles[EA_MAX] = {0, 0, 8, 0, 8, 12, 14, 12, 16, 0, 0, 0};
+static const uint8_t movem_m2r_cycles[EA_MAX] = {0, 0, 12, 12, 0, 16, 18, 16, 20, 16, 18, 0};
+
+/**
+ * MOVEM <list>,<ea>
+ */
+template<int Size, int Mode>
+static void op_movem_r2m(uint32_t op)
+{
+	const uint32_t list = mdM68K_fetch16();
+	int count = 0;
+
+	if (Mode == EA_ADEC) {
+		// Predecrement: The list is reversed. (bit 0 == A7)
+		// If An is in the list, its initial value is written.
+		uint32_t address = REG_A(op & 7);
+		for (int i = 0; i < 16; i++) {
+			if (list & (1U << i)) {
+				address -= Size;
+				mem_write<Size, true>(address, mdM68K.dar[15 - i]);
+				count++;
+			}
+		}
+		REG_A(op & 7) = address;
+	} else {
+		uint32_t address = ea_address<Mode, Size>(op & 7);
+		for (int i = 0; i < 16; i++) {
+			if (list & (1U << i)) {
+				mem_write<Size, false>(address, mdM68K.dar[i]);
+				address += Size;
+				count++;
+			}
+		}
+	}
+
+	USE_CYCLES(movem_r2m_cycles[Mode] + (count * (Size == 4 ? 8 : 4)));
+}
+
+/**
+ * MOVEM <ea>,<list>
+ */
+template<int Size, int Mode>
+static void op_movem_m2r(uint32_t op)
+{
+	const uint32_t list = mdM68K_fetch16();
+	uint32_t address = (Mode == EA_AINC ? REG_A(op & 7) : ea_address<Mode, Size>(op & 7));
+	int count = 0;
+
+	for (int i = 0; i < 16; i++) {
+		if (list & (1U << i)) {
+			// Words are sign-extended to 32 bits.
+			mdM68K.dar[i] = size_sext<Size>(mem_read<Size, false>(address));
+			address += Size;
+			count++;
+		}
+	}
+	if (Mode == EA_AINC)
+		REG_A(op & 7) = address;
+
+	USE_CYCLES(movem_m2r_cycles[Mode] + (count * (Size == 4 ? 8 : 4)));
+}
+
+/**
+ * LEA <ea>,An
+ */
+static const uint8_t lea_cycles[EA_MAX] = {0, 0, 4, 0, 0, 8, 12, 8, 12, 8, 12, 0};
+template<int Mode>
+static void op_lea(uint32_t op)
+{
+	REG_A((op >> 9) & 7) = ea_address<Mode, 4>(op & 7);
+	USE_CYCLES(lea_cycles[Mode]);
+}
+
+/**
+ * PEA <ea>
+ */
+static const uint8_t pea_cycles[EA_MAX] = {0, 0, 12, 0, 0, 16, 20, 16, 20, 16, 20, 0};
+template<int Mode>
+static void op_pea(uint32_t op)
+{
+	mdM68K_push32(ea_address<Mode, 4>(op & 7));
+	USE_CYCLES(pea_cycles[Mode]);
+}
+
+/**
+ * EXG Rx,Ry
+ */
+template<int Type>
+static void op_exg(uint32_t op)
+{
+	// Type: 0 == Dx,Dy; 1 == Ax,Ay; 2 == Dx,Ay
+	uint32_t &rx = mdM68K.dar[((op >> 9) & 7) + (Type == 1 ? 8 : 0)];
+	uint32_t &ry = mdM68K.dar[(op & 7) + (Type != 0 ? 8 : 0)];
+	const uint32_t tmp = rx;
+	rx = ry;
+	ry = tmp;
+	USE_CYCLES(6);
+}
+
+static void op_swap(uint32_t op)
+{
+	uint32_t &dn = REG_D(op & 7);
+	dn = (dn >> 16) | (dn << 16);
+	flags_logic<4>(dn);
+	USE_CYCLES(4);
+}
+
+static void op_ext_w(uint32_t op)
+{
+	uint32_t &dn = REG_D(op & 7);
+	set_dn<2>(dn, SEXT8(dn));
+	flags_logic<2>(dn);
+	USE_CYCLES(4);
+}
+
+static void op_ext_l(uint32_t op)
+{
+	uint32_t &dn = REG_D(op & 7);
+	dn = SEXT16(dn);
+	flags_logic<4>(dn);
+	USE_CYCLES(4);
+}
+
+/** Status register. **/
+
+/**
+ * MOVE SR,<ea>
+ */
+template<int Mode>
+static void op_move_from_sr(uint32_t op)
+{
+	ea_write<Mode, 2>(op & 7, mdM68K_get_sr());
+	USE_CYCLES(Mode == EA_DREG ? 6 : (8 + ea_cycles<Mode, 2>()));
+}
+
+/**
+ * MOVE <ea>,CCR
+ */
+template<int Mode>
+static void op_move_to_ccr(uint32_t op)
+{
+	mdM68K_set_ccr(ea_read<Mode, 2>(op & 7));
+	USE_CYCLES(12 + ea_cycles<Mode, 2>());
+}
+
+/**
+ * MOVE <ea>,SR
+ */
+template<int Mode>
+static void op_move_to_sr(uint32_t op)
+{
+	if (!privileged())
+		return;
+	mdM68K_set_sr(ea_read<Mode, 2>(op & 7));
+	USE_CYCLES(12 + ea_cycles<Mode, 2>());
+	mdM68K_checkpoint();
+}
+
+/**
+ * ORI, ANDI, EORI #imm,CCR
+ */
+template<int Op>
+static void op_alu_ccr(uint32_t op)
+{
+	((void)op);
+	const uint32_t src = mdM68K_fetch16() & 0xFF;
+	const uint32_t ccr = mdM68K_get_ccr();
+	switch (Op) {
+		case ALU_OR:	mdM68K_set_ccr(ccr | src); break;
+		case ALU_AND:	mdM68K_set_ccr(ccr & src); break;
+		case ALU_EOR:	mdM68K_set_ccr(ccr ^ src); break;
+		default:	break;
+	}
+	USE_CYCLES(20);
+}
+
+/**
+ * ORI, ANDI, EORI #imm,SR
+ */
+template<int Op>
+static void op_alu_sr(uint32_t op)
+{
+	((void)op);
+	if (!privileged())
+		return;
+	const uint32_t src = mdM68K_fetch16();
+	const uint32_t sr = mdM68K_get_sr();
+	switch (Op) {
+		case ALU_OR:	mdM68K_set_sr(sr | src); break;
+		case ALU_AND:	mdM68K_set_sr(sr & src); break;
+		case ALU_EOR:	mdM68K_set_sr(sr ^ src); break;
+		default:	break;
+	}
+	USE_CYCLES(20);
+	mdM68K_checkpoint();
+}
+
+/**
+ * MOVE An,USP / MOVE USP,An
+ */
+template<bool ToUsp>
+static void op_move_usp(uint32_t op)
+{
+	if (!privileged())
+		return;
+	// In supervisor mode, asp is the USP.
+	if (ToUsp)
+		mdM68K.asp = REG_A(op & 7);
+	else
+		REG_A(op & 7) = mdM68K.asp;
+	USE_CYCLES(4);
+}
+
+/** Program control. **/
+
+/**
+ * Bcc, BRA, BSR
+ */
+template<int CC>
+static void op_bcc(uint32_t op)
+{
+	uint32_t disp = (op & 0xFF);
+	const uint32_t base = REG_PC;
+	if (disp == 0) {
+		// 16-bit displacement.
+		disp = SEXT16(mdM68K_fetch16());
+	} else {
+		disp = SEXT8(disp);
+	}
+
+	if (CC == 1) {
+		// BSR
+		mdM68K_push32(REG_PC);
+		REG_PC = base + disp;
+		USE_CYCLES(18);
+	} else if (cond<CC>()) {
+		REG_PC = base + disp;
+		USE_CYCLES(10);
+
+		// Short backward branches may be idle loops.
+		if ((int32_t)disp < 0 && (int32_t)disp >= -MDM68K_IDLE_MAX_LENGTH)
+			mdM68K_idle_branch();
+	} else {
+		USE_CYCLES((op & 0xFF) ? 8 : 12);
+	}
+}
+
+/**
+ * DBcc Dn,label
+ */
+template<int CC>
+static void op_dbcc(uint32_t op)
+{
+	if (cond<CC>()) {
+		REG_PC += 2;
+		USE_CYCLES(12);
+		return;
+	}
+
+	uint32_t &dn = REG_D(op & 7);
+	const uint32_t count = (dn - 1) & 0xFFFF;
+	set_dn<2>(dn, count);
+	if (count != 0xFFFF) {
+		const uint32_t base = REG_PC;
+		REG_PC = base + SEXT16(mdM68K_fetch16());
+		USE_CYCLES(10);
+	} else {
+		REG_PC += 2;
+		USE_CYCLES(14);
+	}
+}
+
+/**
+ * Scc <ea>
+ */
+template<int CC, int Mode>
+static void op_scc(uint32_t op)
+{
+	const bool c = cond<CC>();
+	ea_write<Mode, 1>(op & 7, (c ? 0xFF : 0x00));
+	if (Mode == EA_DREG)
+		USE_CYCLES(c ? 6 : 4);
+	else
+		USE_CYCLES(8 + ea_cycles<Mode, 1>());
+}
+
+/**
+ * JMP <ea>
+ */
+static const uint8_t jmp_cycles[EA_MAX] = {0, 0, 8, 0, 0, 10, 14, 10, 12, 10, 14, 0};
+template<int Mode>
+static void op_jmp(uint32_t op)
+{
+	REG_PC = ea_address<Mode, 4>(op & 7);
+	USE_CYCLES(jmp_cycles[Mode]);
+}
+
+/**
+ * JSR <ea>
+ */
+static const uint8_t jsr_cycles[EA_MAX] = {0, 0, 16, 0, 0, 18, 22, 18, 20, 18, 22, 0};
+template<int Mode>
+static void op_jsr(uint32_t op)
+{
+	const uint32_t address = ea_address<Mode, 4>(op & 7);
+	mdM68K_push32(REG_PC);
+	REG_PC = address;
+	USE_CYCLES(jsr_cycles[Mode]);
+}
+
+static void op_rts(uint32_t op)
+{
+	((void)op);
+	REG_PC = mdM68K_pop32();
+	USE_CYCLES(16);
+}
+
+static void op_rtr(uint32_t op)
+{
+	((void)op);
+	mdM68K_set_ccr(mdM68K_pop16());
+	REG_PC = mdM68K_pop32();
+	USE_CYCLES(20);
+}
+
+static void op_rte(uint32_t op)
+{
+	((void)op);
+	if (!privileged())
+		return;
+
+	// Read the frame before switching stacks.
+	const uint32_t sp = REG_SP;
+	const uint32_t sr = mdM68K_read16(sp);
+	const uint32_t pc = mdM68K_read32(sp + 2);
+	REG_SP = sp + 6;
+	mdM68K_set_sr(sr);
+	REG_PC = pc;
+	USE_CYCLES(20);
+	mdM68K_checkpoint();
+}
+
+static void op_link(uint32_t op)
+{
+	const uint32_t reg = (op & 7);
+	const uint32_t disp = SEXT16(mdM68K_fetch16());
+	if (reg == 7) {
+		// LINK A7 pushes the decremented value.
+		REG_SP -= 4;
+		mdM68K_write32(REG_SP, REG_SP);
+	} else {
+		mdM68K_push32(REG_A(reg));
+		REG_A(reg) = REG_SP;
+	}
+	REG_SP += disp;
+	USE_CYCLES(16);
+}
+
+static void op_unlk(uint32_t op)
+{
+	const uint32_t reg = (op & 7);
+	if (reg == 7) {
+		REG_SP = mdM68K_read32(REG_SP);
+	} else {
+		REG_SP = REG_A(reg);
+		REG_A(reg) = mdM68K_pop32();
+	}
+	USE_CYCLES(12);
+}
+
+static void op_nop(uint32_t op)
+{
+	((void)op);
+	USE_CYCLES(4);
+}
+
+static void op_reset(uint32_t op)
+{
+	((void)op);
+	if (!privileged())
+		return;
+	if (main68k_context.resethandler)
+		main68k_context.resethandler();
+	USE_CYCLES(132);
+}
+
+static void op_stop(uint32_t op)
+{
+	((void)op);
+	if (!privileged())
+		return;
+	mdM68K_set_sr(mdM68K_fetch16());
+	main68k_context.interrupts[0] |= MDM68K_INT_STOPPED;
+
+	// Forfeit all remaining cycles.
+	USE_CYCLES(4);
+	if (mdM68K.cycles >= 0)
+		mdM68K.cycles = -1;
+}
+
+static void op_trap(uint32_t op)
+{
+	mdM68K_exception(0x80 + ((op & 0xF) * 4), REG_PC);
+	USE_CYCLES(34);
+}
+
+static void op_trapv(uint32_t op)
+{
+	((void)op);
+	if (mdM68K.flag_v) {
+		mdM68K_exception(0x1C, REG_PC);
+		USE_CYCLES(34 + 4);
+	} else {
+		USE_CYCLES(4);
+	}
+}
+
+/**
+ * CHK <ea>,Dn
+ */
+template<int Mode>
+static void op_chk(uint32_t op)
+{
+	const int32_t bound = (int16_t)ea_read<Mode, 2>(op & 7);
+	const int32_t dn = (int16_t)REG_D((op >> 9) & 7);
+
+	// Z, V, and C are undefined.
+	mdM68K.flag_notz = (dn & 0xFFFF);
+	mdM68K.flag_v = 0;
+	mdM68K.flag_c = 0;
+
+	if (dn < 0 || dn > bound) {
+		mdM68K.flag_n = (dn < 0);
+		mdM68K_exception(0x18, REG_PC);
+		USE_CYCLES(40 + ea_cycles<Mode, 2>());
+		return;
+	}
+	USE_CYCLES(10 + ea_cycles<Mode, 2>());
+}
+
+/** Bit manipulation. **/
+enum BitOp {
+	BIT_TST,
+	BIT_CHG,
+	BIT_CLR,
+	BIT_SET,
+};
+
+template<int Op>
+static inline uint32_t do_bit(uint32_t data, uint32_t mask)
+{
+	mdM68K.flag_notz = (data & mask);
+	switch (Op) {
+		case BIT_CHG:	return (data ^ mask);
+		case BIT_CLR:	return (data & ~mask);
+		case BIT_SET:	return (data | mask);
+		default:	return data;
+	}
+}
+
+/**
+ * BTST, BCHG, BCLR, BSET Dn,<ea> / #imm,<ea>
+ */
+template<int Op, bool Imm, int Mode>
+static void op_bit(uint32_t op)
+{
+	const uint32_t bit = (Imm ? mdM68K_fetch16() : REG_D((op >> 9) & 7));
+
+	if (Mode == EA_DREG) {
+		// Data register: 32-bit.
+		uint32_t &dn = REG_D(op & 7);
+		const uint32_t res = do_bit<Op>(dn, (1U << (bit & 31)));
+		if (Op != BIT_TST)
+			dn = res;
+
+		if (Op == BIT_TST)
+			USE_CYCLES(Imm ? 10 : 6);
+		else if (Op == BIT_CLR)
+			USE_CYCLES(Imm ? 14 : 10);
+		else
+			USE_CYCLES(Imm ? 12 : 8);
+		return;
+	}
+
+	// Memory: 8-bit.
+	const uint32_t mask = (1U << (bit & 7));
+	if (Op == BIT_TST) {
+		do_bit<Op>(ea_read<Mode, 1>(op & 7), mask);
+		USE_CYCLES((Imm ? 8 : 4) + ea_cycles<Mode, 1>());
+	} else {
+		const uint32_t address = ea_address<Mode, 1>(op & 7);
+		mdM68K_write8(address, do_bit<Op>(mdM68K_read8(address), mask));
+		USE_CYCLES((Imm ? 12 : 8) + ea_cycles<Mode, 1>());
+	}
+}
+
+/** Shifts and rotates. **/
+enum ShiftOp {
+	SHIFT_AS,
+	SHIFT_LS,
+	SHIFT_ROX,
+	SHIFT_RO,
+};
+
+/**
+ * Shift or rotate a value.
+ * @param data Value.
+ * @param count Shift count. (0-63)
+ * @return Result.
+ */
+template<int Op, bool Left, int Size>
+static inline uint32_t do_shift(uint32_t data, uint32_t count)
+{
+	const uint32_t mask = size_mask<Size>();
+	const uint32_t msb = size_msb<Size>();
+	const uint32_t bits = Size * 8;
+	data &= mask;
+
+	if (count == 0) {
+		// C is cleared, except for ROXL/ROXR, where it's set to X.
+		mdM68K.flag_c = (Op == SHIFT_ROX ? mdM68K.flag_x : 0);
+		mdM68K.flag_v = 0;
+		mdM68K.flag_n = !!(data & msb);
+		mdM68K.flag_notz = data;
+		return data;
+	}
+
+	uint32_t res = 0;
+	mdM68K.flag_v = 0;
+	switch (Op) {
+		case SHIFT_AS:
+			if (Left) {
+				if (count < bits) {
+					res = (data << count) & mask;
+					mdM68K.flag_c = (data >> (bits - count)) & 1;
+					// V is set if the MSB changed at any time.
+					const uint32_t vmask = (mask << (bits - count - 1)) & mask;
+					mdM68K.flag_v = ((data & vmask) != 0 && (data & vmask) != vmask);
+				} else {
+					mdM68K.flag_c = (count == bits ? (data & 1) : 0);
+					mdM68K.flag_v = (data != 0);
+				}
+			} else {
+				const uint32_t sign = (data & msb) ? mask : 0;
+				if (count < bits) {
+					res = ((data >> count) | (sign << (bits - count))) & mask;
+					mdM68K.flag_c = (data >> (count - 1)) & 1;
+				} else {
+					res = sign;
+					mdM68K.flag_c = (sign & 1);
+				}
+			}
+			mdM68K.flag_x = mdM68K.flag_c;
+			break;
+
+		case SHIFT_LS:
+			if (count < bits) {
+				if (Left) {
+					res = (data << count) & mask;
+					mdM68K.flag_c = (data >> (bits - count)) & 1;
+				} else {
+					res = (data >> count);
+					mdM68K.flag_c = (data >> (count - 1)) & 1;
+				}
+			} else if (count == bits) {
+				mdM68K.flag_c = (Left ? (data & 1) : (data >> (bits - 1)));
+			} else {
+				mdM68K.flag_c = 0;
+			}
+			mdM68K.flag_x = mdM68K.flag_c;
+			break;
+
+		case SHIFT_RO: {
+			const uint32_t n = (count & (bits - 1));
+			if (n == 0) {
+				res = data;
+			} else if (Left) {
+				res = ((data << n) | (data >> (bits - n))) & mask;
+			} else {
+				res = ((data >> n) | (data << (bits - n))) & mask;
+			}
+			mdM68K.flag_c = (Left ? (res & 1) : ((res >> (bits - 1)) & 1));
+			break;
+		}
+
+		case SHIFT_ROX: {
+			uint32_t n = (count % (bits + 1));
+			uint32_t x = mdM68K.flag_x;
+			res = data;
+			for (; n != 0; n--) {
+				uint32_t new_x;
+				if (Left) {
+					new_x = (res >> (bits - 1)) & 1;
+					res = ((res << 1) | x) & mask;
+				} else {
+					new_x = (res & 1);
+					res = (res >> 1) | (x << (bits - 1));
+				}
+				x = new_x;
+			}
+			mdM68K.flag_c = mdM68K.flag_x = x;
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	mdM68K.flag_n = !!(res & msb);
+	mdM68K.flag_notz = res;
+	return res;
+}
+
+/**
+ * ASd, LSd, ROXd, ROd #imm,Dy / Dx,Dy
+ */
+template<int Op, bool Left, int Size, bool Reg>
+static void op_shift_reg(uint32_t op)
+{
+	uint32_t count = (op >> 9) & 7;
+	if (Reg)
+		count = REG_D(count) & 63;
+	else if (count == 0)
+		count = 8;
+
+	uint32_t &dy = REG_D(op & 7);
+	set_dn<Size>(dy, do_shift<Op, Left, Size>(dy, count));
+	USE_CYCLES((Size == 4 ? 8 : 6) + (count * 2));
+}
+
+/**
+ * ASd, LSd, ROXd, ROd <ea>
+ */
+template<int Op, bool Left, int Mode>
+static void op_shift_mem(uint32_t op)
+{
+	const uint32_t address = ea_address<Mode, 2>(op & 7);
+	mdM68K_write16(address, do_shift<Op, Left, 2>(mdM68K_read16(address), 1));
+	USE_CYCLES(8 + ea_cycles<Mode, 2>());
+}
+
+/** Opcode decoding. **/
+
+/**
+ * Decode an EA mode.
+ * @param op Opcode. (mode in bits 5-3, register in bits 2-0)
+ * @param allowed Allowed EA modes.
+ * @return EaMode, or -1 if not allowed.
+ */
+static int ea_decode(uint32_t op, unsigned int allowed)
+{
+	int mode = (op >> 3) & 7;
+	if (mode == 7) {
+		mode += (op & 7);
+		if (mode >= EA_MAX)
+			return -1;
+	}
+	return ((allowed & EAM(mode)) ? mode : -1);
+}
+
+/**
+ * Select a template instantiation for an EA mode.
+ * The mode is the last template parameter.
+ */
+#define EA_CASE(mode, fn, ...) \
+	case mode: return fn<__VA_ARGS__, mode>;
+#define EA_SWITCH(mode, fn, ...) \
+	switch (mode) { \
+		EA_CASE(EA_DREG, fn, __VA_ARGS__) \
+		EA_CASE(EA_AREG, fn, __VA_ARGS__) \
+		EA_CASE(EA_AIND, fn, __VA_ARGS__) \
+		EA_CASE(EA_AINC, fn, __VA_ARGS__) \
+		EA_CASE(EA_ADEC, fn, __VA_ARGS__) \
+		EA_CASE(EA_AD16, fn, __VA_ARGS__) \
+		EA_CASE(EA_AD8X, fn, __VA_ARGS__) \
+		EA_CASE(EA_ABSW, fn, __VA_ARGS__) \
+		EA_CASE(EA_ABSL, fn, __VA_ARGS__) \
+		EA_CASE(EA_PC16, fn, __VA_ARGS__) \
+		EA_CASE(EA_PC8X, fn, __VA_ARGS__) \
+		EA_CASE(EA_IMM,  fn, __VA_ARGS__) \
+		default: return op_illegal; \
+	}
+
+// Same as EA_SWITCH, but for templates with only an EA mode parameter.
+#define EA_SWITCH1(mode, fn) \
+	switch (mode) { \
+		case EA_DREG: return fn<EA_DREG>; \
+		case EA_AREG: return fn<EA_AREG>; \
+		case EA_AIND: return fn<EA_AIND>; \
+		case EA_AINC: return fn<EA_AINC>; \
+		case EA_ADEC: return fn<EA_ADEC>; \
+		case EA_AD16: return fn<EA_AD16>; \
+		case EA_AD8X: return fn<EA_AD8X>; \
+		case EA_ABSW: return fn<EA_ABSW>; \
+		case EA_ABSL: return fn<EA_ABSL>; \
+		case EA_PC16: return fn<EA_PC16>; \
+		case EA_PC8X: return fn<EA_PC8X>; \
+		case EA_IMM:  return fn<EA_IMM>; \
+		default: return op_illegal; \
+	}
+
+// Select by operand size code (0 == byte, 1 == word, 2 == long), then EA mode.
+#define SIZE_EA_SWITCH(size, mode, fn, ...) \
+	switch (size) { \
+		case 0: EA_SWITCH(mode, fn, __VA_ARGS__, 1) \
+		case 1: EA_SWITCH(mode, fn, __VA_ARGS__, 2) \
+		case 2: EA_SWITCH(mode, fn, __VA_ARGS__, 4) \
+		default: return op_illegal; \
+	}
+
+#define CC_SWITCH(cc, fn) \
+	switch (cc) { \
+		case 0x0: return fn<0x0>; case 0x1: return fn<0x1>; \
+		case 0x2: return fn<0x2>; case 0x3: return fn<0x3>; \
+		case 0x4: return fn<0x4>; case 0x5: return fn<0x5>; \
+		case 0x6: return fn<0x6>; case 0x7: return fn<0x7>; \
+		case 0x8: return fn<0x8>; case 0x9: return fn<0x9>; \
+		case 0xA: return fn<0xA>; case 0xB: return fn<0xB>; \
+		case 0xC: return fn<0xC>; case 0xD: return fn<0xD>; \
+		case 0xE: return fn<0xE>; case 0xF: return fn<0xF>; \
+		default: return op_illegal; \
+	}
+
+#define CC_EA_SWITCH(cc, mode, fn) \
+	switch (cc) { \
+		case 0x0: EA_SWITCH(mode, fn, 0x0) case 0x1: EA_SWITCH(mode, fn, 0x1) \
+		case 0x2: EA_SWITCH(mode, fn, 0x2) case 0x3: EA_SWITCH(mode, fn, 0x3) \
+		case 0x4: EA_SWITCH(mode, fn, 0x4) case 0x5: EA_SWITCH(mode, fn, 0x5) \
+		case 0x6: EA_SWITCH(mode, fn, 0x6) case 0x7: EA_SWITCH(mode, fn, 0x7) \
+		case 0x8: EA_SWITCH(mode, fn, 0x8) case 0x9: EA_SWITCH(mode, fn, 0x9) \
+		case 0xA: EA_SWITCH(mode, fn, 0xA) case 0xB: EA_SWITCH(mode, fn, 0xB) \
+		case 0xC: EA_SWITCH(mode, fn, 0xC) case 0xD: EA_SWITCH(mode, fn, 0xD) \
+		case 0xE: EA_SWITCH(mode, fn, 0xE) case 0xF: EA_SWITCH(mode, fn, 0xF) \
+		default: return op_illegal; \
+	}
+
+/**
+ * Decode a MOVE opcode.
+ * Separated from decode_0_3() to keep the instantiations readable.
+ */
+template<int Size, int Src>
+static mdM68K_op_t decode_move_dst(int dst)
+{
+	switch (dst) {
+		case EA_DREG: return op_move<Size, Src, EA_DREG>;
+		case EA_AREG: return op_movea<Size, Src>;
+		case EA_AIND: return op_move<Size, Src, EA_AIND>;
+		case EA_AINC: return op_move<Size, Src, EA_AINC>;
+		case EA_ADEC: return op_move<Size, Src, EA_ADEC>;
+		case EA_AD16: return op_move<Size, Src, EA_AD16>;
+		case EA_AD8X: return op_move<Size, Src, EA_AD8X>;
+		case EA_ABSW: return op_move<Size, Src, EA_ABSW>;
+		case EA_ABSL: return op_move<Size, Src, EA_ABSL>;
+		default: return op_illegal;
+	}
+}
+
+template<int Size>
+static mdM68K_op_t decode_move(uint32_t op)
+{
+	const int src = ea_decode(op, (Size == 1 ? EAM_DATA : EAM_ALL));
+	// Destination: mode in bits 8-6, register in bits 11-9.
+	const int dst = ea_decode(((op >> 3) & 0x38) | ((op >> 9) & 7),
+			(Size == 1 ? EAM_DATA_ALT : EAM_ALTERABLE));
+	if (src < 0 || dst < 0)
+		return op_illegal;
+
+	switch (src) {
+		case EA_DREG: return decode_move_dst<Size, EA_DREG>(dst);
+		case EA_AREG: return decode_move_dst<Size, EA_AREG>(dst);
+		case EA_AIND: return decode_move_dst<Size, EA_AIND>(dst);
+		case EA_AINC: return decode_move_dst<Size, EA_AINC>(dst);
+		case EA_ADEC: return decode_move_dst<Size, EA_ADEC>(dst);
+		case EA_AD16: return decode_move_dst<Size, EA_AD16>(dst);
+		case EA_AD8X: return decode_move_dst<Size, EA_AD8X>(dst);
+		case EA_ABSW: return decode_move_dst<Size, EA_ABSW>(dst);
+		case EA_ABSL: return decode_move_dst<Size, EA_ABSL>(dst);
+		case EA_PC16: return decode_move_dst<Size, EA_PC16>(dst);
+		case EA_PC8X: return decode_move_dst<Size, EA_PC8X>(dst);
+		case EA_IMM:  return decode_move_dst<Size, EA_IMM>(dst);
+		default: return op_illegal;
+	}
+}
+
+/**
+ * Line 0: Immediate, bit manipulation, MOVEP.
+ */
+static mdM68K_op_t decode_line0(uint32_t op)
+{
+	const int size = (op >> 6) & 3;
+
+	if (op & 0x100) {
+		if ((op & 0x38) == 0x08) {
+			// MOVEP
+			switch (size) {
+				case 0: return op_movep<false, 2>;
+				case 1: return op_movep<false, 4>;
+				case 2: return op_movep<true, 2>;
+				default: return op_movep<true, 4>;
+			}
+		}
+
+		// Dynamic bit operation.
+		const int mode = ea_decode(op, (size == 0 ? EAM_DATA : EAM_DATA_ALT));
+		switch (size) {
+			case 0: EA_SWITCH(mode, op_bit, BIT_TST, false)
+			case 1: EA_SWITCH(mode, op_bit, BIT_CHG, false)
+			case 2: EA_SWITCH(mode, op_bit, BIT_CLR, false)
+			default: EA_SWITCH(mode, op_bit, BIT_SET, false)
+		}
+	}
+
+	const int type = (op >> 9) & 7;
+	if (type == 4) {
+		// Static bit operation.
+		const int mode = ea_decode(op, (size == 0 ? (EAM_DATA & ~EAM(EA_IMM)) : EAM_DATA_ALT));
+		switch (size) {
+			case 0: EA_SWITCH(mode, op_bit, BIT_TST, true)
+			case 1: EA_SWITCH(mode, op_bit, BIT_CHG, true)
+			case 2: EA_SWITCH(mode, op_bit, BIT_CLR, true)
+			default: EA_SWITCH(mode, op_bit, BIT_SET, true)
+		}
+	}
+
+	// CCR / SR operations.
+	switch (op) {
+		case 0x003C: return op_alu_ccr<ALU_OR>;
+		case 0x007C: return op_alu_sr<ALU_OR>;
+		case 0x023C: return op_alu_ccr<ALU_AND>;
+		case 0x027C: return op_alu_sr<ALU_AND>;
+		case 0x0A3C: return op_alu_ccr<ALU_EOR>;
+		case 0x0A7C: return op_alu_sr<ALU_EOR>;
+		default: break;
+	}
+
+	// Immediate operation.
+	const int mode = ea_decode(op, EAM_DATA_ALT);
+	switch (type) {
+		case 0: SIZE_EA_SWITCH(size, mode, op_alui, ALU_OR)
+		case 1: SIZE_EA_SWITCH(size, mode, op_alui, ALU_AND)
+		case 2: SIZE_EA_SWITCH(size, mode, op_alui, ALU_SUB)
+		case 3: SIZE_EA_SWITCH(size, mode, op_alui, ALU_ADD)
+		case 5: SIZE_EA_SWITCH(size, mode, op_alui, ALU_EOR)
+		case 6: SIZE_EA_SWITCH(size, mode, op_alui, ALU_CMP)
+		default: return op_illegal;
+	}
+}
+
+/**
+ * Line 4: Miscellaneous.
+ */
+static mdM68K_op_t decode_line4(uint32_t op)
+{
+	if (op & 0x100) {
+		if ((op & 0x1C0) == 0x1C0) {
+			// LEA
+			const int mode = ea_decode(op, EAM_CONTROL);
+			EA_SWITCH1(mode, op_lea)
+		} else if ((op & 0x1C0) == 0x180) {
+			// CHK.W
+			const int mode = ea_decode(op, EAM_DATA);
+			EA_SWITCH1(mode, op_chk)
+		}
+		return op_illegal;
+	}
+
+	const int size = (op >> 6) & 3;
+	switch ((op >> 8) & 0xF) {
+		case 0x0:
+			if (size == 3) {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				EA_SWITCH1(mode, op_move_from_sr)
+			} else {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				SIZE_EA_SWITCH(size, mode, op_unary, UN_NEGX)
+			}
+
+		case 0x2:
+			if (size == 3) {
+				// MOVE from CCR is 68010+.
+				return op_illegal;
+			} else {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				SIZE_EA_SWITCH(size, mode, op_unary, UN_CLR)
+			}
+
+		case 0x4:
+			if (size == 3) {
+				const int mode = ea_decode(op, EAM_DATA);
+				EA_SWITCH1(mode, op_move_to_ccr)
+			} else {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				SIZE_EA_SWITCH(size, mode, op_unary, UN_NEG)
+			}
+
+		case 0x6:
+			if (size == 3) {
+				const int mode = ea_decode(op, EAM_DATA);
+				EA_SWITCH1(mode, op_move_to_sr)
+			} else {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				SIZE_EA_SWITCH(size, mode, op_unary, UN_NOT)
+			}
+
+		case 0x8:
+			switch (size) {
+				case 0: {
+					const int mode = ea_decode(op, EAM_DATA_ALT);
+					EA_SWITCH1(mode, op_nbcd)
+				}
+				case 1:
+					if ((op & 0x38) == 0x00)
+						return op_swap;
+					else {
+						const int mode = ea_decode(op, EAM_CONTROL);
+						EA_SWITCH1(mode, op_pea)
+					}
+				case 2:
+					if ((op & 0x38) == 0x00)
+						return op_ext_w;
+					else {
+						const int mode = ea_decode(op, EAM_CONTROL | EAM(EA_ADEC));
+						EA_SWITCH(mode, op_movem_r2m, 2)
+					}
+				default:
+					if ((op & 0x38) == 0x00)
+						return op_ext_l;
+					else {
+						const int mode = ea_decode(op, EAM_CONTROL | EAM(EA_ADEC));
+						EA_SWITCH(mode, op_movem_r2m, 4)
+					}
+			}
+
+		case 0xA:
+			if (size == 3) {
+				// TAS. (0x4AFC is ILLEGAL.)
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				EA_SWITCH1(mode, op_tas)
+			} else {
+				const int mode = ea_decode(op, EAM_DATA_ALT);
+				switch (size) {
+					case 0: EA_SWITCH(mode, op_tst, 1)
+					case 1: EA_SWITCH(mode, op_tst, 2)
+					default: EA_SWITCH(mode, op_tst, 4)
+				}
+			}
+
+		case 0xC:
+			if (size == 2) {
+				const int mode = ea_decode(op, EAM_CONTROL | EAM(EA_AINC));
+				EA_SWITCH(mode, op_movem_m2r, 2)
+			} else if (size == 3) {
+				const int mode = ea_decode(op, EAM_CONTROL | EAM(EA_AINC));
+				EA_SWITCH(mode, op_movem_m2r, 4)
+			}
+			return op_illegal;
+
+		case 0xE:
+			if (size == 1) {
+				switch ((op >> 3) & 7) {
+					case 0: case 1: return op_trap;
+					case 2: return op_link;
+					case 3: return op_unlk;
+					case 4: return op_move_usp<true>;
+					case 5: return op_move_usp<false>;
+					default:
+						switch (op) {
+							case 0x4E70: return op_reset;
+							case 0x4E71: return op_nop;
+							case 0x4E72: return op_stop;
+							case 0x4E73: return op_rte;
+							case 0x4E75: return op_rts;
+							case 0x4E76: return op_trapv;
+							case 0x4E77: return op_rtr;
+							default: return op_illegal;
+						}
+				}
+			} else if (size == 2) {
+				const int mode = ea_decode(op, EAM_CONTROL);
+				EA_SWITCH1(mode, op_jsr)
+			} else if (size == 3) {
+				const int mode = ea_decode(op, EAM_CONTROL);
+				EA_SWITCH1(mode, op_jmp)
+			}
+			return op_illegal;
+
+		default:
+			return op_illegal;
+	}
+}
+
+/**
+ * Line 5: ADDQ, SUBQ, Scc, DBcc.
+ */
+static mdM68K_op_t decode_line5(uint32_t op)
+{
+	const int size = (op >> 6) & 3;
+	if (size == 3) {
+		const int cc = (op >> 8) & 0xF;
+		if ((op & 0x38) == 0x08) {
+			CC_SWITCH(cc, op_dbcc)
+		}
+		const int mode = ea_decode(op, EAM_DATA_ALT);
+		CC_EA_SWITCH(cc, mode, op_scc)
+	}
+
+	// ADDQ.B / SUBQ.B can't use An.
+	const int mode = ea_decode(op, (size == 0 ? EAM_DATA_ALT : EAM_ALTERABLE));
+	if (op & 0x100) {
+		SIZE_EA_SWITCH(size, mode, op_addq, ALU_SUB)
+	} else {
+		SIZE_EA_SWITCH(size, mode, op_addq, ALU_ADD)
+	}
+}
+
+/**
+ * Lines 8, 9, B, C, D: Arithmetic and logical operations.
+ */
+static mdM68K_op_t decode_alu(uint32_t op)
+{
+	const int line = (op >> 12);
+	const int size = (op >> 6) & 3;
+
+	if (size == 3) {
+		// Word-sized operations with a fixed size.
+		const bool hi = !!(op & 0x100);
+		switch (line) {
+			case 0x8: {
+				const int mode = ea_decode(op, EAM_DATA);
+				if (hi) {
+					EA_SWITCH(mode, op_div, true)
+				} else {
+					EA_SWITCH(mode, op_div, false)
+				}
+			}
+			case 0xC: {
+				const int mode = ea_decode(op, EAM_DATA);
+				if (hi) {
+					EA_SWITCH(mode, op_mul, true)
+				} else {
+					EA_SWITCH(mode, op_mul, false)
+				}
+			}
+			case 0x9: {
+				const int mode = ea_decode(op, EAM_ALL);
+				if (hi) {
+					EA_SWITCH(mode, op_adda, ALU_SUB, 4)
+				} else {
+					EA_SWITCH(mode, op_adda, ALU_SUB, 2)
+				}
+			}
+			case 0xD: {
+				const int mode = ea_decode(op, EAM_ALL);
+				if (hi) {
+					EA_SWITCH(mode, op_adda, ALU_ADD, 4)
+				} else {
+					EA_SWITCH(mode, op_adda, ALU_ADD, 2)
+				}
+			}
+			case 0xB: {
+				const int mode = ea_decode(op, EAM_ALL);
+				if (hi) {
+					EA_SWITCH(mode, op_cmpa, 4)
+				} else {
+					EA_SWITCH(mode, op_cmpa, 2)
+				}
+			}
+			default:
+				return op_illegal;
+		}
+	}
+
+	if (!(op & 0x100)) {
+		// <ea>,Dn
+		// Byte operations can't use An.
+		const unsigned int allowed = (size == 0 ? EAM_DATA : EAM_ALL);
+		switch (line) {
+			case 0x8: {
+				const int mode = ea_decode(op, EAM_DATA);
+				SIZE_EA_SWITCH(size, mode, op_alu_ea_dn, ALU_OR)
+			}
+			case 0x9: {
+				const int mode = ea_decode(op, allowed);
+				SIZE_EA_SWITCH(size, mode, op_alu_ea_dn, ALU_SUB)
+			}
+			case 0xB: {
+				const int mode = ea_decode(op, allowed);
+				SIZE_EA_SWITCH(size, mode, op_alu_ea_dn, ALU_CMP)
+			}
+			case 0xC: {
+				const int mode = ea_decode(op, EAM_DATA);
+				SIZE_EA_SWITCH(size, mode, op_alu_ea_dn, ALU_AND)
+			}
+			case 0xD: {
+				const int mode = ea_decode(op, allowed);
+				SIZE_EA_SWITCH(size, mode, op_alu_ea_dn, ALU_ADD)
+			}
+			default:
+				return op_illegal;
+		}
+	}
+
+	// Dn,<ea>, or register/memory forms.
+	const int rm = (op >> 3) & 7;
+	if (line == 0xB) {
+		if (rm == 1) {
+			// CMPM
+			switch (size) {
+				case 0: return op_cmpm<1>;
+				case 1: return op_cmpm<2>;
+				default: return op_cmpm<4>;
+			}
+		}
+		// EOR Dn,<ea>
+		const int mode = ea_decode(op, EAM_DATA_ALT);
+		SIZE_EA_SWITCH(size, mode, op_alu_dn_ea, ALU_EOR)
+	}
+
+	if (rm < 2) {
+		const bool mem = (rm == 1);
+		switch (line) {
+			case 0x8:
+				// SBCD
+				if (size != 0)
+					return op_illegal;
+				return (mem ? op_bcd<true, true> : op_bcd<true, false>);
+			case 0xC:
+				// ABCD, EXG
+				switch ((op >> 3) & 0x3F) {
+					case 0x20: return op_bcd<false, false>;
+					case 0x21: return op_bcd<false, true>;
+					case 0x28: return op_exg<0>;
+					case 0x29: return op_exg<1>;
+					case 0x31: return op_exg<2>;
+					default: return op_illegal;
+				}
+			case 0x9:
+				// SUBX
+				switch (size) {
+					case 0: return (mem ? op_addx<ALU_SUB, 1, true> : op_addx<ALU_SUB, 1, false>);
+					case 1: return (mem ? op_addx<ALU_SUB, 2, true> : op_addx<ALU_SUB, 2, false>);
+					default: return (mem ? op_addx<ALU_SUB, 4, true> : op_addx<ALU_SUB, 4, false>);
+				}
+			case 0xD:
+				// ADDX
+				switch (size) {
+					case 0: return (mem ? op_addx<ALU_ADD, 1, true> : op_addx<ALU_ADD, 1, false>);
+					case 1: return (mem ? op_addx<ALU_ADD, 2, true> : op_addx<ALU_ADD, 2, false>);
+					default: return (mem ? op_addx<ALU_ADD, 4, true> : op_addx<ALU_ADD, 4, false>);
+				}
+			default:
+				return op_illegal;
+		}
+	}
+
+	// Dn,<ea> (memory only)
+	const int mode = ea_decode(op, EAM_MEM_ALT);
+	switch (line) {
+		case 0x8: SIZE_EA_SWITCH(size, mode, op_alu_dn_ea, ALU_OR)
+		case 0x9: SIZE_EA_SWITCH(size, mode, op_alu_dn_ea, ALU_SUB)
+		case 0xC: SIZE_EA_SWITCH(size, mode, op_alu_dn_ea, ALU_AND)
+		case 0xD: SIZE_EA_SWITCH(size, mode, op_alu_dn_ea, ALU_ADD)
+		default: return op_illegal;
+	}
+}
+
+/**
+ * Line E: Shifts and rotates.
+ */
+#define SHIFT_REG_SWITCH(type, left, size, reg) \
+	switch (type) { \
+		case 0: return op_shift_reg<SHIFT_AS, left, size, reg>; \
+		case 1: return op_shift_reg<SHIFT_LS, left, size, reg>; \
+		case 2: return op_shift_reg<SHIFT_ROX, left, size, reg>; \
+		default: return op_shift_reg<SHIFT_RO, left, size, reg>; \
+	}
+
+#define SHIFT_REG_SIZE_SWITCH(type, left, size, reg) \
+	switch (size) { \
+		case 0: SHIFT_REG_SWITCH(type, left, 1, reg) \
+		case 1: SHIFT_REG_SWITCH(type, left, 2, reg) \
+		default: SHIFT_REG_SWITCH(type, left, 4, reg) \
+	}
+
+static mdM68K_op_t decode_lineE(uint32_t op)
+{
+	const bool left = !!(op & 0x100);
+	const int size = (op >> 6) & 3;
+
+	if (size == 3) {
+		// Memory shift. (word, 1 bit)
+		if (op & 0x800)
+			return op_illegal;
+		const int mode = ea_decode(op, EAM_MEM_ALT);
+		switch (((op >> 9) & 3) | (left ? 4 : 0)) {
+			case 0: EA_SWITCH(mode, op_shift_mem, SHIFT_AS, false)
+			case 1: EA_SWITCH(mode, op_shift_mem, SHIFT_LS, false)
+			case 2: EA_SWITCH(mode, op_shift_mem, SHIFT_ROX, false)
+			case 3: EA_SWITCH(mode, op_shift_mem, SHIFT_RO, false)
+			case 4: EA_SWITCH(mode, op_shift_mem, SHIFT_AS, true)
+			case 5: EA_SWITCH(mode, op_shift_mem, SHIFT_LS, true)
+			case 6: EA_SWITCH(mode, op_shift_mem, SHIFT_ROX, true)
+			default: EA_SWITCH(mode, op_shift_mem, SHIFT_RO, true)
+		}
+	}
+
+	const int type = (op >> 3) & 3;
+	const bool reg = !!(op & 0x20);
+	if (left) {
+		if (reg) {
+			SHIFT_REG_SIZE_SWITCH(type, true, size, true)
+		} else {
+			SHIFT_REG_SIZE_SWITCH(type, true, size, false)
+		}
+	} else {
+		if (reg) {
+			SHIFT_REG_SIZE_SWITCH(type, false, size, true)
+		} else {
+			SHIFT_REG_SIZE_SWITCH(type, false, size, false)
+		}
+	}
+}
+
+/**
+ * Decode an opcode.
+ * @param op Opcode.
+ * @return Opcode handler.
+ */
+static mdM68K_op_t decode(uint32_t op)
+{
+	switch (op >> 12) {
+		case 0x0:
+			return decode_line0(op);
+		case 0x1:
+			return decode_move<1>(op);
+		case 0x2:
+			return decode_move<4>(op);
+		case 0x3:
+			return decode_move<2>(op);
+		case 0x4:
+			return decode_line4(op);
+		case 0x5:
+			return decode_line5(op);
+		case 0x6:
+			CC_SWITCH((op >> 8) & 0xF, op_bcc)
+		case 0x7:
+			if (op & 0x100)
+				return op_illegal;
+			return op_moveq;
+		case 0xA:
+			return op_linea;
+		case 0xE:
+			return decode_lineE(op);
+		case 0xF:
+			return op_linef;
+		default:
+			return decode_alu(op);
+	}
+}
+
+/**
+ * Initialize the opcode table.
+ */
+void mdM68K_init_optable(void)
+{
+	for (uint32_t op = 0; op < 0x10000; op++) {
+		mdM68K_optable[op] = decode(op);
+	}
+}
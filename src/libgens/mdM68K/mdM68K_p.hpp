@@ -0,0 +1,356 @@
+/***************************************************************************
+ * mdM68K: Gens Portable 68000 Emulator.                                   *
+ * mdM68K_p.hpp: Private state and inline helpers.                         *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __MDM68K_P_HPP__
+#define __MDM68K_P_HPP__
+
+/**
+ * mdM68K is a portable replacement for Starscream's main68k core.
+ * It implements the same API (see cpu/star_68k.h) with the same
+ * odometer and interrupt semantics, so the M68K wrapper class
+ * doesn't need to know which core is in use.
+ *
+ * Differences from Starscream:
+ * - Registers and condition codes are kept in mdM68K_state.
+ *   main68k_context is only live for interrupts[] and the
+ *   memory maps; GetContext() / SetContext() convert.
+ * - The fetch region is checked on every opcode fetch instead of
+ *   only on jumps, so the PC is never a host pointer.
+ */
+
+#include "mdM68K.h"
+#include "libgens/cpu/star_68k.h"
+#include "libgens/cpu/M68K_Mem.hpp"
+#include "libcompat/byteswap.h"
+
+// C includes.
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory handlers. (cpu/M68K_Mem.cpp)
+uint8_t Gens_M68K_RB(uint32_t address);
+uint16_t Gens_M68K_RW(uint32_t address);
+void Gens_M68K_WB(uint32_t address, uint8_t data);
+void Gens_M68K_WW(uint32_t address, uint16_t data);
+
+// Interrupt acknowledge. (Vdp/VdpIo.cpp)
+uint8_t VDP_Int_Ack(void);
+
+// Check if a VDP status read only toggles the FIFO flags. (Vdp/VdpIo.cpp)
+uint8_t VDP_Status_Stable(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** SR bits. **/
+#define MDM68K_SR_T	0x8000
+#define MDM68K_SR_S	0x2000
+#define MDM68K_SR_I	0x0700
+
+/** execinfo bits. (Same as Starscream.) **/
+#define MDM68K_EXECINFO_RUNNING	0x01
+#define MDM68K_EXECINFO_BOUNDS	0x02
+
+/** interrupts[0] bits. **/
+#define MDM68K_INT_LEVEL	0x07
+#define MDM68K_INT_STOPPED	0x10
+
+typedef struct _mdM68K_state_t {
+	uint32_t dar[16];	// D0-D7, A0-A7. (A7 is the active stack pointer.)
+	uint32_t asp;		// Inactive stack pointer.
+	uint32_t pc;		// Program counter.
+	uint32_t sr;		// SR system byte. (T, S, I2-I0; CCR is always 0 here.)
+
+	// Condition codes.
+	// Each flag is 0 or 1, except flag_notz,
+	// which is 0 if Z is set.
+	uint32_t flag_x;
+	uint32_t flag_n;
+	uint32_t flag_notz;
+	uint32_t flag_v;
+	uint32_t flag_c;
+
+	// Cycle counters. (Same meaning as Starscream.)
+	// cycles is the number of remaining cycles, minus 1.
+	// It's -1 when the CPU isn't executing.
+	int cycles;
+	unsigned int cycles_needed;
+	unsigned int cycles_leftover;
+	unsigned int odometer;
+
+	// Cached fetch region.
+	uintptr_t fetch_base;
+	uint32_t fetch_lo;
+	uint32_t fetch_span;
+
+	uint8_t execinfo;
+
+	// Idle loop detection.
+	// idle_pc is the loop being observed, or ~0 if none.
+	// idle_regs is a copy of dar[] through flag_c at the loop head.
+	uint32_t idle_pc;
+	int idle_cycles;	// Cycle counter at the loop head.
+	unsigned int idle_iter;	// Iterations observed.
+	uint32_t idle_regs[16 + 8];
+	uint8_t idle_enable;
+
+	// Idle loop counters.
+	unsigned int idle_hits;
+	uint64_t idle_skipped;
+} mdM68K_state_t;
+
+extern EMU_THREAD_LOCAL mdM68K_state_t mdM68K;
+
+/**
+ * Opcode handler.
+ * @param op Opcode.
+ */
+typedef void (*mdM68K_op_t)(uint32_t op);
+
+// Opcode table. (mdM68K_ops.cpp)
+extern mdM68K_op_t mdM68K_optable[0x10000];
+void mdM68K_init_optable(void);
+
+// Core functions. (mdM68K.cpp)
+bool mdM68K_rebase(uint32_t address);
+uint32_t mdM68K_fetch16_slow(uint32_t address);
+void mdM68K_exception(uint32_t vector, uint32_t pc);
+void mdM68K_set_sr(uint32_t sr);
+void mdM68K_checkpoint(void);
+void mdM68K_idle_branch(void);
+void mdM68K_idle_read(uint32_t address);
+
+/** Register access. **/
+#define REG_D(n)	(mdM68K.dar[(n)])
+#define REG_A(n)	(mdM68K.dar[8 + (n)])
+#define REG_SP		(mdM68K.dar[15])
+#define REG_PC		(mdM68K.pc)
+
+/** Cycle counting. **/
+// Variadic so expressions with template arguments don't need extra parentheses.
+#define USE_CYCLES(...)	(mdM68K.cycles -= (__VA_ARGS__))
+
+/** Sign extension. **/
+#define SEXT8(x)	((uint32_t)(int32_t)(int8_t)(x))
+#define SEXT16(x)	((uint32_t)(int32_t)(int16_t)(x))
+
+/**
+ * Get the CCR.
+ * @return CCR.
+ */
+static inline uint32_t mdM68K_get_ccr(void)
+{
+	return (mdM68K.flag_x << 4) |
+	       (mdM68K.flag_n << 3) |
+	       ((mdM68K.flag_notz == 0) << 2) |
+	       (mdM68K.flag_v << 1) |
+	       (mdM68K.flag_c);
+}
+
+/**
+ * Set the CCR.
+ * @param ccr New CCR.
+ */
+static inline void mdM68K_set_ccr(uint32_t ccr)
+{
+	mdM68K.flag_x = (ccr >> 4) & 1;
+	mdM68K.flag_n = (ccr >> 3) & 1;
+	mdM68K.flag_notz = !(ccr & 4);
+	mdM68K.flag_v = (ccr >> 1) & 1;
+	mdM68K.flag_c = (ccr & 1);
+}
+
+/**
+ * Get the full SR.
+ * @return SR.
+ */
+static inline uint32_t mdM68K_get_sr(void)
+{
+	return (mdM68K.sr | mdM68K_get_ccr());
+}
+
+/**
+ * Check if an interrupt should be taken.
+ * Level 7 is non-maskable; other levels must exceed the PPL.
+ * @return True if an interrupt should be taken.
+ */
+static inline bool mdM68K_int_pending(void)
+{
+	const unsigned int level = (main68k_context.interrupts[0] & MDM68K_INT_LEVEL);
+	return (level == 7 || ((mdM68K.sr >> 8) & 7) < level);
+}
+
+/** Idle loop detection. **/
+
+// Longest idle loop, in bytes.
+#define MDM68K_IDLE_MAX_LENGTH 16
+
+/**
+ * Stop observing the current idle loop candidate.
+ * Called on anything an idle loop isn't allowed to do.
+ */
+static inline void mdM68K_idle_abort(void)
+{
+	mdM68K.idle_pc = ~0U;
+}
+
+/** Memory access. **/
+
+/**
+ * 68000 RAM is accessed directly at $E00000-$FFFFFF.
+ * Everything else goes through M68K_Mem.
+ *
+ * While an idle loop is being observed, reads outside
+ * of RAM are checked, and any write ends the observation.
+ */
+
+static inline uint32_t mdM68K_read8(uint32_t address)
+{
+	address &= 0xFFFFFF;
+	if (address >= 0xE00000)
+		return Ram_68k.u8[(address & 0xFFFF) ^ U16DATA_U8_INVERT];
+	if (mdM68K.idle_pc != ~0U)
+		mdM68K_idle_read(address);
+	return Gens_M68K_RB(address);
+}
+
+static inline uint32_t mdM68K_read16(uint32_t address)
+{
+	address &= 0xFFFFFF;
+	if (address >= 0xE00000)
+		return Ram_68k.u16[(address & 0xFFFF) >> 1];
+	if (mdM68K.idle_pc != ~0U)
+		mdM68K_idle_read(address);
+	return Gens_M68K_RW(address);
+}
+
+static inline uint32_t mdM68K_read32(uint32_t address)
+{
+	const uint32_t hi = mdM68K_read16(address);
+	return (hi << 16) | mdM68K_read16(address + 2);
+}
+
+/**
+ * Read a longword for -(An) addressing.
+ * The low word is read first.
+ */
+static inline uint32_t mdM68K_read32_dec(uint32_t address)
+{
+	const uint32_t lo = mdM68K_read16(address + 2);
+	return (mdM68K_read16(address) << 16) | lo;
+}
+
+static inline void mdM68K_write8(uint32_t address, uint32_t data)
+{
+	mdM68K_idle_abort();
+	address &= 0xFFFFFF;
+	if (address >= 0xE00000) {
+		Ram_68k.u8[(address & 0xFFFF) ^ U16DATA_U8_INVERT] = (uint8_t)data;
+		return;
+	}
+	Gens_M68K_WB(address, (uint8_t)data);
+}
+
+static inline void mdM68K_write16(uint32_t address, uint32_t data)
+{
+	mdM68K_idle_abort();
+	address &= 0xFFFFFF;
+	if (address >= 0xE00000) {
+		Ram_68k.u16[(address & 0xFFFF) >> 1] = (uint16_t)data;
+		return;
+	}
+	Gens_M68K_WW(address, (uint16_t)data);
+}
+
+static inline void mdM68K_write32(uint32_t address, uint32_t data)
+{
+	mdM68K_write16(address, data >> 16);
+	mdM68K_write16(address + 2, data);
+}
+
+/**
+ * Write a longword for -(An) addressing.
+ * The low word is written first.
+ */
+static inline void mdM68K_write32_dec(uint32_t address, uint32_t data)
+{
+	mdM68K_write16(address + 2, data);
+	mdM68K_write16(address, data >> 16);
+}
+
+/** Instruction fetch. **/
+
+/**
+ * Fetch a word from the program counter.
+ * @return Word.
+ */
+static inline uint32_t mdM68K_fetch16(void)
+{
+	const uint32_t address = (mdM68K.pc & 0xFFFFFF);
+	mdM68K.pc += 2;
+	if ((address - mdM68K.fetch_lo) <= mdM68K.fetch_span)
+		return *(const uint16_t*)(mdM68K.fetch_base + address);
+	return mdM68K_fetch16_slow(address);
+}
+
+/**
+ * Fetch a longword from the program counter.
+ * @return Longword.
+ */
+static inline uint32_t mdM68K_fetch32(void)
+{
+	const uint32_t hi = mdM68K_fetch16();
+	return (hi << 16) | mdM68K_fetch16();
+}
+
+/** Stack. **/
+
+static inline void mdM68K_push16(uint32_t data)
+{
+	REG_SP -= 2;
+	mdM68K_write16(REG_SP, data);
+}
+
+static inline void mdM68K_push32(uint32_t data)
+{
+	REG_SP -= 4;
+	mdM68K_write32(REG_SP, data);
+}
+
+static inline uint32_t mdM68K_pop16(void)
+{
+	const uint32_t data = mdM68K_read16(REG_SP);
+	REG_SP += 2;
+	return data;
+}
+
+static inline uint32_t mdM68K_pop32(void)
+{
+	const uint32_t data = mdM68K_read32(REG_SP);
+	REG_SP += 4;
+	return data;
+}
+
+#endif /* __MDM68K_P_HPP__ */
@@ -35,7 +35,15 @@
 #include "mdZ80_flags.h"
 
 // Default instruction fetch area. (Consists of HALT opcodes.)
-static uint8_t mdZ80_insn_fetch[256];
+// NOTE: Statically initialized so mdZ80_new() doesn't
+// write to it; Z80 contexts may be created by multiple threads.
+#define HLT4	0x76, 0x76, 0x76, 0x76
+#define HLT16	HLT4, HLT4, HLT4, HLT4
+#define HLT64	HLT16, HLT16, HLT16, HLT16
+static uint8_t mdZ80_insn_fetch[256] = {HLT64, HLT64, HLT64, HLT64};
+#undef HLT4
+#undef HLT16
+#undef HLT64
 
 /*! Z80 context allocation. **/
 
@@ -52,11 +60,6 @@ mdZ80_context *mdZ80_new(void)
 	if (!z80)
 		return NULL;
 
-	// Initialize the default instruction fetch area.
-	// TODO: Only initialize this once!
-	for (i = 0; i < (int)(sizeof(mdZ80_insn_fetch)/sizeof(mdZ80_insn_fetch[0])); i++)
-		mdZ80_insn_fetch[i] = 0x76;	// HLT
-
 	// Initialize Fetch[].
 	for (i = 0; i < (int)(sizeof(z80->Fetch)/sizeof(z80->Fetch[0])); i++)
 		z80->Fetch[i] = (mdZ80_insn_fetch - (i * 256));
@@ -67,6 +70,9 @@ mdZ80_context *mdZ80_new(void)
 	z80->IN_C = mdZ80_def_In;
 	z80->OUT_C = mdZ80_def_Out;
 
+	// Idle loop detection is disabled by default.
+	z80->IdlePC = ~0U;
+
 	// Return the new Z80 context.
 	return z80;
 }
@@ -144,13 +150,20 @@ void mdZ80_soft_reset(mdZ80_context *z80)
 
 /**
  * mdZ80_read_odo(): Read the Z80 odometer.
+ * During z80_Exec(), the odometer is only valid in memory write
+ * and I/O handlers, and points to the start of the instruction.
+ * (C executor only)
  * @param z80 Pointer to Z80 context.
- * @return Z80 odometer, or -1 during z80_Exec().
+ * @return Z80 odometer.
  */
 unsigned int mdZ80_read_odo(mdZ80_context *z80)
 {
 	if (z80->Status & Z80_STATE_RUNNING)
-		return -1;
+	{
+		// z80_Exec() is running.
+		// Cycles held back by EI are stored in CycleSup.
+		return (z80->CycleCnt + z80->CycleTD - (z80->CycleIO + z80->CycleSup));
+	}
 	
 	return (z80->CycleCnt + z80->CycleTD - z80->CycleIO);
 }
@@ -197,6 +210,56 @@ void mdZ80_add_cycles(mdZ80_context *z80, unsigned int cycles)
 }
 
 
+/*! Idle loop detection. (C executor only) **/
+
+/**
+ * Enable or disable idle loop skipping.
+ * A short backward jump is treated as an idle loop if an iteration
+ * doesn't write anything, only reads from stable pages, and leaves
+ * the registers unchanged. The rest of the z80_Exec() timeslice is
+ * then skipped in whole iterations.
+ * @param z80 Pointer to Z80 context.
+ * @param enable If non-zero, enable idle loop skipping.
+ * @param stable_pages Bitmask of 4 KB pages whose reads can't change during z80_Exec().
+ */
+void mdZ80_set_idle_skip(mdZ80_context *z80, int enable, uint16_t stable_pages)
+{
+	z80->IdleEnable = (enable ? 1 : 0);
+	z80->IdleStable = stable_pages;
+	z80->IdlePC = ~0U;
+}
+
+/**
+ * Get the number of idle loops skipped.
+ * @param z80 Pointer to Z80 context.
+ * @return Number of idle loops skipped.
+ */
+unsigned int mdZ80_get_idle_hits(mdZ80_context *z80)
+{
+	return z80->IdleHits;
+}
+
+/**
+ * Get the number of cycles skipped by idle loop skipping.
+ * @param z80 Pointer to Z80 context.
+ * @return Number of cycles skipped.
+ */
+uint64_t mdZ80_get_idle_cycles(mdZ80_context *z80)
+{
+	return z80->IdleSkipped;
+}
+
+/**
+ * Clear the idle loop counters.
+ * @param z80 Pointer to Z80 context.
+ */
+void mdZ80_clear_idle(mdZ80_context *z80)
+{
+	z80->IdleHits = 0;
+	z80->IdleSkipped = 0;
+}
+
+
 /**
  * mdZ80_nmi(): Raise a non-maskable interrupt.
  * @param z80 Pointer to Z80 context.
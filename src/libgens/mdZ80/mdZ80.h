@@ -66,6 +66,12 @@ void mdZ80_clear_odo(mdZ80_context *z80);
 void mdZ80_set_odo(mdZ80_context *z80, unsigned int odo);
 void mdZ80_add_cycles(mdZ80_context *z80, uint32_t cycles);
 
+/*! Idle loop detection. (C executor only) **/
+void mdZ80_set_idle_skip(mdZ80_context *z80, int enable, uint16_t stable_pages);
+unsigned int mdZ80_get_idle_hits(mdZ80_context *z80);
+uint64_t mdZ80_get_idle_cycles(mdZ80_context *z80);
+void mdZ80_clear_idle(mdZ80_context *z80);
+
 /*! Interrupt request functions. **/
 void mdZ80_nmi(mdZ80_context *z80);
 void mdZ80_interrupt(mdZ80_context *z80, unsigned char vector);
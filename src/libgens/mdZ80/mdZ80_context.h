@@ -26,6 +26,10 @@
 #ifndef __MDZ80_CONTEXT_H__
 #define __MDZ80_CONTEXT_H__
 
+// System byte order.
+// NOTE: mdZ80_x86.asm depends on the little-endian layout.
+#include "../../libcompat/byteorder.h"
+
 /****************************/
 /* Structures & definitions */
 /****************************/
@@ -52,8 +56,13 @@ struct _mdZ80_context
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t C;
 			uint8_t B;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t B;
+			uint8_t C;
+#endif
 		} b;
 		uint16_t w;
 	} BC;
@@ -61,8 +70,13 @@ struct _mdZ80_context
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t E;
 			uint8_t D;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t D;
+			uint8_t E;
+#endif
 		} b;
 		uint16_t w;
 	} DE;
@@ -70,8 +84,13 @@ struct _mdZ80_context
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t L;
 			uint8_t H;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t H;
+			uint8_t L;
+#endif
 		} b;
 		uint16_t w;
 	} HL;
@@ -79,8 +98,13 @@ struct _mdZ80_context
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t IXL;
 			uint8_t IXH;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t IXH;
+			uint8_t IXL;
+#endif
 		} b;
 		uint16_t w;
 	} IX;
@@ -88,21 +112,31 @@ struct _mdZ80_context
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t IYL;
 			uint8_t IYH;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t IYH;
+			uint8_t IYL;
+#endif
 		} b;
 		uint16_t w;
 	} IY;
-	uint16_t reserved_reg;	// Reserved for struct alignment.
+	uint16_t WZ;		// WZ (MEMPTR). (mdZ80_exec.c only)
 	
-	uint32_t PC;	// PC == BasePC + Z80 PC [x86 pointer!]
+	uintptr_t PC;	// PC == BasePC + Z80 PC [host pointer!]
 	
 	union
 	{
 		struct
 		{
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
 			uint8_t SPL;
 			uint8_t SPH;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+			uint8_t SPH;
+			uint8_t SPL;
+#endif
 		} b;
 		uint16_t w;
 	} SP;
@@ -143,7 +177,7 @@ struct _mdZ80_context
 	uint8_t Status;
 	uint8_t reserved_stat;	// Reserved for struct alignment.
 	
-	uint32_t BasePC;	// Pointer to x86 memory location where Z80 RAM starts.
+	uintptr_t BasePC;	// Pointer to host memory location where Z80 RAM starts.
 	
 	uint32_t CycleCnt;
 	uint32_t CycleTD;
@@ -156,6 +190,18 @@ struct _mdZ80_context
 	
 	Z80_RB *IN_C;
 	Z80_WB *OUT_C;
+	
+	// Idle loop detection. (mdZ80_exec.c only)
+	// NOTE: These fields are not used by mdZ80_x86.asm,
+	// and they are not cleared by mdZ80_hard_reset().
+	uint32_t IdleRegs[7];	// Registers at the loop head.
+	int IdleCycles;		// Cycles remaining at the loop head.
+	uint32_t IdlePC;	// Loop head, or ~0 if not observing.
+	uint16_t IdleStable;	// Bitmask of 4 KB pages with side-effect-free reads.
+	uint8_t IdleEnable;	// If non-zero, idle loop skipping is enabled.
+	uint8_t reserved_idle;	// Reserved for struct alignment.
+	uint32_t IdleHits;	// Idle loops skipped.
+	uint64_t IdleSkipped;	// Cycles skipped.
 };
 
 #endif /* __MDZ80_CONTEXT_H__ */
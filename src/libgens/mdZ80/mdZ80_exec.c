@@ -0,0 +1,1730 @@
+/***************************************************************************
+ * mdZ80: Gens Z80 Emulator                                                *
+ * mdZ80_exec.c: Z80 execution loop. (Portable C version)                  *
+ *                                                                         *
+ * Copyright (c) 1999-2002 by Stéphane Dallongeville                       *
+ * Copyright (c) 2003-2004 by Stéphane Akhoun                              *
+ * Copyright (c) 2008-2016 by David Korth                                  *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+/**
+ * This is a C implementation of z80_Exec() from mdZ80_x86.asm.
+ * It uses the same context, odometer, and interrupt semantics,
+ * so the register access and odometer functions in mdZ80.c and
+ * mdZ80_reg.c work with either implementation.
+ *
+ * Differences from the assembly version:
+ * - All data accesses go through ReadB() / WriteB().
+ *   (The assembly version reads Ram_Z80[] directly for $0000-$3FFF.)
+ * - Opcode and operand fetches wrap around at $FFFF.
+ * - DAA uses the correct mdZ80_DAA_Table[] index for the H flag.
+ * - CPIR / CPDR take 16 cycles on the last iteration, not 18.
+ *
+ * WZ (MEMPTR) is emulated, since BIT n,(HL) takes X and Y from it.
+ * The asm version doesn't emulate WZ.
+ *
+ * Idle loop detection (mdZ80_set_idle_skip()) is only available here.
+ */
+
+#include "mdZ80.h"
+
+// Z80 context definition.
+#include "mdZ80_context.h"
+
+// Z80 flag and state definitions.
+#include "mdZ80_flags.h"
+
+// Flag tables.
+#include "mdZ80_DAA.h"
+#include "mdZ80_INC_DEC.h"
+
+// C includes.
+#include <string.h>
+
+// gcc and clang support computed goto ("labels as values").
+// Other compilers use a switch() statement.
+#if defined(__GNUC__)
+#define MDZ80_COMPUTED_GOTO 1
+#endif
+
+/** Registers. **/
+// A, F, and the program counter are kept in local variables.
+#define zBC	(z80->BC.w)
+#define zB	(z80->BC.b.B)
+#define zC	(z80->BC.b.C)
+#define zDE	(z80->DE.w)
+#define zD	(z80->DE.b.D)
+#define zE	(z80->DE.b.E)
+#define zHL	(z80->HL.w)
+#define zH	(z80->HL.b.H)
+#define zL	(z80->HL.b.L)
+#define zIX	(z80->IX.w)
+#define zIY	(z80->IY.w)
+#define zSP	(z80->SP.w)
+#define zWZ	(z80->WZ)
+
+// IXH/IXL or IYH/IYL, depending on the prefix.
+#define XYH		((*xy) >> 8)
+#define XYL		((*xy) & 0xFF)
+#define SET_XYH(v)	(*xy = (uint16_t)((*xy & 0x00FF) | ((v) << 8)))
+#define SET_XYL(v)	(*xy = (uint16_t)((*xy & 0xFF00) | (v)))
+
+/** Flags. **/
+#define FLAG_XY		(Z80_FLAG_X | Z80_FLAG_Y)
+#define FLAGS_SZXY(v)	(((v) & (Z80_FLAG_S | FLAG_XY)) | ((v) ? 0 : Z80_FLAG_Z))
+#define FLAG_PARITY(v)	(((0x6996 >> (((v) ^ ((v) >> 4)) & 0xF)) & 1) ? 0 : Z80_FLAG_P)
+#define FLAGS_SZXYP(v)	(FLAGS_SZXY(v) | FLAG_PARITY(v))
+
+/**
+ * Memory access.
+ * The remaining cycle count is stored in CycleIO before
+ * writes so mdZ80_read_odo() can timestamp them.
+ */
+#define READ_B(adr)		mdZ80_read_b(z80, (adr))
+#define WRITE_B(adr, data) do { \
+	IDLE_ABORT(); \
+	z80->CycleIO = (uint32_t)cycles; \
+	z80->WriteB((adr) & 0xFFFF, (uint8_t)(data)); \
+} while (0)
+#define READ_W(adr)		mdZ80_read_w(z80, (adr))
+#define WRITE_W(adr, data) do { \
+	z80->CycleIO = (uint32_t)cycles; \
+	mdZ80_write_w(z80, (adr), (data)); \
+} while (0)
+
+#define PUSH_W(data) do { \
+	zSP -= 2; \
+	WRITE_W(zSP, (data)); \
+} while (0)
+
+#define POP_W(dest) do { \
+	(dest) = READ_W(zSP); \
+	zSP += 2; \
+} while (0)
+
+/**
+ * I/O access.
+ * The remaining cycle count is stored in CycleIO
+ * so mdZ80_add_cycles() can adjust it.
+ */
+#define DO_IN(port, dest) do { \
+	IDLE_ABORT(); \
+	z80->CycleIO = (uint32_t)cycles; \
+	(dest) = z80->IN_C((port) & 0xFFFF); \
+	cycles = (int)z80->CycleIO; \
+} while (0)
+
+#define DO_OUT(port, data) do { \
+	IDLE_ABORT(); \
+	z80->CycleIO = (uint32_t)cycles; \
+	z80->OUT_C((port) & 0xFFFF, (uint8_t)(data)); \
+	cycles = (int)z80->CycleIO; \
+} while (0)
+
+/**
+ * Idle loop detection.
+ * Only backward jumps of up to MDZ80_IDLE_MAX_LENGTH bytes
+ * are considered, since sound driver wait loops are short.
+ * Any write or I/O access stops observing the current loop.
+ */
+#define MDZ80_IDLE_MAX_LENGTH	16
+#define IDLE_ABORT()	(z80->IdlePC = ~0U)
+
+/**
+ * Check for an idle loop at a taken jump.
+ * @param from Address of the next instruction.
+ * @param to Jump target.
+ */
+#define IDLE_CHECK(from, to) do { \
+	if (z80->IdleEnable && \
+	    (((from) - (to)) & 0xFFFF) <= MDZ80_IDLE_MAX_LENGTH) { \
+		cycles = mdZ80_idle_branch(z80, (to), a, f, cycles); \
+	} \
+} while (0)
+
+/** Instruction fetch. **/
+#define FETCH_OP(adr)	(z80->Fetch[(adr) >> 8][(adr)])
+
+#define FETCH_B(dest) do { \
+	(dest) = FETCH_OP(pc); \
+	pc = (pc + 1) & 0xFFFF; \
+} while (0)
+
+#define FETCH_W(dest) do { \
+	(dest) = FETCH_OP(pc); \
+	pc = (pc + 1) & 0xFFFF; \
+	(dest) |= (FETCH_OP(pc) << 8); \
+	pc = (pc + 1) & 0xFFFF; \
+} while (0)
+
+/** Dispatch. **/
+#ifdef MDZ80_COMPUTED_GOTO
+#define OP(n)		op_##n
+#define EXEC_OP()	goto *op_table[op]
+#else
+#define OP(n)		case n
+#define EXEC_OP()	goto exec_op
+#endif
+
+/**
+ * Finish the current instruction.
+ * @param n Number of cycles used.
+ */
+#define NEXT(n) do { \
+	cycles -= (n); \
+	if (cycles < 0) \
+		goto quit; \
+	FETCH_B(op); \
+	EXEC_OP(); \
+} while (0)
+
+/** 8-bit arithmetic. **/
+
+#define OP_ADD(v) do { \
+	val = (v); \
+	res = a + val; \
+	f = FLAGS_SZXY(res & 0xFF) | ((a ^ val ^ res) & Z80_FLAG_H) | \
+	    (((a ^ ~val) & (a ^ res) & 0x80) >> 5) | (res >> 8); \
+	a = res & 0xFF; \
+} while (0)
+
+#define OP_ADC(v) do { \
+	val = (v); \
+	res = a + val + (f & Z80_FLAG_C); \
+	f = FLAGS_SZXY(res & 0xFF) | ((a ^ val ^ res) & Z80_FLAG_H) | \
+	    (((a ^ ~val) & (a ^ res) & 0x80) >> 5) | (res >> 8); \
+	a = res & 0xFF; \
+} while (0)
+
+#define OP_SUB(v) do { \
+	val = (v); \
+	res = a - val; \
+	f = FLAGS_SZXY(res & 0xFF) | ((a ^ val ^ res) & Z80_FLAG_H) | \
+	    (((a ^ val) & (a ^ res) & 0x80) >> 5) | \
+	    Z80_FLAG_N | ((res >> 8) & Z80_FLAG_C); \
+	a = res & 0xFF; \
+} while (0)
+
+#define OP_SBC(v) do { \
+	val = (v); \
+	res = a - val - (f & Z80_FLAG_C); \
+	f = FLAGS_SZXY(res & 0xFF) | ((a ^ val ^ res) & Z80_FLAG_H) | \
+	    (((a ^ val) & (a ^ res) & 0x80) >> 5) | \
+	    Z80_FLAG_N | ((res >> 8) & Z80_FLAG_C); \
+	a = res & 0xFF; \
+} while (0)
+
+// NOTE: CP takes the X and Y flags from the operand.
+#define OP_CP(v) do { \
+	val = (v); \
+	res = a - val; \
+	f = (res & Z80_FLAG_S) | ((res & 0xFF) ? 0 : Z80_FLAG_Z) | \
+	    (val & FLAG_XY) | ((a ^ val ^ res) & Z80_FLAG_H) | \
+	    (((a ^ val) & (a ^ res) & 0x80) >> 5) | \
+	    Z80_FLAG_N | ((res >> 8) & Z80_FLAG_C); \
+} while (0)
+
+#define OP_AND(v) do { \
+	a &= (v); \
+	f = FLAGS_SZXYP(a) | Z80_FLAG_H; \
+} while (0)
+
+#define OP_XOR(v) do { \
+	a ^= (v); \
+	f = FLAGS_SZXYP(a); \
+} while (0)
+
+#define OP_OR(v) do { \
+	a |= (v); \
+	f = FLAGS_SZXYP(a); \
+} while (0)
+
+/**
+ * ALU operation selected by bits 3-5 of the opcode.
+ * @param type ALU operation.
+ * @param v Operand.
+ */
+#define OP_ALU(type, v) do { \
+	switch (type) { \
+		case 0:	OP_ADD(v); break; \
+		case 1:	OP_ADC(v); break; \
+		case 2:	OP_SUB(v); break; \
+		case 3:	OP_SBC(v); break; \
+		case 4:	OP_AND(v); break; \
+		case 5:	OP_XOR(v); break; \
+		case 6:	OP_OR(v);  break; \
+		default: OP_CP(v); break; \
+	} \
+} while (0)
+
+// INC/DEC flags are looked up using the original value.
+#define OP_INC(r) do { \
+	f = (f & Z80_FLAG_C) | mdZ80_INC_Flags_Table[(r)]; \
+	(r) = ((r) + 1) & 0xFF; \
+} while (0)
+
+#define OP_DEC(r) do { \
+	f = (f & Z80_FLAG_C) | mdZ80_DEC_Flags_Table[(r)]; \
+	(r) = ((r) - 1) & 0xFF; \
+} while (0)
+
+/** 16-bit arithmetic. **/
+
+#define OP_ADD16(dest, v) do { \
+	zWZ = (dest) + 1; \
+	val = (v); \
+	res = (dest) + val; \
+	f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | \
+	    ((((dest) ^ val ^ res) >> 8) & Z80_FLAG_H) | \
+	    ((res >> 8) & FLAG_XY) | (res >> 16); \
+	(dest) = res & 0xFFFF; \
+} while (0)
+
+#define OP_ADC16(v) do { \
+	zWZ = zHL + 1; \
+	val = (v); \
+	res = zHL + val + (f & Z80_FLAG_C); \
+	f = ((res >> 8) & (Z80_FLAG_S | FLAG_XY)) | \
+	    ((res & 0xFFFF) ? 0 : Z80_FLAG_Z) | \
+	    (((zHL ^ val ^ res) >> 8) & Z80_FLAG_H) | \
+	    (((zHL ^ ~val) & (zHL ^ res) & 0x8000) >> 13) | \
+	    (res >> 16); \
+	zHL = res & 0xFFFF; \
+} while (0)
+
+#define OP_SBC16(v) do { \
+	zWZ = zHL + 1; \
+	val = (v); \
+	res = zHL - val - (f & Z80_FLAG_C); \
+	f = ((res >> 8) & (Z80_FLAG_S | FLAG_XY)) | \
+	    ((res & 0xFFFF) ? 0 : Z80_FLAG_Z) | \
+	    (((zHL ^ val ^ res) >> 8) & Z80_FLAG_H) | \
+	    (((zHL ^ val) & (zHL ^ res) & 0x8000) >> 13) | \
+	    Z80_FLAG_N | ((res >> 16) & Z80_FLAG_C); \
+	zHL = res & 0xFFFF; \
+} while (0)
+
+/**
+ * Branches.
+ * WZ is set to the target address, even if a JP or CALL isn't taken.
+ * NOTE: WZ is always equal to the loop head at IDLE_CHECK(),
+ * so it doesn't need to be compared by mdZ80_idle_branch().
+ */
+
+#define OP_JR_COND(cond) do { \
+	if (cond) { \
+		FETCH_B(val); \
+		IDLE_CHECK(pc, pc + (int8_t)val); \
+		pc = (pc + (int8_t)val) & 0xFFFF; \
+		zWZ = pc; \
+		NEXT(12); \
+	} \
+	pc = (pc + 1) & 0xFFFF; \
+	NEXT(7); \
+} while (0)
+
+#define OP_JP_COND(cond) do { \
+	FETCH_W(adr); \
+	zWZ = adr; \
+	if (cond) { \
+		IDLE_CHECK(pc, adr); \
+		pc = adr; \
+	} \
+	NEXT(10); \
+} while (0)
+
+#define OP_CALL_COND(cond) do { \
+	FETCH_W(adr); \
+	zWZ = adr; \
+	if (cond) { \
+		PUSH_W(pc); \
+		pc = adr; \
+		NEXT(17); \
+	} \
+	NEXT(10); \
+} while (0)
+
+#define OP_RET_COND(cond) do { \
+	if (cond) { \
+		POP_W(pc); \
+		zWZ = pc; \
+		NEXT(11); \
+	} \
+	NEXT(5); \
+} while (0)
+
+#define OP_RST(vector) do { \
+	PUSH_W(pc); \
+	pc = (vector); \
+	zWZ = pc; \
+	NEXT(11); \
+} while (0)
+
+/** Register access by index. (B, C, D, E, H, L, (HL), A) **/
+
+#define GET_R8(idx, dest) do { \
+	switch (idx) { \
+		case 0:	(dest) = zB; break; \
+		case 1:	(dest) = zC; break; \
+		case 2:	(dest) = zD; break; \
+		case 3:	(dest) = zE; break; \
+		case 4:	(dest) = zH; break; \
+		case 5:	(dest) = zL; break; \
+		case 6:	(dest) = READ_B(zHL); break; \
+		default: (dest) = a; break; \
+	} \
+} while (0)
+
+#define SET_R8(idx, v) do { \
+	switch (idx) { \
+		case 0:	zB = (v); break; \
+		case 1:	zC = (v); break; \
+		case 2:	zD = (v); break; \
+		case 3:	zE = (v); break; \
+		case 4:	zH = (v); break; \
+		case 5:	zL = (v); break; \
+		case 6:	WRITE_B(zHL, (v)); break; \
+		default: a = (v); break; \
+	} \
+} while (0)
+
+// DD/FD versions: H and L are replaced with IXH/IXL or IYH/IYL.
+// (HL) isn't handled here, since it needs a displacement.
+#define GET_R8_XY(idx, dest) do { \
+	switch (idx) { \
+		case 0:	(dest) = zB; break; \
+		case 1:	(dest) = zC; break; \
+		case 2:	(dest) = zD; break; \
+		case 3:	(dest) = zE; break; \
+		case 4:	(dest) = XYH; break; \
+		case 5:	(dest) = XYL; break; \
+		default: (dest) = a; break; \
+	} \
+} while (0)
+
+#define SET_R8_XY(idx, v) do { \
+	switch (idx) { \
+		case 0:	zB = (v); break; \
+		case 1:	zC = (v); break; \
+		case 2:	zD = (v); break; \
+		case 3:	zE = (v); break; \
+		case 4:	SET_XYH(v); break; \
+		case 5:	SET_XYL(v); break; \
+		default: a = (v); break; \
+	} \
+} while (0)
+
+/**
+ * Check for interrupts.
+ * An NMI takes priority over a regular interrupt.
+ */
+#define CHECK_INT() do { \
+	if (z80->IntLine & 0x80) { \
+		/* NMI clears IFF1; IFF2 remains as-is. */ \
+		PUSH_W(pc); \
+		z80->IFF &= ~1; \
+		z80->IntLine &= ~0x80; \
+		z80->Status &= ~Z80_STATE_HALTED; \
+		pc = 0x66; \
+		zWZ = pc; \
+	} else if (z80->IntLine & z80->IFF) { \
+		/* INT clears both IFF1 and IFF2. */ \
+		PUSH_W(pc); \
+		z80->Status &= ~Z80_STATE_HALTED; \
+		z80->IntLine &= 0x80; \
+		z80->IFF = 0; \
+		switch (z80->IM) { \
+			case 0: \
+				/* Assume the vector is an RST instruction. */ \
+				pc = (z80->IntVect - 0xC7) & 0xFF; \
+				cycles -= 13; \
+				break; \
+			case 1: \
+				pc = 0x38; \
+				cycles -= 13; \
+				break; \
+			default: \
+				pc = READ_W((z80->I << 8) | z80->IntVect); \
+				cycles -= 19; \
+				break; \
+		} \
+		zWZ = pc; \
+	} \
+} while (0)
+
+/**
+ * Save the local registers to the Z80 context.
+ */
+#define SAVE_REGS() do { \
+	z80->BasePC = (uintptr_t)z80->Fetch[pc >> 8]; \
+	z80->PC = z80->BasePC + pc; \
+	z80->AF.b.A = (uint8_t)a; \
+	z80->AF.b.F = (uint8_t)(f & ~FLAG_XY); \
+	z80->AF.b.FXY = (uint8_t)(f & FLAG_XY); \
+} while (0)
+
+/**
+ * Read a byte from memory.
+ * Reads from unstable pages stop idle loop observation.
+ * @param z80 Pointer to Z80 context.
+ * @param adr Address.
+ * @return Byte.
+ */
+static inline uint8_t mdZ80_read_b(mdZ80_context *z80, unsigned int adr)
+{
+	adr &= 0xFFFF;
+	if (!(z80->IdleStable & (1 << (adr >> 12))))
+		IDLE_ABORT();
+	return z80->ReadB(adr);
+}
+
+/**
+ * Read a word from memory.
+ * @param z80 Pointer to Z80 context.
+ * @param adr Address.
+ * @return Word.
+ */
+static uint16_t mdZ80_read_w(mdZ80_context *z80, unsigned int adr)
+{
+	uint16_t data = mdZ80_read_b(z80, adr);
+	data |= (mdZ80_read_b(z80, adr + 1) << 8);
+	return data;
+}
+
+/**
+ * Write a word to memory.
+ * @param z80 Pointer to Z80 context.
+ * @param adr Address.
+ * @param data Word.
+ */
+static void mdZ80_write_w(mdZ80_context *z80, unsigned int adr, unsigned int data)
+{
+	IDLE_ABORT();
+	z80->WriteB(adr & 0xFFFF, (uint8_t)data);
+	z80->WriteB((adr + 1) & 0xFFFF, (uint8_t)(data >> 8));
+}
+
+/**
+ * CB-prefixed rotate/shift instructions.
+ * @param type Operation. (RLC, RRC, RL, RR, SLA, SRA, SLL, SRL)
+ * @param v Value.
+ * @param f F register.
+ * @return (New F << 8) | Result.
+ */
+static unsigned int mdZ80_rot(unsigned int type, unsigned int v, unsigned int f)
+{
+	unsigned int res;
+	switch (type & 7) {
+		case 0:	// RLC
+			res = ((v << 1) | (v >> 7)) & 0xFF;
+			f = (v >> 7);
+			break;
+		case 1:	// RRC
+			res = ((v >> 1) | (v << 7)) & 0xFF;
+			f = (v & 1);
+			break;
+		case 2:	// RL
+			res = ((v << 1) | (f & Z80_FLAG_C)) & 0xFF;
+			f = (v >> 7);
+			break;
+		case 3:	// RR
+			res = (v >> 1) | ((f & Z80_FLAG_C) << 7);
+			f = (v & 1);
+			break;
+		case 4:	// SLA
+			res = (v << 1) & 0xFF;
+			f = (v >> 7);
+			break;
+		case 5:	// SRA
+			res = (v >> 1) | (v & 0x80);
+			f = (v & 1);
+			break;
+		case 6:	// SLL (undocumented)
+			res = ((v << 1) | 1) & 0xFF;
+			f = (v >> 7);
+			break;
+		default: // SRL
+			res = (v >> 1);
+			f = (v & 1);
+			break;
+	}
+
+	f |= FLAGS_SZXYP(res);
+	return ((f << 8) | res);
+}
+
+/**
+ * Check for an idle loop at a taken backward jump.
+ *
+ * The loop head is recorded along with the registers. If the jump
+ * returns to the same loop head with the same registers, and nothing
+ * stopped the observation in between, every further iteration will
+ * be identical until z80_Exec() returns: the 68000 doesn't run during
+ * z80_Exec(), and interrupts are only taken at its start or after EI.
+ * The remaining cycles are then skipped in whole iterations, so the
+ * timeslice still ends on the same instruction.
+ *
+ * @param z80 Pointer to Z80 context.
+ * @param target Jump target. (loop head)
+ * @param a A register.
+ * @param f F register.
+ * @param cycles Cycles remaining, minus one.
+ * @return New cycles remaining, minus one.
+ */
+static int mdZ80_idle_branch(mdZ80_context *z80, unsigned int target,
+			     unsigned int a, unsigned int f, int cycles)
+{
+	uint32_t regs[7];
+	int period, iter;
+
+	target &= 0xFFFF;
+	regs[0] = a | (f << 8) | (z80->IFF << 16) | (z80->IM << 24);
+	regs[1] = zBC | (zDE << 16);
+	regs[2] = zHL | (zIX << 16);
+	regs[3] = zIY | (zSP << 16);
+	regs[4] = z80->AF2.d;
+	regs[5] = z80->BC2 | (z80->DE2 << 16);
+	regs[6] = z80->HL2 | (z80->I << 16) | (z80->R << 24);
+
+	if (z80->IdlePC != target ||
+	    memcmp(regs, z80->IdleRegs, sizeof(regs)) != 0)
+	{
+		// New loop candidate.
+		z80->IdlePC = target;
+		z80->IdleCycles = cycles;
+		memcpy(z80->IdleRegs, regs, sizeof(regs));
+		return cycles;
+	}
+
+	// Cycles held back by EI must not be skipped.
+	period = z80->IdleCycles - cycles;
+	if (period > 0 && cycles >= 0 && z80->CycleSup == 0) {
+		iter = cycles / period;
+		if (iter > 0) {
+			cycles -= (iter * period);
+			z80->IdleHits++;
+			z80->IdleSkipped += (uint64_t)iter * period;
+		}
+	}
+	z80->IdleCycles = cycles;
+	return cycles;
+}
+
+/**
+ * Run the Z80.
+ * @param z80 Pointer to Z80 context.
+ * @param odo Odometer value to run to.
+ * @return 0 on success; -1 if no cycles need to be run; Status if the Z80 can't run.
+ */
+uint32_t z80_Exec(mdZ80_context *z80, int odo)
+{
+#ifdef MDZ80_COMPUTED_GOTO
+	static const void *const op_table[0x100] = {
+		&&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07, &&op_0x08, &&op_0x09, &&op_0x0A, &&op_0x0B, &&op_0x0C, &&op_0x0D, &&op_0x0E, &&op_0x0F,
+		&&op_0x10, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17, &&op_0x18, &&op_0x19, &&op_0x1A, &&op_0x1B, &&op_0x1C, &&op_0x1D, &&op_0x1E, &&op_0x1F,
+		&&op_0x20, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&op_0x27, &&op_0x28, &&op_0x29, &&op_0x2A, &&op_0x2B, &&op_0x2C, &&op_0x2D, &&op_0x2E, &&op_0x2F,
+		&&op_0x30, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37, &&op_0x38, &&op_0x39, &&op_0x3A, &&op_0x3B, &&op_0x3C, &&op_0x3D, &&op_0x3E, &&op_0x3F,
+		&&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47, &&op_0x48, &&op_0x49, &&op_0x4A, &&op_0x4B, &&op_0x4C, &&op_0x4D, &&op_0x4E, &&op_0x4F,
+		&&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57, &&op_0x58, &&op_0x59, &&op_0x5A, &&op_0x5B, &&op_0x5C, &&op_0x5D, &&op_0x5E, &&op_0x5F,
+		&&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67, &&op_0x68, &&op_0x69, &&op_0x6A, &&op_0x6B, &&op_0x6C, &&op_0x6D, &&op_0x6E, &&op_0x6F,
+		&&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&op_0x76, &&op_0x77, &&op_0x78, &&op_0x79, &&op_0x7A, &&op_0x7B, &&op_0x7C, &&op_0x7D, &&op_0x7E, &&op_0x7F,
+		&&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87, &&op_0x88, &&op_0x89, &&op_0x8A, &&op_0x8B, &&op_0x8C, &&op_0x8D, &&op_0x8E, &&op_0x8F,
+		&&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97, &&op_0x98, &&op_0x99, &&op_0x9A, &&op_0x9B, &&op_0x9C, &&op_0x9D, &&op_0x9E, &&op_0x9F,
+		&&op_0xA0, &&op_0xA1, &&op_0xA2, &&op_0xA3, &&op_0xA4, &&op_0xA5, &&op_0xA6, &&op_0xA7, &&op_0xA8, &&op_0xA9, &&op_0xAA, &&op_0xAB, &&op_0xAC, &&op_0xAD, &&op_0xAE, &&op_0xAF,
+		&&op_0xB0, &&op_0xB1, &&op_0xB2, &&op_0xB3, &&op_0xB4, &&op_0xB5, &&op_0xB6, &&op_0xB7, &&op_0xB8, &&op_0xB9, &&op_0xBA, &&op_0xBB, &&op_0xBC, &&op_0xBD, &&op_0xBE, &&op_0xBF,
+		&&op_0xC0, &&op_0xC1, &&op_0xC2, &&op_0xC3, &&op_0xC4, &&op_0xC5, &&op_0xC6, &&op_0xC7, &&op_0xC8, &&op_0xC9, &&op_0xCA, &&op_0xCB, &&op_0xCC, &&op_0xCD, &&op_0xCE, &&op_0xCF,
+		&&op_0xD0, &&op_0xD1, &&op_0xD2, &&op_0xD3, &&op_0xD4, &&op_0xD5, &&op_0xD6, &&op_0xD7, &&op_0xD8, &&op_0xD9, &&op_0xDA, &&op_0xDB, &&op_0xDC, &&op_0xDD, &&op_0xDE, &&op_0xDF,
+		&&op_0xE0, &&op_0xE1, &&op_0xE2, &&op_0xE3, &&op_0xE4, &&op_0xE5, &&op_0xE6, &&op_0xE7, &&op_0xE8, &&op_0xE9, &&op_0xEA, &&op_0xEB, &&op_0xEC, &&op_0xED, &&op_0xEE, &&op_0xEF,
+		&&op_0xF0, &&op_0xF1, &&op_0xF2, &&op_0xF3, &&op_0xF4, &&op_0xF5, &&op_0xF6, &&op_0xF7, &&op_0xF8, &&op_0xF9, &&op_0xFA, &&op_0xFB, &&op_0xFC, &&op_0xFD, &&op_0xFE, &&op_0xFF
+};
+#endif
+
+	unsigned int pc;	// Z80 program counter.
+	unsigned int a, f;	// A and F registers. (F includes X and Y.)
+	int cycles;		// Cycles remaining, minus one.
+	unsigned int op;	// Current opcode.
+	unsigned int val, res, adr;
+	uint16_t *xy;		// IX or IY.
+
+	if ((unsigned int)odo <= z80->CycleCnt)
+		return -1;
+	if (z80->Status & Z80_STATE_RUNNING)
+		return z80->Status;
+
+	cycles = (int)((unsigned int)odo - z80->CycleCnt) - 1;
+	pc = (uint16_t)(z80->PC - z80->BasePC);
+	IDLE_ABORT();
+	a = z80->AF.b.A;
+	f = (z80->AF.b.F & ~FLAG_XY) | (z80->AF.b.FXY & FLAG_XY);
+
+	CHECK_INT();
+
+	if (z80->Status & (Z80_STATE_HALTED | Z80_STATE_FAULTED)) {
+		// The Z80 can't run.
+		// If it's halted, use up all of the cycles.
+		if (z80->Status & Z80_STATE_HALTED)
+			z80->CycleCnt += (cycles + 1);
+		SAVE_REGS();
+		return z80->Status;
+	}
+
+	z80->Status |= Z80_STATE_RUNNING;
+	z80->CycleSup = 0;
+	z80->CycleTD = (uint32_t)cycles;
+
+dispatch:
+	FETCH_B(op);
+#ifdef MDZ80_COMPUTED_GOTO
+	EXEC_OP();
+#else
+exec_op:
+	switch (op) {
+#endif
+
+	/** 0x00 - 0x3F **/
+	OP(0x00):	// NOP
+		NEXT(4);
+	OP(0x01):	// LD BC,nn
+		FETCH_W(zBC); NEXT(10);
+	OP(0x02):	// LD (BC),A
+		WRITE_B(zBC, a); zWZ = ((zBC + 1) & 0xFF) | (a << 8); NEXT(7);
+	OP(0x03):	// INC BC
+		zBC++; NEXT(6);
+	OP(0x04):	// INC B
+		OP_INC(zB); NEXT(4);
+	OP(0x05):	// DEC B
+		OP_DEC(zB); NEXT(4);
+	OP(0x06):	// LD B,n
+		FETCH_B(zB); NEXT(7);
+	OP(0x07):	// RLCA
+		a = ((a << 1) | (a >> 7)) & 0xFF;
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | (a & (FLAG_XY | Z80_FLAG_C));
+		NEXT(4);
+	OP(0x08):	// EX AF,AF'
+		val = z80->AF2.b.A2;
+		res = (z80->AF2.b.F2 & ~FLAG_XY) | (z80->AF2.b.FXY2 & FLAG_XY);
+		z80->AF2.b.A2 = (uint8_t)a;
+		z80->AF2.b.F2 = (uint8_t)(f & ~FLAG_XY);
+		z80->AF2.b.FXY2 = (uint8_t)(f & FLAG_XY);
+		a = val;
+		f = res;
+		NEXT(4);
+	OP(0x09):	// ADD HL,BC
+		OP_ADD16(zHL, zBC); NEXT(11);
+	OP(0x0A):	// LD A,(BC)
+		a = READ_B(zBC); zWZ = zBC + 1; NEXT(7);
+	OP(0x0B):	// DEC BC
+		zBC--; NEXT(6);
+	OP(0x0C):	// INC C
+		OP_INC(zC); NEXT(4);
+	OP(0x0D):	// DEC C
+		OP_DEC(zC); NEXT(4);
+	OP(0x0E):	// LD C,n
+		FETCH_B(zC); NEXT(7);
+	OP(0x0F):	// RRCA
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | (a & Z80_FLAG_C);
+		a = ((a >> 1) | (a << 7)) & 0xFF;
+		f |= (a & FLAG_XY);
+		NEXT(4);
+
+	OP(0x10):	// DJNZ n
+		if (--zB != 0) {
+			FETCH_B(val);
+			pc = (pc + (int8_t)val) & 0xFFFF;
+			zWZ = pc;
+			NEXT(13);
+		}
+		pc = (pc + 1) & 0xFFFF;
+		NEXT(8);
+	OP(0x11):	// LD DE,nn
+		FETCH_W(zDE); NEXT(10);
+	OP(0x12):	// LD (DE),A
+		WRITE_B(zDE, a); zWZ = ((zDE + 1) & 0xFF) | (a << 8); NEXT(7);
+	OP(0x13):	// INC DE
+		zDE++; NEXT(6);
+	OP(0x14):	// INC D
+		OP_INC(zD); NEXT(4);
+	OP(0x15):	// DEC D
+		OP_DEC(zD); NEXT(4);
+	OP(0x16):	// LD D,n
+		FETCH_B(zD); NEXT(7);
+	OP(0x17):	// RLA
+		res = ((a << 1) | (f & Z80_FLAG_C)) & 0xFF;
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | (res & FLAG_XY) | (a >> 7);
+		a = res;
+		NEXT(4);
+	OP(0x18):	// JR n
+		FETCH_B(val);
+		IDLE_CHECK(pc, pc + (int8_t)val);
+		pc = (pc + (int8_t)val) & 0xFFFF;
+		zWZ = pc;
+		NEXT(12);
+	OP(0x19):	// ADD HL,DE
+		OP_ADD16(zHL, zDE); NEXT(11);
+	OP(0x1A):	// LD A,(DE)
+		a = READ_B(zDE); zWZ = zDE + 1; NEXT(7);
+	OP(0x1B):	// DEC DE
+		zDE--; NEXT(6);
+	OP(0x1C):	// INC E
+		OP_INC(zE); NEXT(4);
+	OP(0x1D):	// DEC E
+		OP_DEC(zE); NEXT(4);
+	OP(0x1E):	// LD E,n
+		FETCH_B(zE); NEXT(7);
+	OP(0x1F):	// RRA
+		res = (a >> 1) | ((f & Z80_FLAG_C) << 7);
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | (res & FLAG_XY) | (a & Z80_FLAG_C);
+		a = res;
+		NEXT(4);
+
+	OP(0x20):	// JR NZ,n
+		OP_JR_COND(!(f & Z80_FLAG_Z));
+	OP(0x21):	// LD HL,nn
+		FETCH_W(zHL); NEXT(10);
+	OP(0x22):	// LD (nn),HL
+		FETCH_W(adr); WRITE_W(adr, zHL); zWZ = adr + 1; NEXT(16);
+	OP(0x23):	// INC HL
+		zHL++; NEXT(6);
+	OP(0x24):	// INC H
+		OP_INC(zH); NEXT(4);
+	OP(0x25):	// DEC H
+		OP_DEC(zH); NEXT(4);
+	OP(0x26):	// LD H,n
+		FETCH_B(zH); NEXT(7);
+	OP(0x27):	// DAA
+		// Table index: A, plus N and C in bits 8-9 and H in bit 10.
+		val = mdZ80_DAA_Table[a | ((f & (Z80_FLAG_N | Z80_FLAG_C)) << 8) |
+				      ((f & Z80_FLAG_H) ? 0x400 : 0)];
+		a = (val & 0xFF);
+		f = (val >> 8);
+		NEXT(4);
+	OP(0x28):	// JR Z,n
+		OP_JR_COND(f & Z80_FLAG_Z);
+	OP(0x29):	// ADD HL,HL
+		OP_ADD16(zHL, zHL); NEXT(11);
+	OP(0x2A):	// LD HL,(nn)
+		FETCH_W(adr); zHL = READ_W(adr); zWZ = adr + 1; NEXT(16);
+	OP(0x2B):	// DEC HL
+		zHL--; NEXT(6);
+	OP(0x2C):	// INC L
+		OP_INC(zL); NEXT(4);
+	OP(0x2D):	// DEC L
+		OP_DEC(zL); NEXT(4);
+	OP(0x2E):	// LD L,n
+		FETCH_B(zL); NEXT(7);
+	OP(0x2F):	// CPL
+		a ^= 0xFF;
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P | Z80_FLAG_C)) |
+		    Z80_FLAG_H | Z80_FLAG_N | (a & FLAG_XY);
+		NEXT(4);
+
+	OP(0x30):	// JR NC,n
+		OP_JR_COND(!(f & Z80_FLAG_C));
+	OP(0x31):	// LD SP,nn
+		FETCH_W(zSP); NEXT(10);
+	OP(0x32):	// LD (nn),A
+		FETCH_W(adr); WRITE_B(adr, a); zWZ = ((adr + 1) & 0xFF) | (a << 8); NEXT(13);
+	OP(0x33):	// INC SP
+		zSP++; NEXT(6);
+	OP(0x34):	// INC (HL)
+		val = READ_B(zHL); OP_INC(val); WRITE_B(zHL, val); NEXT(11);
+	OP(0x35):	// DEC (HL)
+		val = READ_B(zHL); OP_DEC(val); WRITE_B(zHL, val); NEXT(11);
+	OP(0x36):	// LD (HL),n
+		FETCH_B(val); WRITE_B(zHL, val); NEXT(10);
+	OP(0x37):	// SCF
+		f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P)) | (a & FLAG_XY) | Z80_FLAG_C;
+		NEXT(4);
+	OP(0x38):	// JR C,n
+		OP_JR_COND(f & Z80_FLAG_C);
+	OP(0x39):	// ADD HL,SP
+		OP_ADD16(zHL, zSP); NEXT(11);
+	OP(0x3A):	// LD A,(nn)
+		FETCH_W(adr); a = READ_B(adr); zWZ = adr + 1; NEXT(13);
+	OP(0x3B):	// DEC SP
+		zSP--; NEXT(6);
+	OP(0x3C):	// INC A
+		OP_INC(a); NEXT(4);
+	OP(0x3D):	// DEC A
+		OP_DEC(a); NEXT(4);
+	OP(0x3E):	// LD A,n
+		FETCH_B(a); NEXT(7);
+	OP(0x3F):	// CCF
+		// H is set to the old carry flag.
+		f = ((f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_P | Z80_FLAG_C)) |
+		     ((f & Z80_FLAG_C) << 4) | (a & FLAG_XY)) ^ Z80_FLAG_C;
+		NEXT(4);
+
+	/** 0x40 - 0x7F: LD r,r' **/
+	OP(0x40):	// LD B,B
+		NEXT(4);
+	OP(0x41):	// LD B,C
+		zB = zC; NEXT(4);
+	OP(0x42):	// LD B,D
+		zB = zD; NEXT(4);
+	OP(0x43):	// LD B,E
+		zB = zE; NEXT(4);
+	OP(0x44):	// LD B,H
+		zB = zH; NEXT(4);
+	OP(0x45):	// LD B,L
+		zB = zL; NEXT(4);
+	OP(0x46):	// LD B,(HL)
+		zB = READ_B(zHL); NEXT(7);
+	OP(0x47):	// LD B,A
+		zB = a; NEXT(4);
+	OP(0x48):	// LD C,B
+		zC = zB; NEXT(4);
+	OP(0x49):	// LD C,C
+		NEXT(4);
+	OP(0x4A):	// LD C,D
+		zC = zD; NEXT(4);
+	OP(0x4B):	// LD C,E
+		zC = zE; NEXT(4);
+	OP(0x4C):	// LD C,H
+		zC = zH; NEXT(4);
+	OP(0x4D):	// LD C,L
+		zC = zL; NEXT(4);
+	OP(0x4E):	// LD C,(HL)
+		zC = READ_B(zHL); NEXT(7);
+	OP(0x4F):	// LD C,A
+		zC = a; NEXT(4);
+	OP(0x50):	// LD D,B
+		zD = zB; NEXT(4);
+	OP(0x51):	// LD D,C
+		zD = zC; NEXT(4);
+	OP(0x52):	// LD D,D
+		NEXT(4);
+	OP(0x53):	// LD D,E
+		zD = zE; NEXT(4);
+	OP(0x54):	// LD D,H
+		zD = zH; NEXT(4);
+	OP(0x55):	// LD D,L
+		zD = zL; NEXT(4);
+	OP(0x56):	// LD D,(HL)
+		zD = READ_B(zHL); NEXT(7);
+	OP(0x57):	// LD D,A
+		zD = a; NEXT(4);
+	OP(0x58):	// LD E,B
+		zE = zB; NEXT(4);
+	OP(0x59):	// LD E,C
+		zE = zC; NEXT(4);
+	OP(0x5A):	// LD E,D
+		zE = zD; NEXT(4);
+	OP(0x5B):	// LD E,E
+		NEXT(4);
+	OP(0x5C):	// LD E,H
+		zE = zH; NEXT(4);
+	OP(0x5D):	// LD E,L
+		zE = zL; NEXT(4);
+	OP(0x5E):	// LD E,(HL)
+		zE = READ_B(zHL); NEXT(7);
+	OP(0x5F):	// LD E,A
+		zE = a; NEXT(4);
+	OP(0x60):	// LD H,B
+		zH = zB; NEXT(4);
+	OP(0x61):	// LD H,C
+		zH = zC; NEXT(4);
+	OP(0x62):	// LD H,D
+		zH = zD; NEXT(4);
+	OP(0x63):	// LD H,E
+		zH = zE; NEXT(4);
+	OP(0x64):	// LD H,H
+		NEXT(4);
+	OP(0x65):	// LD H,L
+		zH = zL; NEXT(4);
+	OP(0x66):	// LD H,(HL)
+		zH = READ_B(zHL); NEXT(7);
+	OP(0x67):	// LD H,A
+		zH = a; NEXT(4);
+	OP(0x68):	// LD L,B
+		zL = zB; NEXT(4);
+	OP(0x69):	// LD L,C
+		zL = zC; NEXT(4);
+	OP(0x6A):	// LD L,D
+		zL = zD; NEXT(4);
+	OP(0x6B):	// LD L,E
+		zL = zE; NEXT(4);
+	OP(0x6C):	// LD L,H
+		zL = zH; NEXT(4);
+	OP(0x6D):	// LD L,L
+		NEXT(4);
+	OP(0x6E):	// LD L,(HL)
+		zL = READ_B(zHL); NEXT(7);
+	OP(0x6F):	// LD L,A
+		zL = a; NEXT(4);
+	OP(0x70):	// LD (HL),B
+		WRITE_B(zHL, zB); NEXT(7);
+	OP(0x71):	// LD (HL),C
+		WRITE_B(zHL, zC); NEXT(7);
+	OP(0x72):	// LD (HL),D
+		WRITE_B(zHL, zD); NEXT(7);
+	OP(0x73):	// LD (HL),E
+		WRITE_B(zHL, zE); NEXT(7);
+	OP(0x74):	// LD (HL),H
+		WRITE_B(zHL, zH); NEXT(7);
+	OP(0x75):	// LD (HL),L
+		WRITE_B(zHL, zL); NEXT(7);
+	OP(0x76):	// HALT
+		// Use up all remaining cycles.
+		// Interrupts will be checked on the next z80_Exec().
+		z80->Status |= Z80_STATE_HALTED;
+		cycles = -1;
+		goto really_quit;
+	OP(0x77):	// LD (HL),A
+		WRITE_B(zHL, a); NEXT(7);
+	OP(0x78):	// LD A,B
+		a = zB; NEXT(4);
+	OP(0x79):	// LD A,C
+		a = zC; NEXT(4);
+	OP(0x7A):	// LD A,D
+		a = zD; NEXT(4);
+	OP(0x7B):	// LD A,E
+		a = zE; NEXT(4);
+	OP(0x7C):	// LD A,H
+		a = zH; NEXT(4);
+	OP(0x7D):	// LD A,L
+		a = zL; NEXT(4);
+	OP(0x7E):	// LD A,(HL)
+		a = READ_B(zHL); NEXT(7);
+	OP(0x7F):	// LD A,A
+		NEXT(4);
+
+	/** 0x80 - 0xBF: ALU A,r **/
+	OP(0x80):	// ADD A,B
+		OP_ADD(zB); NEXT(4);
+	OP(0x81):	// ADD A,C
+		OP_ADD(zC); NEXT(4);
+	OP(0x82):	// ADD A,D
+		OP_ADD(zD); NEXT(4);
+	OP(0x83):	// ADD A,E
+		OP_ADD(zE); NEXT(4);
+	OP(0x84):	// ADD A,H
+		OP_ADD(zH); NEXT(4);
+	OP(0x85):	// ADD A,L
+		OP_ADD(zL); NEXT(4);
+	OP(0x86):	// ADD A,(HL)
+		OP_ADD(READ_B(zHL)); NEXT(7);
+	OP(0x87):	// ADD A,A
+		OP_ADD(a); NEXT(4);
+	OP(0x88):	// ADC A,B
+		OP_ADC(zB); NEXT(4);
+	OP(0x89):	// ADC A,C
+		OP_ADC(zC); NEXT(4);
+	OP(0x8A):	// ADC A,D
+		OP_ADC(zD); NEXT(4);
+	OP(0x8B):	// ADC A,E
+		OP_ADC(zE); NEXT(4);
+	OP(0x8C):	// ADC A,H
+		OP_ADC(zH); NEXT(4);
+	OP(0x8D):	// ADC A,L
+		OP_ADC(zL); NEXT(4);
+	OP(0x8E):	// ADC A,(HL)
+		OP_ADC(READ_B(zHL)); NEXT(7);
+	OP(0x8F):	// ADC A,A
+		OP_ADC(a); NEXT(4);
+	OP(0x90):	// SUB B
+		OP_SUB(zB); NEXT(4);
+	OP(0x91):	// SUB C
+		OP_SUB(zC); NEXT(4);
+	OP(0x92):	// SUB D
+		OP_SUB(zD); NEXT(4);
+	OP(0x93):	// SUB E
+		OP_SUB(zE); NEXT(4);
+	OP(0x94):	// SUB H
+		OP_SUB(zH); NEXT(4);
+	OP(0x95):	// SUB L
+		OP_SUB(zL); NEXT(4);
+	OP(0x96):	// SUB (HL)
+		OP_SUB(READ_B(zHL)); NEXT(7);
+	OP(0x97):	// SUB A
+		OP_SUB(a); NEXT(4);
+	OP(0x98):	// SBC A,B
+		OP_SBC(zB); NEXT(4);
+	OP(0x99):	// SBC A,C
+		OP_SBC(zC); NEXT(4);
+	OP(0x9A):	// SBC A,D
+		OP_SBC(zD); NEXT(4);
+	OP(0x9B):	// SBC A,E
+		OP_SBC(zE); NEXT(4);
+	OP(0x9C):	// SBC A,H
+		OP_SBC(zH); NEXT(4);
+	OP(0x9D):	// SBC A,L
+		OP_SBC(zL); NEXT(4);
+	OP(0x9E):	// SBC A,(HL)
+		OP_SBC(READ_B(zHL)); NEXT(7);
+	OP(0x9F):	// SBC A,A
+		OP_SBC(a); NEXT(4);
+	OP(0xA0):	// AND B
+		OP_AND(zB); NEXT(4);
+	OP(0xA1):	// AND C
+		OP_AND(zC); NEXT(4);
+	OP(0xA2):	// AND D
+		OP_AND(zD); NEXT(4);
+	OP(0xA3):	// AND E
+		OP_AND(zE); NEXT(4);
+	OP(0xA4):	// AND H
+		OP_AND(zH); NEXT(4);
+	OP(0xA5):	// AND L
+		OP_AND(zL); NEXT(4);
+	OP(0xA6):	// AND (HL)
+		OP_AND(READ_B(zHL)); NEXT(7);
+	OP(0xA7):	// AND A
+		OP_AND(a); NEXT(4);
+	OP(0xA8):	// XOR B
+		OP_XOR(zB); NEXT(4);
+	OP(0xA9):	// XOR C
+		OP_XOR(zC); NEXT(4);
+	OP(0xAA):	// XOR D
+		OP_XOR(zD); NEXT(4);
+	OP(0xAB):	// XOR E
+		OP_XOR(zE); NEXT(4);
+	OP(0xAC):	// XOR H
+		OP_XOR(zH); NEXT(4);
+	OP(0xAD):	// XOR L
+		OP_XOR(zL); NEXT(4);
+	OP(0xAE):	// XOR (HL)
+		OP_XOR(READ_B(zHL)); NEXT(7);
+	OP(0xAF):	// XOR A
+		OP_XOR(a); NEXT(4);
+	OP(0xB0):	// OR B
+		OP_OR(zB); NEXT(4);
+	OP(0xB1):	// OR C
+		OP_OR(zC); NEXT(4);
+	OP(0xB2):	// OR D
+		OP_OR(zD); NEXT(4);
+	OP(0xB3):	// OR E
+		OP_OR(zE); NEXT(4);
+	OP(0xB4):	// OR H
+		OP_OR(zH); NEXT(4);
+	OP(0xB5):	// OR L
+		OP_OR(zL); NEXT(4);
+	OP(0xB6):	// OR (HL)
+		OP_OR(READ_B(zHL)); NEXT(7);
+	OP(0xB7):	// OR A
+		OP_OR(a); NEXT(4);
+	OP(0xB8):	// CP B
+		OP_CP(zB); NEXT(4);
+	OP(0xB9):	// CP C
+		OP_CP(zC); NEXT(4);
+	OP(0xBA):	// CP D
+		OP_CP(zD); NEXT(4);
+	OP(0xBB):	// CP E
+		OP_CP(zE); NEXT(4);
+	OP(0xBC):	// CP H
+		OP_CP(zH); NEXT(4);
+	OP(0xBD):	// CP L
+		OP_CP(zL); NEXT(4);
+	OP(0xBE):	// CP (HL)
+		OP_CP(READ_B(zHL)); NEXT(7);
+	OP(0xBF):	// CP A
+		OP_CP(a); NEXT(4);
+
+	/** 0xC0 - 0xFF **/
+	OP(0xC0):	// RET NZ
+		OP_RET_COND(!(f & Z80_FLAG_Z));
+	OP(0xC1):	// POP BC
+		POP_W(zBC); NEXT(10);
+	OP(0xC2):	// JP NZ,nn
+		OP_JP_COND(!(f & Z80_FLAG_Z));
+	OP(0xC3):	// JP nn
+		FETCH_W(adr); IDLE_CHECK(pc, adr); pc = adr; zWZ = pc; NEXT(10);
+	OP(0xC4):	// CALL NZ,nn
+		OP_CALL_COND(!(f & Z80_FLAG_Z));
+	OP(0xC5):	// PUSH BC
+		PUSH_W(zBC); NEXT(11);
+	OP(0xC6):	// ADD A,n
+		FETCH_B(res); OP_ADD(res); NEXT(7);
+	OP(0xC7):	// RST 00h
+		OP_RST(0x00);
+	OP(0xC8):	// RET Z
+		OP_RET_COND(f & Z80_FLAG_Z);
+	OP(0xC9):	// RET
+		POP_W(pc); zWZ = pc; NEXT(10);
+	OP(0xCA):	// JP Z,nn
+		OP_JP_COND(f & Z80_FLAG_Z);
+	OP(0xCB):	// CB prefix
+		goto prefix_cb;
+	OP(0xCC):	// CALL Z,nn
+		OP_CALL_COND(f & Z80_FLAG_Z);
+	OP(0xCD):	// CALL nn
+		FETCH_W(adr); PUSH_W(pc); pc = adr; zWZ = pc; NEXT(17);
+	OP(0xCE):	// ADC A,n
+		FETCH_B(res); OP_ADC(res); NEXT(7);
+	OP(0xCF):	// RST 08h
+		OP_RST(0x08);
+
+	OP(0xD0):	// RET NC
+		OP_RET_COND(!(f & Z80_FLAG_C));
+	OP(0xD1):	// POP DE
+		POP_W(zDE); NEXT(10);
+	OP(0xD2):	// JP NC,nn
+		OP_JP_COND(!(f & Z80_FLAG_C));
+	OP(0xD3):	// OUT (n),A
+		FETCH_B(adr); DO_OUT((a << 8) | adr, a);
+		zWZ = ((adr + 1) & 0xFF) | (a << 8);
+		NEXT(11);
+	OP(0xD4):	// CALL NC,nn
+		OP_CALL_COND(!(f & Z80_FLAG_C));
+	OP(0xD5):	// PUSH DE
+		PUSH_W(zDE); NEXT(11);
+	OP(0xD6):	// SUB n
+		FETCH_B(res); OP_SUB(res); NEXT(7);
+	OP(0xD7):	// RST 10h
+		OP_RST(0x10);
+	OP(0xD8):	// RET C
+		OP_RET_COND(f & Z80_FLAG_C);
+	OP(0xD9):	// EXX
+		val = zBC; zBC = z80->BC2; z80->BC2 = (uint16_t)val;
+		val = zDE; zDE = z80->DE2; z80->DE2 = (uint16_t)val;
+		val = zHL; zHL = z80->HL2; z80->HL2 = (uint16_t)val;
+		NEXT(4);
+	OP(0xDA):	// JP C,nn
+		OP_JP_COND(f & Z80_FLAG_C);
+	OP(0xDB):	// IN A,(n)
+		FETCH_B(adr); zWZ = ((a << 8) | adr) + 1;
+		DO_IN((a << 8) | adr, a);
+		NEXT(11);
+	OP(0xDC):	// CALL C,nn
+		OP_CALL_COND(f & Z80_FLAG_C);
+	OP(0xDD):	// DD prefix (IX)
+		xy = &zIX;
+		goto prefix_xy;
+	OP(0xDE):	// SBC A,n
+		FETCH_B(res); OP_SBC(res); NEXT(7);
+	OP(0xDF):	// RST 18h
+		OP_RST(0x18);
+
+	OP(0xE0):	// RET PO
+		OP_RET_COND(!(f & Z80_FLAG_P));
+	OP(0xE1):	// POP HL
+		POP_W(zHL); NEXT(10);
+	OP(0xE2):	// JP PO,nn
+		OP_JP_COND(!(f & Z80_FLAG_P));
+	OP(0xE3):	// EX (SP),HL
+		val = READ_W(zSP); WRITE_W(zSP, zHL); zHL = val; zWZ = val; NEXT(19);
+	OP(0xE4):	// CALL PO,nn
+		OP_CALL_COND(!(f & Z80_FLAG_P));
+	OP(0xE5):	// PUSH HL
+		PUSH_W(zHL); NEXT(11);
+	OP(0xE6):	// AND n
+		FETCH_B(res); OP_AND(res); NEXT(7);
+	OP(0xE7):	// RST 20h
+		OP_RST(0x20);
+	OP(0xE8):	// RET PE
+		OP_RET_COND(f & Z80_FLAG_P);
+	OP(0xE9):	// JP (HL)
+		pc = zHL; NEXT(4);
+	OP(0xEA):	// JP PE,nn
+		OP_JP_COND(f & Z80_FLAG_P);
+	OP(0xEB):	// EX DE,HL
+		val = zDE; zDE = zHL; zHL = val; NEXT(4);
+	OP(0xEC):	// CALL PE,nn
+		OP_CALL_COND(f & Z80_FLAG_P);
+	OP(0xED):	// ED prefix
+		goto prefix_ed;
+	OP(0xEE):	// XOR n
+		FETCH_B(res); OP_XOR(res); NEXT(7);
+	OP(0xEF):	// RST 28h
+		OP_RST(0x28);
+
+	OP(0xF0):	// RET P
+		OP_RET_COND(!(f & Z80_FLAG_S));
+	OP(0xF1):	// POP AF
+		POP_W(val); a = (val >> 8); f = (val & 0xFF); NEXT(10);
+	OP(0xF2):	// JP P,nn
+		OP_JP_COND(!(f & Z80_FLAG_S));
+	OP(0xF3):	// DI
+		z80->IFF = 0; NEXT(4);
+	OP(0xF4):	// CALL P,nn
+		OP_CALL_COND(!(f & Z80_FLAG_S));
+	OP(0xF5):	// PUSH AF
+		PUSH_W((a << 8) | f); NEXT(11);
+	OP(0xF6):	// OR n
+		FETCH_B(res); OP_OR(res); NEXT(7);
+	OP(0xF7):	// RST 30h
+		OP_RST(0x30);
+	OP(0xF8):	// RET M
+		OP_RET_COND(f & Z80_FLAG_S);
+	OP(0xF9):	// LD SP,HL
+		zSP = zHL; NEXT(6);
+	OP(0xFA):	// JP M,nn
+		OP_JP_COND(f & Z80_FLAG_S);
+	OP(0xFB):	// EI
+		// Interrupts are checked after the next instruction.
+		// The remaining cycles are moved to CycleSup so the
+		// next instruction always exits to the quit path.
+		z80->IFF = 3;
+		IDLE_ABORT();
+		z80->CycleSup += (uint32_t)cycles;
+		cycles = -4;
+		FETCH_B(op);
+		EXEC_OP();
+	OP(0xFC):	// CALL M,nn
+		OP_CALL_COND(f & Z80_FLAG_S);
+	OP(0xFD):	// FD prefix (IY)
+		xy = &zIY;
+		goto prefix_xy;
+	OP(0xFE):	// CP n
+		FETCH_B(res); OP_CP(res); NEXT(7);
+	OP(0xFF):	// RST 38h
+		OP_RST(0x38);
+
+#ifndef MDZ80_COMPUTED_GOTO
+	}
+#endif
+
+prefix_cb:
+	/** CB prefix: rotate/shift and bit operations. **/
+	FETCH_B(op);
+	GET_R8(op & 7, val);
+	if (op < 0x40) {
+		// Rotate/shift.
+		res = mdZ80_rot(op >> 3, val, f);
+		f = (res >> 8);
+		res &= 0xFF;
+	} else if (op < 0x80) {
+		// BIT b,r
+		// BIT b,(HL) takes X and Y from the high byte of WZ.
+		res = val & (1 << ((op >> 3) & 7));
+		f = (f & Z80_FLAG_C) | Z80_FLAG_H | (res & Z80_FLAG_S) |
+		    (res ? 0 : (Z80_FLAG_Z | Z80_FLAG_P)) |
+		    (((op & 7) == 6 ? (zWZ >> 8) : val) & FLAG_XY);
+		NEXT((op & 7) == 6 ? 12 : 8);
+	} else if (op < 0xC0) {
+		// RES b,r
+		res = val & ~(1 << ((op >> 3) & 7));
+	} else {
+		// SET b,r
+		res = val | (1 << ((op >> 3) & 7));
+	}
+	SET_R8(op & 7, res);
+	NEXT((op & 7) == 6 ? 15 : 8);
+
+prefix_xy:
+	/** DD/FD prefix: IX/IY instructions. **/
+	FETCH_B(op);
+	switch (op) {
+		case 0x09:	// ADD IX,BC
+			OP_ADD16(*xy, zBC); NEXT(15);
+		case 0x19:	// ADD IX,DE
+			OP_ADD16(*xy, zDE); NEXT(15);
+		case 0x29:	// ADD IX,IX
+			OP_ADD16(*xy, *xy); NEXT(15);
+		case 0x39:	// ADD IX,SP
+			OP_ADD16(*xy, zSP); NEXT(15);
+		case 0x21:	// LD IX,nn
+			FETCH_W(*xy); NEXT(14);
+		case 0x22:	// LD (nn),IX
+			FETCH_W(adr); WRITE_W(adr, *xy); zWZ = adr + 1; NEXT(20);
+		case 0x2A:	// LD IX,(nn)
+			FETCH_W(adr); *xy = READ_W(adr); zWZ = adr + 1; NEXT(20);
+		case 0x23:	// INC IX
+			(*xy)++; NEXT(10);
+		case 0x2B:	// DEC IX
+			(*xy)--; NEXT(10);
+		case 0x24:	// INC IXH
+			val = XYH; OP_INC(val); SET_XYH(val); NEXT(8);
+		case 0x25:	// DEC IXH
+			val = XYH; OP_DEC(val); SET_XYH(val); NEXT(8);
+		case 0x26:	// LD IXH,n
+			FETCH_B(val); SET_XYH(val); NEXT(11);
+		case 0x2C:	// INC IXL
+			val = XYL; OP_INC(val); SET_XYL(val); NEXT(8);
+		case 0x2D:	// DEC IXL
+			val = XYL; OP_DEC(val); SET_XYL(val); NEXT(8);
+		case 0x2E:	// LD IXL,n
+			FETCH_B(val); SET_XYL(val); NEXT(11);
+		case 0x34:	// INC (IX+d)
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			val = READ_B(adr); OP_INC(val); WRITE_B(adr, val);
+			NEXT(23);
+		case 0x35:	// DEC (IX+d)
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			val = READ_B(adr); OP_DEC(val); WRITE_B(adr, val);
+			NEXT(23);
+		case 0x36:	// LD (IX+d),n
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			FETCH_B(val); WRITE_B(adr, val);
+			NEXT(19);
+		case 0xCB:	// DDCB prefix
+			goto prefix_xycb;
+		case 0xE1:	// POP IX
+			POP_W(*xy); NEXT(14);
+		case 0xE3:	// EX (SP),IX
+			val = READ_W(zSP); WRITE_W(zSP, *xy); *xy = val; zWZ = val; NEXT(23);
+		case 0xE5:	// PUSH IX
+			PUSH_W(*xy); NEXT(15);
+		case 0xE9:	// JP (IX)
+			pc = *xy; NEXT(8);
+		case 0xF9:	// LD SP,IX
+			zSP = *xy; NEXT(10);
+		default:
+			break;
+	}
+
+	if (op >= 0x40 && op < 0x80 && op != 0x76) {
+		// LD r,r'
+		if ((op & 7) == 6) {
+			// LD r,(IX+d)
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			SET_R8((op >> 3) & 7, READ_B(adr));
+			NEXT(19);
+		} else if ((op & 0x38) == 0x30) {
+			// LD (IX+d),r
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			GET_R8(op & 7, val);
+			WRITE_B(adr, val);
+			NEXT(19);
+		} else if ((op & 0x06) == 0x04 || (op & 0x30) == 0x20) {
+			// LD with IXH/IXL. (undocumented)
+			GET_R8_XY(op & 7, val);
+			SET_R8_XY((op >> 3) & 7, val);
+			NEXT(8);
+		}
+	} else if (op >= 0x80 && op < 0xC0) {
+		// ALU A,r
+		if ((op & 7) == 6) {
+			// ALU A,(IX+d)
+			FETCH_B(adr);
+			adr = (*xy + (int8_t)adr) & 0xFFFF;
+			zWZ = adr;
+			res = READ_B(adr);
+			OP_ALU((op >> 3) & 7, res);
+			NEXT(19);
+		} else if ((op & 0x06) == 0x04) {
+			// ALU A,IXH/IXL (undocumented)
+			GET_R8_XY(op & 7, res);
+			OP_ALU((op >> 3) & 7, res);
+			NEXT(8);
+		}
+	}
+
+	// Any other opcode ignores the prefix.
+	// (This includes another DD/FD prefix.)
+	cycles -= 4;
+	EXEC_OP();
+
+prefix_xycb:
+	/** DDCB/FDCB prefix: rotate/shift and bit operations on (IX+d). **/
+	FETCH_B(adr);
+	adr = (*xy + (int8_t)adr) & 0xFFFF;
+	zWZ = adr;
+	FETCH_B(op);
+	val = READ_B(adr);
+	if (op < 0x40) {
+		// Rotate/shift.
+		res = mdZ80_rot(op >> 3, val, f);
+		f = (res >> 8);
+		res &= 0xFF;
+	} else if (op < 0x80) {
+		// BIT b,(IX+d)
+		// X and Y are taken from the high byte of the address. (WZ)
+		res = val & (1 << ((op >> 3) & 7));
+		f = (f & Z80_FLAG_C) | Z80_FLAG_H | (res & Z80_FLAG_S) |
+		    (res ? 0 : (Z80_FLAG_Z | Z80_FLAG_P)) | ((adr >> 8) & FLAG_XY);
+		NEXT(20);
+	} else if (op < 0xC0) {
+		// RES b,(IX+d)
+		res = val & ~(1 << ((op >> 3) & 7));
+	} else {
+		// SET b,(IX+d)
+		res = val | (1 << ((op >> 3) & 7));
+	}
+	WRITE_B(adr, res);
+	if ((op & 7) != 6) {
+		// Undocumented: The result is also copied to a register.
+		SET_R8(op & 7, res);
+	}
+	NEXT(23);
+
+prefix_ed:
+	/** ED prefix: extended instructions. **/
+	FETCH_B(op);
+	switch (op) {
+		case 0x40: case 0x48: case 0x50: case 0x58:
+		case 0x60: case 0x68: case 0x70: case 0x78:
+			// IN r,(C)
+			// IN (C) [0x70] only sets the flags.
+			DO_IN(zBC, val);
+			zWZ = zBC + 1;
+			f = (f & Z80_FLAG_C) | FLAGS_SZXYP(val);
+			if (op != 0x70)
+				SET_R8((op >> 3) & 7, val);
+			NEXT(12);
+
+		case 0x41: case 0x49: case 0x51: case 0x59:
+		case 0x61: case 0x69: case 0x71: case 0x79:
+			// OUT (C),r
+			// OUT (C),0 [0x71] writes 0.
+			if (op != 0x71) {
+				GET_R8((op >> 3) & 7, val);
+			} else {
+				val = 0;
+			}
+			DO_OUT(zBC, val);
+			zWZ = zBC + 1;
+			NEXT(12);
+
+		case 0x42:	// SBC HL,BC
+			OP_SBC16(zBC); NEXT(15);
+		case 0x52:	// SBC HL,DE
+			OP_SBC16(zDE); NEXT(15);
+		case 0x62:	// SBC HL,HL
+			OP_SBC16(zHL); NEXT(15);
+		case 0x72:	// SBC HL,SP
+			OP_SBC16(zSP); NEXT(15);
+		case 0x4A:	// ADC HL,BC
+			OP_ADC16(zBC); NEXT(15);
+		case 0x5A:	// ADC HL,DE
+			OP_ADC16(zDE); NEXT(15);
+		case 0x6A:	// ADC HL,HL
+			OP_ADC16(zHL); NEXT(15);
+		case 0x7A:	// ADC HL,SP
+			OP_ADC16(zSP); NEXT(15);
+
+		case 0x43:	// LD (nn),BC
+			FETCH_W(adr); WRITE_W(adr, zBC); zWZ = adr + 1; NEXT(20);
+		case 0x53:	// LD (nn),DE
+			FETCH_W(adr); WRITE_W(adr, zDE); zWZ = adr + 1; NEXT(20);
+		case 0x63:	// LD (nn),HL
+			FETCH_W(adr); WRITE_W(adr, zHL); zWZ = adr + 1; NEXT(20);
+		case 0x73:	// LD (nn),SP
+			FETCH_W(adr); WRITE_W(adr, zSP); zWZ = adr + 1; NEXT(20);
+		case 0x4B:	// LD BC,(nn)
+			FETCH_W(adr); zBC = READ_W(adr); zWZ = adr + 1; NEXT(20);
+		case 0x5B:	// LD DE,(nn)
+			FETCH_W(adr); zDE = READ_W(adr); zWZ = adr + 1; NEXT(20);
+		case 0x6B:	// LD HL,(nn)
+			FETCH_W(adr); zHL = READ_W(adr); zWZ = adr + 1; NEXT(20);
+		case 0x7B:	// LD SP,(nn)
+			FETCH_W(adr); zSP = READ_W(adr); zWZ = adr + 1; NEXT(20);
+
+		case 0x44: case 0x4C: case 0x54: case 0x5C:
+		case 0x64: case 0x6C: case 0x74: case 0x7C:
+			// NEG
+			res = a;
+			a = 0;
+			OP_SUB(res);
+			NEXT(8);
+
+		case 0x45: case 0x4D: case 0x55: case 0x5D:
+		case 0x65: case 0x6D: case 0x75: case 0x7D:
+			// RETN / RETI
+			// Both instructions copy IFF2 to IFF1.
+			POP_W(pc);
+			zWZ = pc;
+			z80->IFF = (z80->IFF & 2) | ((z80->IFF >> 1) & 1);
+			NEXT(14);
+
+		case 0x46: case 0x4E: case 0x66: case 0x6E:
+			// IM 0
+			z80->IM = 0; NEXT(8);
+		case 0x56: case 0x76:
+			// IM 1
+			z80->IM = 1; NEXT(8);
+		case 0x5E: case 0x7E:
+			// IM 2
+			z80->IM = 2; NEXT(8);
+
+		case 0x47:	// LD I,A
+			z80->I = (uint8_t)a; NEXT(9);
+		case 0x4F:	// LD R,A
+			z80->R = (uint8_t)a; NEXT(9);
+		case 0x57:	// LD A,I
+			a = z80->I;
+			f = (f & Z80_FLAG_C) | FLAGS_SZXY(a) | ((z80->IFF & 2) << 1);
+			NEXT(9);
+		case 0x5F:	// LD A,R
+			// R isn't emulated, so it's derived from the odometer.
+			a = ((((z80->CycleCnt + z80->CycleTD - (uint32_t)cycles) >> 2) + z80->R) & 0x7F) |
+			    (z80->R & 0x80);
+			f = (f & Z80_FLAG_C) | FLAGS_SZXY(a) | ((z80->IFF & 2) << 1);
+			NEXT(9);
+
+		case 0x67:	// RRD
+			val = READ_B(zHL);
+			zWZ = zHL + 1;
+			WRITE_B(zHL, ((a << 4) | (val >> 4)) & 0xFF);
+			a = (a & 0xF0) | (val & 0x0F);
+			f = (f & Z80_FLAG_C) | FLAGS_SZXYP(a);
+			NEXT(18);
+		case 0x6F:	// RLD
+			val = READ_B(zHL);
+			zWZ = zHL + 1;
+			WRITE_B(zHL, ((val << 4) | (a & 0x0F)) & 0xFF);
+			a = (a & 0xF0) | (val >> 4);
+			f = (f & Z80_FLAG_C) | FLAGS_SZXYP(a);
+			NEXT(18);
+
+		/** Block transfer instructions. **/
+		// Repeating instructions loop internally, using 21 cycles
+		// per iteration. If the cycles run out, the PC is moved back
+		// to the start of the instruction so it can be resumed.
+		// LDIR, LDDR, CPIR, and CPDR set WZ to the instruction
+		// address + 1 on each iteration that repeats.
+
+		case 0xA0:	// LDI
+		case 0xA8:	// LDD
+		case 0xB0:	// LDIR
+		case 0xB8:	// LDDR
+			for (;;) {
+				val = READ_B(zHL);
+				WRITE_B(zDE, val);
+				if (op & 0x08) {
+					zHL--; zDE--;
+				} else {
+					zHL++; zDE++;
+				}
+				zBC--;
+
+				// X and Y are taken from (A + data).
+				val += a;
+				f = (f & (Z80_FLAG_S | Z80_FLAG_Z | Z80_FLAG_C)) |
+				    (val & Z80_FLAG_X) | ((val << 4) & Z80_FLAG_Y) |
+				    (zBC ? Z80_FLAG_P : 0);
+				if (!(op & 0x10) || zBC == 0)
+					break;
+				zWZ = (pc - 1) & 0xFFFF;
+				cycles -= 21;
+				if (cycles < 0) {
+					pc = (pc - 2) & 0xFFFF;
+					goto quit;
+				}
+			}
+			NEXT(16);
+
+		case 0xA1:	// CPI
+		case 0xA9:	// CPD
+		case 0xB1:	// CPIR
+		case 0xB9:	// CPDR
+			for (;;) {
+				val = READ_B(zHL);
+				res = (a - val) & 0xFF;
+				if (op & 0x08)
+					zHL--;
+				else
+					zHL++;
+				zBC--;
+
+				f = (f & Z80_FLAG_C) | Z80_FLAG_N | (res & Z80_FLAG_S) |
+				    (res ? 0 : Z80_FLAG_Z) | ((a ^ val ^ res) & Z80_FLAG_H) |
+				    (zBC ? Z80_FLAG_P : 0);
+
+				// X and Y are taken from (A - data - H).
+				res -= ((f & Z80_FLAG_H) >> 4);
+				f |= (res & Z80_FLAG_X) | ((res << 4) & Z80_FLAG_Y);
+				zWZ += ((op & 0x08) ? -1 : 1);
+				if (!(op & 0x10) || zBC == 0 || (f & Z80_FLAG_Z))
+					break;
+				zWZ = (pc - 1) & 0xFFFF;
+				cycles -= 21;
+				if (cycles < 0) {
+					pc = (pc - 2) & 0xFFFF;
+					goto quit;
+				}
+			}
+			NEXT(16);
+
+		case 0xA2:	// INI
+		case 0xAA:	// IND
+		case 0xB2:	// INIR
+		case 0xBA:	// INDR
+			for (;;) {
+				DO_IN(zBC, val);
+				zWZ = zBC + ((op & 0x08) ? -1 : 1);
+				WRITE_B(zHL, val);
+				if (op & 0x08) {
+					zHL--;
+					res = val + ((zC - 1) & 0xFF);
+				} else {
+					zHL++;
+					res = val + ((zC + 1) & 0xFF);
+				}
+				zB--;
+
+				f = FLAGS_SZXY(zB) | ((val >> 6) & Z80_FLAG_N) |
+				    ((res > 0xFF) ? (Z80_FLAG_H | Z80_FLAG_C) : 0) |
+				    FLAG_PARITY((res & 7) ^ zB);
+				if (!(op & 0x10) || zB == 0)
+					break;
+				cycles -= 21;
+				if (cycles < 0) {
+					pc = (pc - 2) & 0xFFFF;
+					goto quit;
+				}
+			}
+			NEXT(16);
+
+		case 0xA3:	// OUTI
+		case 0xAB:	// OUTD
+		case 0xB3:	// OTIR
+		case 0xBB:	// OTDR
+			for (;;) {
+				val = READ_B(zHL);
+				zB--;
+				DO_OUT(zBC, val);
+				zWZ = zBC + ((op & 0x08) ? -1 : 1);
+				if (op & 0x08)
+					zHL--;
+				else
+					zHL++;
+				res = val + zL;
+
+				f = FLAGS_SZXY(zB) | ((val >> 6) & Z80_FLAG_N) |
+				    ((res > 0xFF) ? (Z80_FLAG_H | Z80_FLAG_C) : 0) |
+				    FLAG_PARITY((res & 7) ^ zB);
+				if (!(op & 0x10) || zB == 0)
+					break;
+				cycles -= 21;
+				if (cycles < 0) {
+					pc = (pc - 2) & 0xFFFF;
+					goto quit;
+				}
+			}
+			NEXT(16);
+
+		default:
+			// Undefined ED opcodes act as an 8-cycle NOP.
+			NEXT(8);
+	}
+
+quit:
+	// Return any cycles held back by EI.
+	cycles += (int)z80->CycleSup;
+	z80->CycleSup = 0;
+	if (cycles >= 0) {
+		// Cycles remain. (EI was executed.)
+		CHECK_INT();
+		goto dispatch;
+	}
+
+really_quit:
+	z80->CycleCnt += (z80->CycleTD - (uint32_t)cycles);
+	z80->Status &= ~Z80_STATE_RUNNING;
+	SAVE_REGS();
+	return 0;
+}
@@ -82,7 +82,16 @@ PsgPrivate::PsgPrivate(Psg *q)
 	: q(q)
 	, writeLen(0)
 	, enabled(true)	// TODO: Make this customizable.
+	, bandLimited(false)
 {
+	// Initialize the static tables.
+	// NOTE: The tables are shared by all threads.
+	// A function-local static is initialized exactly once.
+	static const bool isInit = (doStaticInit(), true);
+	((void)isInit);
+
+	resetBlep();
+
 	// TODO: Move this here?
 	// (It's currently initialized in the Psg constructors.)
 	//resetBufferPtrs();
@@ -90,11 +99,10 @@ PsgPrivate::PsgPrivate(Psg *q)
 
 /**
  * Update the PSG audio output using square waves.
- * @param bufL Left audio buffer. (16-bit; int32_t is used for saturation.)
- * @param bufR Right audio buffer. (16-bit; int32_t is used for saturation.)
+ * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
  * @param length Length to write.
  */
-void PsgPrivate::update(int32_t *bufL, int32_t *bufR, int length)
+void PsgPrivate::update(int32_t *buf, int length)
 {
 	int cur_cnt, cur_step, cur_vol;
 
@@ -119,8 +127,8 @@ void PsgPrivate::update(int32_t *bufL, int32_t *bufR, int length)
 					cur_cnt += cur_step;
 					if (cur_cnt & 0x10000) {
 						// Overflow. Apply +1 tone.
-						bufL[i] += cur_vol;
-						bufR[i] += cur_vol;
+						buf[i*2] += cur_vol;
+						buf[i*2+1] += cur_vol;
 					}
 				}
 
@@ -131,8 +139,8 @@ void PsgPrivate::update(int32_t *bufL, int32_t *bufR, int length)
 				// Always apply a +1 tone.
 				// (TODO: Is this correct?)
 				for (int i = 0; i < length; i++) {
-					bufL[i] += cur_vol;
-					bufR[i] += cur_vol;
+					buf[i*2] += cur_vol;
+					buf[i*2+1] += cur_vol;
 				}
 
 				// Update the counter for this channel.
@@ -155,8 +163,8 @@ void PsgPrivate::update(int32_t *bufL, int32_t *bufR, int length)
 			cur_cnt += cur_step;
 
 			if (lfsr & 1) {
-				bufL[i] += cur_vol;
-				bufR[i] += cur_vol;
+				buf[i*2] += cur_vol;
+				buf[i*2+1] += cur_vol;
 			}
 
 			// Check if the LFSR should be shifted.
@@ -209,6 +217,7 @@ void Psg::reset(void)
 	// Use the ZOMG restore function
 	// to restore the initial state.
 	zomgRestore(&d->psgStateInit);
+	d->resetBlep();
 }
 
 /**
@@ -342,6 +351,30 @@ void Psg::write(uint8_t data)
 	}
 }
 
+/**
+ * Is band-limited step synthesis enabled?
+ * @return True if band-limited step synthesis is enabled.
+ */
+bool Psg::bandLimited(void) const
+{
+	return d->bandLimited;
+}
+
+/**
+ * Enable or disable band-limited step synthesis.
+ * @param bandLimited If true, enable band-limited step synthesis.
+ */
+void Psg::setBandLimited(bool bandLimited)
+{
+	if (d->bandLimited == bandLimited)
+		return;
+
+	// Render any pending audio with the current method.
+	specialUpdate();
+	d->bandLimited = bandLimited;
+	d->resetBlep();
+}
+
 /** ZOMG savestate functions. **/
 
 /**
@@ -419,7 +452,11 @@ void Psg::specialUpdate(void)
 		return;
 
 	// Update the sound buffer.
-	d->update(d->bufPtrL, d->bufPtrR, d->writeLen);
+	if (d->bandLimited) {
+		d->update_blep(d->bufPtr, d->writeLen);
+	} else {
+		d->update(d->bufPtr, d->writeLen);
+	}
 	d->writeLen = 0;
 
 	// TODO: Don't use EmuContext here...
@@ -432,9 +469,8 @@ void Psg::specialUpdate(void)
 	// Determine the new starting position.
 	int writePos = SoundMgr::GetWritePos(line_num);
 
-	// Update the PSG buffer pointers.
-	d->bufPtrL = &SoundMgr::ms_SegBufL[writePos];
-	d->bufPtrR = &SoundMgr::ms_SegBufR[writePos];
+	// Update the PSG buffer pointer.
+	d->bufPtr = &SoundMgr::ms_SegBuf[writePos * 2];
 }
 
 /** PSG write length. **/
@@ -454,8 +490,7 @@ void Psg::clearWriteLen(void)
  */
 void Psg::resetBufferPtrs(void)
 {
-	d->bufPtrL = &SoundMgr::ms_SegBufL[0];
-	d->bufPtrR = &SoundMgr::ms_SegBufR[0];
+	d->bufPtr = &SoundMgr::ms_SegBuf[0];
 }
 
 // TODO: Eliminate the GSXv7 stuff.
@@ -65,6 +65,22 @@ class Psg
 		 */
 		void write(uint8_t data);
 
+		/**
+		 * Is band-limited step synthesis enabled?
+		 * If enabled, each channel's transitions are rendered
+		 * as band-limited steps instead of per-sample square waves.
+		 * This removes aliasing at high pitches, but the output
+		 * is delayed by a few samples.
+		 * @return True if band-limited step synthesis is enabled.
+		 */
+		bool bandLimited(void) const;
+
+		/**
+		 * Enable or disable band-limited step synthesis.
+		 * @param bandLimited If true, enable band-limited step synthesis.
+		 */
+		void setBandLimited(bool bandLimited);
+
 		/** ZOMG savestate functions. **/
 		void zomgSave(_Zomg_PsgSave_t *state);
 		void zomgRestore(const _Zomg_PsgSave_t *state);
@@ -0,0 +1,360 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Psg_blep.cpp: TI SN76489 (PSG) emulator.                                *
+ * Band-limited step synthesis.                                            *
+ *                                                                         *
+ * Copyright (c) 1999-2002 by Stéphane Dallongeville                       *
+ * Copyright (c) 2003-2004 by Stéphane Akhoun                              *
+ * Copyright (c) 2008-2016 by David Korth                                  *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "Psg.hpp"
+#include "Psg_p.hpp"
+
+// C includes.
+#include <math.h>
+#include <string.h>
+
+// CPU flags.
+#include "libcompat/cpuflags.h"
+
+#ifdef PSG_HAS_SSE2
+// SSE2 intrinsics.
+#include <emmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace LibGens {
+
+/**
+ * The legacy update() function outputs each channel's level
+ * for each sample, so any transition that falls between two
+ * samples is rounded to the next sample. High-pitched tones
+ * alias badly as a result.
+ *
+ * update_blep() calculates the exact time of each transition
+ * from the channel's counter, and adds a band-limited step
+ * at that time to a delta buffer. Nothing is done for samples
+ * without a transition. The delta buffer is then integrated
+ * into the audio buffers.
+ *
+ * Away from transitions, the output is identical to update(),
+ * delayed by BLEP_WIDTH / 2 samples.
+ */
+
+// Step kernel.
+int PsgPrivate::BLEP_TAB[PsgPrivate::BLEP_PHASES][PsgPrivate::BLEP_WIDTH];
+
+/**
+ * Zeroth-order modified Bessel function of the first kind.
+ * Used to calculate the Kaiser window.
+ * @param x Argument.
+ * @return I0(x)
+ */
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	const double xx = x * x / 4.0;
+	for (int k = 1; k < 32; k++) {
+		term *= xx / ((double)k * (double)k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * Initialize the static tables.
+ */
+void PsgPrivate::doStaticInit(void)
+{
+	// The step is the integral of a Kaiser-windowed sinc
+	// lowpass filter that spans BLEP_WIDTH samples.
+	// Cutoff is 90% of the Nyquist frequency.
+	static const double CUTOFF = 0.9;
+	static const double KAISER_BETA = 6.0;
+	static const int SUBSTEPS = 64;		// Integration steps per sample.
+	static const int HALF = BLEP_WIDTH / 2;
+
+	// Integrate the filter at (BLEP_PHASES * SUBSTEPS) points per sample.
+	// step[x] is the step's value at time (x / RES) - HALF.
+	static const int RES = BLEP_PHASES * SUBSTEPS;
+	static const int LEN = (BLEP_WIDTH + 1) * RES;
+	double *const step = new double[LEN + 1];
+	const double i0_beta = bessel_i0(KAISER_BETA);
+	double sum = 0.0;
+	step[0] = 0.0;
+	for (int x = 0; x < LEN; x++) {
+		// Midpoint of this integration step.
+		const double t = ((double)x + 0.5) / (double)RES - (double)HALF;
+		const double u = t / (double)HALF;
+		double h = 0.0;
+		if (u > -1.0 && u < 1.0) {
+			const double a = M_PI * CUTOFF * t;
+			const double sinc = (t == 0.0 ? 1.0 : sin(a) / a);
+			h = sinc * bessel_i0(KAISER_BETA * sqrt(1.0 - u * u)) / i0_beta;
+		}
+		sum += h;
+		step[x + 1] = sum;
+	}
+
+	// Calculate the kernel for each phase.
+	// A step at (pos + phase / BLEP_PHASES) adds BLEP_TAB[phase][m]
+	// to sample (pos + 1 + m).
+	for (int phase = 0; phase < BLEP_PHASES; phase++) {
+		int *const k = BLEP_TAB[phase];
+		int total = 0;
+		int peak = 0;
+		for (int m = 0; m < BLEP_WIDTH; m++) {
+			// Sample (pos + 1 + m) is at time (m + 1 - phase / BLEP_PHASES)
+			// relative to the step, or (m + 1 - phase / BLEP_PHASES - HALF)
+			// relative to the center of the kernel.
+			const int x1 = ((m + 1) * BLEP_PHASES - phase) * SUBSTEPS;
+			const int x0 = x1 - RES;
+			const double v0 = (x0 > 0 ? step[x0] : 0.0);
+			const double v1 = (x1 < LEN ? step[x1] : sum);
+			k[m] = (int)lrint((v1 - v0) / sum * (double)(1 << BLEP_SHIFT));
+			total += k[m];
+			if (k[m] > k[peak])
+				peak = m;
+		}
+
+		// Make sure the step is exact once it settles.
+		k[peak] += (1 << BLEP_SHIFT) - total;
+	}
+
+	delete[] step;
+}
+
+/**
+ * Clear the band-limited step state.
+ */
+void PsgPrivate::resetBlep(void)
+{
+	memset(blepLevel, 0, sizeof(blepLevel));
+	blepAcc = 0;
+	memset(blepDelta, 0, sizeof(blepDelta));
+}
+
+/**
+ * Update the PSG audio output using band-limited steps.
+ * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
+ * @param length Length to write.
+ */
+void PsgPrivate::update_blep(int32_t *buf, int length)
+{
+	while (length > 0) {
+		const int len = (length > BLEP_BUF_LEN ? BLEP_BUF_LEN : length);
+		update_blep_pass(buf, len);
+		buf += (len * 2);
+		length -= len;
+	}
+}
+
+/**
+ * Update the PSG audio output using band-limited steps.
+ * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
+ * @param length Length to write. (no more than BLEP_BUF_LEN)
+ */
+void PsgPrivate::update_blep_pass(int32_t *buf, int length)
+{
+	// NOTE: The counter timing and LFSR shifts are the same as update(),
+	// so switching between the two doesn't change the PSG state.
+
+	// Channels 0-2: Tone.
+	// update() outputs the channel's volume for sample i if bit 16 of
+	// (counter + ((i+1) * step)) is set. Bit 16 toggles each time the
+	// low 16 bits overflow.
+	for (int j = 0; j < 3; j++) {
+		const int vol = volume[j];
+		const unsigned int step = cntStep[j];
+		const unsigned int cnt = counter[j];
+
+		if (step >= 0x10000) {
+			// Tone is not audible. update() applies a +1 tone.
+			if (blepLevel[j] != vol) {
+				addStep(0, 0, vol - blepLevel[j]);
+				blepLevel[j] = vol;
+			}
+		} else {
+			// Volume changes take effect at the start of the update.
+			const int level = ((cnt & 0x10000) ? vol : 0);
+			if (blepLevel[j] != level) {
+				addStep(0, 0, level - blepLevel[j]);
+				blepLevel[j] = level;
+			}
+
+			if (vol != 0 && step != 0) {
+				// Add a step for each overflow.
+				// Overflow at pos affects sample ((pos / step) - 1) onwards.
+				const unsigned int total = step * (unsigned int)length;
+				for (unsigned int pos = 0x10000 - (cnt & 0xFFFF);
+				     pos <= total; pos += 0x10000)
+				{
+					const int q = (int)(pos / step);
+					const int phase = (int)(((pos % step) * BLEP_PHASES) / step);
+					const int delta = (blepLevel[j] != 0 ? -vol : vol);
+					addStep(q - 1, phase, delta);
+					blepLevel[j] += delta;
+				}
+			}
+		}
+
+		counter[j] = cnt + (step * length);
+	}
+
+	// Channel 3: Noise.
+	// update() outputs the channel's volume for sample i if bit 0 of
+	// the LFSR is set, then shifts the LFSR if bit 16 of the counter
+	// is set, and clears the counter's upper bits.
+	const int vol = volume[3];
+	{
+		const int level = ((lfsr & 1) ? vol : 0);
+		if (blepLevel[3] != level) {
+			addStep(0, 0, level - blepLevel[3]);
+			blepLevel[3] = level;
+		}
+	}
+
+	const unsigned int step = cntStep[3];
+	if (vol != 0 && step != 0) {
+		// The first sample is handled separately, since the counter
+		// may have leftover upper bits if the volume was zero.
+		// After that, bit 16 is only set by an overflow.
+		unsigned int cnt = counter[3] + step;
+		if (cnt & 0x10000) {
+			// The LFSR is shifted after the first sample.
+			lfsr = LFSR16_Shift(lfsr, lfsrMask);
+			const int level = ((lfsr & 1) ? vol : 0);
+			if (blepLevel[3] != level) {
+				addStep(1, 0, level - blepLevel[3]);
+				blepLevel[3] = level;
+			}
+		}
+		cnt &= 0xFFFF;
+		int i = 1;	// Samples processed so far.
+
+		// Add a step for each LFSR shift that changes the output.
+		// An overflow at pos affects sample (pos / step) onwards.
+		while (i < length) {
+			const unsigned int remaining = 0x10000 - (cnt & 0xFFFF);
+			const unsigned int q = remaining / step;
+			const unsigned int r = remaining % step;
+			const int inc = (int)q + (r != 0);
+			if (i + inc > length) {
+				// No more overflows in this update.
+				cnt += step * (unsigned int)(length - i);
+				break;
+			}
+
+			lfsr = LFSR16_Shift(lfsr, lfsrMask);
+			const int level = ((lfsr & 1) ? vol : 0);
+			if (blepLevel[3] != level) {
+				const int phase = (int)((r * BLEP_PHASES) / step);
+				addStep(i + (int)q, phase, level - blepLevel[3]);
+				blepLevel[3] = level;
+			}
+			cnt = (cnt + (step * inc)) & 0xFFFF;
+			i += inc;
+		}
+
+		counter[3] = cnt;
+	} else {
+		// Current channel's volume is zero.
+		// Simply increase the channel's counter.
+		counter[3] += (step * length);
+	}
+
+	// Integrate the delta buffer into the audio buffers.
+#ifdef PSG_HAS_SSE2
+	if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+		integrate_SSE2(buf, blepDelta, &blepAcc, length);
+	} else
+#endif /* PSG_HAS_SSE2 */
+	{
+		integrate_noasm(buf, blepDelta, &blepAcc, length);
+	}
+
+	// Carry the end of the delta buffer over to the next pass.
+	memmove(&blepDelta[0], &blepDelta[length], (BLEP_WIDTH * 2) * sizeof(blepDelta[0]));
+	memset(&blepDelta[BLEP_WIDTH * 2], 0, length * sizeof(blepDelta[0]));
+}
+
+/**
+ * Integrate the delta buffer into the audio buffers.
+ * @param buf Interleaved stereo audio buffer.
+ * @param delta Delta buffer.
+ * @param acc Integrator.
+ * @param length Number of samples.
+ */
+void PsgPrivate::integrate_noasm(int32_t *buf, const int32_t *delta,
+				 int32_t *acc, int length)
+{
+	int32_t sum = *acc;
+	for (int i = 0; i < length; i++) {
+		sum += delta[i];
+		const int32_t out = (sum >> BLEP_SHIFT);
+		buf[i*2] += out;
+		buf[i*2+1] += out;
+	}
+	*acc = sum;
+}
+
+#ifdef PSG_HAS_SSE2
+/**
+ * Integrate the delta buffer into the audio buffers. (SSE2)
+ * @param buf Interleaved stereo audio buffer.
+ * @param delta Delta buffer.
+ * @param acc Integrator.
+ * @param length Number of samples.
+ */
+void PsgPrivate::integrate_SSE2(int32_t *buf, const int32_t *delta,
+				int32_t *acc, int length)
+{
+	// The audio buffer is at arbitrary line offsets,
+	// so unaligned loads and stores are used.
+	__m128i sum = _mm_set1_epi32(*acc);
+	int i = 0;
+	for (; i + 4 <= length; i += 4) {
+		// Prefix sum of four deltas.
+		__m128i x = _mm_loadu_si128((const __m128i*)&delta[i]);
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi32(x, sum);
+		sum = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+
+		// PSG output is mono, so each sample is duplicated.
+		const __m128i out = _mm_srai_epi32(x, BLEP_SHIFT);
+		__m128i *const lo = (__m128i*)&buf[i*2];
+		__m128i *const hi = (__m128i*)&buf[i*2+4];
+		_mm_storeu_si128(lo, _mm_add_epi32(_mm_loadu_si128(lo), _mm_unpacklo_epi32(out, out)));
+		_mm_storeu_si128(hi, _mm_add_epi32(_mm_loadu_si128(hi), _mm_unpackhi_epi32(out, out)));
+	}
+
+	// Remaining samples.
+	*acc = _mm_cvtsi128_si32(sum);
+	if (i < length) {
+		integrate_noasm(&buf[i*2], &delta[i], acc, length - i);
+	}
+}
+#endif /* PSG_HAS_SSE2 */
+
+}
@@ -30,6 +30,13 @@
 // ZOMG
 #include "libzomg/zomg_psg.h"
 
+// NOTE: The SSE2 integrator uses intrinsics with the target
+// attribute, so i386 builds don't need to use -msse2.
+#if defined(__GNUC__) && \
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+#define PSG_HAS_SSE2 1
+#endif
+
 namespace LibGens {
 
 // TODO: Needs more optimization.
@@ -48,7 +55,14 @@ class PsgPrivate
 		PsgPrivate &operator=(const PsgPrivate &);
 
 	public:
-		void update(int32_t *bufL, int32_t *bufR, int length);
+		void update(int32_t *buf, int length);
+
+		/**
+		 * Update the PSG audio output using band-limited steps.
+		 * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
+		 * @param length Length to write.
+		 */
+		void update_blep(int32_t *buf, int length);
 
 		// Initial PSG state.
 		static const Zomg_PsgSave_t psgStateInit;
@@ -117,10 +131,65 @@ class PsgPrivate
 		int writeLen;
 		bool enabled;
 
-		// PSG buffer pointers.
-		// TODO: Figure out how to get rid of these!
-		int32_t *bufPtrL;
-		int32_t *bufPtrR;
+		/** Band-limited step synthesis. **/
+
+		// Each channel's transitions are recorded as band-limited
+		// steps in a delta buffer, which is then integrated into
+		// the audio buffers. Output is delayed by BLEP_WIDTH / 2
+		// samples, since each step is centered in its kernel.
+		bool bandLimited;
+
+		// Step kernel: BLEP_PHASES fractional positions,
+		// BLEP_WIDTH samples each. Each phase sums to
+		// (1 << BLEP_SHIFT), so a settled step is exact.
+		static const int BLEP_PHASES = 32;
+		static const int BLEP_WIDTH = 16;
+		static const int BLEP_SHIFT = 15;
+		static int BLEP_TAB[BLEP_PHASES][BLEP_WIDTH];
+		static void doStaticInit(void);
+
+		// Maximum number of samples per update_blep() pass.
+		// Longer updates are split.
+		static const int BLEP_BUF_LEN = 2048;
+
+		int blepLevel[4];	// Current level of each channel.
+		int32_t blepAcc;	// Integrator.
+		// Delta buffer. Index 0 is the start of the current pass.
+		// The last (BLEP_WIDTH * 2) entries carry over to the next pass.
+		int32_t blepDelta[BLEP_BUF_LEN + (BLEP_WIDTH * 2)];
+
+		/**
+		 * Clear the band-limited step state.
+		 */
+		void resetBlep(void);
+
+		/**
+		 * Add a band-limited step to the delta buffer.
+		 * @param pos Sample position. (-1 or higher)
+		 * @param phase Fractional position. [0, BLEP_PHASES)
+		 * @param delta Step size.
+		 */
+		inline void addStep(int pos, int phase, int delta)
+		{
+			int32_t *const dest = &blepDelta[pos + 1];
+			const int *const k = BLEP_TAB[phase];
+			for (int m = 0; m < BLEP_WIDTH; m++) {
+				dest[m] += delta * k[m];
+			}
+		}
+
+		void update_blep_pass(int32_t *buf, int length);
+		static void integrate_noasm(int32_t *buf, const int32_t *delta,
+					    int32_t *acc, int length);
+#ifdef PSG_HAS_SSE2
+		__attribute__((target("sse2")))
+		static void integrate_SSE2(int32_t *buf, const int32_t *delta,
+					   int32_t *acc, int length);
+#endif /* PSG_HAS_SSE2 */
+
+		// PSG buffer pointer. (interleaved stereo)
+		// TODO: Figure out how to get rid of this!
+		int32_t *bufPtr;
 };
 
 }
@@ -0,0 +1,445 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Resampler.cpp: Polyphase audio resampler.                               *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth                                       *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "Resampler.hpp"
+
+// C includes.
+#include <math.h>
+#include <string.h>
+
+// aligned_malloc()
+#include "libcompat/aligned_malloc.h"
+
+// CPU flags.
+#include "libcompat/cpuflags.h"
+
+#ifdef RESAMPLER_HAS_SSE2
+// SSE2 and AVX intrinsics.
+// The functions that use them are compiled with the target
+// attribute, so the rest of libgens doesn't need -msse2 or -mavx.
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace LibGens {
+
+// Kaiser window beta. (about -50 dB stopband)
+static const double KAISER_BETA = 5.0;
+
+// Cutoff frequency, relative to the lower of the two Nyquist frequencies.
+// With 32 taps, the transition band ends just below Nyquist.
+static const double CUTOFF = 0.9;
+
+// Short filter. (about -40 dB stopband)
+// At 48 kHz output, the passband is flat to about 16 kHz,
+// and the transition band ends just below Nyquist.
+static const double SHORT_KAISER_BETA = 4.0;
+static const double SHORT_CUTOFF = 0.8;
+
+/**
+ * Zeroth-order modified Bessel function of the first kind.
+ * Used to calculate the Kaiser window.
+ * @param x Argument.
+ * @return I0(x)
+ */
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	const double xx = x * x / 4.0;
+	for (int k = 1; k < 32; k++) {
+		term *= xx / ((double)k * (double)k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * Greatest common divisor.
+ * @param a First number.
+ * @param b Second number.
+ * @return gcd(a, b)
+ */
+static int gcd(int a, int b)
+{
+	while (b != 0) {
+		const int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+Resampler::Resampler()
+	: m_inLen(0)
+	, m_outLen(0)
+	, m_taps(TAPS)
+	, m_coeffs(nullptr)
+	, m_phases(0)
+	, m_histPos(nullptr)
+	, m_coeffPos(nullptr)
+	, m_histL(nullptr)
+	, m_histR(nullptr)
+	, m_histSilent(true)
+{ }
+
+Resampler::~Resampler()
+{
+	aligned_free(m_coeffs);
+	aligned_free(m_histPos);
+	aligned_free(m_coeffPos);
+	aligned_free(m_histL);
+	aligned_free(m_histR);
+}
+
+/**
+ * Set the segment lengths.
+ * This recalculates the filter and clears the history.
+ * @param inLen Input segment length.
+ * @param outLen Output segment length.
+ */
+void Resampler::setLengths(int inLen, int outLen)
+{
+	if (inLen == m_inLen && outLen == m_outLen) {
+		reset();
+		return;
+	}
+
+	aligned_free(m_coeffs);
+	aligned_free(m_histPos);
+	aligned_free(m_coeffPos);
+	aligned_free(m_histL);
+	aligned_free(m_histR);
+	m_coeffs = nullptr;
+	m_histPos = nullptr;
+	m_coeffPos = nullptr;
+	m_histL = nullptr;
+	m_histR = nullptr;
+
+	m_inLen = inLen;
+	m_outLen = outLen;
+	if (inLen <= 0 || outLen <= 0) {
+		m_inLen = 0;
+		m_outLen = 0;
+		m_phases = 0;
+		return;
+	}
+
+	const int phaseDiv = gcd(inLen, outLen);
+	m_phases = outLen / phaseDiv;
+
+	// Use the short filter if downsampling to at least 7/8 of the input rate.
+	const bool isShort = (outLen < inLen && outLen * 8 >= inLen * 7);
+	const int taps = (isShort ? SHORT_TAPS : TAPS);
+	const double beta = (isShort ? SHORT_KAISER_BETA : KAISER_BETA);
+	m_taps = taps;
+
+	// NOTE: Each phase is 32-byte aligned for AVX.
+	m_coeffs = (float*)aligned_malloc(32, m_phases * taps * sizeof(float));
+	m_histL = (float*)aligned_malloc(16, (taps + inLen) * sizeof(float));
+	m_histR = (float*)aligned_malloc(16, (taps + inLen) * sizeof(float));
+	m_histPos = (int*)aligned_malloc(16, outLen * sizeof(int));
+	m_coeffPos = (int*)aligned_malloc(16, outLen * sizeof(int));
+
+	// Calculate the filter positions.
+	// Each output sample advances the input by inLen / outLen samples.
+	const int step_n = inLen / outLen;
+	const int step_p = (inLen % outLen) / phaseDiv;
+	int n = 0, phase = 0;
+	for (int j = 0; j < outLen; j++) {
+		m_histPos[j] = n + 1;
+		m_coeffPos[j] = phase * taps;
+		phase += step_p;
+		if (phase >= m_phases) {
+			phase -= m_phases;
+			n++;
+		}
+		n += step_n;
+	}
+
+	// Cutoff frequency, relative to the input Nyquist frequency.
+	double fc = (isShort ? SHORT_CUTOFF : CUTOFF);
+	if (outLen < inLen)
+		fc *= (double)outLen / (double)inLen;
+
+	// Calculate the filter phases.
+	// Tap k of phase p is applied to the input sample that's
+	// (k - taps/2 + 1 - p/m_phases) samples from the output sample.
+	const double i0_beta = bessel_i0(beta);
+	for (int p = 0; p < m_phases; p++) {
+		const double frac = (double)p / (double)m_phases;
+		float *const c = &m_coeffs[p * taps];
+		double h[TAPS];
+		double sum = 0.0;
+		for (int k = 0; k < taps; k++) {
+			const double x = (double)(k - taps/2 + 1) - frac;
+			const double u = x / (double)(taps/2);
+			if (u <= -1.0 || u >= 1.0) {
+				h[k] = 0.0;
+				continue;
+			}
+
+			const double t = M_PI * fc * x;
+			const double sinc = (x == 0.0 ? 1.0 : sin(t) / t);
+			const double window = bessel_i0(beta * sqrt(1.0 - u * u)) / i0_beta;
+			h[k] = sinc * window;
+			sum += h[k];
+		}
+
+		// Normalize for unity gain at DC.
+		for (int k = 0; k < taps; k++) {
+			c[k] = (float)(h[k] / sum);
+		}
+	}
+
+	reset();
+}
+
+/**
+ * Clear the history.
+ */
+void Resampler::reset(void)
+{
+	m_histSilent = true;
+	if (!m_histL)
+		return;
+	memset(m_histL, 0, (m_taps + m_inLen) * sizeof(float));
+	memset(m_histR, 0, (m_taps + m_inLen) * sizeof(float));
+}
+
+/**
+ * Check if a stereo segment is silent.
+ * @param buf Stereo buffer.
+ * @param len Number of samples.
+ * @return True if all samples are 0.
+ */
+bool Resampler::isSilent(const int32_t *buf, int len)
+{
+	// NOTE: Most segments aren't silent,
+	// so this usually returns right away.
+	for (int i = 0; i < len * 2; i++) {
+		if (buf[i] != 0)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Resample an interleaved stereo segment in place.
+ * @param buf Stereo buffer. (inLen samples on input; outLen samples on output)
+ */
+void Resampler::process(int32_t *buf)
+{
+	if (!m_coeffs)
+		return;
+
+	// If both the history and the input are silent, the output
+	// is silent, and the history doesn't change. Only the output
+	// samples past the end of the input need to be cleared.
+	const bool silent = isSilent(buf, m_inLen);
+	if (silent && m_histSilent) {
+		if (m_outLen > m_inLen) {
+			memset(&buf[m_inLen * 2], 0, (m_outLen - m_inLen) * 2 * sizeof(buf[0]));
+		}
+		return;
+	}
+	// The end of the input is the next segment's history.
+	m_histSilent = (silent && m_inLen >= m_taps);
+
+#ifdef RESAMPLER_HAS_SSE2
+	if (CPU_Flags & MDP_CPUFLAG_X86_AVX) {
+		process_AVX(buf);
+		return;
+	} else if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+		process_SSE2(buf);
+		return;
+	}
+#endif /* RESAMPLER_HAS_SSE2 */
+
+	process_noasm(buf);
+}
+
+/**
+ * Resample a stereo segment.
+ * Both channels use the same filter phase, so they're
+ * processed together to share the coefficient loads.
+ * @param buf Stereo buffer.
+ */
+void Resampler::process_noasm(int32_t *buf) const
+{
+	// Convert the input to float.
+	float *const inL = &m_histL[m_taps];
+	float *const inR = &m_histR[m_taps];
+	for (int i = 0; i < m_inLen; i++) {
+		inL[i] = (float)buf[i*2];
+		inR[i] = (float)buf[i*2+1];
+	}
+
+	// NOTE: The sum is calculated in the same order as process_SSE2(),
+	// so both functions return the same results.
+	for (int j = 0; j < m_outLen; j++) {
+		const float *const c = &m_coeffs[m_coeffPos[j]];
+		const float *const xL = &m_histL[m_histPos[j]];
+		const float *const xR = &m_histR[m_histPos[j]];
+
+		float accL[8], accR[8];
+		for (int l = 0; l < 8; l++) {
+			accL[l] = c[l] * xL[l];
+			accR[l] = c[l] * xR[l];
+		}
+		for (int k = 8; k < m_taps; k += 8) {
+			for (int l = 0; l < 8; l++) {
+				accL[l] += c[k + l] * xL[k + l];
+				accR[l] += c[k + l] * xR[k + l];
+			}
+		}
+
+		float sumL[4], sumR[4];
+		for (int l = 0; l < 4; l++) {
+			sumL[l] = accL[l] + accL[l + 4];
+			sumR[l] = accR[l] + accR[l + 4];
+		}
+		buf[j*2] = (int32_t)lrintf((sumL[0] + sumL[2]) + (sumL[1] + sumL[3]));
+		buf[j*2+1] = (int32_t)lrintf((sumR[0] + sumR[2]) + (sumR[1] + sumR[3]));
+	}
+
+	// Save the end of the segment for the next segment.
+	memmove(m_histL, &m_histL[m_inLen], m_taps * sizeof(float));
+	memmove(m_histR, &m_histR[m_inLen], m_taps * sizeof(float));
+}
+
+#ifdef RESAMPLER_HAS_SSE2
+/**
+ * Convert a stereo segment to float. (SSE2)
+ * @param inL Left input history buffer, starting at the current segment.
+ * @param inR Right input history buffer, starting at the current segment.
+ * @param buf Stereo buffer.
+ * @param len Number of samples.
+ */
+static __attribute__((target("sse2")))
+inline void cvt_to_float_SSE2(float *inL, float *inR, const int32_t *buf, int len)
+{
+	int i = 0;
+	for (; i + 4 <= len; i += 4) {
+		const __m128 s0 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&buf[i*2]));
+		const __m128 s1 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&buf[i*2+4]));
+		_mm_store_ps(&inL[i], _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_store_ps(&inR[i], _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	for (; i < len; i++) {
+		inL[i] = (float)buf[i*2];
+		inR[i] = (float)buf[i*2+1];
+	}
+}
+
+/**
+ * Resample a stereo segment. (SSE2)
+ * Both channels use the same filter phase, so they're
+ * processed together to share the coefficient loads.
+ * @param buf Stereo buffer.
+ */
+void Resampler::process_SSE2(int32_t *buf) const
+{
+	// Convert the input to float.
+	cvt_to_float_SSE2(&m_histL[m_taps], &m_histR[m_taps], buf, m_inLen);
+
+	for (int j = 0; j < m_outLen; j++) {
+		const float *const c = &m_coeffs[m_coeffPos[j]];
+		const float *const xL = &m_histL[m_histPos[j]];
+		const float *const xR = &m_histR[m_histPos[j]];
+
+		__m128 c0 = _mm_load_ps(&c[0]);
+		__m128 c1 = _mm_load_ps(&c[4]);
+		__m128 accL0 = _mm_mul_ps(c0, _mm_loadu_ps(&xL[0]));
+		__m128 accL1 = _mm_mul_ps(c1, _mm_loadu_ps(&xL[4]));
+		__m128 accR0 = _mm_mul_ps(c0, _mm_loadu_ps(&xR[0]));
+		__m128 accR1 = _mm_mul_ps(c1, _mm_loadu_ps(&xR[4]));
+		for (int k = 8; k < m_taps; k += 8) {
+			c0 = _mm_load_ps(&c[k]);
+			c1 = _mm_load_ps(&c[k+4]);
+			accL0 = _mm_add_ps(accL0, _mm_mul_ps(c0, _mm_loadu_ps(&xL[k])));
+			accL1 = _mm_add_ps(accL1, _mm_mul_ps(c1, _mm_loadu_ps(&xL[k+4])));
+			accR0 = _mm_add_ps(accR0, _mm_mul_ps(c0, _mm_loadu_ps(&xR[k])));
+			accR1 = _mm_add_ps(accR1, _mm_mul_ps(c1, _mm_loadu_ps(&xR[k+4])));
+		}
+
+		// Horizontal sums: (s0 + s2) + (s1 + s3)
+		const __m128 sumL = _mm_add_ps(accL0, accL1);	// [L3 | L2 | L1 | L0]
+		const __m128 sumR = _mm_add_ps(accR0, accR1);	// [R3 | R2 | R1 | R0]
+		__m128 sum = _mm_add_ps(_mm_unpacklo_ps(sumL, sumR),
+					_mm_unpackhi_ps(sumL, sumR));	// [R1+R3 | L1+L3 | R0+R2 | L0+L2]
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));		// [ ... | ... | R | L ]
+		_mm_storel_epi64((__m128i*)&buf[j*2], _mm_cvtps_epi32(sum));
+	}
+
+	// Save the end of the segment for the next segment.
+	memmove(m_histL, &m_histL[m_inLen], m_taps * sizeof(float));
+	memmove(m_histR, &m_histR[m_inLen], m_taps * sizeof(float));
+}
+
+/**
+ * Resample a stereo segment. (AVX)
+ * Each 8-float accumulator holds the same partial sums as the
+ * two 4-float accumulators in process_SSE2(), so the results
+ * are identical.
+ * @param buf Stereo buffer.
+ */
+void Resampler::process_AVX(int32_t *buf) const
+{
+	// Convert the input to float.
+	cvt_to_float_SSE2(&m_histL[m_taps], &m_histR[m_taps], buf, m_inLen);
+
+	for (int j = 0; j < m_outLen; j++) {
+		const float *const c = &m_coeffs[m_coeffPos[j]];
+		const float *const xL = &m_histL[m_histPos[j]];
+		const float *const xR = &m_histR[m_histPos[j]];
+
+		__m256 c0 = _mm256_load_ps(&c[0]);
+		__m256 accL = _mm256_mul_ps(c0, _mm256_loadu_ps(&xL[0]));
+		__m256 accR = _mm256_mul_ps(c0, _mm256_loadu_ps(&xR[0]));
+		for (int k = 8; k < m_taps; k += 8) {
+			c0 = _mm256_load_ps(&c[k]);
+			accL = _mm256_add_ps(accL, _mm256_mul_ps(c0, _mm256_loadu_ps(&xL[k])));
+			accR = _mm256_add_ps(accR, _mm256_mul_ps(c0, _mm256_loadu_ps(&xR[k])));
+		}
+
+		// Horizontal sums: (s0 + s2) + (s1 + s3)
+		const __m128 sumL = _mm_add_ps(_mm256_castps256_ps128(accL),
+					       _mm256_extractf128_ps(accL, 1));
+		const __m128 sumR = _mm_add_ps(_mm256_castps256_ps128(accR),
+					       _mm256_extractf128_ps(accR, 1));
+		__m128 sum = _mm_add_ps(_mm_unpacklo_ps(sumL, sumR),
+					_mm_unpackhi_ps(sumL, sumR));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		_mm_storel_epi64((__m128i*)&buf[j*2], _mm_cvtps_epi32(sum));
+	}
+
+	// Save the end of the segment for the next segment.
+	memmove(m_histL, &m_histL[m_inLen], m_taps * sizeof(float));
+	memmove(m_histR, &m_histR[m_inLen], m_taps * sizeof(float));
+}
+#endif /* RESAMPLER_HAS_SSE2 */
+
+}
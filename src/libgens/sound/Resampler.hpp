@@ -0,0 +1,155 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Resampler.hpp: Polyphase audio resampler.                               *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth                                       *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __LIBGENS_SOUND_RESAMPLER_HPP__
+#define __LIBGENS_SOUND_RESAMPLER_HPP__
+
+#include <stdint.h>
+
+// NOTE: The SSE2 and AVX resamplers use intrinsics with the
+// target attribute, so i386 builds don't need to use -msse2.
+#if defined(__GNUC__) && \
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+#define RESAMPLER_HAS_SSE2 1
+#endif
+
+namespace LibGens {
+
+/**
+ * Resampler: Polyphase audio resampler.
+ *
+ * Converts segments of inLen samples to segments of outLen samples.
+ * Since the ratio is rational, each output sample uses one of
+ * outLen / gcd(inLen, outLen) precalculated filter phases.
+ *
+ * The filter is a Kaiser-windowed sinc with taps() taps.
+ * Output is delayed by taps() / 2 input samples, since the filter
+ * needs input samples from the next segment.
+ *
+ * When downsampling to at least 7/8 of the input rate, anything
+ * above the output Nyquist frequency aliases to above ~20 kHz,
+ * so a shorter filter (SHORT_TAPS) is enough. Otherwise, the
+ * full filter (TAPS) is used.
+ *
+ * Silent segments are skipped if the history is also silent.
+ */
+class Resampler
+{
+	public:
+		Resampler();
+		~Resampler();
+
+	private:
+		// Q_DISABLE_COPY() equivalent.
+		// TODO: Add LibGens-specific version of Q_DISABLE_COPY().
+		Resampler(const Resampler &);
+		Resampler &operator=(const Resampler &);
+
+	public:
+		// Number of filter taps.
+		// Must be a multiple of 8. (SSE2)
+		static const int TAPS = 32;
+		static const int SHORT_TAPS = 16;
+
+		/**
+		 * Set the segment lengths.
+		 * This recalculates the filter and clears the history.
+		 * @param inLen Input segment length.
+		 * @param outLen Output segment length.
+		 */
+		void setLengths(int inLen, int outLen);
+
+		inline int inLen(void) const
+			{ return m_inLen; }
+		inline int outLen(void) const
+			{ return m_outLen; }
+		inline int taps(void) const
+			{ return m_taps; }
+
+		/**
+		 * Clear the history.
+		 */
+		void reset(void);
+
+		/**
+		 * Resample an interleaved stereo segment in place.
+		 * @param buf Stereo buffer. (inLen samples on input; outLen samples on output)
+		 */
+		void process(int32_t *buf);
+
+	private:
+		/**
+		 * Check if a stereo segment is silent.
+		 * @param buf Stereo buffer.
+		 * @param len Number of samples.
+		 * @return True if all samples are 0.
+		 */
+		static bool isSilent(const int32_t *buf, int len);
+
+		/**
+		 * Resample a stereo segment.
+		 * @param buf Stereo buffer.
+		 */
+		void process_noasm(int32_t *buf) const;
+
+#ifdef RESAMPLER_HAS_SSE2
+		/**
+		 * Resample a stereo segment. (SSE2)
+		 * @param buf Stereo buffer.
+		 */
+		__attribute__((target("sse2")))
+		void process_SSE2(int32_t *buf) const;
+
+		/**
+		 * Resample a stereo segment. (AVX)
+		 * @param buf Stereo buffer.
+		 */
+		__attribute__((target("avx")))
+		void process_AVX(int32_t *buf) const;
+#endif /* RESAMPLER_HAS_SSE2 */
+
+		int m_inLen;
+		int m_outLen;
+		int m_taps;		// TAPS or SHORT_TAPS
+
+		// Filter phases. [m_phases][m_taps]
+		float *m_coeffs;
+		int m_phases;
+
+		// Filter position for each output sample. [m_outLen]
+		// The phase wraps around irregularly, so the positions
+		// are precalculated instead of stepped in the inner loop.
+		int *m_histPos;		// Index of the first input sample in m_histL/m_histR.
+		int *m_coeffPos;	// Index of the filter phase in m_coeffs.
+
+		// Input history. [m_taps + inLen]
+		// The first m_taps samples are the end of the previous segment.
+		float *m_histL;
+		float *m_histR;
+
+		// If true, the history is all zero, so a silent
+		// segment can be skipped.
+		bool m_histSilent;
+};
+
+}
+
+#endif /* __LIBGENS_SOUND_RESAMPLER_HPP__ */
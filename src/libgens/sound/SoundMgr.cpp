@@ -48,8 +48,13 @@ namespace LibGens {
 /** SoundManagerPrivate **/
 
 // Audio settings.
-int SoundMgrPrivate::rate = 44100;
-bool SoundMgrPrivate::isPal = false;
+EMU_THREAD_LOCAL int SoundMgrPrivate::rate = 44100;
+EMU_THREAD_LOCAL bool SoundMgrPrivate::isPal = false;
+
+// Native-rate synthesis.
+EMU_THREAD_LOCAL bool SoundMgrPrivate::nativeRate = false;
+EMU_THREAD_LOCAL int SoundMgrPrivate::synthLength = 0;
+EMU_THREAD_LOCAL Resampler SoundMgrPrivate::resampler;
 
 /**
  * Calculate the segment length.
@@ -60,7 +65,6 @@ bool SoundMgrPrivate::isPal = false;
 int SoundMgrPrivate::CalcSegLength(int rate, bool isPal)
 {
 	if (rate > SoundMgr::MAX_SAMPLING_RATE) {
-		// TODO: Support higher rates than 48 kHz.
 		rate = SoundMgr::MAX_SAMPLING_RATE;
 	}
 
@@ -77,26 +81,41 @@ int SoundMgrPrivate::CalcSegLength(int rate, bool isPal)
 	}
 }
 
+/**
+ * Calculate the native-rate synthesis segment length.
+ * This is the YM2612's native rate divided by the frame rate,
+ * rounded up so the YM2612 doesn't need to interpolate.
+ * @param isPal If true, system is PAL.
+ * @return Synthesis segment length.
+ */
+int SoundMgrPrivate::CalcNativeLength(bool isPal)
+{
+	// The YM2612 outputs one sample every 144 YM clocks.
+	// NTSC: 53,267 Hz; 888 samples per frame.
+	// PAL:  52,781 Hz; 1,056 samples per frame.
+	const double ymClock = (isPal ? (double)CLOCK_PAL : (double)CLOCK_NTSC) / 7.0;
+	return (int)ceil(ymClock / 144.0 / (isPal ? 50.0 : 60.0));
+}
+
 /** SoundMgr **/
 
 // Segment buffer.
-// Stores up to 882 32-bit stereo samples.
+// Stores up to MAX_SEGMENT_SIZE 32-bit stereo samples, interleaved.
 // (32-bit instead of 16-bit to handle oversaturation properly.)
-// TODO: Convert to interleaved stereo.
+// Aligned for AVX2.
 // TODO: Make SoundMgr non-static and allocate this using aligned_malloc().
-int32_t ALIGN(16) SoundMgr::ms_SegBufL[MAX_SEGMENT_SIZE];
-int32_t ALIGN(16) SoundMgr::ms_SegBufR[MAX_SEGMENT_SIZE];
+EMU_THREAD_LOCAL int32_t ALIGN(32) SoundMgr::ms_SegBuf[MAX_SEGMENT_SIZE * 2];
 
 // Audio ICs.
-Psg SoundMgr::ms_Psg;
-Ym2612 SoundMgr::ms_Ym2612;
+EMU_THREAD_LOCAL Psg SoundMgr::ms_Psg;
+EMU_THREAD_LOCAL Ym2612 SoundMgr::ms_Ym2612;
 
 // Static variable initialization.
-int SoundMgr::ms_SegLength = 0;
+EMU_THREAD_LOCAL int SoundMgr::ms_SegLength = 0;
 
 // Line extrapolation values. [312 + extra room to prevent overflows]
 // Index 0 == start; Index 1 == length
-unsigned int SoundMgr::ms_Extrapol[312+8][2];
+EMU_THREAD_LOCAL unsigned int SoundMgr::ms_Extrapol[312+8][2];
 
 void SoundMgr::Init(void)
 {
@@ -122,11 +141,24 @@ void SoundMgr::ReInit(int rate, bool isPal, bool preserveState)
 	// Calculate the segment length.
 	ms_SegLength = SoundMgrPrivate::CalcSegLength(rate, isPal);
 
+	// In native-rate mode, the PSG and YM2612 run at a fixed rate,
+	// and the resampler converts each segment to the output rate.
+	int synthRate = rate;
+	if (SoundMgrPrivate::nativeRate) {
+		const int synthLength = SoundMgrPrivate::CalcNativeLength(isPal);
+		SoundMgrPrivate::synthLength = synthLength;
+		synthRate = synthLength * (isPal ? 50 : 60);
+		SoundMgrPrivate::resampler.setLengths(synthLength, ms_SegLength);
+	} else {
+		SoundMgrPrivate::synthLength = ms_SegLength;
+	}
+
 	// Build the sound extrapolation table.
+	const int synthLength = SoundMgrPrivate::synthLength;
 	const int lines = (isPal ? 312 : 262);
 	for (int i = 0; i < lines; i++) {
-		ms_Extrapol[i][0] = ((ms_SegLength * i) / lines);
-		ms_Extrapol[i][1] = (((ms_SegLength * (i+1)) / lines) - ms_Extrapol[i][0]);
+		ms_Extrapol[i][0] = ((synthLength * i) / lines);
+		ms_Extrapol[i][1] = (((synthLength * (i+1)) / lines) - ms_Extrapol[i][0]);
 	}
 	// Copy the last extrapolation value to 8 more lines.
 	// This may help at the end of the frame.
@@ -135,9 +167,8 @@ void SoundMgr::ReInit(int rate, bool isPal, bool preserveState)
 		ms_Extrapol[i][1] = ms_Extrapol[lines-1][1];
 	}
 
-	// Clear the segment buffers.
-	memset(ms_SegBufL, 0x00, sizeof(ms_SegBufL));
-	memset(ms_SegBufR, 0x00, sizeof(ms_SegBufR));
+	// Clear the segment buffer.
+	memset(ms_SegBuf, 0x00, sizeof(ms_SegBuf));
 
 	// If requested, save the PSG/YM state.
 	Zomg_PsgSave_t psgState;
@@ -149,11 +180,11 @@ void SoundMgr::ReInit(int rate, bool isPal, bool preserveState)
 
 	// Initialize the PSG and YM2612.
 	if (isPal) {
-		ms_Psg.reInit((int)((double)CLOCK_PAL / 15.0), rate);
-		ms_Ym2612.reInit((int)((double)CLOCK_PAL / 7.0), rate);
+		ms_Psg.reInit((int)((double)CLOCK_PAL / 15.0), synthRate);
+		ms_Ym2612.reInit((int)((double)CLOCK_PAL / 7.0), synthRate);
 	} else {
-		ms_Psg.reInit((int)((double)CLOCK_NTSC / 15.0), rate);
-		ms_Ym2612.reInit((int)((double)CLOCK_NTSC / 7.0), rate);
+		ms_Psg.reInit((int)((double)CLOCK_NTSC / 15.0), synthRate);
+		ms_Ym2612.reInit((int)((double)CLOCK_NTSC / 7.0), synthRate);
 	}
 
 	// If requested, restore the PSG/YM state.
@@ -175,4 +206,35 @@ void SoundMgr::SetRegion(bool isPal, bool preserveState)
 	ReInit(SoundMgrPrivate::rate, isPal, preserveState);
 }
 
+/**
+ * Run the specialUpdate() functions.
+ * Called at the end of every frame. In native-rate mode,
+ * this also resamples the segment to the output rate.
+ */
+void SoundMgr::SpecialUpdate(void)
+{
+	ms_Psg.specialUpdate();
+	ms_Ym2612.specialUpdate();
+
+	// NOTE: This is done here instead of in writeStereo() and
+	// writeMono() so the resampler history is kept up to date
+	// even if audio output is disabled.
+	SoundMgrPrivate::resample();
+}
+
+/** Native-rate synthesis. **/
+
+bool SoundMgr::IsNativeRate(void)
+{
+	return SoundMgrPrivate::nativeRate;
+}
+
+void SoundMgr::SetNativeRate(bool nativeRate, bool preserveState)
+{
+	if (SoundMgrPrivate::nativeRate == nativeRate)
+		return;
+	SoundMgrPrivate::nativeRate = nativeRate;
+	ReInit(SoundMgrPrivate::rate, SoundMgrPrivate::isPal, preserveState);
+}
+
 }
@@ -31,6 +31,9 @@
 // C includes. (C++ namespace)
 #include <cassert>
 
+// Thread-local storage for multi-context builds.
+#include "libgens/macros/tls.h"
+
 // Audio ICs.
 #include "../sound/Psg.hpp"
 #include "../sound/Ym2612.hpp"
@@ -47,6 +50,15 @@ class SoundMgr
 		static void SetRate(int rate, bool preserveState = true);
 		static void SetRegion(bool isPal, bool preserveState = true);
 
+		/**
+		 * Native-rate synthesis.
+		 * If enabled, the PSG and YM2612 run at a fixed internal rate
+		 * close to the YM2612's native rate (~53 kHz), and each segment
+		 * is resampled to the output rate by SpecialUpdate().
+		 */
+		static bool IsNativeRate(void);
+		static void SetNativeRate(bool nativeRate, bool preserveState = true);
+
 		static inline int GetSegLength(void);
 
 		// TODO: Bounds checking.
@@ -54,21 +66,20 @@ class SoundMgr
 		static inline int GetWriteLen(int line);
 
 		// Maximum sampling rate and segment size.
-		static const int MAX_SAMPLING_RATE = 48000;
-		static const int MAX_SEGMENT_SIZE = 960;	// ceil(MAX_SAMPLING_RATE / 50)
+		static const int MAX_SAMPLING_RATE = 96000;
+		static const int MAX_SEGMENT_SIZE = 1920;	// ceil(MAX_SAMPLING_RATE / 50)
 
 		// Segment buffer.
-		// Stores up to MAX_SEGMENT_SIZE 16-bit stereo samples.
+		// Stores up to MAX_SEGMENT_SIZE 16-bit stereo samples,
+		// interleaved as [L0, R0, L1, R1, ...].
 		// (Samples are actually 32-bit in order to handle oversaturation properly.)
 		// TODO: Call the write functions from SoundMgr so this doesn't need to be public.
-		// TODO: Convert to interleaved stereo.
-		static int32_t ms_SegBufL[MAX_SEGMENT_SIZE];
-		static int32_t ms_SegBufR[MAX_SEGMENT_SIZE];
+		static EMU_THREAD_LOCAL int32_t ms_SegBuf[MAX_SEGMENT_SIZE * 2];
 
 		// Audio ICs.
 		// TODO: Add wrapper functions?
-		static Psg ms_Psg;
-		static Ym2612 ms_Ym2612;
+		static EMU_THREAD_LOCAL Psg ms_Psg;
+		static EMU_THREAD_LOCAL Ym2612 ms_Ym2612;
 
 		/**
 		 * Reset buffer pointers and lengths.
@@ -83,12 +94,10 @@ class SoundMgr
 
 		/**
 		 * Run the specialUpdate() functions.
+		 * Called at the end of every frame. In native-rate mode,
+		 * this also resamples the segment to the output rate.
 		 */
-		static inline void SpecialUpdate(void)
-		{
-			ms_Psg.specialUpdate();
-			ms_Ym2612.specialUpdate();
-		}
+		static void SpecialUpdate(void);
 
 		/**
 		 * Write stereo audio to a buffer.
@@ -108,15 +117,24 @@ class SoundMgr
 		 */
 		static int writeMono(int16_t *dest, int samples);
 
+		/**
+		 * Clear the internal audio buffer without writing it.
+		 * Use this instead of writeStereo() / writeMono()
+		 * if audio output is disabled.
+		 */
+		static void clearBuffers(void);
+
 	protected:
 		// TODO: Move these into the private class.
 
 		// Segment length.
-		static int ms_SegLength;
+		// In native-rate mode, this is the output length;
+		// the PSG and YM2612 write SoundMgrPrivate::synthLength samples.
+		static EMU_THREAD_LOCAL int ms_SegLength;
 
 		// Line extrapolation values. [312 + extra room to prevent overflows]
 		// Index 0 == start; Index 1 == length
-		static unsigned int ms_Extrapol[312+8][2];
+		static EMU_THREAD_LOCAL unsigned int ms_Extrapol[312+8][2];
 
 	private:
 		SoundMgr() { }
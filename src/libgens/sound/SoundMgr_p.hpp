@@ -24,12 +24,30 @@
 #ifndef LIBGENS_SOUND_SOUNDMGR_P_HPP__
 #define LIBGENS_SOUND_SOUNDMGR_P_HPP__
 
-// NOTE: We're implementing the MMX and SSE2 code
-// using GNU inline assembler *only*.
-#if defined(__GNUC__) && \
-    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+// NOTE: The optimized write functions use intrinsics.
+// On gcc, they're compiled with the target attribute,
+// so i386 builds don't need to use -msse2 or -mavx2.
+// MSVC doesn't support MMX intrinsics on 64-bit.
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
+#define SOUNDMGR_HAS_SSE2 1
+#if defined(__GNUC__) || defined(_M_IX86)
 #define SOUNDMGR_HAS_MMX 1
 #endif
+#ifdef __GNUC__
+#define SOUNDMGR_TARGET(x) __attribute__((target(x)))
+#else
+#define SOUNDMGR_TARGET(x)
+#endif
+#endif
+
+// NEON is always available on 64-bit ARM.
+// On 32-bit ARM, it has to be enabled at compile time.
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SOUNDMGR_HAS_NEON 1
+#endif
+
+#include "Resampler.hpp"
 
 namespace LibGens {
 
@@ -50,16 +68,63 @@ class SoundMgrPrivate
 		// Segment length.
 		static int CalcSegLength(int rate, bool isPal);
 
-		static int rate;
-		static bool isPal;
+		static EMU_THREAD_LOCAL int rate;
+		static EMU_THREAD_LOCAL bool isPal;
+
+		// Native-rate synthesis.
+		// synthLength is the number of samples the PSG and YM2612
+		// write per frame. If nativeRate is false, it's the same
+		// as ms_SegLength, and the resampler isn't used.
+		static EMU_THREAD_LOCAL bool nativeRate;
+		static EMU_THREAD_LOCAL int synthLength;
+		static EMU_THREAD_LOCAL Resampler resampler;
+
+		/**
+		 * Calculate the native-rate synthesis segment length.
+		 * This is the YM2612's native rate divided by the frame rate,
+		 * rounded up so the YM2612 doesn't need to interpolate.
+		 * @param isPal If true, system is PAL.
+		 * @return Synthesis segment length.
+		 */
+		static int CalcNativeLength(bool isPal);
+
+		/**
+		 * Resample the segment buffer in native-rate mode.
+		 * Called by SoundMgr::SpecialUpdate().
+		 */
+		static inline void resample(void)
+		{
+			if (nativeRate)
+				resampler.process(SoundMgr::ms_SegBuf);
+		}
 
 	public:
-#ifdef SOUNDMGR_HAS_MMX
+		// NOTE: samples is clamped to std::min(samples, ms_SegLength)
+		// by writeStereo() and writeMono().
+
+#ifdef SOUNDMGR_HAS_SSE2
+		/**
+		 * Write stereo audio to a buffer. (AVX2-optimized)
+		 * @param dest Destination buffer.
+		 * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
+		 */
+		SOUNDMGR_TARGET("avx2")
+		static void writeStereo_AVX2(int16_t *dest, int samples);
+
+		/**
+		 * Write monaural audio to a buffer. (AVX2-optimized)
+		 * @param dest Destination buffer.
+		 * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
+		 */
+		SOUNDMGR_TARGET("avx2")
+		static void writeMono_AVX2(int16_t *dest, int samples);
+
 		/**
 		 * Write stereo audio to a buffer. (SSE2-optimized)
 		 * @param dest Destination buffer.
 		 * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
 		 */
+		SOUNDMGR_TARGET("sse2")
 		static void writeStereo_SSE2(int16_t *dest, int samples);
 
 		/**
@@ -67,13 +132,17 @@ class SoundMgrPrivate
 		 * @param dest Destination buffer.
 		 * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
 		 */
+		SOUNDMGR_TARGET("sse2")
 		static void writeMono_SSE2(int16_t *dest, int samples);
+#endif /* SOUNDMGR_HAS_SSE2 */
 
+#ifdef SOUNDMGR_HAS_MMX
 		/**
 		 * Write stereo audio to a buffer. (MMX-optimized)
 		 * @param dest Destination buffer.
 		 * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
 		 */
+		SOUNDMGR_TARGET("mmx")
 		static void writeStereo_MMX(int16_t *dest, int samples);
 
 		/**
@@ -81,9 +150,26 @@ class SoundMgrPrivate
 		 * @param dest Destination buffer.
 		 * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
 		 */
+		SOUNDMGR_TARGET("mmx")
 		static void writeMono_MMX(int16_t *dest, int samples);
 #endif /* SOUNDMGR_HAS_MMX */
 
+#ifdef SOUNDMGR_HAS_NEON
+		/**
+		 * Write stereo audio to a buffer. (NEON-optimized)
+		 * @param dest Destination buffer.
+		 * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
+		 */
+		static void writeStereo_NEON(int16_t *dest, int samples);
+
+		/**
+		 * Write monaural audio to a buffer. (NEON-optimized)
+		 * @param dest Destination buffer.
+		 * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
+		 */
+		static void writeMono_NEON(int16_t *dest, int samples);
+#endif /* SOUNDMGR_HAS_NEON */
+
 		/**
 		 * Write stereo audio to a buffer.
 		 * @param dest Destination buffer.
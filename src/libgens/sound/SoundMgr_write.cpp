@@ -33,6 +33,15 @@
 #include <algorithm>
 
 #include "SoundMgr_p.hpp"
+
+#if defined(SOUNDMGR_HAS_SSE2)
+// MMX, SSE2, and AVX2 intrinsics.
+#include <immintrin.h>
+#elif defined(SOUNDMGR_HAS_NEON)
+// NEON intrinsics.
+#include <arm_neon.h>
+#endif
+
 namespace LibGens {
 
 /**
@@ -51,9 +60,82 @@ static inline int16_t clamp(int32_t sample)
 	return (int16_t)sample;
 }
 
-/** SoundMgrPrivate: SSE-optimized functions. **/
+/** SoundMgrPrivate: AVX2-optimized functions. **/
+
+#ifdef SOUNDMGR_HAS_SSE2
+/**
+ * Write stereo audio to a buffer. (AVX2-optimized)
+ * @param dest Destination buffer.
+ * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
+ */
+void SoundMgrPrivate::writeStereo_AVX2(int16_t *dest, int samples)
+{
+	// Source buffer pointer.
+	// The segment buffer is 32-byte aligned.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
+
+	// Write 8 samples at once using AVX2.
+	int i = samples;
+	for (; i > 7; i -= 8, src += 16, dest += 16) {
+		const __m256i s0 = _mm256_load_si256((const __m256i*)&src[0]);	// [R4 | L4 | R3 | L3 | R2 | L2 | R1 | L1]
+		const __m256i s1 = _mm256_load_si256((const __m256i*)&src[8]);	// [R8 | L8 | R7 | L7 | R6 | L6 | R5 | L5]
+		// packssdw works within 128-bit lanes:
+		// [R8 L8 R7 L7 R4 L4 R3 L3 | R6 L6 R5 L5 R2 L2 R1 L1]
+		__m256i out = _mm256_packs_epi32(s0, s1);
+		out = _mm256_permute4x64_epi64(out, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)dest, out);
+	}
+
+	// If the buffer size isn't a multiple of 8 samples,
+	// write the remaining samples normally.
+	for (; i > 0; i--, src += 2, dest += 2) {
+		*(dest+0) = clamp(*(src+0));
+		*(dest+1) = clamp(*(src+1));
+	}
+}
+
+/**
+ * Write monaural audio to a buffer. (AVX2-optimized)
+ * @param dest Destination buffer.
+ * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
+ */
+void SoundMgrPrivate::writeMono_AVX2(int16_t *dest, int samples)
+{
+	// Source buffer pointer.
+	// The segment buffer is 32-byte aligned.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
+
+	// Write 16 samples at once using AVX2.
+	int i = samples;
+	for (; i > 15; i -= 16, src += 32, dest += 16) {
+		const __m256i s0 = _mm256_load_si256((const __m256i*)&src[0]);
+		const __m256i s1 = _mm256_load_si256((const __m256i*)&src[8]);
+		const __m256i s2 = _mm256_load_si256((const __m256i*)&src[16]);
+		const __m256i s3 = _mm256_load_si256((const __m256i*)&src[24]);
+		// phaddd works within 128-bit lanes:
+		// m0 = [M8 M7 M4 M3 | M6 M5 M2 M1]
+		// m1 = [M16 M15 M12 M11 | M14 M13 M10 M9]
+		// NOTE: This may overflow if samples are >= 2^30,
+		// but that shouldn't happen except in unit tests.
+		const __m256i m0 = _mm256_srai_epi32(_mm256_hadd_epi32(s0, s1), 1);
+		const __m256i m1 = _mm256_srai_epi32(_mm256_hadd_epi32(s2, s3), 1);
+		// out = [M16 M15 M12 M11 M8 M7 M4 M3 | M14 M13 M10 M9 M6 M5 M2 M1]
+		__m256i out = _mm256_packs_epi32(m0, m1);
+		out = _mm256_permutevar8x32_epi32(out, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+		_mm256_storeu_si256((__m256i*)dest, out);
+	}
+
+	// If the buffer size isn't a multiple of 16 samples,
+	// write the remaining samples normally.
+	for (; i > 0; i--, src += 2, dest++) {
+		// Combine the L and R samples into one sample.
+		const int32_t out = ((*(src+0) + *(src+1)) >> 1);
+		*dest = clamp(out);
+	}
+}
+
+/** SoundMgrPrivate: SSE2-optimized functions. **/
 
-#ifdef SOUNDMGR_HAS_MMX
 /**
  * Write stereo audio to a buffer. (SSE2-optimized)
  * @param dest Destination buffer.
@@ -61,60 +143,29 @@ static inline int16_t clamp(int32_t sample)
  */
 void SoundMgrPrivate::writeStereo_SSE2(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeStereo().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	// The segment buffer is 16-byte aligned.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
 
 	// Write 8 samples at once using SSE2.
-	assert((uintptr_t)dest % 16 == 0);
+	// Since the segment buffer is interleaved,
+	// packssdw writes the samples in the correct order.
 	int i = samples;
-	for (; i > 7; i -= 8, srcL += 8, srcR += 8, dest += 16) {
-		__asm__ (
-			"movdqa		(%[srcL]), %%xmm0\n"	// %xmm0 = [L4h | L4l | L3h | L3l | L2h | L2l | L1h | L1l]
-			"movdqa		(%[srcR]), %%xmm1\n"	// %xmm1 = [R4h | R4l | R3h | R3l | R2h | R2l | R1h | R1l]
-			"movdqa		16(%[srcL]), %%xmm2\n"	// %xmm2 = [L8h | L8l | L7h | L7l | L6h | L6l | L5h | L5l]
-			"movdqa		16(%[srcR]), %%xmm3\n"	// %xmm3 = [R8h | R8l | R7h | R7l | R6h | R6l | R5h | R5l]
-			// NOTE: On my ThinkPad T60p with Core 2 Duo T7200, the
-			// pshufd version is faster than the punpcklwd version, even though
-			// agner.org's optimization documents say otherwise.
-			// Reference: http://www.agner.org/optimize/instruction_tables.pdf
-			// punpcklwd version:
-			#if 0
-			"packssdw	%%xmm0, %%xmm0\n"	// %xmm0 = [L4  | L3  | L2  | L1  | L4  | L3  | L2  | L1 ]
-			"packssdw	%%xmm1, %%xmm1\n"	// %xmm1 = [R4  | R3  | R2  | R1  | R4  | R3  | R2  | R1 ]
-			"packssdw	%%xmm2, %%xmm2\n"	// %xmm2 = [L8  | L7  | L6  | L5  | L8  | L7  | L6  | L5 ]
-			"packssdw	%%xmm3, %%xmm3\n"	// %xmm3 = [R8  | R7  | R6  | R5  | R8  | R7  | R6  | R5 ]
-			"punpcklwd	%%xmm1, %%xmm0\n"	// %xmm0 = [R4  | L4  | R3  | L3  | R2  | L2  | R1  | L1 ]
-			"punpcklwd	%%xmm3, %%xmm2\n"	// %xmm2 = [R8  | L8  | R7  | L7  | R6  | L6  | R5  | L5 ]
-			#endif
-			// pshufd version:
-			"packssdw	%%xmm1, %%xmm0\n"		// %xmm0 = [R4  | R3  | R2  | R1  | L4  | L3  | L2  | L1 ]
-			"packssdw	%%xmm3, %%xmm2\n"		// %xmm2 = [R8  | R7  | R6  | R5  | L8  | L7  | L6  | L5 ]
-			"pshufd		$0xD8, %%xmm0, %%xmm0\n"	// %xmm0 = [R4  | R3  | L4  | L3  | R2  | R1  | L2  | L1 ]
-			"pshuflw	$0xD8, %%xmm0, %%xmm0\n"	// %xmm0 = [R4  | R3  | L4  | L3  | R2  | L2  | R1  | L1 ]
-			"pshufhw	$0xD8, %%xmm0, %%xmm0\n"	// %xmm0 = [R4  | L4  | R3  | L3  | R2  | L2  | R1  | L1 ]
-			"pshufd		$0xD8, %%xmm2, %%xmm2\n"	// %xmm0 = [R8  | R7  | L8  | L7  | R6  | R5  | L6  | L5 ]
-			"pshuflw	$0xD8, %%xmm2, %%xmm2\n"	// %xmm0 = [R8  | R7  | L8  | L7  | R6  | L6  | R5  | L5 ]
-			"pshufhw	$0xD8, %%xmm2, %%xmm2\n"	// %xmm0 = [R8  | L8  | R7  | L7  | R6  | L6  | R5  | L5 ]
-			"movdqa		%%xmm0, (%[dest])\n"
-			"movdqa		%%xmm2, 16(%[dest])\n"
-			:
-			: [srcL] "r" (srcL), [srcR] "r" (srcR), [dest] "r" (dest)
-			// FIXME: gcc complains xmm? registers are unknown.
-			// May need to compile with -msse...
-			//: "xmm0", "xmm1", "xmm2", "xmm3"
-			);
+	for (; i > 7; i -= 8, src += 16, dest += 16) {
+		const __m128i s0 = _mm_load_si128((const __m128i*)&src[0]);	// [R2 | L2 | R1 | L1]
+		const __m128i s1 = _mm_load_si128((const __m128i*)&src[4]);	// [R4 | L4 | R3 | L3]
+		const __m128i s2 = _mm_load_si128((const __m128i*)&src[8]);	// [R6 | L6 | R5 | L5]
+		const __m128i s3 = _mm_load_si128((const __m128i*)&src[12]);	// [R8 | L8 | R7 | L7]
+		_mm_storeu_si128((__m128i*)&dest[0], _mm_packs_epi32(s0, s1));
+		_mm_storeu_si128((__m128i*)&dest[8], _mm_packs_epi32(s2, s3));
 	}
 
 	// If the buffer size isn't a multiple of 8 samples,
 	// write the remaining samples normally.
-        for (; i > 0; i--, srcL++, srcR++, dest += 2) {
-                *(dest+0) = clamp(*srcL);
-                *(dest+1) = clamp(*srcR);
-        }
+	for (; i > 0; i--, src += 2, dest += 2) {
+		*(dest+0) = clamp(*(src+0));
+		*(dest+1) = clamp(*(src+1));
+	}
 }
 
 /**
@@ -124,52 +175,39 @@ void SoundMgrPrivate::writeStereo_SSE2(int16_t *dest, int samples)
  */
 void SoundMgrPrivate::writeMono_SSE2(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeStereo().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	// The segment buffer is 16-byte aligned.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
 
 	// Write 8 samples at once using SSE2.
-	assert((uintptr_t)dest % 16 == 0);
 	int i = samples;
-	for (; i > 7; i -= 8, srcL += 8, srcR += 8, dest += 8) {
-		__asm__ (
-			"movdqa		(%[srcL]), %%xmm0\n"	// %xmm0 = [L4h | L4l | L3h | L3l | L2h | L2l | L1h | L1l]
-			"movdqa		(%[srcR]), %%xmm1\n"	// %xmm1 = [R4h | R4l | R3h | R3l | R2h | R2l | R1h | R1l]
-			"movdqa		16(%[srcL]), %%xmm2\n"	// %xmm2 = [L8h | L8l | L7h | L7l | L6h | L6l | L5h | L5l]
-			"movdqa		16(%[srcR]), %%xmm3\n"	// %xmm3 = [R8h | R8l | R7h | R7l | R6h | R6l | R5h | R5l]
-			// NOTE: This may overflow if samples are >= 2^30,
-			// but that shouldn't happen except in unit tests.
-			// TODO: Use pavgw after packing? (Unsigned, thoguh...)
-			"paddd		%%xmm1, %%xmm0\n"
-			"paddd		%%xmm3, %%xmm2\n"
-			// TODO: Add 1 to match SSE2 'pavgw'?
-			"psrad		$1, %%xmm0\n"		// %xmm0 = [M4h | M4l | M3h | M3l | M2h | M2l | M1h | M1l]
-			"psrad		$1, %%xmm2\n"		// %xmm2 = [M8h | M8l | M7h | M7l | M6h | M6l | M5h | M5l]
-			"packssdw	%%xmm0, %%xmm0\n"	// %xmm0 = [M4  | M3  | M2  | M1  | M4  | M3  | M2  | M1 ]
-			"packssdw	%%xmm2, %%xmm2\n"	// %xmm2 = [M8  | M7  | M6  | M5  | M8  | M7  | M6  | M5 ]
-			// TODO: Combine %%xmm0 and %%xmm1 into a single register before writing?
-			"movq		%%xmm0, (%[dest])\n"
-			"movq		%%xmm2, 8(%[dest])\n"
-			:
-			: [srcL] "r" (srcL), [srcR] "r" (srcR), [dest] "r" (dest)
-			// FIXME: gcc complains xmm? registers are unknown.
-			// May need to compile with -msse...
-			//: "xmm0", "xmm1", "xmm2", "xmm3"
-			);
+	for (; i > 7; i -= 8, src += 16, dest += 8) {
+		// SSE2 doesn't have phaddd, so the L and R samples
+		// are separated using shufps.
+		const __m128 s0 = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&src[0]));
+		const __m128 s1 = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&src[4]));
+		const __m128 s2 = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&src[8]));
+		const __m128 s3 = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&src[12]));
+		const __m128i l0 = _mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)));	// [L4 | L3 | L2 | L1]
+		const __m128i r0 = _mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)));	// [R4 | R3 | R2 | R1]
+		const __m128i l1 = _mm_castps_si128(_mm_shuffle_ps(s2, s3, _MM_SHUFFLE(2, 0, 2, 0)));	// [L8 | L7 | L6 | L5]
+		const __m128i r1 = _mm_castps_si128(_mm_shuffle_ps(s2, s3, _MM_SHUFFLE(3, 1, 3, 1)));	// [R8 | R7 | R6 | R5]
+		// NOTE: This may overflow if samples are >= 2^30,
+		// but that shouldn't happen except in unit tests.
+		const __m128i m0 = _mm_srai_epi32(_mm_add_epi32(l0, r0), 1);
+		const __m128i m1 = _mm_srai_epi32(_mm_add_epi32(l1, r1), 1);
+		_mm_storeu_si128((__m128i*)dest, _mm_packs_epi32(m0, m1));
 	}
 
 	// If the buffer size isn't a multiple of 8 samples,
 	// write the remaining samples normally.
-        for (; i > 0; i--, srcL++, srcR++, dest++) {
+	for (; i > 0; i--, src += 2, dest++) {
 		// Combine the L and R samples into one sample.
-		const int32_t out = ((*srcL + *srcR) >> 1);
+		const int32_t out = ((*(src+0) + *(src+1)) >> 1);
 		*dest = clamp(out);
-        }
+	}
 }
-#endif /* SOUNDMGR_HAS_MMX */
+#endif /* SOUNDMGR_HAS_SSE2 */
 
 /** SoundMgrPrivate: MMX-optimized functions. **/
 
@@ -181,66 +219,27 @@ void SoundMgrPrivate::writeMono_SSE2(int16_t *dest, int samples)
  */
 void SoundMgrPrivate::writeStereo_MMX(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeStereo().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	const __m64 *src = (const __m64*)&SoundMgr::ms_SegBuf[0];
 
 	// Write 4 samples at once using MMX.
 	int i = samples;
-	for (; i > 3; i -= 4, srcL += 4, srcR += 4, dest += 8) {
-		__asm__ (
-			// NOTE: pshufw is NOT an MMX instruction.
-			// We have to use movd and shift to get the words into place.
-			// FIXME: Optimize it using movq somehow.
-			// (Attempted a movq optimization, and it ended up being slower...)
-			"movd		(%[srcL]), %%mm0\n"	// %mm0 = [ 0  |  0  | L1h | L1l]
-			"movd		(%[srcR]), %%mm1\n"	// %mm1 = [ 0  |  0  | R1h | R1l]
-			"psllq		$32, %%mm1\n"		// %mm1 = [R1h | R1l |  0  |  0 ]
-			"por		%%mm1, %%mm0\n"		// %mm0 = [R1h | R1l | L1h | L1l]
-			"packssdw	%%mm0, %%mm0\n"		// %mm0 = [R1  | L1  | R1  | L1 ]
-
-			"movd		4(%[srcL]), %%mm2\n"	// %mm2 = [ 0  |  0  | L2h | L2l]
-			"movd		4(%[srcR]), %%mm3\n"	// %mm3 = [ 0  |  0  | R2h | R2l]
-			"psllq		$32, %%mm3\n"		// %mm3 = [R2h | R2l |  0  |  0 ]
-			"por		%%mm3, %%mm2\n"		// %mm2 = [R2h | R2l | L2h | L2l]
-			"packssdw	%%mm2, %%mm2\n"		// %mm2 = [R2  | L2  | R2  | L2 ]
-
-			"movd		8(%[srcL]), %%mm4\n"	// %mm4 = [ 0  |  0  | L3h | L3l]
-			"movd		8(%[srcR]), %%mm5\n"	// %mm5 = [ 0  |  0  | R3h | R3l]
-			"psllq		$32, %%mm5\n"		// %mm5 = [R3h | R3l |  0  |  0 ]
-			"por		%%mm5, %%mm4\n"		// %mm4 = [R3h | R3l | L3h | L3l]
-			"packssdw	%%mm4, %%mm4\n"		// %mm4 = [R3  | L3  | R3  | L3 ]
-
-			"movd		12(%[srcL]), %%mm6\n"	// %mm6 = [ 0  |  0  | L4h | L4l]
-			"movd		12(%[srcR]), %%mm7\n"	// %mm7 = [ 0  |  0  | R4h | R4l]
-			"psllq		$32, %%mm7\n"		// %mm7 = [R4h | R4l |  0  |  0 ]
-			"por		%%mm7, %%mm6\n"		// %mm6 = [R4h | R4l | L4h | L4l]
-			"packssdw	%%mm6, %%mm6\n"		// %mm6 = [R4  | L4  | R4  | L4 ]
-
-			"movd		%%mm0, (%[dest])\n"
-			"movd		%%mm2, 4(%[dest])\n"
-			"movd		%%mm4, 8(%[dest])\n"
-			"movd		%%mm6, 12(%[dest])\n"
-			:
-			: [srcL] "r" (srcL), [srcR] "r" (srcR), [dest] "r" (dest)
-			// FIXME: gcc complains mm? registers are unknown.
-			// May need to compile with -mmmx...
-			//: "mm0", "mm1", "mm2", "mm3", "mm4", "mm5", "mm6", "mm7"
-			);
+	for (; i > 3; i -= 4, src += 4, dest += 8) {
+		__m64 *const d = (__m64*)dest;
+		d[0] = _mm_packs_pi32(src[0], src[1]);	// [R2 | L2 | R1 | L1]
+		d[1] = _mm_packs_pi32(src[2], src[3]);	// [R4 | L4 | R3 | L3]
 	}
 
 	// Reset the FPU state.
-	__asm__ __volatile__ ("emms");
+	_mm_empty();
 
 	// If the buffer size isn't a multiple of 4 samples,
 	// write the remaining samples normally.
-        for (; i > 0; i--, srcL++, srcR++, dest += 2) {
-                *(dest+0) = clamp(*srcL);
-                *(dest+1) = clamp(*srcR);
-        }
+	const int32_t *src32 = (const int32_t*)src;
+	for (; i > 0; i--, src32 += 2, dest += 2) {
+		*(dest+0) = clamp(*(src32+0));
+		*(dest+1) = clamp(*(src32+1));
+	}
 }
 
 /**
@@ -250,54 +249,97 @@ void SoundMgrPrivate::writeStereo_MMX(int16_t *dest, int samples)
  */
 void SoundMgrPrivate::writeMono_MMX(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeMono().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	const __m64 *src = (const __m64*)&SoundMgr::ms_SegBuf[0];
 
 	// Write 4 samples at once using MMX.
 	int i = samples;
-	for (; i > 3; i -= 4, srcL += 4, srcR += 4, dest += 4) {
-		__asm__ (
-			// NOTE: Add/shift may overflow if samples are >= 2^30,
-			// but that shouldn't happen except in unit tests.
-			// TODO: Add 1 before shifting to match SSE2 'pavgw'?
-			"movq		(%[srcL]), %%mm0\n"	// %mm0 = [L2h | L2l | L1h | L1l]
-			"movq		(%[srcR]), %%mm1\n"	// %mm1 = [R2h | R2l | R1h | R1l]
-			"movq		8(%[srcL]), %%mm2\n"	// %mm2 = [L4h | L3l | L2h | L2l]
-			"paddd		%%mm1, %%mm0\n"
-			"movq		8(%[srcR]), %%mm3\n"	// %mm3 = [R4h | R4l | R3h | R3l]
-			"psrad		$1, %%mm0\n"		// %mm0 = [M2h | M2l | M1h | M1l]
-			"paddd		%%mm3, %%mm2\n"
-			"packssdw	%%mm0, %%mm0\n"		// %mm0 = [M2  | M1  | M2  | M1 ]
-			"psrad		$1, %%mm2\n"		// %mm2 = [M4h | M4l | M3h | M3l]
-			"movd		%%mm0, (%[dest])\n"
-			"packssdw	%%mm2, %%mm2\n"		// %mm2 = [M4  | M3  | M4  | M3 ]
-			// TODO: Combine %%mm0 and %%mm2 so we only have to do one movq?
-			"movd		%%mm2, 4(%[dest])\n"
-			:
-			: [srcL] "r" (srcL), [srcR] "r" (srcR), [dest] "r" (dest)
-			// FIXME: gcc complains mm? registers are unknown.
-			// May need to compile with -mmmx...
-			//: "mm0", "mm1", "mm2", "mm3"
-		);
+	for (; i > 3; i -= 4, src += 4, dest += 4) {
+		// NOTE: Add/shift may overflow if samples are >= 2^30,
+		// but that shouldn't happen except in unit tests.
+		const __m64 m0 = _mm_srai_pi32(_mm_add_pi32(
+			_mm_unpacklo_pi32(src[0], src[1]),		// [L2 | L1]
+			_mm_unpackhi_pi32(src[0], src[1])), 1);		// [R2 | R1]
+		const __m64 m1 = _mm_srai_pi32(_mm_add_pi32(
+			_mm_unpacklo_pi32(src[2], src[3]),		// [L4 | L3]
+			_mm_unpackhi_pi32(src[2], src[3])), 1);		// [R4 | R3]
+		*(__m64*)dest = _mm_packs_pi32(m0, m1);
 	}
 
 	// Reset the FPU state.
-	__asm__ __volatile__ ("emms");
+	_mm_empty();
 
 	// If the buffer size isn't a multiple of 4 samples,
 	// write the remaining samples normally.
-        for (; i > 0; i--, srcL++, srcR++, dest++) {
+	const int32_t *src32 = (const int32_t*)src;
+	for (; i > 0; i--, src32 += 2, dest++) {
 		// Combine the L and R samples into one sample.
-		const int32_t out = ((*srcL + *srcR) >> 1);
+		const int32_t out = ((*(src32+0) + *(src32+1)) >> 1);
 		*dest = clamp(out);
-        }
+	}
 }
 #endif /* SOUNDMGR_HAS_MMX */
 
+/** SoundMgrPrivate: NEON-optimized functions. **/
+
+#ifdef SOUNDMGR_HAS_NEON
+/**
+ * Write stereo audio to a buffer. (NEON-optimized)
+ * @param dest Destination buffer.
+ * @param samples Number of samples in the buffer. (1 sample == 4 bytes)
+ */
+void SoundMgrPrivate::writeStereo_NEON(int16_t *dest, int samples)
+{
+	// Source buffer pointer.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
+
+	// Write 4 samples at once using NEON.
+	int i = samples;
+	for (; i > 3; i -= 4, src += 8, dest += 8) {
+		const int32x4_t s0 = vld1q_s32(&src[0]);	// [R2 | L2 | R1 | L1]
+		const int32x4_t s1 = vld1q_s32(&src[4]);	// [R4 | L4 | R3 | L3]
+		vst1q_s16(dest, vcombine_s16(vqmovn_s32(s0), vqmovn_s32(s1)));
+	}
+
+	// If the buffer size isn't a multiple of 4 samples,
+	// write the remaining samples normally.
+	for (; i > 0; i--, src += 2, dest += 2) {
+		*(dest+0) = clamp(*(src+0));
+		*(dest+1) = clamp(*(src+1));
+	}
+}
+
+/**
+ * Write monaural audio to a buffer. (NEON-optimized)
+ * @param dest Destination buffer.
+ * @param samples Number of samples in the buffer. (1 sample == 2 bytes)
+ */
+void SoundMgrPrivate::writeMono_NEON(int16_t *dest, int samples)
+{
+	// Source buffer pointer.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
+
+	// Write 4 samples at once using NEON.
+	// vld2q deinterleaves the L and R samples.
+	int i = samples;
+	for (; i > 3; i -= 4, src += 8, dest += 4) {
+		const int32x4x2_t s = vld2q_s32(src);
+		// NOTE: This may overflow if samples are >= 2^30,
+		// but that shouldn't happen except in unit tests.
+		const int32x4_t m = vshrq_n_s32(vaddq_s32(s.val[0], s.val[1]), 1);
+		vst1_s16(dest, vqmovn_s32(m));
+	}
+
+	// If the buffer size isn't a multiple of 4 samples,
+	// write the remaining samples normally.
+	for (; i > 0; i--, src += 2, dest++) {
+		// Combine the L and R samples into one sample.
+		const int32_t out = ((*(src+0) + *(src+1)) >> 1);
+		*dest = clamp(out);
+	}
+}
+#endif /* SOUNDMGR_HAS_NEON */
+
 /** SoundMgrPrivate: Non-optimized functions. **/
 
 /**
@@ -307,18 +349,14 @@ void SoundMgrPrivate::writeMono_MMX(int16_t *dest, int samples)
  */
 void SoundMgrPrivate::writeStereo_noasm(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeStereo().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
 
 	for (int i = samples; i > 0;
-	     i--, srcL++, srcR++, dest += 2)
+	     i--, src += 2, dest += 2)
 	{
-		*(dest+0) = clamp(*srcL);
-		*(dest+1) = clamp(*srcR);
+		*(dest+0) = clamp(*(src+0));
+		*(dest+1) = clamp(*(src+1));
 	}
 }
 
@@ -329,22 +367,18 @@ void SoundMgrPrivate::writeStereo_noasm(int16_t *dest, int samples)
  */
 void SoundMgrPrivate::writeMono_noasm(int16_t *dest, int samples)
 {
-	// samples is clamped to std::min(samples, ms_SegLength)
-	// by writeMono().
-
-	// Source buffer pointers.
-	const int32_t *srcL = &SoundMgr::ms_SegBufL[0];
-	const int32_t *srcR = &SoundMgr::ms_SegBufR[0];
+	// Source buffer pointer.
+	const int32_t *src = &SoundMgr::ms_SegBuf[0];
 
 	for (int i = samples; i > 0;
-	     i--, srcL++, srcR++, dest++)
+	     i--, src += 2, dest++)
 	{
 		// NOTE: This will be incorrect if
-		// (*srcL + *srcR) >= 2^31.
+		// (L + R) >= 2^31.
 		// This is highly unlikely, since there's a
 		// maximum of 4 (PSG, FM, PCM, PWM) audio chips,
 		// which means a worst-case maximum of 0x8000 * 4.
-		const int32_t out = ((*srcL + *srcR) >> 1);
+		const int32_t out = ((*(src+0) + *(src+1)) >> 1);
 		*dest = clamp(out);
 	}
 }
@@ -361,23 +395,27 @@ void SoundMgrPrivate::writeMono_noasm(int16_t *dest, int samples)
 int SoundMgr::writeStereo(int16_t *dest, int samples)
 {
 	samples = std::min(samples, ms_SegLength);
-#ifdef SOUNDMGR_HAS_MMX
-	if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+#if defined(SOUNDMGR_HAS_NEON)
+	SoundMgrPrivate::writeStereo_NEON(dest, samples);
+#else /* !SOUNDMGR_HAS_NEON */
+#ifdef SOUNDMGR_HAS_SSE2
+	if (CPU_Flags & MDP_CPUFLAG_X86_AVX2) {
+		SoundMgrPrivate::writeStereo_AVX2(dest, samples);
+	} else if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
 		SoundMgrPrivate::writeStereo_SSE2(dest, samples);
-	} else if (CPU_Flags & MDP_CPUFLAG_X86_MMX) {
+	} else
+#endif /* SOUNDMGR_HAS_SSE2 */
+#ifdef SOUNDMGR_HAS_MMX
+	if (CPU_Flags & MDP_CPUFLAG_X86_MMX) {
 		SoundMgrPrivate::writeStereo_MMX(dest, samples);
 	} else
 #endif /* SOUNDMGR_HAS_MMX */
 	{
 		SoundMgrPrivate::writeStereo_noasm(dest, samples);
 	}
+#endif /* SOUNDMGR_HAS_NEON */
 
-	// Clear the segment buffers.
-	// These buffers are additive, so if they aren't cleared,
-	// we'll end up with static.
-	memset(ms_SegBufL, 0, ms_SegLength * sizeof(ms_SegBufL[0]));
-	memset(ms_SegBufR, 0, ms_SegLength * sizeof(ms_SegBufL[0]));
-
+	clearBuffers();
 	return samples;
 }
 
@@ -391,24 +429,44 @@ int SoundMgr::writeStereo(int16_t *dest, int samples)
 int SoundMgr::writeMono(int16_t *dest, int samples)
 {
 	samples = std::min(samples, ms_SegLength);
-#ifdef SOUNDMGR_HAS_MMX
-	if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
+#if defined(SOUNDMGR_HAS_NEON)
+	SoundMgrPrivate::writeMono_NEON(dest, samples);
+#else /* !SOUNDMGR_HAS_NEON */
+#ifdef SOUNDMGR_HAS_SSE2
+	if (CPU_Flags & MDP_CPUFLAG_X86_AVX2) {
+		SoundMgrPrivate::writeMono_AVX2(dest, samples);
+	} else if (CPU_Flags & MDP_CPUFLAG_X86_SSE2) {
 		SoundMgrPrivate::writeMono_SSE2(dest, samples);
-	} else if (CPU_Flags & MDP_CPUFLAG_X86_MMX) {
+	} else
+#endif /* SOUNDMGR_HAS_SSE2 */
+#ifdef SOUNDMGR_HAS_MMX
+	if (CPU_Flags & MDP_CPUFLAG_X86_MMX) {
 		SoundMgrPrivate::writeMono_MMX(dest, samples);
 	} else
 #endif /* SOUNDMGR_HAS_MMX */
 	{
 		SoundMgrPrivate::writeMono_noasm(dest, samples);
 	}
+#endif /* SOUNDMGR_HAS_NEON */
 
-	// Clear the segment buffers.
-	// These buffers are additive, so if they aren't cleared,
-	// we'll end up with static.
-	memset(ms_SegBufL, 0, ms_SegLength * sizeof(ms_SegBufL[0]));
-	memset(ms_SegBufR, 0, ms_SegLength * sizeof(ms_SegBufL[0]));
-
+	clearBuffers();
 	return samples;
 }
 
+/**
+ * Clear the internal audio buffer without writing it.
+ * Use this instead of writeStereo() / writeMono()
+ * if audio output is disabled.
+ */
+void SoundMgr::clearBuffers(void)
+{
+	// Clear the segment buffer.
+	// This buffer is additive, so if it isn't cleared,
+	// we'll end up with static.
+	// In native-rate mode, the PSG and YM2612 may have written
+	// more samples than the output segment length.
+	const int len = std::max(ms_SegLength, SoundMgrPrivate::synthLength);
+	memset(ms_SegBuf, 0, len * 2 * sizeof(ms_SegBuf[0]));
+}
+
 }
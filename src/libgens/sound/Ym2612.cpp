@@ -48,12 +48,12 @@
 /* Message logging. */
 #include "macros/log_msg.h"
 
+// CPU flags.
+#include "libcompat/cpuflags.h"
+
 // Sound Manager.
 #include "SoundMgr.hpp"
-#include "Vdp/Vdp.hpp"
-
-// TODO: Get rid of EmuContext.
-#include "EmuContext/EmuContext.hpp"
+#include "EmuContext/Scheduler.hpp"
 
 #if 0
 // GSX v7 savestate functionality.
@@ -69,12 +69,14 @@ namespace LibGens {
 /** Ym2612Private **/
 
 // Static variables.
-bool Ym2612Private::isInit = false;
 int *Ym2612Private::SIN_TAB[SIN_LENGTH];			// SINUS TABLE (pointer on TL TABLE)
 int Ym2612Private::TL_TAB[TL_LENGTH * 2];			// TOTAL LEVEL TABLE (plus and minus)
 unsigned int Ym2612Private::ENV_TAB[2 * ENV_LENGTH * 8];	// ENV CURVE TABLE (attack & decay)
 //unsigned int Ym2612Private::ATTACK_TO_DECAY[ENV_LENGTH];	// Conversion from attack to decay phase
 unsigned int Ym2612Private::DECAY_TO_ATTACK[ENV_LENGTH];	// Conversion from decay to attack phase
+#ifdef YM2612_HAS_AVX2
+int Ym2612Private::SIN_OFF_TAB[SIN_LENGTH];			// SINUS TABLE (offsets into TL TABLE)
+#endif
 
 // Next Enveloppe phase functions pointer table
 const Ym2612Private::Env_Event Ym2612Private::ENV_NEXT_EVENT[8] = {
@@ -146,12 +148,15 @@ int Ym2612Private::LFO_FREQ_TAB[LFO_LENGTH];	// LFO FMS TABLE
 
 Ym2612Private::Ym2612Private(Ym2612 *q)
 	: q(q)
+	, regLogCount(0)
+	, regLogPos(0)
+	, regLogReplay(false)
 {
-	if (!isInit) {
-		// Initialize the static tables.
-		isInit = true;
-		doStaticInit();
-	}
+	// Initialize the static tables.
+	// NOTE: The tables are shared by all threads.
+	// A function-local static is initialized exactly once.
+	static const bool isInit = (doStaticInit(), true);
+	((void)isInit);
 }
 
 void Ym2612Private::doStaticInit(void)
@@ -181,6 +186,13 @@ void Ym2612Private::doStaticInit(void)
 			SIN_TAB[SIN_LENGTH - i][0]);
 	}
 
+#ifdef YM2612_HAS_AVX2
+	// Sine table as offsets into TL_TAB. (for the SIMD FM engine)
+	for (int i = 0; i < SIN_LENGTH; i++) {
+		SIN_OFF_TAB[i] = (int)(SIN_TAB[i] - TL_TAB);
+	}
+#endif
+
 	// LFO table:
 	for (int i = 0; i < LFO_LENGTH; i++) {
 		double x = sin (2.0 * PI * (double) (i) / (double) (LFO_LENGTH));	// Sinus
@@ -697,33 +709,6 @@ int Ym2612Private::YM_SET(int address, uint8_t data)
 			}
 			break;
 
-		case 0x24:
-			state.TimerA = (state.TimerA & 0x003) | (((int)data) << 2);
-			if (state.TimerAL != (1024 - state.TimerA) << 12) {
-				state.TimerAcnt = state.TimerAL = (1024 - state.TimerA) << 12;
-				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
-					"Timer A Set = %.8X", state.TimerAcnt);
-			}
-			break;
-
-		case 0x25:
-			state.TimerA = (state.TimerA & 0x3FC) | (data & 3);
-			if (state.TimerAL != (1024 - state.TimerA) << 12) {
-				state.TimerAcnt = state.TimerAL = (1024 - state.TimerA) << 12;
-				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
-					"Timer A Set = %.8X", state.TimerAcnt);
-			}
-			break;
-
-		case 0x26:
-			state.TimerB = data;
-			if (state.TimerBL != (256 - state.TimerB) << (4 + 12)) {
-				state.TimerBcnt = state.TimerBL = (256 - state.TimerB) << (4 + 12);
-				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
-					"Timer B Set = %.8X", state.TimerBcnt);
-			}
-			break;
-
 		case 0x27:
 			// Paramètre divers
 			// b7 = CSM MODE
@@ -734,6 +719,7 @@ int Ym2612Private::YM_SET(int address, uint8_t data)
 			// b2 = timer enable a
 			// b1 = load b
 			// b0 = load a
+			// NOTE: The timer bits are handled by TIMER_SET().
 
 			if ((data ^ state.Mode) & 0x40) {
 				// We changed the channel 2 mode, so recalculate phase step
@@ -742,16 +728,6 @@ int Ym2612Private::YM_SET(int address, uint8_t data)
 				state.CHANNEL[2]._SLOT[0].Finc = -1;	// recalculate phase step
 			}
 
-			/*
-			if ((data & 2) && (YM2612.Status & 2))
-				YM2612.TimerBcnt = YM2612.TimerBL;
-			if ((data & 1) && (YM2612.Status & 1))
-				YM2612.TimerAcnt = YM2612.TimerAL;
-			*/
-
-			//YM2612.Status &= (~data >> 4);	// Reset du Status au cas ou c'est demandé
-			state.status &= (~data >> 4) & (data >> 2);	// Reset Status
-
 			state.Mode = data;
 
 			LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG1,
@@ -809,6 +785,188 @@ int Ym2612Private::YM_SET(int address, uint8_t data)
 	return 0;
 }
 
+/**
+ * Set a timer register.
+ * Timers are updated when the register is written,
+ * even if synthesis is batched.
+ * @param address Register address.
+ * @param data Data.
+ */
+int Ym2612Private::TIMER_SET(int address, uint8_t data)
+{
+	switch (address) {
+		case 0x24:
+			state.TimerA = (state.TimerA & 0x003) | (((int)data) << 2);
+			if (state.TimerAL != (1024 - state.TimerA) << 12) {
+				state.TimerAcnt = state.TimerAL = (1024 - state.TimerA) << 12;
+				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
+					"Timer A Set = %.8X", state.TimerAcnt);
+			}
+			break;
+
+		case 0x25:
+			state.TimerA = (state.TimerA & 0x3FC) | (data & 3);
+			if (state.TimerAL != (1024 - state.TimerA) << 12) {
+				state.TimerAcnt = state.TimerAL = (1024 - state.TimerA) << 12;
+				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
+					"Timer A Set = %.8X", state.TimerAcnt);
+			}
+			break;
+
+		case 0x26:
+			state.TimerB = data;
+			if (state.TimerBL != (256 - state.TimerB) << (4 + 12)) {
+				state.TimerBcnt = state.TimerBL = (256 - state.TimerB) << (4 + 12);
+				LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG2,
+					"Timer B Set = %.8X", state.TimerBcnt);
+			}
+			break;
+
+		case 0x27:
+			/*
+			if ((data & 2) && (YM2612.Status & 2))
+				YM2612.TimerBcnt = YM2612.TimerBL;
+			if ((data & 1) && (YM2612.Status & 1))
+				YM2612.TimerAcnt = YM2612.TimerAL;
+			*/
+
+			//YM2612.Status &= (~data >> 4);	// Reset du Status au cas ou c'est demandé
+			state.status &= (~data >> 4) & (data >> 2);	// Reset Status
+
+			state.TimerMode = data;
+			break;
+	}
+
+	return 0;
+}
+
+/** Register log. (batched synthesis) **/
+
+/**
+ * Add an entry to the register log.
+ * @param pos Sample position in the segment buffer.
+ * @param reg Register number.
+ * @param data Data.
+ */
+void Ym2612Private::logReg(int pos, int reg, uint8_t data)
+{
+	// Entries must be in order, and they can't be
+	// past the end of the current line.
+	const int bufEnd = (int)(q->m_bufPtr - SoundMgr::ms_SegBuf) / 2 + q->m_writeLen;
+	if (pos > bufEnd)
+		pos = bufEnd;
+	if (pos < regLogPos)
+		pos = regLogPos;
+
+	if (regLogCount == REG_LOG_SIZE) {
+		// Log is full. Flush it.
+		flushRegLog(pos);
+	}
+
+	RegLogEntry_t *const entry = &regLog[regLogCount++];
+	entry->pos = (uint16_t)pos;
+	entry->reg = (uint16_t)reg;
+	entry->data = data;
+	regLogPos = pos;
+}
+
+/**
+ * Apply a logged register write.
+ * DAC data writes are handled by flushRegLog().
+ * @param reg Register number.
+ * @param data Data.
+ */
+void Ym2612Private::applyReg(int reg, uint8_t data)
+{
+	if (reg == REG_LOG_CSM) {
+		CSM_Key_Control();
+		return;
+	}
+
+	const int reg_num = (reg & 0xF0);
+	if (reg_num < 0x30) {
+		// Control registers. (bank 0 only)
+		YM_SET(reg, data);
+	} else if (reg_num < 0xA0) {
+		SLOT_SET(reg, data);
+	} else {
+		CHANNEL_SET(reg, data);
+	}
+}
+
+/**
+ * Add the DAC output between two register log entries.
+ * @param start Starting position in the segment buffer.
+ * @param end Ending position in the segment buffer.
+ */
+void Ym2612Private::renderRegLogDac(int start, int end)
+{
+	if (!(state.DAC && state.DACdata && q->m_dacEnabled))
+		return;
+
+	int32_t *const buf = &SoundMgr::ms_SegBuf[start * 2];
+	const int dacL = (state.DACdata & state.CHANNEL[5].LEFT);
+	const int dacR = (state.DACdata & state.CHANNEL[5].RIGHT);
+	for (int i = 0; i < (end - start); i++) {
+		buf[i*2] += dacL;
+		buf[i*2+1] += dacR;
+	}
+}
+
+/**
+ * Replay the register log, rendering audio up to the specified position.
+ *
+ * DAC data writes don't affect the FM channels, so the FM
+ * output is only split at other register writes. The DAC
+ * output is split at every logged write.
+ *
+ * @param end Ending position in the segment buffer.
+ */
+void Ym2612Private::flushRegLog(int end)
+{
+	const int start = (int)(q->m_bufPtr - SoundMgr::ms_SegBuf) / 2;
+	int fmPos = start;
+	int dacPos = start;
+
+	// SLOT_SET() and friends call specialUpdate(),
+	// which must not flush the log while it's being replayed.
+	regLogReplay = true;
+	for (int i = 0; i < regLogCount; i++) {
+		const RegLogEntry_t *const entry = &regLog[i];
+		if (entry->pos > dacPos) {
+			renderRegLogDac(dacPos, entry->pos);
+			dacPos = entry->pos;
+		}
+		if (entry->reg == 0x2A) {
+			// DAC data.
+			state.DACdata = ((int)entry->data - 0x80) << 7;
+			continue;
+		}
+
+		if (entry->pos > fmPos) {
+			if (q->m_enabled) {
+				q->update(&SoundMgr::ms_SegBuf[fmPos * 2],
+					  entry->pos - fmPos);
+			}
+			fmPos = entry->pos;
+		}
+		applyReg(entry->reg, entry->data);
+	}
+	regLogReplay = false;
+	regLogCount = 0;
+
+	if (end > dacPos) {
+		renderRegLogDac(dacPos, end);
+	}
+	if (end > fmPos && q->m_enabled) {
+		q->update(&SoundMgr::ms_SegBuf[fmPos * 2], end - fmPos);
+	}
+
+	q->m_bufPtr = &SoundMgr::ms_SegBuf[end * 2];
+	q->m_writeLen -= (end - start);
+	regLogPos = end;
+}
+
 /***********************************************
  *          fonctions de génération            *
  ***********************************************/
@@ -1095,16 +1253,16 @@ en3 = ENV_TAB[(CH->_SLOT[S3].Ecnt >> ENV_LBITS)] + CH->_SLOT[S3].TLL + (env_LFO
 	DO_LIMIT();							\
 } while (0)
 
-#define DO_OUTPUT() do {			\
-	bufL[i] += (int)(CH->OUTd & CH->LEFT);	\
-	bufR[i] += (int)(CH->OUTd & CH->RIGHT);	\
+#define DO_OUTPUT() do {				\
+	buf[i*2] += (int)(CH->OUTd & CH->LEFT);		\
+	buf[i*2+1] += (int)(CH->OUTd & CH->RIGHT);	\
 } while (0)
 
 #define DO_OUTPUT_INT0() do {					\
 	if ((int_cnt += state.Inter_Step) & 0x04000)	{	\
 		int_cnt &= 0x3FFF;				\
-		bufL[i] += (int)(CH->OUTd & CH->LEFT);		\
-		bufR[i] += (int)(CH->OUTd & CH->RIGHT);		\
+		buf[i*2] += (int)(CH->OUTd & CH->LEFT);		\
+		buf[i*2+1] += (int)(CH->OUTd & CH->RIGHT);	\
 	} else {						\
 		i--;						\
 	}							\
@@ -1114,8 +1272,8 @@ en3 = ENV_TAB[(CH->_SLOT[S3].Ecnt >> ENV_LBITS)] + CH->_SLOT[S3].TLL + (env_LFO
 	CH->Old_OUTd = (CH->OUTd + CH->Old_OUTd) >> 1;		\
 	if ((int_cnt += state.Inter_Step) & 0x04000) {		\
 		int_cnt &= 0x3FFF;				\
-		bufL[i] += (int)(CH->Old_OUTd & CH->LEFT);	\
-		bufR[i] += (int)(CH->Old_OUTd & CH->RIGHT);	\
+		buf[i*2] += (int)(CH->Old_OUTd & CH->LEFT);	\
+		buf[i*2+1] += (int)(CH->Old_OUTd & CH->RIGHT);	\
 	} else {						\
 		i--;						\
 	}							\
@@ -1125,8 +1283,8 @@ en3 = ENV_TAB[(CH->_SLOT[S3].Ecnt >> ENV_LBITS)] + CH->_SLOT[S3].TLL + (env_LFO
 	if ((int_cnt += state.Inter_Step) & 0x04000) {		\
 		int_cnt &= 0x3FFF;				\
 		CH->Old_OUTd = (CH->OUTd + CH->Old_OUTd) >> 1;	\
-		bufL[i] += (int)(CH->Old_OUTd & CH->LEFT);	\
-		bufR[i] += (int)(CH->Old_OUTd & CH->RIGHT);	\
+		buf[i*2] += (int)(CH->Old_OUTd & CH->LEFT);	\
+		buf[i*2+1] += (int)(CH->Old_OUTd & CH->RIGHT);	\
 	} else {						\
 		i--;						\
 	} \							\
@@ -1138,8 +1296,8 @@ en3 = ENV_TAB[(CH->_SLOT[S3].Ecnt >> ENV_LBITS)] + CH->_SLOT[S3].TLL + (env_LFO
 		int_cnt &= 0x3FFF;					\
 		CH->Old_OUTd = (((int_cnt ^ 0x3FFF) * CH->OUTd) +	\
 				(int_cnt * CH->Old_OUTd)) >> 14;	\
-		bufL[i] += (int)(CH->Old_OUTd & CH->LEFT);		\
-		bufR[i] += (int)(CH->Old_OUTd & CH->RIGHT);		\
+		buf[i*2] += (int)(CH->Old_OUTd & CH->LEFT);		\
+		buf[i*2+1] += (int)(CH->Old_OUTd & CH->RIGHT);		\
 	} else {							\
 		i--;							\
 	}								\
@@ -1147,7 +1305,7 @@ en3 = ENV_TAB[(CH->_SLOT[S3].Ecnt >> ENV_LBITS)] + CH->_SLOT[S3].TLL + (env_LFO
 } while (0)
 
 template<int algo>
-inline void Ym2612Private::T_Update_Chan(channel_t *CH, int32_t *bufL, int32_t *bufR, int length)
+inline void Ym2612Private::T_Update_Chan(channel_t *CH, int32_t *buf, int length)
 {
 	// Check if the channel has reached the end of the update.
 	{
@@ -1213,7 +1371,7 @@ inline void Ym2612Private::T_Update_Chan(channel_t *CH, int32_t *bufL, int32_t *
 }
 
 template<int algo>
-inline void Ym2612Private::T_Update_Chan_LFO(channel_t *CH, int32_t *bufL, int32_t *bufR, int length)
+inline void Ym2612Private::T_Update_Chan_LFO(channel_t *CH, int32_t *buf, int length)
 {
 	// Check if the channel has reached the end of the update.
 	{
@@ -1285,7 +1443,7 @@ inline void Ym2612Private::T_Update_Chan_LFO(channel_t *CH, int32_t *bufL, int32
  *****************************************************/
 
 template<int algo>
-inline void Ym2612Private::T_Update_Chan_Int(channel_t *CH, int32_t *bufL, int32_t *bufR, int length)
+inline void Ym2612Private::T_Update_Chan_Int(channel_t *CH, int32_t *buf, int length)
 {
 	// Check if the channel has reached the end of the update.
 	{
@@ -1353,7 +1511,7 @@ inline void Ym2612Private::T_Update_Chan_Int(channel_t *CH, int32_t *bufL, int32
 }
 
 template<int algo>
-inline void Ym2612Private::T_Update_Chan_LFO_Int(channel_t *CH, int32_t *bufL, int32_t *bufR, int length)
+inline void Ym2612Private::T_Update_Chan_LFO_Int(channel_t *CH, int32_t *buf, int length)
 {
 	// Check if the channel has reached the end of the update.
 	{
@@ -1427,44 +1585,44 @@ inline void Ym2612Private::T_Update_Chan_LFO_Int(channel_t *CH, int32_t *bufL, i
  * NOTE: This will probably be slower than the function pointer table.
  * TODO: Figure out how to optimize it!
  */
-void Ym2612Private::Update_Chan(int algo_type, channel_t *CH, int32_t *bufL, int32_t *bufR, int length)
+void Ym2612Private::Update_Chan(int algo_type, channel_t *CH, int32_t *buf, int length)
 {
 	switch (algo_type & 0x1F) {
-		case 0x00:	T_Update_Chan<0>(CH, bufL, bufR, length);		break;
-		case 0x01:	T_Update_Chan<1>(CH, bufL, bufR, length);		break;
-		case 0x02:	T_Update_Chan<2>(CH, bufL, bufR, length);		break;
-		case 0x03:	T_Update_Chan<3>(CH, bufL, bufR, length);		break;
-		case 0x04:	T_Update_Chan<4>(CH, bufL, bufR, length);		break;
-		case 0x05:	T_Update_Chan<5>(CH, bufL, bufR, length);		break;
-		case 0x06:	T_Update_Chan<6>(CH, bufL, bufR, length);		break;
-		case 0x07:	T_Update_Chan<7>(CH, bufL, bufR, length);		break;
-
-		case 0x08:	T_Update_Chan_LFO<0>(CH, bufL, bufR, length);		break;
-		case 0x09:	T_Update_Chan_LFO<1>(CH, bufL, bufR, length);		break;
-		case 0x0A:	T_Update_Chan_LFO<2>(CH, bufL, bufR, length);		break;
-		case 0x0B:	T_Update_Chan_LFO<3>(CH, bufL, bufR, length);		break;
-		case 0x0C:	T_Update_Chan_LFO<4>(CH, bufL, bufR, length);		break;
-		case 0x0D:	T_Update_Chan_LFO<5>(CH, bufL, bufR, length);		break;
-		case 0x0E:	T_Update_Chan_LFO<6>(CH, bufL, bufR, length);		break;
-		case 0x0F:	T_Update_Chan_LFO<7>(CH, bufL, bufR, length);		break;
-
-		case 0x10:	T_Update_Chan_Int<0>(CH, bufL, bufR, length);		break;
-		case 0x11:	T_Update_Chan_Int<1>(CH, bufL, bufR, length);		break;
-		case 0x12:	T_Update_Chan_Int<2>(CH, bufL, bufR, length);		break;
-		case 0x13:	T_Update_Chan_Int<3>(CH, bufL, bufR, length);		break;
-		case 0x14:	T_Update_Chan_Int<4>(CH, bufL, bufR, length);		break;
-		case 0x15:	T_Update_Chan_Int<5>(CH, bufL, bufR, length);		break;
-		case 0x16:	T_Update_Chan_Int<6>(CH, bufL, bufR, length);		break;
-		case 0x17:	T_Update_Chan_Int<7>(CH, bufL, bufR, length);		break;
-
-		case 0x18:	T_Update_Chan_LFO_Int<0>(CH, bufL, bufR, length);	break;
-		case 0x19:	T_Update_Chan_LFO_Int<1>(CH, bufL, bufR, length);	break;
-		case 0x1A:	T_Update_Chan_LFO_Int<2>(CH, bufL, bufR, length);	break;
-		case 0x1B:	T_Update_Chan_LFO_Int<3>(CH, bufL, bufR, length);	break;
-		case 0x1C:	T_Update_Chan_LFO_Int<4>(CH, bufL, bufR, length);	break;
-		case 0x1D:	T_Update_Chan_LFO_Int<5>(CH, bufL, bufR, length);	break;
-		case 0x1E:	T_Update_Chan_LFO_Int<6>(CH, bufL, bufR, length);	break;
-		case 0x1F:	T_Update_Chan_LFO_Int<7>(CH, bufL, bufR, length);	break;
+		case 0x00:	T_Update_Chan<0>(CH, buf, length);		break;
+		case 0x01:	T_Update_Chan<1>(CH, buf, length);		break;
+		case 0x02:	T_Update_Chan<2>(CH, buf, length);		break;
+		case 0x03:	T_Update_Chan<3>(CH, buf, length);		break;
+		case 0x04:	T_Update_Chan<4>(CH, buf, length);		break;
+		case 0x05:	T_Update_Chan<5>(CH, buf, length);		break;
+		case 0x06:	T_Update_Chan<6>(CH, buf, length);		break;
+		case 0x07:	T_Update_Chan<7>(CH, buf, length);		break;
+
+		case 0x08:	T_Update_Chan_LFO<0>(CH, buf, length);		break;
+		case 0x09:	T_Update_Chan_LFO<1>(CH, buf, length);		break;
+		case 0x0A:	T_Update_Chan_LFO<2>(CH, buf, length);		break;
+		case 0x0B:	T_Update_Chan_LFO<3>(CH, buf, length);		break;
+		case 0x0C:	T_Update_Chan_LFO<4>(CH, buf, length);		break;
+		case 0x0D:	T_Update_Chan_LFO<5>(CH, buf, length);		break;
+		case 0x0E:	T_Update_Chan_LFO<6>(CH, buf, length);		break;
+		case 0x0F:	T_Update_Chan_LFO<7>(CH, buf, length);		break;
+
+		case 0x10:	T_Update_Chan_Int<0>(CH, buf, length);		break;
+		case 0x11:	T_Update_Chan_Int<1>(CH, buf, length);		break;
+		case 0x12:	T_Update_Chan_Int<2>(CH, buf, length);		break;
+		case 0x13:	T_Update_Chan_Int<3>(CH, buf, length);		break;
+		case 0x14:	T_Update_Chan_Int<4>(CH, buf, length);		break;
+		case 0x15:	T_Update_Chan_Int<5>(CH, buf, length);		break;
+		case 0x16:	T_Update_Chan_Int<6>(CH, buf, length);		break;
+		case 0x17:	T_Update_Chan_Int<7>(CH, buf, length);		break;
+
+		case 0x18:	T_Update_Chan_LFO_Int<0>(CH, buf, length);	break;
+		case 0x19:	T_Update_Chan_LFO_Int<1>(CH, buf, length);	break;
+		case 0x1A:	T_Update_Chan_LFO_Int<2>(CH, buf, length);	break;
+		case 0x1B:	T_Update_Chan_LFO_Int<3>(CH, buf, length);	break;
+		case 0x1C:	T_Update_Chan_LFO_Int<4>(CH, buf, length);	break;
+		case 0x1D:	T_Update_Chan_LFO_Int<5>(CH, buf, length);	break;
+		case 0x1E:	T_Update_Chan_LFO_Int<6>(CH, buf, length);	break;
+		case 0x1F:	T_Update_Chan_LFO_Int<7>(CH, buf, length);	break;
 
 		default:
 			break;
@@ -1485,6 +1643,9 @@ Ym2612::Ym2612()
 	m_enabled = true;	// TODO: Make this customizable.
 	m_dacEnabled = true;	// TODO: Make this customizable.
 	m_improved = true;	// TODO: Make this customizable.
+	m_batched = false;
+	m_simdEngine = true;
+	resetBufferPtrs();
 }
 
 Ym2612::Ym2612(int clock, int rate)
@@ -1495,6 +1656,9 @@ Ym2612::Ym2612(int clock, int rate)
 	m_enabled = true;	// TODO: Make this customizable.
 	m_dacEnabled = true;	// TODO: Make this customizable.
 	m_improved = true;	// TODO: Make this customizable.
+	m_batched = false;
+	m_simdEngine = true;
+	resetBufferPtrs();
 	
 	reInit(clock, rate);
 }
@@ -1519,7 +1683,10 @@ int Ym2612::reInit(int clock, int rate)
 		return -1;
 
 	// Clear the state struct.
+	// Logged writes are discarded.
 	memset(&d->state, 0, sizeof(d->state));
+	d->regLogCount = 0;
+	d->int_cnt = 0;
 	d->state.Clock = clock;
 	d->state.Rate = rate;
 
@@ -1641,6 +1808,13 @@ void Ym2612::reset(void)
 	d->state.OPNAadr = 0;
 	d->state.OPNBadr = 0;
 	d->state.Inter_Cnt = 0;
+	d->int_cnt = 0;
+
+	// Logged writes are discarded.
+	// New writes must be logged after the current position.
+	d->regLogCount = 0;
+	d->regLogPos = (int)(m_bufPtr - SoundMgr::ms_SegBuf) / 2;
+	d->regLogReplay = false;
 
 	for (int i = 0; i < 6; i++) {
 		d->state.CHANNEL[i].Old_OUTd = 0;
@@ -1786,6 +1960,7 @@ int Ym2612::write(unsigned int address, uint8_t data)
 				}
 				*/
 
+				d->TIMER_SET(d->state.OPNAadr, data);
 				d->YM_SET(d->state.OPNAadr, data);
 			}
 			break;
@@ -1827,13 +2002,97 @@ int Ym2612::write(unsigned int address, uint8_t data)
 	return 0;
 }
 
+/**
+ * Write to a YM2612 register.
+ * If batched synthesis is enabled, the write is logged
+ * and applied to the audio output by specialUpdate().
+ * Timer registers are always applied immediately.
+ * @param address Address.
+ * @param data Data.
+ * @param mclk Timestamp, in master clock cycles from the start of the frame.
+ * @param lines Number of lines in the frame. (VDP_Lines.totalDisplayLines)
+ * @return 0 on success; non-zero on error. (TODO: This isn't used by anything!)
+ */
+int Ym2612::write(unsigned int address, uint8_t data, int mclk, int lines)
+{
+	if (!m_batched)
+		return write(address, data);
+
+	int reg;
+	switch (address & 0x03) {
+		case 0:
+			d->state.OPNAadr = data;
+			return 0;
+
+		case 1:
+			reg = d->state.OPNAadr;
+			if (reg == 0x2A) {
+				// DAC data.
+				break;
+			}
+
+			if (reg < 0x30) {
+				// YM2612 control registers.
+				d->state.REG[0][reg] = data;
+				d->TIMER_SET(reg, data);
+				if (reg >= 0x24 && reg <= 0x26) {
+					// Timer registers don't affect the audio output.
+					return 0;
+				}
+				break;
+			}
+
+			if (d->state.REG[0][reg] == data) {
+				// Don't bother doing anything if the
+				// register has the same value.
+				return 2;
+			}
+			d->state.REG[0][reg] = data;
+			break;
+
+		case 2:
+			d->state.OPNBadr = data;
+			return 0;
+
+		case 3:
+		default:
+			reg = d->state.OPNBadr;
+			if (reg < 0x30) {
+				// Invalid register.
+				return 1;
+			}
+
+			if (d->state.REG[1][reg] == data) {
+				// Don't bother doing anything if the
+				// register has the same value.
+				return 2;
+			}
+			d->state.REG[1][reg] = data;
+			reg |= 0x100;
+			break;
+	}
+
+	// Convert the timestamp to a segment buffer position.
+	if (mclk < 0)
+		mclk = 0;
+	// Writes past the end of the frame are logged
+	// at the end of the last line.
+	int line = (mclk / Scheduler::MCLK_PER_LINE);
+	if (line >= lines)
+		line = lines - 1;
+	const int pos = SoundMgr::GetWritePos(line) +
+		((mclk - (line * Scheduler::MCLK_PER_LINE)) *
+		 SoundMgr::GetWriteLen(line) / Scheduler::MCLK_PER_LINE);
+	d->logReg(pos, reg, data);
+	return 0;
+}
+
 /**
  * Update the YM2612 audio output.
- * @param bufL Left audio buffer. (16-bit; int32_t is used for saturation.)
- * @param bufR Right audio buffer. (16-bit; int32_t is used for saturation.)
+ * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
  * @param length Length to write.
  */
-void Ym2612::update(int32_t *bufL, int32_t *bufR, int length)
+void Ym2612::update(int32_t *buf, int length)
 {
 	LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG4,
 		"Starting generating sound...");
@@ -1914,14 +2173,23 @@ void Ym2612::update(int32_t *bufL, int32_t *bufR, int length)
 		algo_type |= 8;
 	}
 
-	d->Update_Chan((d->state.CHANNEL[0].ALGO + algo_type), &(d->state.CHANNEL[0]), bufL, bufR, length);
-	d->Update_Chan((d->state.CHANNEL[1].ALGO + algo_type), &(d->state.CHANNEL[1]), bufL, bufR, length);
-	d->Update_Chan((d->state.CHANNEL[2].ALGO + algo_type), &(d->state.CHANNEL[2]), bufL, bufR, length);
-	d->Update_Chan((d->state.CHANNEL[3].ALGO + algo_type), &(d->state.CHANNEL[3]), bufL, bufR, length);
-	d->Update_Chan((d->state.CHANNEL[4].ALGO + algo_type), &(d->state.CHANNEL[4]), bufL, bufR, length);
-	if (!(d->state.DAC)) {
-		// Update channel 6 only if DAC is disabled.
-		d->Update_Chan((d->state.CHANNEL[5].ALGO + algo_type), &(d->state.CHANNEL[5]), bufL, bufR, length);
+#ifdef YM2612_HAS_AVX2
+	if (m_simdEngine && (CPU_Flags & MDP_CPUFLAG_X86_AVX2)) {
+		// Update all channels at once.
+		// Channel 6 is skipped if DAC is enabled.
+		d->Update_All_AVX2(algo_type, buf, length);
+	} else
+#endif /* YM2612_HAS_AVX2 */
+	{
+		d->Update_Chan((d->state.CHANNEL[0].ALGO + algo_type), &(d->state.CHANNEL[0]), buf, length);
+		d->Update_Chan((d->state.CHANNEL[1].ALGO + algo_type), &(d->state.CHANNEL[1]), buf, length);
+		d->Update_Chan((d->state.CHANNEL[2].ALGO + algo_type), &(d->state.CHANNEL[2]), buf, length);
+		d->Update_Chan((d->state.CHANNEL[3].ALGO + algo_type), &(d->state.CHANNEL[3]), buf, length);
+		d->Update_Chan((d->state.CHANNEL[4].ALGO + algo_type), &(d->state.CHANNEL[4]), buf, length);
+		if (!(d->state.DAC)) {
+			// Update channel 6 only if DAC is disabled.
+			d->Update_Chan((d->state.CHANNEL[5].ALGO + algo_type), &(d->state.CHANNEL[5]), buf, length);
+		}
 	}
 
 	d->state.Inter_Cnt = d->int_cnt;
@@ -2126,6 +2394,7 @@ int YM2612_Restore_Full(gsx_v7_ym2612 *save)
 	YM2612.TimerBL		= le32_to_cpu(save->timerBL);
 	YM2612.TimerBcnt	= le32_to_cpu(save->timerBcnt);
 	YM2612.Mode		= le32_to_cpu(save->mode);
+	YM2612.TimerMode	= YM2612.Mode;
 	YM2612.DAC		= le32_to_cpu(save->dac_enabled);
 	YM2612.DACdata		= le32_to_cpu(save->dac_data);
 	
@@ -2241,44 +2510,49 @@ int YM2612_Restore_Full(gsx_v7_ym2612 *save)
 
 /**
  * Update the YM2612 DAC output and timers.
- * @param bufL Left audio buffer. (16-bit; int32_t is used for saturation.)
- * @param bufR Right audio buffer. (16-bit; int32_t is used for saturation.)
+ * @param buf Interleaved stereo audio buffer. (16-bit; int32_t is used for saturation.)
  * @param length Length of the output buffer.
  */
-void Ym2612::updateDacAndTimers(int32_t *bufL, int32_t *bufR, int length)
+void Ym2612::updateDacAndTimers(int32_t *buf, int length)
 {
 	// Update DAC.
-	if (d->state.DAC && d->state.DACdata && m_dacEnabled) {
+	// If synthesis is batched, the DAC is updated by specialUpdate().
+	if (!m_batched && d->state.DAC && d->state.DACdata && m_dacEnabled) {
 		for (int i = 0; i < length; i++) {
-			bufL[i] += (d->state.DACdata & d->state.CHANNEL[5].LEFT);
-			bufR[i] += (d->state.DACdata & d->state.CHANNEL[5].RIGHT);
+			buf[i*2] += (d->state.DACdata & d->state.CHANNEL[5].LEFT);
+			buf[i*2+1] += (d->state.DACdata & d->state.CHANNEL[5].RIGHT);
 		}
 	}
 
 	// Update timers.
 	int i = d->state.TimerBase * length;
 	
-	if (d->state.Mode & 1) {
+	if (d->state.TimerMode & 1) {
 		// Timer A is ON.
 		//if ((YM2612.TimerAcnt -= 14073) <= 0)           // 13879=NTSC (old: 14475=NTSC  14586=PAL)
 		if ((d->state.TimerAcnt -= i) <= 0) {
-			d->state.status |= (d->state.Mode & 0x04) >> 2;
+			d->state.status |= (d->state.TimerMode & 0x04) >> 2;
 			d->state.TimerAcnt += d->state.TimerAL;
 
 			LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG1,
 				"Counter A overflow");
 
-			if (d->state.Mode & 0x80) {
-				d->CSM_Key_Control();
+			if (d->state.TimerMode & 0x80) {
+				if (!m_batched) {
+					d->CSM_Key_Control();
+				} else {
+					d->logReg((int)(buf - SoundMgr::ms_SegBuf) / 2,
+						  Ym2612Private::REG_LOG_CSM, 0);
+				}
 			}
 		}
 	}
 
-	if (d->state.Mode & 2) {
+	if (d->state.TimerMode & 2) {
 		// Timer B is ON.
 		//if ((d->state.TimerBcnt -= 14073) <= 0)           // 13879=NTSC (old: 14475=NTSC  14586=PAL)
 		if ((d->state.TimerBcnt -= i) <= 0) {
-			d->state.status |= (d->state.Mode & 0x08) >> 2;
+			d->state.status |= (d->state.TimerMode & 0x08) >> 2;
 			d->state.TimerBcnt += d->state.TimerBL;
 
 			LOG_MSG(ym2612, LOG_MSG_LEVEL_DEBUG1,
@@ -2292,25 +2566,24 @@ void Ym2612::updateDacAndTimers(int32_t *bufL, int32_t *bufR, int length)
  */
 void Ym2612::specialUpdate(void)
 {
+	if (m_batched) {
+		// Replay the register log up to the end of the current line.
+		if (d->regLogReplay || (m_writeLen <= 0 && d->regLogCount == 0))
+			return;
+		d->flushRegLog((int)(m_bufPtr - SoundMgr::ms_SegBuf) / 2 + m_writeLen);
+		return;
+	}
+
 	if (!(m_writeLen > 0 && m_enabled))
 		return;
 
 	// Update the sound buffer.
-	update(m_bufPtrL, m_bufPtrR, m_writeLen);
-	m_writeLen = 0;
-
-	// TODO: Don't use EmuContext here...
-	int line_num = 1;
-	EmuContext *context = EmuContext::Instance();
-	if (context != nullptr)
-		line_num = (context->m_vdp->VDP_Lines.currentLine + 1);
-
-	// Determine the new starting position.
-	int writePos = SoundMgr::GetWritePos(line_num);
+	update(m_bufPtr, m_writeLen);
 
-	// Update the PSG buffer pointers.
-	m_bufPtrL = &SoundMgr::ms_SegBufL[writePos];
-	m_bufPtrR = &SoundMgr::ms_SegBufR[writePos];
+	// The write length includes the current line,
+	// so the next update starts on the next line.
+	m_bufPtr += (m_writeLen * 2);
+	m_writeLen = 0;
 }
 
 /**
@@ -2331,8 +2604,34 @@ int Ym2612::getReg(int regID) const
  */
 void Ym2612::resetBufferPtrs(void)
 {
-	m_bufPtrL = &SoundMgr::ms_SegBufL[0];
-	m_bufPtrR = &SoundMgr::ms_SegBufR[0];
+	if (d->regLogCount > 0) {
+		// Apply the logged writes before resetting.
+		specialUpdate();
+	}
+
+	m_bufPtr = &SoundMgr::ms_SegBuf[0];
+	d->regLogPos = 0;
+}
+
+/**
+ * Enable or disable batched synthesis.
+ * If batched synthesis is being disabled,
+ * the register log is flushed first.
+ * @param batched If true, enable batched synthesis.
+ */
+void Ym2612::setBatched(bool batched)
+{
+	if (m_batched == batched)
+		return;
+
+	if (m_batched) {
+		// Flush the register log.
+		specialUpdate();
+	} else {
+		// New writes must be logged after the current position.
+		d->regLogPos = (int)(m_bufPtr - SoundMgr::ms_SegBuf) / 2;
+	}
+	m_batched = batched;
 }
 
 /* end */
@@ -53,7 +53,8 @@ class Ym2612
 
 		uint8_t read(void) const;
 		int write(unsigned int address, uint8_t data);
-		void update(int32_t *bufL, int32_t *bufR, int length);
+		int write(unsigned int address, uint8_t data, int mclk, int lines);
+		void update(int32_t *buf, int length);
 
 		// Properties.
 		// TODO: Read-only for now.
@@ -61,12 +62,46 @@ class Ym2612
 		bool dacEnabled(void) const { return m_dacEnabled; }
 		bool improved(void) const { return m_improved; }
 
+		/**
+		 * Is batched synthesis enabled?
+		 * If enabled, timestamped register writes are logged,
+		 * and audio is synthesized in batches between the
+		 * logged writes when specialUpdate() is called.
+		 * Timers and the status register are still updated
+		 * when the write occurs.
+		 * @return True if batched synthesis is enabled.
+		 */
+		bool batched(void) const { return m_batched; }
+
+		/**
+		 * Enable or disable batched synthesis.
+		 * If batched synthesis is being disabled,
+		 * the register log is flushed first.
+		 * @param batched If true, enable batched synthesis.
+		 */
+		void setBatched(bool batched);
+
+		/**
+		 * Is the SIMD FM engine enabled?
+		 * If enabled, and the CPU supports it, all channels
+		 * are synthesized at once. The output is identical
+		 * to the scalar FM engine.
+		 * @return True if the SIMD FM engine is enabled.
+		 */
+		bool simdEngine(void) const { return m_simdEngine; }
+
+		/**
+		 * Enable or disable the SIMD FM engine.
+		 * @param simdEngine If true, enable the SIMD FM engine.
+		 */
+		void setSimdEngine(bool simdEngine) { m_simdEngine = simdEngine; }
+
 		/** ZOMG savestate functions. **/
 		void zomgSave(_Zomg_Ym2612Save_t *state) const;
 		void zomgRestore(const _Zomg_Ym2612Save_t *state);
 
 		/** Gens-specific code. **/
-		void updateDacAndTimers(int32_t *bufL, int32_t *bufR, int length);
+		void updateDacAndTimers(int32_t *buf, int length);
 		void specialUpdate(void);
 		int getReg(int regID) const;
 
@@ -85,11 +120,12 @@ class Ym2612
 		bool m_enabled;		// YM2612 Enabled
 		bool m_dacEnabled;	// DAC Enabled
 		bool m_improved;	// YM2612 Improved
+		bool m_batched;		// Batched synthesis
+		bool m_simdEngine;	// SIMD FM engine
 		
-		// YM buffer pointers.
-		// TODO: Figure out how to get rid of these!
-		int32_t *m_bufPtrL;
-		int32_t *m_bufPtrR;
+		// YM buffer pointer. (interleaved stereo)
+		// TODO: Figure out how to get rid of this!
+		int32_t *m_bufPtr;
 };
 
 /* Gens */
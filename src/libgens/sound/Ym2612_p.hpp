@@ -30,6 +30,14 @@
 #define PI 3.14159265358979323846
 #endif
 
+// NOTE: The SIMD FM engine uses intrinsics with the target
+// attribute, so libgens doesn't need to be built with -mavx2.
+#if defined(__GNUC__) && \
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define YM2612_HAS_AVX2 1
+#endif
+
 namespace LibGens {
 
 class Ym2612;
@@ -128,6 +136,7 @@ class Ym2612Private
 			int TimerBL;
 			int TimerBcnt;		// timerB counter = valeur courante du Timer B
 			int Mode;		// Mode actuel des voie 3 et 6 (normal / spécial)
+			int TimerMode;		// Timer mode. (register 0x27, as seen by the timers)
 			int DAC;		// DAC enabled flag
 			int DACdata;		// DAC data
 
@@ -236,7 +245,6 @@ class Ym2612Private
 		};
 
 		// Static tables.
-		static bool isInit;	// True if the static tables have been initialized.
 		static int *SIN_TAB[SIN_LENGTH];			// SINUS TABLE (pointer on TL TABLE)
 		static int TL_TAB[TL_LENGTH * 2];			// TOTAL LEVEL TABLE (plus and minus)
 		static unsigned int ENV_TAB[2 * ENV_LENGTH * 8];	// ENV CURVE TABLE (attack & decay)
@@ -303,21 +311,86 @@ class Ym2612Private
 		int SLOT_SET(int address, uint8_t data);
 		int CHANNEL_SET(int address, uint8_t data);
 		int YM_SET(int address, uint8_t data);
+		int TIMER_SET(int address, uint8_t data);
+
+		/** Register log. (batched synthesis) **/
+
+		// Register log entry.
+		struct RegLogEntry_t {
+			uint16_t pos;	// Sample position in the segment buffer.
+			uint16_t reg;	// Register number. (0x000-0x1FF, or REG_LOG_CSM)
+			uint8_t data;	// Data.
+		};
+
+		// Maximum number of logged writes.
+		// If the log fills up, it's flushed early.
+		static const int REG_LOG_SIZE = 1024;
+
+		// CSM key-on caused by a Timer A overflow.
+		static const int REG_LOG_CSM = 0x200;
+
+		RegLogEntry_t regLog[REG_LOG_SIZE];
+		int regLogCount;	// Number of entries in regLog[].
+		int regLogPos;		// Position of the last logged entry.
+		bool regLogReplay;	// True while the log is being replayed.
+
+		/**
+		 * Add an entry to the register log.
+		 * @param pos Sample position in the segment buffer.
+		 * @param reg Register number.
+		 * @param data Data.
+		 */
+		void logReg(int pos, int reg, uint8_t data);
+
+		/**
+		 * Apply a logged register write.
+		 * DAC data writes are handled by flushRegLog().
+		 * @param reg Register number.
+		 * @param data Data.
+		 */
+		void applyReg(int reg, uint8_t data);
+
+		/**
+		 * Add the DAC output between two register log entries.
+		 * @param start Starting position in the segment buffer.
+		 * @param end Ending position in the segment buffer.
+		 */
+		void renderRegLogDac(int start, int end);
+
+		/**
+		 * Replay the register log, rendering audio up to the specified position.
+		 * @param end Ending position in the segment buffer.
+		 */
+		void flushRegLog(int end);
 
 		/** Update Channel templates. **/
 		template<int algo>
-		inline void T_Update_Chan(channel_t *CH, int32_t *bufL, int32_t *bufR, int length);
+		inline void T_Update_Chan(channel_t *CH, int32_t *buf, int length);
 
 		template<int algo>
-		inline void T_Update_Chan_LFO(channel_t *CH, int32_t *bufL, int32_t *bufR, int length);
+		inline void T_Update_Chan_LFO(channel_t *CH, int32_t *buf, int length);
 
 		template<int algo>
-		inline void T_Update_Chan_Int(channel_t *CH, int32_t *bufL, int32_t *bufR, int length);
+		inline void T_Update_Chan_Int(channel_t *CH, int32_t *buf, int length);
 
 		template<int algo>
-		inline void T_Update_Chan_LFO_Int(channel_t *CH, int32_t *bufL, int32_t *bufR, int length);
+		inline void T_Update_Chan_LFO_Int(channel_t *CH, int32_t *buf, int length);
+
+		void Update_Chan(int algo_type, channel_t *CH, int32_t *buf, int length);
+
+#ifdef YM2612_HAS_AVX2
+		/** SIMD FM engine. (Ym2612_simd.cpp) **/
+
+		// Sine table as offsets into TL_TAB, so the operator output
+		// is TL_TAB[SIN_OFF_TAB[phase] + env]. (scalar loads in gather6())
+		static int SIN_OFF_TAB[SIN_LENGTH];
+
+		template<bool lfo, bool interp>
+		__attribute__((target("avx2")))
+		void T_Update_All_AVX2(int32_t *buf, int length);
 
-		void Update_Chan(int algo_type, channel_t *CH, int32_t *bufL, int32_t *bufR, int length);
+		void Update_All_AVX2(int algo_type, int32_t *buf, int length);
+#endif /* YM2612_HAS_AVX2 */
 };
 
 }
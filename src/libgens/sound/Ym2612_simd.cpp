@@ -0,0 +1,507 @@
+/***************************************************************************
+ * libgens: Gens Emulation Library.                                        *
+ * Ym2612_simd.cpp: Yamaha YM2612 FM synthesis chip emulator.              *
+ * SIMD FM operator engine. (structure-of-arrays)                          *
+ *                                                                         *
+ * Copyright (c) 1999-2002 by Stéphane Dallongeville                       *
+ * Copyright (c) 2003-2004 by Stéphane Akhoun                              *
+ * Copyright (c) 2008-2016 by David Korth                                  *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "Ym2612.hpp"
+#include "Ym2612_p.hpp"
+
+#ifdef YM2612_HAS_AVX2
+
+// C includes.
+#include <stdint.h>
+#include <limits.h>
+
+// AVX2 intrinsics.
+// The functions that use them are compiled with target("avx2"),
+// so the rest of libgens doesn't need to be built with -mavx2.
+#include <immintrin.h>
+
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+namespace LibGens {
+
+/**
+ * The AVX2 engine processes all active channels at once.
+ * Each channel is a 32-bit lane in a 256-bit vector, and each
+ * slot parameter is stored in its own vector. (structure-of-arrays)
+ *
+ * The operators are computed in the order S0, S1, S2, S3 for all
+ * lanes. The algorithm's routing is handled with per-lane masks:
+ * each operator's output is added to the phase of the operators
+ * it modulates, and to the channel output if it's a carrier.
+ *
+ * Table lookups are done with scalar loads; see gather6().
+ *
+ * Envelope phase changes are rare, so they're handled by the
+ * scalar ENV_NEXT_EVENT[] functions.
+ *
+ * The output is bit-identical to T_Update_Chan() and friends.
+ */
+
+// Slot order used by the algorithms.
+static const int SLOT_ORDER[4] = {
+	Ym2612Private::S0, Ym2612Private::S1,
+	Ym2612Private::S2, Ym2612Private::S3
+};
+
+// Operator routing for each algorithm.
+// Bits 0-2: S0 -> S1, S2, S3
+// Bits 3-4: S1 -> S2, S3
+// Bit 5: S2 -> S3
+// Bits 6-8: S0, S1, S2 are carriers. (S3 is always a carrier.)
+// Bit 9: Limit the channel output.
+enum {
+	R_01 = (1 << 0), R_02 = (1 << 1), R_03 = (1 << 2),
+	R_12 = (1 << 3), R_13 = (1 << 4),
+	R_23 = (1 << 5),
+	R_C0 = (1 << 6), R_C1 = (1 << 7), R_C2 = (1 << 8),
+	R_LIMIT = (1 << 9),
+};
+
+static const uint16_t ALGO_ROUTING[8] = {
+	R_01 | R_12 | R_23,				// Algorithm 0
+	R_02 | R_12 | R_23,				// Algorithm 1
+	R_03 | R_12 | R_23,				// Algorithm 2
+	R_01 | R_13 | R_23,				// Algorithm 3
+	R_01 | R_23 | R_C1 | R_LIMIT,			// Algorithm 4
+	R_01 | R_02 | R_03 | R_C1 | R_C2 | R_LIMIT,	// Algorithm 5
+	R_01 | R_C1 | R_C2 | R_LIMIT,			// Algorithm 6
+	R_C0 | R_C1 | R_C2 | R_LIMIT,			// Algorithm 7
+};
+
+/**
+ * Check if a channel's carriers have reached the end of the envelope.
+ * Same check as T_Update_Chan().
+ * @param CH Channel.
+ * @return True if the channel should be updated.
+ */
+static inline bool isChannelActive(const Ym2612Private::channel_t *CH)
+{
+	int not_end = (CH->_SLOT[Ym2612Private::S3].Ecnt - Ym2612Private::ENV_END);
+
+	// Special cases.
+	// Copied from Game_Music_Emu v0.5.2.
+	const int algo = CH->ALGO;
+	if (algo == 7)
+		not_end |= (CH->_SLOT[Ym2612Private::S0].Ecnt - Ym2612Private::ENV_END);
+	if (algo >= 5)
+		not_end |= (CH->_SLOT[Ym2612Private::S2].Ecnt - Ym2612Private::ENV_END);
+	if (algo >= 4)
+		not_end |= (CH->_SLOT[Ym2612Private::S1].Ecnt - Ym2612Private::ENV_END);
+
+	return (not_end != 0);
+}
+
+/**
+ * Build a lane mask from a routing bit.
+ * @param routing Routing bits for each lane.
+ * @param bit Routing bit.
+ * @return Lane mask. (all ones if the bit is set)
+ */
+static inline AVX2_FUNC __m256i routingMask(const __m256i routing, int bit)
+{
+	const __m256i vbit = _mm256_set1_epi32(bit);
+	return _mm256_cmpeq_epi32(_mm256_and_si256(routing, vbit), vbit);
+}
+
+/**
+ * Gather 32-bit values from a table.
+ * Only the first six lanes are gathered, since there are only six
+ * channels. Lanes 6 and 7 are always 0.
+ *
+ * NOTE: This is faster than vpgatherdd on many CPUs,
+ * especially with the GDS microcode mitigation.
+ *
+ * @param base Table.
+ * @param idx Indexes.
+ * @return Values.
+ */
+static inline AVX2_FUNC __m256i gather6(const int *base, const __m256i idx)
+{
+	union {
+		__m256i v;
+		int i[8];
+	} u;
+	u.v = idx;
+	return _mm256_setr_epi32(
+		base[u.i[0]], base[u.i[1]], base[u.i[2]],
+		base[u.i[3]], base[u.i[4]], base[u.i[5]], 0, 0);
+}
+
+/**
+ * Look up the operator output.
+ * Equivalent to SIN_TAB[(in >> SIN_LBITS) & SIN_MASK][en].
+ * @param in Phase.
+ * @param en Envelope.
+ * @return Operator output.
+ */
+static inline AVX2_FUNC __m256i opOutput(const __m256i in, const __m256i en)
+{
+	const __m256i phase = _mm256_and_si256(_mm256_srli_epi32(in, SIN_LBITS),
+					_mm256_set1_epi32(Ym2612Private::SIN_MASK));
+	const __m256i off = gather6(Ym2612Private::SIN_OFF_TAB, phase);
+	return gather6(Ym2612Private::TL_TAB, _mm256_add_epi32(off, en));
+}
+
+/**
+ * Add the channel outputs to the audio buffer.
+ * @param out Channel outputs.
+ * @param left LEFT masks.
+ * @param right RIGHT masks.
+ * @param buf Stereo audio sample. (L, R)
+ */
+static inline AVX2_FUNC void addOutput(const __m256i out,
+	const __m256i left, const __m256i right, int32_t *buf)
+{
+	__m256i t = _mm256_hadd_epi32(_mm256_and_si256(out, left), _mm256_and_si256(out, right));
+	t = _mm256_hadd_epi32(t, t);
+	const __m128i s = _mm_add_epi32(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+	// s = [ ... | ... | R | L ]
+	__m128i *const dest = (__m128i*)buf;
+	_mm_storel_epi64(dest, _mm_add_epi32(_mm_loadl_epi64(dest), s));
+}
+
+/**
+ * Update all channels using AVX2.
+ * @param lfo If true, the LFO is enabled.
+ * @param interp If true, use interpolated output.
+ * @param buf Interleaved stereo audio buffer.
+ * @param length Length to write.
+ */
+template<bool lfo, bool interp>
+void Ym2612Private::T_Update_All_AVX2(int32_t *buf, int length)
+{
+	// Active channels.
+	// Channel 6 is only updated if the DAC is disabled.
+	channel_t *chs[8];
+	int nch = 0;
+	for (int ch = 0; ch < 6; ch++) {
+		if (ch == 5 && state.DAC)
+			break;
+		if (isChannelActive(&state.CHANNEL[ch]))
+			chs[nch++] = &state.CHANNEL[ch];
+	}
+	if (nch == 0)
+		return;
+
+	// Load the channel and slot state.
+	// Unused lanes have no output and no envelope events.
+	int FB[8], FMS[8], LEFT[8], RIGHT[8], ROUTING[8];
+	int S0_OUT0[8], S0_OUT1[8], OUTd[8], Old_OUTd[8];
+	int Fcnt[4][8], Finc[4][8], Ecnt[4][8], Einc[4][8], Ecmp[4][8], TLL[4][8], AMS[4][8];
+	for (int l = 0; l < 8; l++) {
+		if (l < nch) {
+			const channel_t *const CH = chs[l];
+			FB[l] = CH->FB;
+			FMS[l] = CH->FMS;
+			LEFT[l] = CH->LEFT;
+			RIGHT[l] = CH->RIGHT;
+			ROUTING[l] = ALGO_ROUTING[CH->ALGO & 7];
+			S0_OUT0[l] = CH->S0_OUT[0];
+			S0_OUT1[l] = CH->S0_OUT[1];
+			OUTd[l] = CH->OUTd;
+			Old_OUTd[l] = CH->Old_OUTd;
+			for (int k = 0; k < 4; k++) {
+				const slot_t *const SL = &CH->_SLOT[SLOT_ORDER[k]];
+				Fcnt[k][l] = SL->Fcnt;
+				Finc[k][l] = SL->Finc;
+				Ecnt[k][l] = SL->Ecnt;
+				Einc[k][l] = SL->Einc;
+				Ecmp[k][l] = SL->Ecmp;
+				TLL[k][l] = SL->TLL;
+				AMS[k][l] = SL->AMS;
+			}
+		} else {
+			FB[l] = 31;
+			FMS[l] = 0;
+			LEFT[l] = 0;
+			RIGHT[l] = 0;
+			ROUTING[l] = 0;
+			S0_OUT0[l] = 0;
+			S0_OUT1[l] = 0;
+			OUTd[l] = 0;
+			Old_OUTd[l] = 0;
+			for (int k = 0; k < 4; k++) {
+				Fcnt[k][l] = 0;
+				Finc[k][l] = 0;
+				Ecnt[k][l] = 0;
+				Einc[k][l] = 0;
+				Ecmp[k][l] = INT_MAX;
+				TLL[k][l] = 0;
+				AMS[k][l] = 31;
+			}
+		}
+	}
+
+	#define LOAD(arr) _mm256_loadu_si256((const __m256i*)(arr))
+	#define STORE(arr, v) _mm256_storeu_si256((__m256i*)(arr), (v))
+
+	const __m256i vFB = LOAD(FB);
+	const __m256i vFMS = LOAD(FMS);
+	const __m256i vLEFT = LOAD(LEFT);
+	const __m256i vRIGHT = LOAD(RIGHT);
+	const __m256i vRouting = LOAD(ROUTING);
+	const __m256i m01 = routingMask(vRouting, R_01);
+	const __m256i m02 = routingMask(vRouting, R_02);
+	const __m256i m03 = routingMask(vRouting, R_03);
+	const __m256i m12 = routingMask(vRouting, R_12);
+	const __m256i m13 = routingMask(vRouting, R_13);
+	const __m256i m23 = routingMask(vRouting, R_23);
+	const __m256i mC0 = routingMask(vRouting, R_C0);
+	const __m256i mC1 = routingMask(vRouting, R_C1);
+	const __m256i mC2 = routingMask(vRouting, R_C2);
+	const __m256i mLimit = routingMask(vRouting, R_LIMIT);
+	const __m256i vLimitMax = _mm256_set1_epi32(LIMIT_CH_OUT);
+	const __m256i vLimitMin = _mm256_set1_epi32(-LIMIT_CH_OUT);
+
+	__m256i vS0_OUT0 = LOAD(S0_OUT0);
+	__m256i vS0_OUT1 = LOAD(S0_OUT1);
+	__m256i vOUTd = LOAD(OUTd);
+	__m256i vOld_OUTd = LOAD(Old_OUTd);
+
+	__m256i vFcnt[4], vFinc[4], vEcnt[4], vEinc[4], vEcmp[4], vTLL[4], vAMS[4];
+	for (int k = 0; k < 4; k++) {
+		vFcnt[k] = LOAD(Fcnt[k]);
+		vFinc[k] = LOAD(Finc[k]);
+		vEcnt[k] = LOAD(Ecnt[k]);
+		vEinc[k] = LOAD(Einc[k]);
+		vEcmp[k] = LOAD(Ecmp[k]);
+		vTLL[k] = LOAD(TLL[k]);
+		vAMS[k] = LOAD(AMS[k]);
+	}
+
+	// Cached ENV_TAB[] lookups.
+	__m256i vEnvIdx[4], vEnvVal[4];
+	for (int k = 0; k < 4; k++) {
+		vEnvIdx[k] = _mm256_set1_epi32(-1);
+		vEnvVal[k] = _mm256_setzero_si256();
+	}
+
+	if (interp) {
+		int_cnt = state.Inter_Cnt;
+	}
+
+	// Samples are processed in blocks of BLOCK_LEN iterations.
+	// Pass 1 updates the phase and envelope counters and computes S0,
+	// which depends on the previous sample due to feedback.
+	// Pass 2 computes S1-S3 and the output. Each iteration only depends
+	// on pass 1, so the CPU can overlap the table lookups.
+	static const int BLOCK_LEN = 32;
+	__m256i blkIn[3][BLOCK_LEN], blkEn[3][BLOCK_LEN], blkS0[BLOCK_LEN];
+	int blkPos[BLOCK_LEN];		// Output sample, or -1 if none.
+	int blkIntCnt[BLOCK_LEN];	// Interpolation counter.
+
+	int i = 0;
+	while (i < length) {
+		// Pass 1: Phase, envelope, and S0.
+		int n;
+		for (n = 0; n < BLOCK_LEN && i < length; n++) {
+			__m256i in[4], en[4];
+
+			// Current phase. (GET_CURRENT_PHASE, UPDATE_PHASE)
+			if (lfo) {
+				// If freq_LFO is 0, this is the same as UPDATE_PHASE.
+				const __m256i freq_LFO = _mm256_srai_epi32(
+					_mm256_mullo_epi32(vFMS, _mm256_set1_epi32(LFO_FREQ_UP[i])),
+					LFO_HBITS - 1);
+				for (int k = 0; k < 4; k++) {
+					in[k] = vFcnt[k];
+					const __m256i fm = _mm256_srai_epi32(
+						_mm256_mullo_epi32(vFinc[k], freq_LFO), LFO_FMS_LBITS);
+					vFcnt[k] = _mm256_add_epi32(vFcnt[k], _mm256_add_epi32(vFinc[k], fm));
+				}
+			} else {
+				for (int k = 0; k < 4; k++) {
+					in[k] = vFcnt[k];
+					vFcnt[k] = _mm256_add_epi32(vFcnt[k], vFinc[k]);
+				}
+			}
+
+			// Current envelope. (GET_CURRENT_ENV, UPDATE_ENV)
+			const __m256i env_LFO = _mm256_set1_epi32(lfo ? LFO_ENV_UP[i] : 0);
+			int events = 0;
+			for (int k = 0; k < 4; k++) {
+				// ENV_TAB[] is only looked up if the index changed,
+				// since the envelope is usually constant.
+				const __m256i envIdx = _mm256_srai_epi32(vEcnt[k], ENV_LBITS);
+				if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(envIdx, vEnvIdx[k])) != -1) {
+					vEnvIdx[k] = envIdx;
+					vEnvVal[k] = gather6((const int*)ENV_TAB, envIdx);
+				}
+				en[k] = _mm256_add_epi32(vEnvVal[k], vTLL[k]);
+				if (lfo) {
+					en[k] = _mm256_add_epi32(en[k], _mm256_srav_epi32(env_LFO, vAMS[k]));
+				}
+
+				vEcnt[k] = _mm256_add_epi32(vEcnt[k], vEinc[k]);
+				// Ecnt >= Ecmp: the envelope phase has ended.
+				const int notEnded = _mm256_movemask_ps(_mm256_castsi256_ps(
+					_mm256_cmpgt_epi32(vEcmp[k], vEcnt[k])));
+				events |= ((~notEnded & 0xFF) << (k * 8));
+			}
+
+			if (events != 0) {
+				// Envelope phase change.
+				for (int k = 0; k < 4; k++) {
+					const int slotEvents = (events >> (k * 8)) & 0xFF;
+					if (slotEvents == 0)
+						continue;
+
+					STORE(Ecnt[k], vEcnt[k]);
+					STORE(Einc[k], vEinc[k]);
+					STORE(Ecmp[k], vEcmp[k]);
+					for (int l = 0; l < nch; l++) {
+						if (!(slotEvents & (1 << l)))
+							continue;
+						slot_t *const SL = &chs[l]->_SLOT[SLOT_ORDER[k]];
+						SL->Ecnt = Ecnt[k][l];
+						ENV_NEXT_EVENT[SL->Ecurp](SL);
+						Ecnt[k][l] = SL->Ecnt;
+						Einc[k][l] = SL->Einc;
+						Ecmp[k][l] = SL->Ecmp;
+					}
+					vEcnt[k] = LOAD(Ecnt[k]);
+					vEinc[k] = LOAD(Einc[k]);
+					vEcmp[k] = LOAD(Ecmp[k]);
+				}
+			}
+
+			// S0 with feedback. (DO_FEEDBACK)
+			in[0] = _mm256_add_epi32(in[0], _mm256_srav_epi32(
+				_mm256_add_epi32(vS0_OUT0, vS0_OUT1), vFB));
+			vS0_OUT1 = vS0_OUT0;
+			vS0_OUT0 = opOutput(in[0], en[0]);
+
+			blkS0[n] = vS0_OUT0;
+			for (int k = 0; k < 3; k++) {
+				blkIn[k][n] = in[k + 1];
+				blkEn[k][n] = en[k + 1];
+			}
+
+			if (!interp) {
+				blkPos[n] = i++;
+			} else {
+				// DO_OUTPUT_INT: Check if a sample is output.
+				if ((int_cnt += state.Inter_Step) & 0x04000) {
+					int_cnt &= 0x3FFF;
+					blkIntCnt[n] = int_cnt;
+					blkPos[n] = i++;
+				} else {
+					blkPos[n] = -1;
+				}
+			}
+		}
+
+		// Pass 2: S1-S3 and output. (DO_ALGO_*)
+		for (int j = 0; j < n; j++) {
+			const __m256i s0 = blkS0[j];
+
+			const __m256i in1 = _mm256_add_epi32(blkIn[0][j], _mm256_and_si256(s0, m01));
+			const __m256i s1 = opOutput(in1, blkEn[0][j]);
+
+			const __m256i in2 = _mm256_add_epi32(blkIn[1][j], _mm256_add_epi32(
+				_mm256_and_si256(s0, m02), _mm256_and_si256(s1, m12)));
+			const __m256i s2 = opOutput(in2, blkEn[1][j]);
+
+			const __m256i in3 = _mm256_add_epi32(blkIn[2][j], _mm256_add_epi32(
+				_mm256_add_epi32(_mm256_and_si256(s0, m03), _mm256_and_si256(s1, m13)),
+				_mm256_and_si256(s2, m23)));
+			const __m256i s3 = opOutput(in3, blkEn[2][j]);
+
+			__m256i out = _mm256_add_epi32(
+				_mm256_add_epi32(s3, _mm256_and_si256(s0, mC0)),
+				_mm256_add_epi32(_mm256_and_si256(s1, mC1), _mm256_and_si256(s2, mC2)));
+			out = _mm256_srai_epi32(out, OUT_SHIFT);
+
+			// DO_LIMIT
+			const __m256i limited = _mm256_max_epi32(_mm256_min_epi32(out, vLimitMax), vLimitMin);
+			vOUTd = _mm256_blendv_epi8(out, limited, mLimit);
+
+			const int pos = blkPos[j];
+			if (!interp) {
+				// DO_OUTPUT
+				addOutput(vOUTd, vLEFT, vRIGHT, &buf[pos * 2]);
+			} else {
+				// DO_OUTPUT_INT
+				if (pos >= 0) {
+					const int cnt = blkIntCnt[j];
+					vOld_OUTd = _mm256_srai_epi32(_mm256_add_epi32(
+						_mm256_mullo_epi32(_mm256_set1_epi32(cnt ^ 0x3FFF), vOUTd),
+						_mm256_mullo_epi32(_mm256_set1_epi32(cnt), vOld_OUTd)), 14);
+					addOutput(vOld_OUTd, vLEFT, vRIGHT, &buf[pos * 2]);
+				}
+				vOld_OUTd = vOUTd;
+			}
+		}
+	}
+
+	// Save the channel and slot state.
+	STORE(S0_OUT0, vS0_OUT0);
+	STORE(S0_OUT1, vS0_OUT1);
+	STORE(OUTd, vOUTd);
+	STORE(Old_OUTd, vOld_OUTd);
+	for (int k = 0; k < 4; k++) {
+		STORE(Fcnt[k], vFcnt[k]);
+		STORE(Ecnt[k], vEcnt[k]);
+	}
+
+	#undef LOAD
+	#undef STORE
+
+	for (int l = 0; l < nch; l++) {
+		channel_t *const CH = chs[l];
+		CH->S0_OUT[1] = S0_OUT1[l];
+		CH->S0_OUT[0] = S0_OUT0[l];
+		CH->OUTd = OUTd[l];
+		if (interp) {
+			CH->Old_OUTd = Old_OUTd[l];
+		}
+		for (int k = 0; k < 4; k++) {
+			slot_t *const SL = &CH->_SLOT[SLOT_ORDER[k]];
+			SL->Fcnt = Fcnt[k][l];
+			SL->Ecnt = Ecnt[k][l];
+		}
+	}
+}
+
+/**
+ * Update all channels using AVX2.
+ * @param algo_type Algorithm type. (LFO and interpolation flags only)
+ * @param buf Interleaved stereo audio buffer.
+ * @param length Length to write.
+ */
+void Ym2612Private::Update_All_AVX2(int algo_type, int32_t *buf, int length)
+{
+	switch (algo_type & 0x18) {
+		case 0x00:	T_Update_All_AVX2<false, false>(buf, length);	break;
+		case 0x08:	T_Update_All_AVX2<true, false>(buf, length);	break;
+		case 0x10:	T_Update_All_AVX2<false, true>(buf, length);	break;
+		case 0x18:	T_Update_All_AVX2<true, true>(buf, length);	break;
+		default:
+			break;
+	}
+}
+
+}
+
+#endif /* YM2612_HAS_AVX2 */
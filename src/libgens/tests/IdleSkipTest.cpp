@@ -0,0 +1,404 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * IdleSkipTest.cpp: 68000 and Z80 idle loop skipping test.                *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "Rom.hpp"
+#include "EmuContext/EmuContext.hpp"
+#include "EmuContext/EmuContextFactory.hpp"
+#include "cpu/M68K.hpp"
+#include "cpu/M68K_Mem.hpp"
+#include "cpu/Z80.hpp"
+#include "cpu/Z80_MD_Mem.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+/**
+ * Idle loops included in the test program.
+ */
+struct IdleSkipTest_loops {
+	bool vdpPoll;	// 68000: Poll the VDP status for VBlank.
+	bool ramPoll;	// 68000: Poll a RAM flag set by the VBlank handler.
+	bool ymPoll;	// Z80: Poll the YM2612 status for Timer A.
+	bool jrSelf;	// Z80: JR $ until the next interrupt.
+
+	IdleSkipTest_loops(bool vdpPoll, bool ramPoll, bool ymPoll, bool jrSelf)
+	{
+		this->vdpPoll = vdpPoll;
+		this->ramPoll = ramPoll;
+		this->ymPoll = ymPoll;
+		this->jrSelf = jrSelf;
+	}
+};
+
+/**
+ * Formatting function for IdleSkipTest_loops.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const IdleSkipTest_loops& loops) {
+	return os << (loops.vdpPoll ? "VDP " : "")
+		<< (loops.ramPoll ? "RAM " : "")
+		<< (loops.ymPoll ? "YM " : "")
+		<< (loops.jrSelf ? "JR$" : "");
+};
+
+/**
+ * Emulation state after each frame.
+ */
+struct IdleSkipTest_state {
+	vector<unsigned int> odo68K;	// 68000 odometer.
+	vector<unsigned int> odoZ80;	// Z80 odometer.
+	vector<uint8_t> ram68K;		// 68000 RAM. (final)
+	vector<uint8_t> ramZ80;		// Z80 RAM. (final)
+	unsigned int hits68K;		// 68000 idle loops skipped.
+	unsigned int hitsZ80;		// Z80 idle loops skipped.
+};
+
+class IdleSkipTest : public ::testing::TestWithParam<IdleSkipTest_loops>
+{
+	protected:
+		IdleSkipTest()
+			: ::testing::TestWithParam<IdleSkipTest_loops>() { }
+		virtual ~IdleSkipTest() { }
+
+		virtual void TearDown(void) override;
+
+	protected:
+		static const int frames = 60;
+
+		/**
+		 * Build the test ROM.
+		 * @param rom ROM image.
+		 */
+		void buildRom(vector<uint8_t> &rom) const;
+
+		/**
+		 * Run the test ROM.
+		 * @param idleSkip If true, enable idle loop skipping.
+		 * @param state Emulation state.
+		 */
+		void run(bool idleSkip, IdleSkipTest_state &state) const;
+};
+
+const int IdleSkipTest::frames;
+
+/**
+ * Disable idle loop skipping after each test.
+ */
+void IdleSkipTest::TearDown(void)
+{
+	M68K::SetIdleSkip(false);
+	Z80::SetIdleSkip(false);
+}
+
+/**
+ * Build the test ROM.
+ *
+ * 68000 main loop: (VBlank handler sets a RAM flag)
+ * - Wait for VBlank to start, then end. (VDP status poll)
+ * - Clear the flag and wait for the VBlank handler. (RAM poll)
+ * - Log the HV counter and count the frame.
+ *
+ * Z80 main loop: (interrupt handler restarts the main loop)
+ * - Wait for three Timer A overflows. (YM2612 status poll)
+ *   Log the H counter after each one.
+ * - EI, then JR $ until the next interrupt.
+ *
+ * Loops that aren't selected are left out or jumped over.
+ *
+ * @param rom ROM image.
+ */
+void IdleSkipTest::buildRom(vector<uint8_t> &rom) const
+{
+	const IdleSkipTest_loops loops = GetParam();
+	rom.assign(0x2000, 0x00);
+
+	// Z80 program.
+	uint8_t z80[0xB8];
+	memset(z80, 0x00, sizeof(z80));
+	static const uint8_t z80_init[] = {
+		0xF3,			// 0000: DI
+		0x31, 0x00, 0x20,	// 0001: LD SP,2000h
+		0xED, 0x56,		// 0004: IM 1
+		0xC3, 0x80, 0x00,	// 0006: JP 0080h
+	};
+	static const uint8_t z80_int[] = {
+		0x21, 0x00, 0x1F,	// 0038: LD HL,1F00h
+		0x34,			// 003B: INC (HL)	; Count interrupts.
+		0xE1,			// 003C: POP HL		; Discard the return address.
+		0xC3, 0x80, 0x00,	// 003D: JP 0080h	; Restart with interrupts disabled.
+	};
+	static const uint8_t z80_main[] = {
+		0x3E, 0x24,		// 0080: LD A,24h
+		0x32, 0x00, 0x40,	// 0082: LD (4000h),A
+		0x3E, 0xF0,		// 0085: LD A,F0h	; Timer A = 3C0h
+		0x32, 0x01, 0x40,	// 0087: LD (4001h),A
+		0x3E, 0x25,		// 008A: LD A,25h
+		0x32, 0x00, 0x40,	// 008C: LD (4000h),A
+		0xAF,			// 008F: XOR A
+		0x32, 0x01, 0x40,	// 0090: LD (4001h),A
+		0x06, 0x03,		// 0093: LD B,3
+		0x3E, 0x27,		// 0095: LD A,27h
+		0x32, 0x00, 0x40,	// 0097: LD (4000h),A
+		0x3E, 0x15,		// 009A: LD A,15h	; Load, enable, and reset Timer A.
+		0x32, 0x01, 0x40,	// 009C: LD (4001h),A
+		0x3A, 0x00, 0x40,	// 009F: LD A,(4000h)
+		0xE6, 0x01,		// 00A2: AND 1
+		0x28, 0xF9,		// 00A4: JR Z,009Fh
+		0x3A, 0x09, 0x7F,	// 00A6: LD A,(7F09h)	; H counter
+		0x21, 0x02, 0x1F,	// 00A9: LD HL,1F02h
+		0x5E,			// 00AC: LD E,(HL)
+		0x1C,			// 00AD: INC E
+		0x73,			// 00AE: LD (HL),E
+		0x16, 0x10,		// 00AF: LD D,10h
+		0x12,			// 00B1: LD (DE),A	; Log at 1000h-10FFh.
+		0x10, 0xE1,		// 00B2: DJNZ 0095h
+		0xFB,			// 00B4: EI
+		0x18, 0xFE,		// 00B5: JR $
+	};
+	memcpy(&z80[0x00], z80_init, sizeof(z80_init));
+	memcpy(&z80[0x38], z80_int, sizeof(z80_int));
+	memcpy(&z80[0x80], z80_main, sizeof(z80_main));
+	if (!loops.ymPoll) {
+		// 0093: EI / JR $
+		z80[0x93] = 0xFB;
+		z80[0x94] = 0x18;
+		z80[0x95] = 0xFE;
+	} else if (!loops.jrSelf) {
+		// 00B4: JP 0093h
+		z80[0xB4] = 0xC3;
+		z80[0xB5] = 0x93;
+		z80[0xB6] = 0x00;
+	}
+	memcpy(&rom[0x400], z80, sizeof(z80));
+
+	// 68000 program.
+	vector<uint16_t> m68k;
+	static const uint16_t m68k_init[] = {
+		0x41F9, 0x00C0, 0x0004,		// lea	$C00004,a0
+		0x30BC, 0x8004,			// move.w #$8004,(a0)
+		0x30BC, 0x8164,			// move.w #$8164,(a0)	; Display, VINT, Mode 5
+		0x33FC, 0x0100, 0x00A1, 0x1100,	// move.w #$100,$A11100	; Z80 bus request
+		0x33FC, 0x0100, 0x00A1, 0x1200,	// move.w #$100,$A11200
+		0x0839, 0x0000, 0x00A1, 0x1100,	// btst	#0,$A11100
+		0x66F6,				// bne.s *-8
+		0x43F9, 0x0000, 0x0400,		// lea	$400,a1
+		0x45F9, 0x00A0, 0x0000,		// lea	$A00000,a2
+		0x323C, sizeof(z80) - 1,	// move.w #len-1,d1
+		0x14D9,				// move.b (a1)+,(a2)+
+		0x51C9, 0xFFFC,			// dbra	d1,*-2
+		0x33FC, 0x0000, 0x00A1, 0x1200,	// move.w #0,$A11200	; Z80 reset
+		0x33FC, 0x0000, 0x00A1, 0x1100,	// move.w #0,$A11100	; Release the bus.
+		0x33FC, 0x0100, 0x00A1, 0x1200,	// move.w #$100,$A11200	; Start the Z80.
+		0x47F9, 0x00FF, 0x0000,		// lea	$FF0000,a3	; Flag and counters
+		0x49F9, 0x00FF, 0x0100,		// lea	$FF0100,a4	; HV counter log
+		0x46FC, 0x2000,			// move	#$2000,sr
+	};
+	static const uint16_t m68k_vdpPoll[] = {
+		0x3010,				// move.w (a0),d0
+		0x0800, 0x0003,			// btst	#3,d0
+		0x67F8,				// beq.s *-6
+		0x3010,				// move.w (a0),d0
+		0x0800, 0x0003,			// btst	#3,d0
+		0x66F8,				// bne.s *-6
+	};
+	static const uint16_t m68k_ramPoll[] = {
+		0x4213,				// clr.b (a3)
+		0x4A13,				// tst.b (a3)
+		0x67FC,				// beq.s *-2
+	};
+	static const uint16_t m68k_log[] = {
+		0x38F9, 0x00C0, 0x0008,		// move.w $C00008,(a4)+
+		0x526B, 0x0002,			// addq.w #1,2(a3)
+		0xB9FC, 0x00FF, 0x0200,		// cmpa.l #$FF0200,a4
+		0x6606,				// bne.s *+8
+		0x49F9, 0x00FF, 0x0100,		// lea	$FF0100,a4
+	};
+	m68k.assign(m68k_init, m68k_init + (sizeof(m68k_init) / sizeof(m68k_init[0])));
+	const size_t frameLoop = m68k.size();
+	if (loops.vdpPoll) {
+		m68k.insert(m68k.end(), m68k_vdpPoll,
+			m68k_vdpPoll + (sizeof(m68k_vdpPoll) / sizeof(m68k_vdpPoll[0])));
+	}
+	if (loops.ramPoll) {
+		m68k.insert(m68k.end(), m68k_ramPoll,
+			m68k_ramPoll + (sizeof(m68k_ramPoll) / sizeof(m68k_ramPoll[0])));
+	}
+	m68k.insert(m68k.end(), m68k_log,
+		m68k_log + (sizeof(m68k_log) / sizeof(m68k_log[0])));
+	// bra.s frameLoop
+	const int disp = (int)(frameLoop - (m68k.size() + 1)) * 2;
+	m68k.push_back(0x6000 | (disp & 0xFF));
+
+	// VBlank handler.
+	static const uint16_t m68k_vint[] = {
+		0x16BC, 0x0001,			// move.b #1,(a3)
+		0x526B, 0x0004,			// addq.w #1,4(a3)
+		0x4E73,				// rte
+	};
+
+	// Copy the 68000 code into the ROM. (big-endian)
+	for (size_t i = 0; i < m68k.size(); i++) {
+		rom[0x200 + (i * 2)] = (m68k[i] >> 8);
+		rom[0x200 + (i * 2) + 1] = (m68k[i] & 0xFF);
+	}
+	for (size_t i = 0; i < sizeof(m68k_vint) / sizeof(m68k_vint[0]); i++) {
+		rom[0x300 + (i * 2)] = (m68k_vint[i] >> 8);
+		rom[0x300 + (i * 2) + 1] = (m68k_vint[i] & 0xFF);
+	}
+	// Unexpected exceptions: bra.s *
+	rom[0x380] = 0x60;
+	rom[0x381] = 0xFE;
+
+	// Vector table.
+	for (int i = 0; i < 64; i++) {
+		uint32_t vector = 0x380;
+		if (i == 0)
+			vector = 0x00FFFE00;	// Initial SSP
+		else if (i == 1)
+			vector = 0x200;		// Initial PC
+		else if (i == 30)
+			vector = 0x300;		// Level 6 autovector (VINT)
+		rom[(i * 4)] = (vector >> 24);
+		rom[(i * 4) + 1] = (vector >> 16) & 0xFF;
+		rom[(i * 4) + 2] = (vector >> 8) & 0xFF;
+		rom[(i * 4) + 3] = (vector & 0xFF);
+	}
+
+	// ROM header.
+	memcpy(&rom[0x100], "SEGA MEGA DRIVE ", 16);
+	memcpy(&rom[0x1F0], "JUE", 3);
+}
+
+/**
+ * Run the test ROM.
+ * @param idleSkip If true, enable idle loop skipping.
+ * @param state Emulation state.
+ */
+void IdleSkipTest::run(bool idleSkip, IdleSkipTest_state &state) const
+{
+	vector<uint8_t> rom_data;
+	buildRom(rom_data);
+	Rom *rom = new Rom(rom_data.data(), (unsigned int)rom_data.size());
+	ASSERT_TRUE(rom->isOpen());
+	EmuContext *context = EmuContextFactory::createContext(rom, SysVersion::REGION_US_NTSC);
+	ASSERT_TRUE(context != nullptr);
+	ASSERT_TRUE(context->isRomOpened());
+
+	M68K::SetIdleSkip(idleSkip);
+	Z80::SetIdleSkip(idleSkip);
+
+	state.odo68K.clear();
+	state.odoZ80.clear();
+	for (int frame = 0; frame < frames; frame++) {
+		context->execFrame();
+		state.odo68K.push_back(M68K::ReadOdometer());
+		state.odoZ80.push_back(Z80::ReadOdometer());
+	}
+
+	state.ram68K.assign(Ram_68k.u8, Ram_68k.u8 + sizeof(Ram_68k.u8));
+	state.ramZ80.assign(Ram_Z80, Ram_Z80 + sizeof(Ram_Z80));
+	state.hits68K = M68K::IdleHits();
+	state.hitsZ80 = Z80::IdleHits();
+
+	delete context;
+	delete rom;
+}
+
+/**
+ * Skipping idle loops is bit-identical to running them.
+ */
+TEST_P(IdleSkipTest, bitIdentical)
+{
+	IdleSkipTest_state expected, actual;
+	ASSERT_NO_FATAL_FAILURE(run(false, expected));
+	ASSERT_NO_FATAL_FAILURE(run(true, actual));
+	EXPECT_EQ(0U, expected.hits68K);
+	EXPECT_EQ(0U, expected.hitsZ80);
+
+	// Make sure the test program is actually running.
+	// 68000 RAM is stored in host-endian words.
+	const IdleSkipTest_loops loops = GetParam();
+	uint16_t frames68K, vints68K;
+	memcpy(&frames68K, &expected.ram68K[2], sizeof(frames68K));
+	memcpy(&vints68K, &expected.ram68K[4], sizeof(vints68K));
+	EXPECT_GE(frames68K, frames - 2);
+	EXPECT_GE(vints68K, frames - 1);
+	if (loops.ymPoll) {
+		EXPECT_GE(expected.ramZ80[0x1F02], frames);
+	}
+	if (loops.jrSelf) {
+		EXPECT_GE(expected.ramZ80[0x1F00], frames - 1);
+	}
+
+	// Idle loops must have been skipped.
+	EXPECT_GT(actual.hits68K, 0U);
+	EXPECT_GT(actual.hitsZ80, 0U);
+
+	// Emulation state must be identical.
+	EXPECT_EQ(expected.odo68K, actual.odo68K);
+	EXPECT_EQ(expected.odoZ80, actual.odoZ80);
+	for (size_t i = 0; i < expected.ram68K.size(); i++) {
+		ASSERT_EQ(expected.ram68K[i], actual.ram68K[i]) <<
+			"68000 RAM differs at $FF" << std::hex << std::uppercase << i;
+	}
+	for (size_t i = 0; i < expected.ramZ80.size(); i++) {
+		ASSERT_EQ(expected.ramZ80[i], actual.ramZ80[i]) <<
+			"Z80 RAM differs at " << std::hex << std::uppercase << i << "h";
+	}
+}
+
+// Test cases.
+
+INSTANTIATE_TEST_CASE_P(IdleSkipTest, IdleSkipTest,
+	::testing::Values(
+		IdleSkipTest_loops(true, true, true, true),
+		IdleSkipTest_loops(true, false, true, false),
+		IdleSkipTest_loops(false, true, false, true)
+));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: Idle loop skipping test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,309 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * IntTimingTest.cpp: HINT/VINT and H/V counter timing test.               *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "Rom.hpp"
+#include "EmuContext/EmuContext.hpp"
+#include "EmuContext/EmuContextFactory.hpp"
+#include "cpu/M68K_Mem.hpp"
+#include "Vdp/VdpStatus.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+/**
+ * Test parameters.
+ */
+struct IntTimingTest_flags {
+	uint8_t hint;			// HINT reload value. (VDP register 10)
+	SysVersion::RegionCode_t region;
+
+	IntTimingTest_flags(uint8_t hint, SysVersion::RegionCode_t region)
+	{
+		this->hint = hint;
+		this->region = region;
+	}
+};
+
+/**
+ * Formatting function for IntTimingTest_flags.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const IntTimingTest_flags& flags) {
+	return os << "HINT " << (int)flags.hint
+		<< (flags.region == SysVersion::REGION_EU_PAL ? " PAL" : " NTSC");
+};
+
+/**
+ * Interrupt log entry.
+ */
+struct IntTimingTest_entry {
+	uint16_t level;		// Interrupt level. (4 == HINT, 6 == VINT)
+	uint16_t hv;		// HV counter.
+	uint16_t status;	// VDP status register.
+};
+
+class IntTimingTest : public ::testing::TestWithParam<IntTimingTest_flags>
+{
+	protected:
+		IntTimingTest()
+			: ::testing::TestWithParam<IntTimingTest_flags>() { }
+		virtual ~IntTimingTest() { }
+
+	protected:
+		static const int frames = 4;
+
+		/**
+		 * Build the test ROM.
+		 * @param rom ROM image.
+		 */
+		void buildRom(vector<uint8_t> &rom) const;
+
+		/**
+		 * Run the test ROM.
+		 * @param log Interrupt log.
+		 */
+		void run(vector<IntTimingTest_entry> &log) const;
+};
+
+const int IntTimingTest::frames;
+
+/**
+ * Build the test ROM.
+ *
+ * The 68000 enables HINT (reload value is the test parameter)
+ * and VINT, then runs STOP in a loop. STOP uses up the rest of
+ * each timeslice, so the interrupts are always taken at the same
+ * cycle on the line they're raised on.
+ *
+ * Each interrupt handler logs the interrupt level,
+ * the HV counter, and the VDP status register.
+ *
+ * @param rom ROM image.
+ */
+void IntTimingTest::buildRom(vector<uint8_t> &rom) const
+{
+	rom.assign(0x1000, 0x00);
+
+	// 68000 program.
+	const uint8_t hint = GetParam().hint;
+	const uint16_t m68k_init[] = {
+		0x41F9, 0x00C0, 0x0004,		// lea	$C00004,a0
+		0x30BC, 0x8014,			// move.w #$8014,(a0)	; HINT
+		0x30BC, 0x8164,			// move.w #$8164,(a0)	; Display, VINT, Mode 5
+		0x30BC, 0x8C81,			// move.w #$8C81,(a0)	; H40
+		0x30BC, (uint16_t)(0x8A00 | hint),	// move.w #$8Axx,(a0)	; HINT reload value
+		0x49F9, 0x00FF, 0x0100,		// lea	$FF0100,a4	; Interrupt log
+		0x4E72, 0x2000,			// stop	#$2000
+		0x60FA,				// bra.s *-4
+	};
+	const vector<uint16_t> m68k(m68k_init, m68k_init + (sizeof(m68k_init) / sizeof(m68k_init[0])));
+
+	// Interrupt handlers.
+	static const uint16_t m68k_hint[] = {
+		0x38FC, 0x0004,			// move.w #4,(a4)+
+		0x38F9, 0x00C0, 0x0008,		// move.w $C00008,(a4)+
+		0x38D0,				// move.w (a0),(a4)+
+		0x4E73,				// rte
+	};
+	static const uint16_t m68k_vint[] = {
+		0x38FC, 0x0006,			// move.w #6,(a4)+
+		0x38F9, 0x00C0, 0x0008,		// move.w $C00008,(a4)+
+		0x38D0,				// move.w (a0),(a4)+
+		0x4E73,				// rte
+	};
+
+	// Copy the 68000 code into the ROM. (big-endian)
+	for (size_t i = 0; i < m68k.size(); i++) {
+		rom[0x200 + (i * 2)] = (m68k[i] >> 8);
+		rom[0x200 + (i * 2) + 1] = (m68k[i] & 0xFF);
+	}
+	for (size_t i = 0; i < sizeof(m68k_hint) / sizeof(m68k_hint[0]); i++) {
+		rom[0x300 + (i * 2)] = (m68k_hint[i] >> 8);
+		rom[0x300 + (i * 2) + 1] = (m68k_hint[i] & 0xFF);
+	}
+	for (size_t i = 0; i < sizeof(m68k_vint) / sizeof(m68k_vint[0]); i++) {
+		rom[0x340 + (i * 2)] = (m68k_vint[i] >> 8);
+		rom[0x340 + (i * 2) + 1] = (m68k_vint[i] & 0xFF);
+	}
+	// Unexpected exceptions: bra.s *
+	rom[0x380] = 0x60;
+	rom[0x381] = 0xFE;
+
+	// Vector table.
+	for (int i = 0; i < 64; i++) {
+		uint32_t vector = 0x380;
+		if (i == 0)
+			vector = 0x00FFFE00;	// Initial SSP
+		else if (i == 1)
+			vector = 0x200;		// Initial PC
+		else if (i == 28)
+			vector = 0x300;		// Level 4 autovector (HINT)
+		else if (i == 30)
+			vector = 0x340;		// Level 6 autovector (VINT)
+		rom[(i * 4)] = (vector >> 24);
+		rom[(i * 4) + 1] = (vector >> 16) & 0xFF;
+		rom[(i * 4) + 2] = (vector >> 8) & 0xFF;
+		rom[(i * 4) + 3] = (vector & 0xFF);
+	}
+
+	// ROM header.
+	memcpy(&rom[0x100], "SEGA MEGA DRIVE ", 16);
+	memcpy(&rom[0x1F0], "JUE", 3);
+}
+
+/**
+ * Run the test ROM.
+ * @param log Interrupt log.
+ */
+void IntTimingTest::run(vector<IntTimingTest_entry> &log) const
+{
+	vector<uint8_t> rom_data;
+	buildRom(rom_data);
+	Rom *rom = new Rom(rom_data.data(), (unsigned int)rom_data.size());
+	ASSERT_TRUE(rom->isOpen());
+	EmuContext *context = EmuContextFactory::createContext(rom, GetParam().region);
+	ASSERT_TRUE(context != nullptr);
+	ASSERT_TRUE(context->isRomOpened());
+
+	for (int frame = 0; frame < frames; frame++) {
+		context->execFrame();
+	}
+
+	// 68000 RAM is stored in host-endian words.
+	log.clear();
+	for (int addr = 0x100; addr < 0xFE00; addr += 6) {
+		IntTimingTest_entry entry;
+		entry.level = Ram_68k.u16[addr / 2];
+		entry.hv = Ram_68k.u16[(addr / 2) + 1];
+		entry.status = Ram_68k.u16[(addr / 2) + 2];
+		if (entry.level == 0)
+			break;
+		log.push_back(entry);
+	}
+
+	delete context;
+	delete rom;
+}
+
+/**
+ * HINT and VINT are taken on the same lines, with the same
+ * H/V counter values and HBLANK/VBLANK flags, as they were
+ * before the master clock scheduler was added.
+ *
+ * - HINT is taken at H=1E on each line where the counter expires.
+ *   HBLANK has been cleared by then. On the first VBlank line,
+ *   HINT is raised at the start of the line, so it's taken at
+ *   H=FB with HBLANK and VBLANK set.
+ * - VINT is taken at V=E0, H=31, with VBLANK set.
+ *
+ * NOTE: Before the scheduler, PAL VINT was taken at H=30, since
+ * it was timed from the end of the line with a rounded CPL of 487
+ * instead of 3420 / 7. It's now at the same master clock cycle
+ * as NTSC.
+ */
+TEST_P(IntTimingTest, lineTiming)
+{
+	vector<IntTimingTest_entry> log;
+	ASSERT_NO_FATAL_FAILURE(run(log));
+
+	const int hint = GetParam().hint;
+	const uint16_t pal = (GetParam().region == SysVersion::REGION_EU_PAL
+				? VdpStatus::VDP_STATUS_PAL : 0);
+	const uint16_t mask = VdpStatus::VDP_STATUS_PAL |
+			      VdpStatus::VDP_STATUS_HBLANK |
+			      VdpStatus::VDP_STATUS_VBLANK;
+
+	IntTimingTest_entry vint;
+	vint.level = 6;
+	vint.hv = 0xE031;
+	vint.status = pal | VdpStatus::VDP_STATUS_VBLANK;
+
+	// The first frame's HINTs are missed while the VDP is set up.
+	vector<IntTimingTest_entry> expected;
+	expected.push_back(vint);
+	for (int frame = 1; frame < frames; frame++) {
+		for (int line = 0; line <= 224; line++) {
+			if ((line + 1) % (hint + 1) != 0)
+				continue;
+
+			IntTimingTest_entry entry;
+			entry.level = 4;
+			if (line < 224) {
+				entry.hv = (line << 8) | 0x1E;
+				entry.status = pal;
+			} else {
+				entry.hv = (line << 8) | 0xFB;
+				entry.status = pal | VdpStatus::VDP_STATUS_HBLANK |
+					       VdpStatus::VDP_STATUS_VBLANK;
+			}
+			expected.push_back(entry);
+		}
+		expected.push_back(vint);
+	}
+
+	ASSERT_EQ(expected.size(), log.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		EXPECT_EQ(expected[i].level, log[i].level) << "entry " << i;
+		EXPECT_EQ(expected[i].hv, log[i].hv) << "entry " << i << std::hex
+			<< ": expected HV " << expected[i].hv << ", got " << log[i].hv;
+		EXPECT_EQ(expected[i].status, log[i].status & mask) << "entry " << i;
+	}
+}
+
+// Test cases.
+
+INSTANTIATE_TEST_CASE_P(IntTimingTest, IntTimingTest,
+	::testing::Values(
+		IntTimingTest_flags(0, SysVersion::REGION_US_NTSC),
+		IntTimingTest_flags(3, SysVersion::REGION_US_NTSC),
+		IntTimingTest_flags(100, SysVersion::REGION_US_NTSC),
+		IntTimingTest_flags(0, SysVersion::REGION_EU_PAL),
+		IntTimingTest_flags(3, SysVersion::REGION_EU_PAL)
+));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: HINT/VINT timing test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,370 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * MdFbDirtyTest.cpp: MdFb dirty line tracking test.                       *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+
+// LibGens VDP.
+#include "Vdp/Vdp.hpp"
+#include "Util/MdFb.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+class MdFbDirtyTest : public ::testing::Test
+{
+	protected:
+		MdFbDirtyTest()
+			: ::testing::Test()
+			, m_fb(nullptr)
+			, m_vdp(nullptr)
+			, m_seed(0x1234) { }
+		virtual ~MdFbDirtyTest() { }
+
+		virtual void SetUp(void) override;
+		virtual void TearDown(void) override;
+
+	protected:
+		MdFb *m_fb;
+		Vdp *m_vdp;
+
+		/**
+		 * Get the dirty lines.
+		 * @param fb MdFb.
+		 * @return Dirty line numbers.
+		 */
+		static vector<int> dirtyLines(const MdFb *fb);
+
+		/**
+		 * Initialize the VDP with a random scene.
+		 * Line scrolling is enabled.
+		 */
+		void initScene(void);
+
+		/**
+		 * Render one frame.
+		 */
+		void renderFrame(void);
+
+		// Random number generator.
+		// Deterministic, so failures are reproducible.
+		uint32_t m_seed;
+		inline uint32_t rng(void)
+		{
+			m_seed = (m_seed * 1103515245) + 12345;
+			return (m_seed >> 8);
+		}
+};
+
+/**
+ * Set up the MdFb and Vdp for testing.
+ */
+void MdFbDirtyTest::SetUp(void)
+{
+	m_fb = new MdFb();
+	m_vdp = new Vdp();
+	m_vdp->setNtsc();
+}
+
+/**
+ * Tear down the MdFb and Vdp.
+ */
+void MdFbDirtyTest::TearDown(void)
+{
+	delete m_vdp;
+	m_vdp = nullptr;
+	m_fb->unref();
+	m_fb = nullptr;
+}
+
+/**
+ * Get the dirty lines.
+ * @param fb MdFb.
+ * @return Dirty line numbers.
+ */
+vector<int> MdFbDirtyTest::dirtyLines(const MdFb *fb)
+{
+	vector<int> lines;
+	for (int line = 0; line < fb->numLines(); line++) {
+		if (fb->isLineDirty(line)) {
+			lines.push_back(line);
+		}
+	}
+
+	// The bitmap must agree with isLineDirty(),
+	// and must not have bits past the last line.
+	const uint32_t *bitmap = fb->dirtyLines();
+	const int words = (fb->numLines() + 31) / 32;
+	size_t bits = 0;
+	for (int i = 0; i < words; i++) {
+		for (uint32_t w = bitmap[i]; w != 0; w &= (w - 1)) {
+			bits++;
+		}
+	}
+	EXPECT_EQ(lines.size(), bits);
+	EXPECT_EQ(!lines.empty(), fb->isAnyLineDirty());
+	return lines;
+}
+
+/**
+ * Initialize the VDP with a random scene.
+ * Line scrolling is enabled.
+ */
+void MdFbDirtyTest::initScene(void)
+{
+	m_vdp->dbg_setReg(0x00, 0x04);	// Enable the palette.
+	m_vdp->dbg_setReg(0x01, 0x44);	// Enable the display, set Mode 5.
+	m_vdp->dbg_setReg(0x02, 0x30);	// Set scroll A name table base to 0xC000.
+	m_vdp->dbg_setReg(0x03, 0x00);	// Window isn't used.
+	m_vdp->dbg_setReg(0x04, 0x05);	// Set scroll B name table base to 0xA000.
+	m_vdp->dbg_setReg(0x05, 0x70);	// Set the sprite table base to 0xE000.
+	m_vdp->dbg_setReg(0x07, 0x05);	// Background color.
+	m_vdp->dbg_setReg(0x0B, 0x03);	// Line scrolling.
+	m_vdp->dbg_setReg(0x0C, 0x81);	// H40.
+	m_vdp->dbg_setReg(0x0D, 0x3F);	// Set the HScroll table base to 0xFC00.
+	m_vdp->dbg_setReg(0x0F, 0x02);	// Set the auto-increment value to 2.
+	m_vdp->dbg_setReg(0x10, 0x01);	// Set the scroll size to V32 H64.
+
+	// Random CRam.
+	uint16_t cram[64];
+	for (int i = 0; i < 64; i++) {
+		cram[i] = (rng() & 0x0EEE);
+	}
+	m_vdp->dbg_writeCRam_16(0, cram, 64);
+
+	// Random patterns and name tables.
+	// No sprites, and no horizontal scrolling.
+	// Name table entries only use patterns below 0x8000,
+	// so writes to the HScroll table don't change any patterns.
+	vector<uint16_t> vram(0x8000);
+	for (int i = 0; i < 0xE000/2; i++) {
+		vram[i] = (uint16_t)rng();
+		if (i >= 0xA000/2) {
+			vram[i] &= 0xE3FF;
+		}
+	}
+	m_vdp->dbg_writeVRam_16(0, vram.data(), vram.size() * 2);
+}
+
+/**
+ * Render one frame.
+ */
+void MdFbDirtyTest::renderFrame(void)
+{
+	m_vdp->updateVdpLines(true);
+	for (; m_vdp->VDP_Lines.currentLine < m_vdp->VDP_Lines.totalDisplayLines;
+	     m_vdp->VDP_Lines.currentLine++)
+	{
+		m_vdp->renderLine();
+	}
+}
+
+/**
+ * markLineDirty(), markAllLinesDirty(), and clearDirtyLines().
+ */
+TEST_F(MdFbDirtyTest, bitmap)
+{
+	// A new framebuffer is entirely dirty.
+	EXPECT_EQ((size_t)m_fb->numLines(), dirtyLines(m_fb).size());
+
+	m_fb->clearDirtyLines();
+	EXPECT_TRUE(dirtyLines(m_fb).empty());
+
+	// Only the marked lines are dirty.
+	m_fb->markLineDirty(0);
+	m_fb->markLineDirty(31);
+	m_fb->markLineDirty(32);
+	m_fb->markLineDirty(m_fb->numLines() - 1);
+	vector<int> lines = dirtyLines(m_fb);
+	ASSERT_EQ(4U, lines.size());
+	EXPECT_EQ(0, lines[0]);
+	EXPECT_EQ(31, lines[1]);
+	EXPECT_EQ(32, lines[2]);
+	EXPECT_EQ(m_fb->numLines() - 1, lines[3]);
+	EXPECT_EQ(0x80000001U, m_fb->dirtyLines()[0]);
+	EXPECT_EQ(0x00000001U, m_fb->dirtyLines()[1]);
+
+	// markAllLinesDirty() doesn't set bits past the last line.
+	m_fb->clearDirtyLines();
+	m_fb->markAllLinesDirty();
+	EXPECT_EQ((size_t)m_fb->numLines(), dirtyLines(m_fb).size());
+}
+
+/**
+ * clear() and setBpp() mark the entire framebuffer as dirty.
+ */
+TEST_F(MdFbDirtyTest, clearAndBpp)
+{
+	m_fb->clearDirtyLines();
+	m_fb->clear();
+	EXPECT_EQ((size_t)m_fb->numLines(), dirtyLines(m_fb).size());
+
+	// Setting the same color depth doesn't change anything.
+	m_fb->clearDirtyLines();
+	m_fb->setBpp(m_fb->bpp());
+	EXPECT_TRUE(dirtyLines(m_fb).empty());
+
+	m_fb->setBpp(MdFb::BPP_16);
+	EXPECT_EQ((size_t)m_fb->numLines(), dirtyLines(m_fb).size());
+}
+
+/**
+ * With line hashing, only lines whose contents changed are marked.
+ */
+TEST_F(MdFbDirtyTest, lineHashing)
+{
+	static const int line = 10;
+
+	// Hashes are only available if hashing is enabled.
+	EXPECT_FALSE(m_fb->lineHashing());
+	EXPECT_EQ(0U, m_fb->lineHash(line));
+
+	// Enabling hashing marks everything dirty,
+	// and all hashes are unknown.
+	m_fb->clearDirtyLines();
+	m_fb->setLineHashing(true);
+	EXPECT_TRUE(m_fb->lineHashing());
+	EXPECT_EQ((size_t)m_fb->numLines(), dirtyLines(m_fb).size());
+	EXPECT_EQ(0U, m_fb->lineHash(line));
+
+	const MdFb::ColorDepth bpps[] = {MdFb::BPP_32, MdFb::BPP_16};
+	for (int i = 0; i < 2; i++) {
+		m_fb->setBpp(bpps[i]);
+		m_fb->clearDirtyLines();
+
+		// The first hash is always a change.
+		m_fb->markLineDirty(line);
+		EXPECT_TRUE(m_fb->isLineDirty(line));
+		const uint32_t hash = m_fb->lineHash(line);
+		EXPECT_NE(0U, hash);
+
+		// Same contents: not dirty.
+		m_fb->clearDirtyLines();
+		m_fb->markLineDirty(line);
+		EXPECT_TRUE(dirtyLines(m_fb).empty());
+		EXPECT_EQ(hash, m_fb->lineHash(line));
+
+		// Change the last pixel.
+		const int x = m_fb->pxPerLine() - 1;
+		if (m_fb->bpp() == MdFb::BPP_32) {
+			m_fb->lineBuf32(line)[x] ^= 0x00FFFFFF;
+		} else {
+			m_fb->lineBuf16(line)[x] ^= 0xFFFF;
+		}
+		m_fb->markLineDirty(line);
+		vector<int> lines = dirtyLines(m_fb);
+		ASSERT_EQ(1U, lines.size());
+		EXPECT_EQ(line, lines[0]);
+		EXPECT_NE(hash, m_fb->lineHash(line));
+
+		// markAllLinesDirty() invalidates the hashes,
+		// so an unchanged line is dirty again.
+		m_fb->markAllLinesDirty();
+		EXPECT_EQ(0U, m_fb->lineHash(line));
+		m_fb->clearDirtyLines();
+		m_fb->markLineDirty(line);
+		EXPECT_TRUE(m_fb->isLineDirty(line));
+	}
+}
+
+/**
+ * The renderer marks each line it renders.
+ */
+TEST_F(MdFbDirtyTest, renderLine)
+{
+	initScene();
+	renderFrame();
+	MdFb *const fb = m_vdp->MD_Screen;
+	fb->clearDirtyLines();
+
+	// Render a single line.
+	static const int line = 100;
+	m_vdp->VDP_Lines.currentLine = line;
+	m_vdp->renderLine();
+	vector<int> lines = dirtyLines(fb);
+	ASSERT_EQ(1U, lines.size());
+	EXPECT_EQ(line + m_vdp->VDP_Lines.Border.borderSize, lines[0]);
+}
+
+/**
+ * With line hashing, re-rendering a frame only marks
+ * the lines that changed.
+ */
+TEST_F(MdFbDirtyTest, renderLineHashing)
+{
+	initScene();
+	MdFb *const fb = m_vdp->MD_Screen;
+	fb->setLineHashing(true);
+	renderFrame();
+
+	// Nothing changed.
+	fb->clearDirtyLines();
+	renderFrame();
+	EXPECT_TRUE(dirtyLines(fb).empty());
+
+	// Scroll one line.
+	static const int line = 57;
+	uint16_t hscroll = 8;
+	m_vdp->dbg_writeVRam_16(0xFC00 + (line * 4), &hscroll, 2);
+	fb->clearDirtyLines();
+	renderFrame();
+	vector<int> lines = dirtyLines(fb);
+	ASSERT_EQ(1U, lines.size());
+	EXPECT_EQ(line + m_vdp->VDP_Lines.Border.borderSize, lines[0]);
+
+	// Disable the display. Every active line changes.
+	m_vdp->dbg_setReg(0x01, 0x04);
+	fb->clearDirtyLines();
+	renderFrame();
+	EXPECT_EQ((size_t)m_vdp->VDP_Lines.totalVisibleLines, dirtyLines(fb).size());
+
+	// Blank lines don't change either.
+	fb->clearDirtyLines();
+	renderFrame();
+	EXPECT_TRUE(dirtyLines(fb).empty());
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: MdFb dirty line tracking test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
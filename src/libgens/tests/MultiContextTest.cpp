@@ -0,0 +1,364 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * MultiContextTest.cpp: Multiple emulation context test.                  *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "Rom.hpp"
+#include "EmuContext/EmuContext.hpp"
+#include "EmuContext/EmuContextFactory.hpp"
+#include "cpu/M68K_Mem.hpp"
+#include "cpu/Z80_MD_Mem.hpp"
+#include "Vdp/Vdp.hpp"
+#include "Util/MdFb.hpp"
+#include "sound/SoundMgr.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+/**
+ * Keeps two threads on the same frame, so both
+ * emulation contexts are always running at once.
+ */
+class MultiContextTest_barrier
+{
+	public:
+		MultiContextTest_barrier()
+			: m_waiting(0)
+			, m_generation(0) { }
+
+		/**
+		 * Wait for the other thread to reach the barrier.
+		 */
+		void wait(void)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			const unsigned int generation = m_generation;
+			if (++m_waiting == 2) {
+				m_waiting = 0;
+				m_generation++;
+				m_cond.notify_all();
+				return;
+			}
+			while (generation == m_generation) {
+				m_cond.wait(lock);
+			}
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		int m_waiting;
+		unsigned int m_generation;
+};
+
+/**
+ * Context run parameters and results.
+ */
+struct MultiContextTest_run {
+	uint16_t seed;			// Test ROM seed.
+	MultiContextTest_barrier *barrier;	// Frame barrier. (nullptr for a single context)
+	vector<uint64_t> hashes;	// Frame hashes.
+	bool ok;			// True if the context was created.
+};
+
+class MultiContextTest : public ::testing::Test
+{
+	protected:
+		MultiContextTest()
+			: ::testing::Test() { }
+		virtual ~MultiContextTest() { }
+
+	protected:
+		static const int frames = 60;
+
+		/**
+		 * Build the test ROM.
+		 * @param rom ROM image.
+		 * @param seed Initial background color.
+		 */
+		static void buildRom(vector<uint8_t> &rom, uint16_t seed);
+
+		/**
+		 * Hash the current frame.
+		 * This includes the framebuffer, 68000 RAM,
+		 * Z80 RAM, and the frame's audio output.
+		 * @param context Emulation context.
+		 * @return FNV-1a hash.
+		 */
+		static uint64_t hashFrame(const EmuContext *context);
+
+		/**
+		 * Run the test ROM in the calling thread.
+		 * @param run Run parameters and results.
+		 */
+		static void run(MultiContextTest_run *run);
+
+		/**
+		 * Run the test ROM in a new thread.
+		 * @param run Run parameters and results.
+		 */
+		static void runThread(MultiContextTest_run *run);
+};
+
+const int MultiContextTest::frames;
+
+/**
+ * Build the test ROM.
+ *
+ * The 68000 loads a Z80 program, then writes a changing
+ * background color to CRAM in a delay loop, so the color
+ * changes partway through the frame. The Z80 writes the
+ * YM2612 DAC and the PSG in a loop.
+ *
+ * @param rom ROM image.
+ * @param seed Initial background color.
+ */
+void MultiContextTest::buildRom(vector<uint8_t> &rom, uint16_t seed)
+{
+	rom.assign(0x1000, 0x00);
+
+	// 68000 program.
+	const uint16_t m68k_init[] = {
+		0x41F9, 0x00C0, 0x0004,		// lea	$C00004,a0
+		0x43F9, 0x00C0, 0x0000,		// lea	$C00000,a1
+		0x30BC, 0x8144,			// move.w #$8144,(a0)	; Display, Mode 5
+		0x30BC, 0x8C81,			// move.w #$8C81,(a0)	; H40
+		0x30BC, 0x8F02,			// move.w #$8F02,(a0)	; Auto-increment
+		0x30BC, 0x8700,			// move.w #$8700,(a0)	; Background color
+		0x33FC, 0x0100, 0x00A1, 0x1100,	// move.w #$100,$A11100	; Z80 BUSREQ
+		0x33FC, 0x0100, 0x00A1, 0x1200,	// move.w #$100,$A11200	; Z80 RESET off
+		0x45F9, 0x0000, 0x0400,		// lea	$400,a2		; Z80 program
+		0x47F9, 0x00A0, 0x0000,		// lea	$A00000,a3	; Z80 RAM
+		0x723F,				// moveq #63,d1
+		0x16DA,				// move.b (a2)+,(a3)+
+		0x51C9, 0xFFFC,			// dbf	d1,*-2
+		0x33FC, 0x0000, 0x00A1, 0x1200,	// move.w #0,$A11200	; Z80 RESET on
+		0x33FC, 0x0000, 0x00A1, 0x1100,	// move.w #0,$A11100	; Z80 BUSREQ off
+		0x33FC, 0x0100, 0x00A1, 0x1200,	// move.w #$100,$A11200	; Z80 RESET off
+		0x303C, seed,			// move.w #seed,d0
+		// Main loop.
+		0x20BC, 0xC000, 0x0000,		// move.l #$C0000000,(a0) ; CRAM write, $0000
+		0x3280,				// move.w d0,(a1)
+		0x33C0, 0x00FF, 0x0000,		// move.w d0,$FF0000
+		0x0640, 0x0123,			// addi.w #$123,d0
+		0x343C, 0x01FF,			// move.w #$1FF,d2
+		0x51CA, 0xFFFE,			// dbf	d2,*
+		0x60E4,				// bra.s main loop
+	};
+
+	// Z80 program.
+	static const uint8_t z80[] = {
+		0x21, 0x00, 0x40,		// ld	hl,4000h
+		0x36, 0x2B,			// ld	(hl),2Bh
+		0x23,				// inc	hl
+		0x36, 0x80,			// ld	(hl),80h	; DAC on
+		0x2B,				// dec	hl
+		0x36, 0x2A,			// ld	(hl),2Ah
+		0x23,				// inc	hl
+		// Main loop.
+		0x3C,				// inc	a
+		0x77,				// ld	(hl),a		; DAC data
+		0x32, 0x11, 0x7F,		// ld	(7F11h),a	; PSG
+		0x06, 0x20,			// ld	b,20h
+		0x10, 0xFE,			// djnz	$
+		0x18, 0xF5,			// jr	main loop
+	};
+
+	// Copy the 68000 code into the ROM. (big-endian)
+	for (size_t i = 0; i < sizeof(m68k_init) / sizeof(m68k_init[0]); i++) {
+		rom[0x200 + (i * 2)] = (m68k_init[i] >> 8);
+		rom[0x200 + (i * 2) + 1] = (m68k_init[i] & 0xFF);
+	}
+	memcpy(&rom[0x400], z80, sizeof(z80));
+
+	// Unexpected exceptions: bra.s *
+	rom[0x380] = 0x60;
+	rom[0x381] = 0xFE;
+
+	// Vector table.
+	for (int i = 0; i < 64; i++) {
+		uint32_t vector = 0x380;
+		if (i == 0)
+			vector = 0x00FFFE00;	// Initial SSP
+		else if (i == 1)
+			vector = 0x200;		// Initial PC
+		rom[(i * 4)] = (vector >> 24);
+		rom[(i * 4) + 1] = (vector >> 16) & 0xFF;
+		rom[(i * 4) + 2] = (vector >> 8) & 0xFF;
+		rom[(i * 4) + 3] = (vector & 0xFF);
+	}
+
+	// ROM header.
+	memcpy(&rom[0x100], "SEGA MEGA DRIVE ", 16);
+	memcpy(&rom[0x1F0], "JUE", 3);
+}
+
+/**
+ * Hash the current frame.
+ * This includes the framebuffer, 68000 RAM,
+ * Z80 RAM, and the frame's audio output.
+ * @param context Emulation context.
+ * @return FNV-1a hash.
+ */
+uint64_t MultiContextTest::hashFrame(const EmuContext *context)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	#define HASH_BYTES(data, size) do { \
+		const uint8_t *p = (const uint8_t*)(data); \
+		for (size_t i = 0; i < (size_t)(size); i++) { \
+			hash = (hash ^ p[i]) * 0x100000001B3ULL; \
+		} \
+	} while (0)
+
+	const MdFb *fb = context->m_vdp->MD_Screen;
+	for (int line = 0; line < fb->numLines(); line++) {
+		HASH_BYTES(fb->lineBuf32(line), fb->pxPitch() * sizeof(uint32_t));
+	}
+	HASH_BYTES(Ram_68k.u8, sizeof(Ram_68k.u8));
+	HASH_BYTES(Ram_Z80, sizeof(Ram_Z80));
+
+	int16_t audio[SoundMgr::MAX_SEGMENT_SIZE * 2];
+	const int samples = SoundMgr::writeStereo(audio, SoundMgr::MAX_SEGMENT_SIZE);
+	HASH_BYTES(audio, samples * 2 * sizeof(audio[0]));
+
+	#undef HASH_BYTES
+	return hash;
+}
+
+/**
+ * Run the test ROM in the calling thread.
+ * @param run Run parameters and results.
+ */
+void MultiContextTest::run(MultiContextTest_run *run)
+{
+	run->hashes.clear();
+	run->ok = false;
+
+	vector<uint8_t> rom_data;
+	buildRom(rom_data, run->seed);
+	Rom *rom = new Rom(rom_data.data(), (unsigned int)rom_data.size());
+	EmuContext *context = nullptr;
+	if (rom->isOpen()) {
+		context = EmuContextFactory::createContext(rom, SysVersion::REGION_US_NTSC);
+	}
+	run->ok = (context != nullptr && context->isRomOpened());
+
+	for (int frame = 0; frame < frames; frame++) {
+		if (run->barrier) {
+			// Wait for the other context, even if this one
+			// failed, so the other context doesn't deadlock.
+			run->barrier->wait();
+		}
+		if (run->ok) {
+			context->execFrame();
+			run->hashes.push_back(hashFrame(context));
+		}
+	}
+
+	delete context;
+	delete rom;
+}
+
+/**
+ * Run the test ROM in a new thread.
+ * @param run Run parameters and results.
+ */
+void MultiContextTest::runThread(MultiContextTest_run *run)
+{
+	LibGens::InitThread();
+	MultiContextTest::run(run);
+	LibGens::EndThread();
+}
+
+/**
+ * Two contexts running at the same time on two threads
+ * produce the same frames as one context at a time.
+ */
+TEST_F(MultiContextTest, twoThreads)
+{
+	static const uint16_t seeds[2] = {0x0E00, 0x00EE};
+	MultiContextTest_barrier barrier;
+	MultiContextTest_run single[2], multi[2];
+
+	// Reference: One context at a time on the main thread.
+	for (int i = 0; i < 2; i++) {
+		single[i].seed = seeds[i];
+		single[i].barrier = nullptr;
+		run(&single[i]);
+		ASSERT_TRUE(single[i].ok);
+		ASSERT_EQ((size_t)frames, single[i].hashes.size());
+	}
+
+	// The two ROMs must produce different frames,
+	// or the comparison wouldn't detect shared state.
+	EXPECT_NE(single[0].hashes.back(), single[1].hashes.back());
+
+	// Two contexts at the same time, one per thread.
+	vector<std::thread> threads;
+	for (int i = 0; i < 2; i++) {
+		multi[i].seed = seeds[i];
+		multi[i].barrier = &barrier;
+		threads.push_back(std::thread(runThread, &multi[i]));
+	}
+	for (int i = 0; i < 2; i++) {
+		threads[i].join();
+	}
+
+	for (int i = 0; i < 2; i++) {
+		ASSERT_TRUE(multi[i].ok) << "context " << i;
+		ASSERT_EQ(single[i].hashes.size(), multi[i].hashes.size()) << "context " << i;
+		for (int frame = 0; frame < frames; frame++) {
+			ASSERT_EQ(single[i].hashes[frame], multi[i].hashes[frame])
+				<< "context " << i << ", frame " << frame;
+		}
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: Multiple emulation context test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,491 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * VdpDmaBlockTest.cpp: VDP ROM / 68000 RAM DMA test.                      *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "Rom.hpp"
+#include "EmuContext/EmuContext.hpp"
+#include "EmuContext/EmuContextFactory.hpp"
+#include "cpu/M68K_Mem.hpp"
+
+// LibGens VDP.
+#include "Vdp/Vdp.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <iomanip>
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+struct VdpDmaBlockTest_flags {
+	uint8_t cd;		// Destination access code. (VRam, CRam, or VSRam write)
+	uint8_t autoInc;	// Auto-increment value.
+
+	VdpDmaBlockTest_flags(uint8_t cd, uint8_t autoInc)
+	{
+		this->cd = cd;
+		this->autoInc = autoInc;
+	}
+};
+
+/**
+ * Run ROM and 68000 RAM DMA transfers and compare the results
+ * to a second VDP that receives the same words through the
+ * data port, one word at a time.
+ */
+class VdpDmaBlockTest : public ::testing::TestWithParam<VdpDmaBlockTest_flags>
+{
+	protected:
+		VdpDmaBlockTest()
+			: ::testing::TestWithParam<VdpDmaBlockTest_flags>()
+			, m_rom(nullptr)
+			, m_context(nullptr)
+			, m_vdp(nullptr)
+			, m_ref(nullptr)
+			, m_seed(0) { }
+		virtual ~VdpDmaBlockTest() { }
+
+		virtual void SetUp(void) override;
+		virtual void TearDown(void) override;
+
+	protected:
+		// ROM size. Two 128 KB DMA windows.
+		static const unsigned int ROM_SIZE = 0x40000;
+
+		vector<uint8_t> m_rom_data;
+		Rom *m_rom;
+		EmuContext *m_context;
+
+		// VDP under test. (Owned by m_context.)
+		Vdp *m_vdp;
+
+		// Reference VDP.
+		Vdp *m_ref;
+
+		/**
+		 * Set the VDP address and access code.
+		 * @param vdp VDP.
+		 * @param cd Access code.
+		 * @param address Address.
+		 */
+		static void setAddress(Vdp *vdp, uint8_t cd, uint32_t address);
+
+		/**
+		 * Set up a VDP's registers and memory.
+		 * @param vdp VDP.
+		 */
+		void initVdp(Vdp *vdp);
+
+		/**
+		 * Get a source word, using the VDP's DMA address wrapping.
+		 * Source addresses wrap at 128 KB boundaries.
+		 * 68000 RAM is mirrored within its 128 KB window.
+		 * @param src Source address.
+		 * @param index Word index.
+		 * @return Source word.
+		 */
+		uint16_t srcWord(uint32_t src, unsigned int index) const;
+
+		/**
+		 * Run a ROM or 68000 RAM DMA on both VDPs.
+		 * @param src Source address. (must be even)
+		 * @param dest Destination address.
+		 * @param length DMA length. (must not be 0)
+		 */
+		void doDma(uint32_t src, uint32_t dest, uint16_t length);
+
+		/**
+		 * Compare the VDP's VRam, CRam, VSRam, and
+		 * address to the reference VDP.
+		 */
+		void checkVdp(void);
+
+		// Random number generator.
+		// Deterministic, so failures are reproducible.
+		uint32_t m_seed;
+		inline uint32_t rng(void)
+		{
+			m_seed = (m_seed * 1103515245) + 12345;
+			return (m_seed >> 8);
+		}
+};
+
+const unsigned int VdpDmaBlockTest::ROM_SIZE;
+
+/**
+ * Formatting function for VdpDmaBlockTest_flags.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const VdpDmaBlockTest_flags& flags) {
+	const char *dest;
+	switch (flags.cd) {
+		case 0x01:	dest = "VRam"; break;
+		case 0x03:	dest = "CRam"; break;
+		case 0x05:	dest = "VSRam"; break;
+		default:	dest = "???"; break;
+	}
+	return os << dest << ", Auto_Inc "
+		<< std::hex << std::uppercase
+		<< std::setfill('0') << std::setw(2)
+		<< (unsigned int)flags.autoInc;
+};
+
+/**
+ * Set up the emulation context and the reference VDP.
+ */
+void VdpDmaBlockTest::SetUp(void)
+{
+	m_seed = 0x9ABC ^ (GetParam().cd << 8) ^ GetParam().autoInc;
+
+	// Random ROM data.
+	// NOTE: The low bits of rng() repeat every 64K calls,
+	// which would make the 128 KB windows identical.
+	m_rom_data.resize(ROM_SIZE);
+	for (unsigned int i = 0; i < ROM_SIZE; i++) {
+		m_rom_data[i] = (uint8_t)(rng() >> 16);
+	}
+	memcpy(&m_rom_data[0x100], "SEGA MEGA DRIVE ", 16);
+	memcpy(&m_rom_data[0x1F0], "JUE", 3);
+
+	m_rom = new Rom(m_rom_data.data(), (unsigned int)m_rom_data.size());
+	ASSERT_TRUE(m_rom->isOpen());
+	m_context = EmuContextFactory::createContext(m_rom, SysVersion::REGION_US_NTSC);
+	ASSERT_TRUE(m_context != nullptr);
+	ASSERT_TRUE(m_context->isRomOpened());
+	m_vdp = m_context->m_vdp;
+
+	// Random 68000 RAM.
+	for (unsigned int i = 0; i < sizeof(Ram_68k.u16) / sizeof(Ram_68k.u16[0]); i++) {
+		Ram_68k.u16[i] = (uint16_t)rng();
+	}
+
+	m_ref = new Vdp();
+	m_ref->setNtsc();
+
+	// Both VDPs start with the same registers and memory.
+	const uint32_t seed = m_seed;
+	initVdp(m_vdp);
+	m_seed = seed;
+	initVdp(m_ref);
+}
+
+/**
+ * Tear down the emulation context and the reference VDP.
+ */
+void VdpDmaBlockTest::TearDown(void)
+{
+	delete m_ref;
+	m_ref = nullptr;
+	delete m_context;
+	m_context = nullptr;
+	m_vdp = nullptr;
+	delete m_rom;
+	m_rom = nullptr;
+}
+
+/**
+ * Set the VDP address and access code.
+ * @param vdp VDP.
+ * @param cd Access code.
+ * @param address Address.
+ */
+void VdpDmaBlockTest::setAddress(Vdp *vdp, uint8_t cd, uint32_t address)
+{
+	vdp->writeCtrlMD(((cd & 0x03) << 14) | (address & 0x3FFF));
+	vdp->writeCtrlMD(((cd & 0x3C) << 2) | ((address >> 14) & 0x03));
+}
+
+/**
+ * Set up a VDP's registers and memory.
+ * @param vdp VDP.
+ */
+void VdpDmaBlockTest::initVdp(Vdp *vdp)
+{
+	vdp->dbg_setReg(0x01, 0x54);	// Enable the display and DMA, set Mode 5.
+	vdp->dbg_setReg(0x05, 0x70);	// Set the sprite table base to 0xE000.
+	vdp->dbg_setReg(0x0C, 0x81);	// H40
+	vdp->dbg_setReg(0x0F, GetParam().autoInc);
+
+	vector<uint16_t> vram(0x8000);
+	for (int i = 0; i < 0x8000; i++) {
+		vram[i] = (uint16_t)rng();
+	}
+	// Valid sprite links.
+	for (int i = 0; i < 80; i++) {
+		vram[(0xE000/2) + (i*4) + 1] &= 0x0F00;
+		vram[(0xE000/2) + (i*4) + 1] |= (i < 79 ? i + 1 : 0);
+	}
+	vdp->dbg_writeVRam_16(0, vram.data(), 0x10000);
+
+	uint16_t cram[64];
+	for (int i = 0; i < 64; i++) {
+		cram[i] = (uint16_t)rng() & 0x0EEE;
+	}
+	vdp->dbg_writeCRam_16(0, cram, sizeof(cram));
+
+	uint16_t vsram[40];
+	for (int i = 0; i < 40; i++) {
+		vsram[i] = (uint16_t)rng() & 0x07FF;
+	}
+	vdp->dbg_writeVSRam_16(0, vsram, sizeof(vsram));
+}
+
+/**
+ * Get a source word, using the VDP's DMA address wrapping.
+ * Source addresses wrap at 128 KB boundaries.
+ * 68000 RAM is mirrored within its 128 KB window.
+ * @param src Source address.
+ * @param index Word index.
+ * @return Source word.
+ */
+uint16_t VdpDmaBlockTest::srcWord(uint32_t src, unsigned int index) const
+{
+	const uint32_t address = (src & 0xFE0000) | ((src + (index * 2)) & 0x1FFFE);
+	if (address >= 0xE00000) {
+		// 68000 RAM.
+		return Ram_68k.u16[(address & 0xFFFF) >> 1];
+	}
+
+	// ROM. (big-endian)
+	return (m_rom_data[address] << 8) | m_rom_data[address + 1];
+}
+
+/**
+ * Run a ROM or 68000 RAM DMA on both VDPs.
+ * @param src Source address. (must be even)
+ * @param dest Destination address.
+ * @param length DMA length. (must not be 0)
+ */
+void VdpDmaBlockTest::doDma(uint32_t src, uint32_t dest, uint16_t length)
+{
+	const uint8_t cd = GetParam().cd;
+
+	// VDP.
+	m_vdp->dbg_setReg(0x13, length & 0xFF);
+	m_vdp->dbg_setReg(0x14, length >> 8);
+	m_vdp->dbg_setReg(0x15, (src >> 1) & 0xFF);
+	m_vdp->dbg_setReg(0x16, (src >> 9) & 0xFF);
+	m_vdp->dbg_setReg(0x17, (src >> 17) & 0x7F);
+	setAddress(m_vdp, cd | 0x20, dest);
+
+	// Finish the DMA, so the next one starts from a clean state.
+	while (m_vdp->DMAT_Length > 0) {
+		m_vdp->updateDMA();
+	}
+
+	// Reference VDP.
+	setAddress(m_ref, cd, dest);
+	for (unsigned int i = 0; i < length; i++) {
+		m_ref->writeDataMD(srcWord(src, i));
+	}
+}
+
+/**
+ * Compare the VDP's VRam, CRam, VSRam, and
+ * address to the reference VDP.
+ */
+void VdpDmaBlockTest::checkVdp(void)
+{
+	uint32_t address, ref_address;
+	ASSERT_EQ(0, m_vdp->dbg_getAddress(&address));
+	ASSERT_EQ(0, m_ref->dbg_getAddress(&ref_address));
+	EXPECT_EQ(ref_address, address) << "VDP address is incorrect.";
+
+	// Read the VDP memory using the data port.
+	static const struct {
+		uint8_t cd;
+		unsigned int size;
+		const char *name;
+	} mem[3] = {
+		{0x00, 0x10000, "VRam"},
+		{0x08, 0x80, "CRam"},
+		{0x04, 0x50, "VSRam"},
+	};
+
+	m_vdp->dbg_setReg(0x0F, 0x02);
+	m_ref->dbg_setReg(0x0F, 0x02);
+	for (int i = 0; i < 3; i++) {
+		setAddress(m_vdp, mem[i].cd, 0);
+		setAddress(m_ref, mem[i].cd, 0);
+		for (unsigned int addr = 0; addr < mem[i].size; addr += 2) {
+			const uint16_t expected = m_ref->readDataMD();
+			const uint16_t actual = m_vdp->readDataMD();
+			ASSERT_EQ(expected, actual) << mem[i].name << " mismatch at address "
+				<< std::hex << std::uppercase
+				<< std::setfill('0') << std::setw(4) << addr;
+		}
+	}
+	m_vdp->dbg_setReg(0x0F, GetParam().autoInc);
+	m_ref->dbg_setReg(0x0F, GetParam().autoInc);
+}
+
+/**
+ * ROM DMA that crosses a 128 KB source boundary.
+ * The source address wraps to the start of the 128 KB window.
+ */
+TEST_P(VdpDmaBlockTest, romWrap)
+{
+	doDma(0x1FF80, 0x0000, 0x80);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+	doDma(0x3FFFE, 0x1235, 0x41);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+	doDma(0x3F000, 0xDF00, 0x1800);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+}
+
+/**
+ * 68000 RAM DMA that crosses the end of RAM.
+ * 68000 RAM is mirrored in the 128 KB window, so the
+ * source address wraps to the start of RAM.
+ */
+TEST_P(VdpDmaBlockTest, ramWrap)
+{
+	doDma(0xFFFF80, 0x0000, 0x80);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+	doDma(0xFFFFFE, 0x1235, 0x41);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+	doDma(0xFFF000, 0xDF00, 0x1800);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+
+	// $FE0000-$FEFFFF mirrors $FF0000-$FFFFFF.
+	doDma(0xFEFF00, 0x4001, 0x100);
+	ASSERT_NO_FATAL_FAILURE(checkVdp());
+}
+
+/**
+ * ROM and 68000 RAM DMA with random addresses and lengths.
+ * Destination addresses may be odd.
+ */
+TEST_P(VdpDmaBlockTest, random)
+{
+	for (int i = 0; i < 100; i++) {
+		uint32_t src = (rng() % ROM_SIZE) & ~1;
+		if (i & 1) {
+			src = 0xFE0000 | (rng() & 0x1FFFE);
+		}
+		uint32_t dest = rng() & 0xFFFF;
+		if (i & 2) {
+			// Start near the Sprite Attribute Table.
+			dest = (0xE000 - 0x100 + (rng() & 0x7FF)) & 0xFFFF;
+		}
+		uint16_t length = (i & 4 ? (rng() & 0x3FF) : (rng() & 0x3FFF));
+		if (length == 0)
+			length = 1;
+		doDma(src, dest, length);
+		ASSERT_NO_FATAL_FAILURE(checkVdp());
+	}
+}
+
+/**
+ * DMA cycle stealing is the same as it was with the
+ * per-word loop. The loop left DMAT_Length set to the full
+ * transfer length, and updateDMA() charges it line by line.
+ */
+TEST_P(VdpDmaBlockTest, cycles)
+{
+	// DMA_Timing_Table: H40 active, H40 blanking.
+	const bool isVRam = (GetParam().cd == 0x01);
+	const int timing[2] = {isVRam ? 9 : 18, isVRam ? 102 : 205};
+
+	for (int vblank = 0; vblank < 2; vblank++) {
+		m_vdp->VDP_Lines.currentLine = (vblank ? 230 : 100);
+		static const uint16_t lengths[] = {1, 9, 10, 0x80, 0x1001};
+		for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+			const int length = lengths[i];
+			const int rate = timing[vblank];
+
+			m_vdp->dbg_setReg(0x13, length & 0xFF);
+			m_vdp->dbg_setReg(0x14, length >> 8);
+			m_vdp->dbg_setReg(0x15, 0x00);
+			m_vdp->dbg_setReg(0x16, (i & 1) ? 0x80 : 0x00);
+			m_vdp->dbg_setReg(0x17, (i & 1) ? 0x7F : 0x00);
+			setAddress(m_vdp, GetParam().cd | 0x20, 0);
+
+			// The DMA charges its first line itself.
+			int remaining = (length > rate ? length - rate : 0);
+			EXPECT_EQ(remaining, m_vdp->DMAT_Length) << "length " << length;
+			EXPECT_EQ(remaining != 0,
+				!!(m_vdp->readCtrlMD() & VdpStatus::VDP_STATUS_DMA)) << "length " << length;
+
+			// Remaining lines.
+			const unsigned int cpl = M68K_Mem::CPL_M68K;
+			while (remaining > 0) {
+				unsigned int expected = cpl;
+				if (remaining > rate) {
+					remaining -= rate;
+				} else {
+					expected = (((cpl << 16) / rate) * remaining) >> 16;
+					remaining = 0;
+				}
+				ASSERT_EQ(expected, m_vdp->updateDMA()) << "length " << length;
+				EXPECT_EQ(remaining, m_vdp->DMAT_Length) << "length " << length;
+			}
+			EXPECT_FALSE(!!(m_vdp->readCtrlMD() & VdpStatus::VDP_STATUS_DMA)) << "length " << length;
+		}
+	}
+}
+
+// Test cases.
+INSTANTIATE_TEST_CASE_P(VdpDmaBlockTest_VRam, VdpDmaBlockTest,
+	::testing::Values(
+		VdpDmaBlockTest_flags(0x01, 0x02),
+		VdpDmaBlockTest_flags(0x01, 0x01),
+		VdpDmaBlockTest_flags(0x01, 0x04),
+		VdpDmaBlockTest_flags(0x01, 0x00),
+		VdpDmaBlockTest_flags(0x01, 0x80)
+));
+INSTANTIATE_TEST_CASE_P(VdpDmaBlockTest_CRam, VdpDmaBlockTest,
+	::testing::Values(
+		VdpDmaBlockTest_flags(0x03, 0x02),
+		VdpDmaBlockTest_flags(0x03, 0x01),
+		VdpDmaBlockTest_flags(0x03, 0x04)
+));
+INSTANTIATE_TEST_CASE_P(VdpDmaBlockTest_VSRam, VdpDmaBlockTest,
+	::testing::Values(
+		VdpDmaBlockTest_flags(0x05, 0x02),
+		VdpDmaBlockTest_flags(0x05, 0x01),
+		VdpDmaBlockTest_flags(0x05, 0x04)
+));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: VDP ROM / 68000 RAM DMA test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,352 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * VdpDmaTest.cpp: VDP DMA FILL / DMA COPY test.                           *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "libcompat/byteswap.h"
+
+// LibGens VDP.
+#include "Vdp/Vdp.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <iomanip>
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+struct VdpDmaTest_flags {
+	uint8_t autoInc;	// Auto-increment value.
+	bool h40;		// If true, use H40. (affects the SAT mask)
+
+	VdpDmaTest_flags(uint8_t autoInc, bool h40)
+	{
+		this->autoInc = autoInc;
+		this->h40 = h40;
+	}
+};
+
+/**
+ * Run random DMA FILL and DMA COPY operations and compare
+ * the resulting VRam to a byte-by-byte reference model.
+ */
+class VdpDmaTest : public ::testing::TestWithParam<VdpDmaTest_flags>
+{
+	protected:
+		VdpDmaTest()
+			: ::testing::TestWithParam<VdpDmaTest_flags>()
+			, m_vdp(nullptr)
+			, m_seed(0) { }
+		virtual ~VdpDmaTest() { }
+
+		virtual void SetUp(void) override;
+		virtual void TearDown(void) override;
+
+	protected:
+		Vdp *m_vdp;
+
+		// Reference VRam, in VdpTypes::VRam_t::u8[] order.
+		uint8_t m_vram[0x10000];
+
+		/**
+		 * Initialize the VDP with random VRam.
+		 */
+		void initVRam(void);
+
+		/**
+		 * Set the VDP address and access code.
+		 * @param cd Access code.
+		 * @param address Address.
+		 */
+		void setAddress(uint8_t cd, uint32_t address);
+
+		/**
+		 * Run a DMA FILL on both the VDP and the reference model.
+		 * @param address VRam address.
+		 * @param length DMA length.
+		 * @param data Fill data.
+		 */
+		void doFill(uint32_t address, uint16_t length, uint16_t data);
+
+		/**
+		 * Run a DMA COPY on both the VDP and the reference model.
+		 * @param src Source address.
+		 * @param dest Destination address.
+		 * @param length DMA length. (must not be 0)
+		 */
+		void doCopy(uint32_t src, uint32_t dest, uint16_t length);
+
+		/**
+		 * Compare the VDP's VRam to the reference model.
+		 */
+		void checkVRam(void);
+
+		// Expected VDP address after the last operation.
+		uint32_t m_address;
+
+		// Random number generator.
+		// Deterministic, so failures are reproducible.
+		uint32_t m_seed;
+		inline uint32_t rng(void)
+		{
+			m_seed = (m_seed * 1103515245) + 12345;
+			return (m_seed >> 8);
+		}
+};
+
+/**
+ * Formatting function for VdpDmaTest_flags.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const VdpDmaTest_flags& flags) {
+	return os << "Auto_Inc "
+		<< std::hex << std::uppercase
+		<< std::setfill('0') << std::setw(2)
+		<< (unsigned int)flags.autoInc
+		<< (flags.h40 ? ", H40" : ", H32");
+};
+
+/**
+ * Set up the Vdp for testing.
+ */
+void VdpDmaTest::SetUp(void)
+{
+	m_vdp = new Vdp();
+	m_vdp->setNtsc();
+	m_seed = 0x5678 ^ GetParam().autoInc;
+	m_address = 0;
+
+	const VdpDmaTest_flags flags = GetParam();
+	m_vdp->dbg_setReg(0x01, 0x54);	// Enable the display and DMA, set Mode 5.
+	m_vdp->dbg_setReg(0x05, 0x70);	// Set the sprite table base to 0xE000.
+	m_vdp->dbg_setReg(0x0C, flags.h40 ? 0x81 : 0x00);
+	initVRam();
+}
+
+/**
+ * Tear down the Vdp.
+ */
+void VdpDmaTest::TearDown(void)
+{
+	delete m_vdp;
+	m_vdp = nullptr;
+}
+
+/**
+ * Initialize the VDP with random VRam.
+ */
+void VdpDmaTest::initVRam(void)
+{
+	vector<uint16_t> vram(0x8000);
+	for (int i = 0; i < 0x8000; i++) {
+		vram[i] = (uint16_t)rng();
+	}
+
+	// Valid sprite links.
+	for (int i = 0; i < 80; i++) {
+		vram[(0xE000/2) + (i*4) + 1] &= 0x0F00;
+		vram[(0xE000/2) + (i*4) + 1] |= (i < 79 ? i + 1 : 0);
+	}
+
+	m_vdp->dbg_writeVRam_16(0, vram.data(), 0x10000);
+	memcpy(m_vram, vram.data(), sizeof(m_vram));
+}
+
+/**
+ * Set the VDP address and access code.
+ * @param cd Access code.
+ * @param address Address.
+ */
+void VdpDmaTest::setAddress(uint8_t cd, uint32_t address)
+{
+	m_vdp->writeCtrlMD(((cd & 0x03) << 14) | (address & 0x3FFF));
+	m_vdp->writeCtrlMD(((cd & 0x3C) << 2) | ((address >> 14) & 0x03));
+}
+
+/**
+ * Run a DMA FILL on both the VDP and the reference model.
+ * @param address VRam address.
+ * @param length DMA length.
+ * @param data Fill data.
+ */
+void VdpDmaTest::doFill(uint32_t address, uint16_t length, uint16_t data)
+{
+	const unsigned int inc = GetParam().autoInc;
+
+	// VDP.
+	m_vdp->dbg_setReg(0x0F, inc);
+	m_vdp->dbg_setReg(0x13, length & 0xFF);
+	m_vdp->dbg_setReg(0x14, length >> 8);
+	m_vdp->dbg_setReg(0x17, 0x80);
+	setAddress(0x21, address);
+	m_vdp->writeDataMD(data);
+
+	// Reference model.
+	// The data word is written first.
+	uint16_t tmp = ((address & 1) ? ((data << 8) | (data >> 8)) : data);
+	memcpy(&m_vram[address & ~1], &tmp, sizeof(tmp));
+	address = (address + inc) & 0xFFFF;
+
+	// NOTE: DMA FILL writes to the adjacent byte.
+	unsigned int count = (length != 0 ? length : 0x10000);
+	for (; count != 0; count--) {
+		m_vram[address ^ 1 ^ U16DATA_U8_INVERT] = (data >> 8);
+		address = (address + inc) & 0xFFFF;
+	}
+	m_address = address;
+}
+
+/**
+ * Run a DMA COPY on both the VDP and the reference model.
+ * @param src Source address.
+ * @param dest Destination address.
+ * @param length DMA length. (must not be 0)
+ */
+void VdpDmaTest::doCopy(uint32_t src, uint32_t dest, uint16_t length)
+{
+	const unsigned int inc = GetParam().autoInc;
+
+	// VDP.
+	m_vdp->dbg_setReg(0x0F, inc);
+	m_vdp->dbg_setReg(0x13, length & 0xFF);
+	m_vdp->dbg_setReg(0x14, length >> 8);
+	m_vdp->dbg_setReg(0x15, src & 0xFF);
+	m_vdp->dbg_setReg(0x16, (src >> 8) & 0xFF);
+	m_vdp->dbg_setReg(0x17, 0xC0);
+	setAddress(0x30, dest);
+
+	// Reference model.
+	for (unsigned int count = length; count != 0; count--) {
+		m_vram[dest] = m_vram[src];
+		src = (src + 1) & 0xFFFF;
+		dest = (dest + inc) & 0xFFFF;
+	}
+	m_address = dest;
+}
+
+/**
+ * Compare the VDP's VRam to the reference model.
+ */
+void VdpDmaTest::checkVRam(void)
+{
+	uint32_t address;
+	ASSERT_EQ(0, m_vdp->dbg_getAddress(&address));
+	EXPECT_EQ(m_address, address) << "VDP address is incorrect.";
+
+	// Read VRam using the data port.
+	m_vdp->dbg_setReg(0x0F, 0x02);
+	setAddress(0x00, 0);
+	for (unsigned int i = 0; i < 0x10000; i += 2) {
+		uint16_t expected;
+		memcpy(&expected, &m_vram[i], sizeof(expected));
+		const uint16_t actual = m_vdp->readDataMD();
+		ASSERT_EQ(expected, actual) << "VRam mismatch at word address "
+			<< std::hex << std::uppercase
+			<< std::setfill('0') << std::setw(4) << i;
+	}
+}
+
+/**
+ * DMA FILL with random addresses and lengths.
+ */
+TEST_P(VdpDmaTest, Fill)
+{
+	for (int i = 0; i < 200; i++) {
+		uint32_t address = rng() & 0xFFFF;
+		if (i & 1) {
+			// Start near the Sprite Attribute Table.
+			address = (0xE000 - 0x100 + (rng() & 0x7FF)) & 0xFFFF;
+		}
+		uint16_t length;
+		switch (i & 3) {
+			case 0:		length = (rng() & 0x0F); break;
+			case 1:		length = (rng() & 0x3FF); break;
+			default:	length = (uint16_t)rng(); break;
+		}
+		doFill(address, length, (uint16_t)rng());
+		ASSERT_NO_FATAL_FAILURE(checkVRam());
+	}
+}
+
+/**
+ * DMA COPY with random addresses and lengths.
+ */
+TEST_P(VdpDmaTest, Copy)
+{
+	for (int i = 0; i < 200; i++) {
+		uint32_t src = rng() & 0xFFFF;
+		uint32_t dest = rng() & 0xFFFF;
+		if (i & 1) {
+			// Overlapping source and destination.
+			dest = (src + (rng() & 0xFF) - 0x80) & 0xFFFF;
+		}
+		if (i & 2) {
+			// Copy to the Sprite Attribute Table.
+			dest = (0xE000 - 0x100 + (rng() & 0x7FF)) & 0xFFFF;
+		}
+		uint16_t length = (i & 4 ? (rng() & 0x3FF) : (uint16_t)rng());
+		if (length == 0)
+			length = 1;
+		doCopy(src, dest, length);
+		ASSERT_NO_FATAL_FAILURE(checkVRam());
+	}
+}
+
+// Test cases.
+INSTANTIATE_TEST_CASE_P(VdpDmaTest_H40, VdpDmaTest,
+	::testing::Values(
+		VdpDmaTest_flags(0x01, true),
+		VdpDmaTest_flags(0x02, true),
+		VdpDmaTest_flags(0x80, true),
+		VdpDmaTest_flags(0x00, true),
+		VdpDmaTest_flags(0x03, true),
+		VdpDmaTest_flags(0x20, true)
+));
+INSTANTIATE_TEST_CASE_P(VdpDmaTest_H32, VdpDmaTest,
+	::testing::Values(
+		VdpDmaTest_flags(0x01, false),
+		VdpDmaTest_flags(0x02, false),
+		VdpDmaTest_flags(0x80, false)
+));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: VDP DMA FILL / DMA COPY test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,234 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * VdpPaletteDirtyTest.cpp: VDP palette dirty CRAM entry test.             *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+
+// LibGens VDP.
+#include "Vdp/VdpPalette.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+namespace LibGens { namespace Tests {
+
+struct VdpPaletteDirtyTest_mode {
+	MdFb::ColorDepth bpp;
+	VdpPalette::PalMode_t palMode;
+
+	VdpPaletteDirtyTest_mode(MdFb::ColorDepth bpp, VdpPalette::PalMode_t palMode)
+	{
+		this->bpp = bpp;
+		this->palMode = palMode;
+	}
+};
+
+/**
+ * Formatting function for VdpPaletteDirtyTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const VdpPaletteDirtyTest_mode& mode) {
+	return os << MdFb::colorDepthToBpp(mode.bpp) << "-bit color, "
+		<< (mode.palMode == VdpPalette::PALMODE_32X ? "32X" : "MD");
+};
+
+class VdpPaletteDirtyTest : public ::testing::TestWithParam<VdpPaletteDirtyTest_mode>
+{
+	protected:
+		VdpPaletteDirtyTest()
+			: ::testing::TestWithParam<VdpPaletteDirtyTest_mode>()
+			, m_seed(0x5EED) { }
+		virtual ~VdpPaletteDirtyTest() { }
+
+		virtual void SetUp(void) override;
+
+	protected:
+		// Palette using the dirty CRAM entry path.
+		VdpPalette m_pal;
+
+		// Reference palette. Fully recalculated on every update.
+		VdpPalette m_ref;
+
+		/**
+		 * Update both palettes and compare the active palettes.
+		 * @param step Step number, for error messages.
+		 */
+		void updateAndCompare(int step);
+
+		// Random number generator.
+		// Deterministic, so failures are reproducible.
+		uint32_t m_seed;
+		inline uint32_t rng(void)
+		{
+			m_seed = (m_seed * 1103515245) + 12345;
+			return (m_seed >> 8);
+		}
+};
+
+/**
+ * Set up the palettes for testing.
+ */
+void VdpPaletteDirtyTest::SetUp(void)
+{
+	const VdpPaletteDirtyTest_mode mode = GetParam();
+	VdpPalette *const pals[2] = {&m_pal, &m_ref};
+	for (int i = 0; i < 2; i++) {
+		pals[i]->setBpp(mode.bpp);
+		pals[i]->setPalMode(mode.palMode);
+		pals[i]->setM5M4bits(0x03);
+		pals[i]->setBgColorIdx(0x00);
+		pals[i]->setMdShadowHighlight(false);
+		pals[i]->update();
+	}
+}
+
+/**
+ * Update both palettes and compare the active palettes.
+ * @param step Step number, for error messages.
+ */
+void VdpPaletteDirtyTest::updateAndCompare(int step)
+{
+	m_pal.update();
+	EXPECT_FALSE(m_pal.isDirty());
+
+	// Copy the state to the reference palette.
+	// Restoring CRam marks the whole active palette as dirty.
+	Zomg_CRam_t cram;
+	m_pal.zomgSaveCRam(&cram);
+	m_ref.zomgRestoreCRam(&cram);
+	m_ref.setM5M4bits(m_pal.m5m4bits());
+	m_ref.setBgColorIdx(m_pal.bgColorIdx());
+	m_ref.setMdShadowHighlight(m_pal.mdShadowHighlight());
+	m_ref.update();
+
+	// Only Mode 5 uses the dirty path.
+	// Colors 64-255 are only used with Shadow/Highlight.
+	if (!(m_pal.m5m4bits() & 0x02))
+		return;
+	const int count = (m_pal.mdShadowHighlight() ? 0x100 : 0x40);
+	if (GetParam().bpp != MdFb::BPP_32) {
+		for (int i = 0; i < count; i++) {
+			ASSERT_EQ(m_ref.m_palActive.u16[i], m_pal.m_palActive.u16[i]) <<
+				"Step " << step << ": Color " << i << " differs.";
+		}
+	} else {
+		for (int i = 0; i < count; i++) {
+			ASSERT_EQ(m_ref.m_palActive.u32[i], m_pal.m_palActive.u32[i]) <<
+				"Step " << step << ": Color " << i << " differs.";
+		}
+	}
+}
+
+/**
+ * Random CRAM writes and register changes.
+ * The dirty path must match a full recalculation.
+ */
+TEST_P(VdpPaletteDirtyTest, randomWrites)
+{
+	for (int step = 0; step < 20000; step++) {
+		const unsigned int op = rng() % 100;
+		if (op < 70) {
+			// CRAM writes. Usually a few colors, so the
+			// dirty path is used, but sometimes more than 16.
+			const int writes = ((op < 65) ? (rng() % 4) + 1 : (rng() % 24) + 1);
+			for (int i = 0; i < writes; i++) {
+				if (rng() & 7) {
+					m_pal.writeCRam_16((rng() % 64) * 2, rng() & 0xFFFF);
+				} else {
+					m_pal.writeCRam_8(rng() % 128, rng() & 0xFF);
+				}
+			}
+		} else if (op < 80) {
+			// Toggle Shadow/Highlight.
+			m_pal.setMdShadowHighlight(!m_pal.mdShadowHighlight());
+		} else if (op < 90) {
+			// Change the background color.
+			m_pal.setBgColorIdx(rng() % 64);
+		} else {
+			// Change the mode bits. Mostly Mode 5 with PSEL=1.
+			static const uint8_t m5m4[8] = {3, 3, 3, 3, 2, 2, 1, 0};
+			m_pal.setM5M4bits(m5m4[rng() % 8]);
+		}
+
+		updateAndCompare(step);
+		if (HasFatalFailure())
+			return;
+	}
+}
+
+/**
+ * CRAM writes followed by a background color change
+ * in the same update.
+ */
+TEST_P(VdpPaletteDirtyTest, bgColorAfterWrite)
+{
+	m_pal.setMdShadowHighlight(true);
+	m_pal.setBgColorIdx(0x15);
+	updateAndCompare(0);
+
+	// Color 0 and the background color both change.
+	m_pal.writeCRam_16(0x00, 0x0E00);
+	m_pal.writeCRam_16(0x15 * 2, 0x00E0);
+	updateAndCompare(1);
+
+	// Only the background color changes.
+	m_pal.writeCRam_16(0x15 * 2, 0x0ACE);
+	updateAndCompare(2);
+
+	// Only color 0 changes. The background color is still shown.
+	m_pal.writeCRam_16(0x00, 0x0246);
+	updateAndCompare(3);
+}
+
+// Test cases.
+
+INSTANTIATE_TEST_CASE_P(VdpPaletteDirtyTest_MD, VdpPaletteDirtyTest,
+	::testing::Values(
+		VdpPaletteDirtyTest_mode(MdFb::BPP_15, VdpPalette::PALMODE_MD),
+		VdpPaletteDirtyTest_mode(MdFb::BPP_16, VdpPalette::PALMODE_MD),
+		VdpPaletteDirtyTest_mode(MdFb::BPP_32, VdpPalette::PALMODE_MD)
+));
+
+INSTANTIATE_TEST_CASE_P(VdpPaletteDirtyTest_32X, VdpPaletteDirtyTest,
+	::testing::Values(
+		VdpPaletteDirtyTest_mode(MdFb::BPP_16, VdpPalette::PALMODE_32X),
+		VdpPaletteDirtyTest_mode(MdFb::BPP_32, VdpPalette::PALMODE_32X)
+));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: VDP palette dirty CRAM entry test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
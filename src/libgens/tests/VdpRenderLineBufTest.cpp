@@ -0,0 +1,412 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * VdpRenderLineBufTest.cpp: VDP line buffer rendering test.               *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "libcompat/cpuflags.h"
+
+// LibGens VDP.
+#include "Vdp/Vdp.hpp"
+#include "Util/MdFb.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <iomanip>
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+struct VdpRenderLineBufTest_flags {
+	uint32_t cpuFlags;
+	uint32_t cpuFlags_slow;
+
+	VdpRenderLineBufTest_flags(uint32_t cpuFlags, uint32_t cpuFlags_slow)
+	{
+		this->cpuFlags = cpuFlags;
+		this->cpuFlags_slow = cpuFlags_slow;
+	}
+};
+
+/**
+ * Render a Mode 5 scene using the scalar line buffer renderer,
+ * then render it again using the selected CPU flags and verify
+ * that the framebuffers are identical.
+ */
+class VdpRenderLineBufTest : public ::testing::TestWithParam<VdpRenderLineBufTest_flags>
+{
+	protected:
+		VdpRenderLineBufTest()
+			: ::testing::TestWithParam<VdpRenderLineBufTest_flags>()
+			, m_vdp(nullptr)
+			, m_seed(0) { }
+		virtual ~VdpRenderLineBufTest() { }
+
+		virtual void SetUp(void) override;
+		virtual void TearDown(void) override;
+
+	protected:
+		Vdp *m_vdp;
+
+		// Previous CPU flags.
+		uint32_t cpuFlags_old;
+
+		/**
+		 * Initialize the VDP with a random scene.
+		 * @param reg0C Mode Set 4 register value.
+		 */
+		void initScene(uint8_t reg0C);
+
+		/**
+		 * Render one frame.
+		 */
+		void renderFrame(void);
+
+		/**
+		 * Copy the framebuffer.
+		 * @param fb Destination buffer.
+		 */
+		void copyFb(vector<uint32_t> &fb) const;
+
+		/**
+		 * Render the scene in all color depths and compare
+		 * the output to the scalar renderer.
+		 * @param layerCompositing If true, use layer compositing for the tested output.
+		 */
+		void checkScene(bool layerCompositing = false);
+
+		// Random number generator.
+		// Deterministic, so failures are reproducible.
+		uint32_t m_seed;
+		inline uint32_t rng(void)
+		{
+			m_seed = (m_seed * 1103515245) + 12345;
+			return (m_seed >> 8);
+		}
+};
+
+/**
+ * Formatting function for VdpRenderLineBufTest_flags.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const VdpRenderLineBufTest_flags& flags) {
+	return os << "CPU flags "
+		<< std::hex << std::uppercase
+		<< std::setfill('0') << std::setw(8)
+		<< flags.cpuFlags;
+};
+
+/**
+ * Get the test parameters for a set of CPU flags.
+ * gtest evaluates the parameter generators in InitGoogleTest(),
+ * after LibGens::Init() has set CPU_Flags.
+ * If the CPU doesn't support the flags, no parameters are
+ * returned, so the tests aren't instantiated.
+ * @param name Test case name.
+ * @param cpuFlags Required CPU flags.
+ * @param cpuFlags_slow CPU flags that indicate the CPU is slow with cpuFlags.
+ * @return Test parameters.
+ */
+static vector<VdpRenderLineBufTest_flags> VdpRenderLineBufTest_params(
+	const char *name, uint32_t cpuFlags, uint32_t cpuFlags_slow)
+{
+	vector<VdpRenderLineBufTest_flags> params;
+	if (cpuFlags != 0 && !(CPU_Flags & (cpuFlags | cpuFlags_slow))) {
+		fprintf(stderr, "NOTE: CPU does not support the required flags for %s.\n"
+			"These tests will not be run.\n", name);
+	} else {
+		params.push_back(VdpRenderLineBufTest_flags(cpuFlags, cpuFlags_slow));
+	}
+	return params;
+}
+
+/**
+ * Set up the Vdp for testing.
+ */
+void VdpRenderLineBufTest::SetUp(void)
+{
+	// Verify CPU flags.
+	VdpRenderLineBufTest_flags flags = GetParam();
+	uint32_t totalFlags = (flags.cpuFlags | flags.cpuFlags_slow);
+	if (flags.cpuFlags != 0) {
+		ASSERT_NE(0U, CPU_Flags & totalFlags) <<
+			"CPU does not support the required flags for this test.";
+	}
+	cpuFlags_old = CPU_Flags;
+
+	// Initialize the VDP.
+	m_vdp = new Vdp();
+	m_vdp->setNtsc();
+	m_seed = 0x1234;
+}
+
+/**
+ * Tear down the Vdp.
+ */
+void VdpRenderLineBufTest::TearDown(void)
+{
+	CPU_Flags = cpuFlags_old;
+	delete m_vdp;
+	m_vdp = nullptr;
+}
+
+/**
+ * Initialize the VDP with a random scene.
+ * @param reg0C Mode Set 4 register value.
+ */
+void VdpRenderLineBufTest::initScene(uint8_t reg0C)
+{
+	m_vdp->dbg_setReg(0x00, 0x04);	// Enable the palette.
+	m_vdp->dbg_setReg(0x01, 0x44);	// Enable the display, set Mode 5.
+	m_vdp->dbg_setReg(0x02, 0x30);	// Set scroll A name table base to 0xC000.
+	m_vdp->dbg_setReg(0x03, 0x00);	// Window isn't used.
+	m_vdp->dbg_setReg(0x04, 0x05);	// Set scroll B name table base to 0xA000.
+	m_vdp->dbg_setReg(0x05, 0x70);	// Set the sprite table base to 0xE000.
+	m_vdp->dbg_setReg(0x07, 0x05);	// Background color.
+	m_vdp->dbg_setReg(0x0B, 0x00);	// Full-screen scrolling.
+	m_vdp->dbg_setReg(0x0C, reg0C);
+	m_vdp->dbg_setReg(0x0D, 0x3F);	// Set the HScroll table base to 0xFC00.
+	m_vdp->dbg_setReg(0x0F, 0x02);	// Set the auto-increment value to 2.
+	m_vdp->dbg_setReg(0x10, 0x01);	// Set the scroll size to V32 H64.
+
+	// Random CRam.
+	uint16_t cram[64];
+	for (int i = 0; i < 64; i++) {
+		cram[i] = (rng() & 0x0EEE);
+	}
+	m_vdp->dbg_writeCRam_16(0, cram, 64);
+
+	// Random VSRam.
+	uint16_t vsram[40];
+	for (int i = 0; i < 40; i++) {
+		vsram[i] = (rng() & 0x3FF);
+	}
+	m_vdp->dbg_writeVSRam_16(0, vsram, 40);
+
+	// Random patterns and name tables.
+	// The sprite table and HScroll table are set up below.
+	vector<uint16_t> vram(0x8000);
+	for (int i = 0; i < 0xE000/2; i++) {
+		vram[i] = (uint16_t)rng();
+	}
+
+	// 80 random sprites.
+	uint16_t *spr = &vram[0xE000/2];
+	for (int i = 0; i < 80; i++, spr += 4) {
+		spr[0] = 128 + (rng() % 256) - 32;
+		spr[1] = ((rng() & 0x0F) << 8) | (i < 79 ? i + 1 : 0);
+		spr[2] = (uint16_t)rng();
+		spr[3] = 128 + (rng() % 352) - 32;
+	}
+
+	// Random horizontal scrolling.
+	for (int i = 0xFC00/2; i < 0x10000/2; i++) {
+		vram[i] = (rng() & 0x3FF);
+	}
+
+	m_vdp->dbg_writeVRam_16(0, vram.data(), vram.size() * 2);
+}
+
+/**
+ * Render one frame.
+ */
+void VdpRenderLineBufTest::renderFrame(void)
+{
+	m_vdp->updateVdpLines(true);
+	for (; m_vdp->VDP_Lines.currentLine < m_vdp->VDP_Lines.totalDisplayLines;
+	     m_vdp->VDP_Lines.currentLine++)
+	{
+		m_vdp->renderLine();
+	}
+}
+
+/**
+ * Copy the framebuffer.
+ * @param fb Destination buffer.
+ */
+void VdpRenderLineBufTest::copyFb(vector<uint32_t> &fb) const
+{
+	const MdFb *const md_screen = m_vdp->MD_Screen;
+	const int lines = md_screen->numLines();
+	const int px = md_screen->pxPerLine();
+	fb.resize(lines * px);
+
+	uint32_t *dest = fb.data();
+	for (int line = 0; line < lines; line++, dest += px) {
+		if (md_screen->bpp() == MdFb::BPP_32) {
+			memcpy(dest, md_screen->lineBuf32(line), px * sizeof(uint32_t));
+		} else {
+			const uint16_t *src = md_screen->lineBuf16(line);
+			for (int x = 0; x < px; x++) {
+				dest[x] = src[x];
+			}
+		}
+	}
+}
+
+/**
+ * Render the scene in all color depths and compare
+ * the output to the scalar renderer.
+ * @param layerCompositing If true, use layer compositing for the tested output.
+ */
+void VdpRenderLineBufTest::checkScene(bool layerCompositing)
+{
+	static const MdFb::ColorDepth bpps[] = {
+		MdFb::BPP_15, MdFb::BPP_16, MdFb::BPP_32
+	};
+
+	const uint32_t cpuFlags = GetParam().cpuFlags;
+	vector<uint32_t> expected, actual;
+	for (int i = 0; i < (int)(sizeof(bpps)/sizeof(bpps[0])); i++) {
+		m_vdp->MD_Screen->setBpp(bpps[i]);
+
+		// Reference implementation.
+		// The first frame is discarded, since the sprite line
+		// cache for line 0 is set up by the previous frame.
+		CPU_Flags = 0;
+		m_vdp->options.layerCompositing = false;
+		renderFrame();
+		m_vdp->MD_Screen->clear();
+		renderFrame();
+		copyFb(expected);
+
+		// Selected CPU flags.
+		CPU_Flags = cpuFlags;
+		m_vdp->options.layerCompositing = layerCompositing;
+		m_vdp->MD_Screen->clear();
+		renderFrame();
+		copyFb(actual);
+
+		ASSERT_EQ(expected.size(), actual.size());
+		const int px = m_vdp->MD_Screen->pxPerLine();
+		for (int j = 0; j < (int)expected.size(); j++) {
+			ASSERT_EQ(expected[j], actual[j]) <<
+				MdFb::colorDepthToBpp(bpps[i]) << "-bit color: " <<
+				"Pixel (" << (j % px) << ", " << (j / px) << ") differs.";
+		}
+	}
+}
+
+/**
+ * Test rendering in H40.
+ */
+TEST_P(VdpRenderLineBufTest, H40)
+{
+	initScene(0x81);
+	checkScene();
+}
+
+/**
+ * Test rendering in H32.
+ * This also tests the left and right borders.
+ */
+TEST_P(VdpRenderLineBufTest, H32)
+{
+	initScene(0x00);
+	checkScene();
+}
+
+/**
+ * Test rendering in H40 with Shadow/Highlight enabled.
+ * This uses all 256 palette entries.
+ */
+TEST_P(VdpRenderLineBufTest, H40_ShadowHighlight)
+{
+	initScene(0x89);
+	checkScene();
+}
+
+/**
+ * Test layer compositing in H40 with the Window plane.
+ */
+TEST_P(VdpRenderLineBufTest, H40_LayerCompositing)
+{
+	initScene(0x81);
+	m_vdp->dbg_setReg(0x03, 0x2C);	// Set the window name table base to 0xB000.
+	m_vdp->dbg_setReg(0x11, 0x8A);	// Window: Right side, starting at cell 20.
+	m_vdp->dbg_setReg(0x12, 0x08);	// Window: Top 8 cells.
+	checkScene(true);
+}
+
+/**
+ * Test layer compositing in H32 with 2-cell vertical scrolling.
+ */
+TEST_P(VdpRenderLineBufTest, H32_LayerCompositing)
+{
+	initScene(0x00);
+	m_vdp->dbg_setReg(0x0B, 0x04);	// 2-cell vertical scrolling.
+	checkScene(true);
+}
+
+/**
+ * Test layer compositing in H40 with Shadow/Highlight and the Window plane.
+ * Window and high-priority Scroll A pixels affect shadowing.
+ */
+TEST_P(VdpRenderLineBufTest, H40_ShadowHighlight_LayerCompositing)
+{
+	initScene(0x89);
+	m_vdp->dbg_setReg(0x03, 0x2C);	// Set the window name table base to 0xB000.
+	m_vdp->dbg_setReg(0x11, 0x06);	// Window: Left side, up to cell 12.
+	m_vdp->dbg_setReg(0x12, 0x94);	// Window: Bottom, starting at cell 20.
+	checkScene(true);
+}
+
+// Test cases.
+
+INSTANTIATE_TEST_CASE_P(VdpRenderLineBufTest_NoFlags, VdpRenderLineBufTest,
+	::testing::Values(VdpRenderLineBufTest_flags(0, 0)
+));
+
+// NOTE: The SIMD renderers are only implemented for GNU C on x86.
+#if defined(__GNUC__) && \
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+INSTANTIATE_TEST_CASE_P(VdpRenderLineBufTest_SSE2, VdpRenderLineBufTest,
+	::testing::ValuesIn(VdpRenderLineBufTest_params("VdpRenderLineBufTest_SSE2",
+		MDP_CPUFLAG_X86_SSE2, MDP_CPUFLAG_X86_SSE2SLOW))
+);
+INSTANTIATE_TEST_CASE_P(VdpRenderLineBufTest_AVX2, VdpRenderLineBufTest,
+	::testing::ValuesIn(VdpRenderLineBufTest_params("VdpRenderLineBufTest_AVX2",
+		MDP_CPUFLAG_X86_AVX2, 0))
+);
+#endif
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: VDP line buffer rendering test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
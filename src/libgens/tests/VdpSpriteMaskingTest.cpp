@@ -93,6 +93,19 @@ class VdpSpriteMaskingTest : public ::testing::TestWithParam<VdpSpriteMaskingTes
 
 		int loadVRam(ScreenMode screenMode);
 
+		/**
+		 * Run the VDP for one frame and check the sprite test.
+		 */
+		void runSpriteTest(void);
+
+		/**
+		 * Run the VDP for one frame, reading the status register
+		 * after each line, as a game polling the VDP would.
+		 * @param status Array for SOVR and COL after each line.
+		 * @param count Number of lines in the array.
+		 */
+		void runStatusFrame(uint16_t *status, int count);
+
 	public:
 		/**
 		 * Channel value must be < this number
@@ -387,9 +400,9 @@ VdpSpriteMaskingTest::SpriteTestResult VdpSpriteMaskingTest::checkSpriteTest(int
 }
 
 /**
- * Run a sprite test.
+ * Run the VDP for one frame and check the sprite test.
  */
-TEST_P(VdpSpriteMaskingTest, spriteMaskingTest)
+void VdpSpriteMaskingTest::runSpriteTest(void)
 {
 	VdpSpriteMaskingTest_mode mode = GetParam();
 
@@ -451,6 +464,80 @@ TEST_P(VdpSpriteMaskingTest, spriteMaskingTest)
 	}
 }
 
+/**
+ * Run a sprite test.
+ */
+TEST_P(VdpSpriteMaskingTest, spriteMaskingTest)
+{
+	runSpriteTest();
+}
+
+/**
+ * Run a sprite test using threaded rendering.
+ * Sprite masking depends on the previous line's
+ * dot overflow, so this checks that the rendering
+ * thread processes lines in order.
+ */
+TEST_P(VdpSpriteMaskingTest, spriteMaskingTestThreaded)
+{
+	m_vdp->setThreadedRendering(true);
+	ASSERT_TRUE(m_vdp->isThreadedRendering());
+	runSpriteTest();
+}
+
+/**
+ * Run the VDP for one frame, reading the status register
+ * after each line, as a game polling the VDP would.
+ * @param status Array for SOVR and COL after each line.
+ * @param count Number of lines in the array.
+ */
+void VdpSpriteMaskingTest::runStatusFrame(uint16_t *status, int count)
+{
+	static const uint16_t mask =
+		(VdpStatus::VDP_STATUS_SOVR | VdpStatus::VDP_STATUS_COLLISION);
+
+	memset(status, 0, count * sizeof(*status));
+	m_vdp->updateVdpLines(true);
+	for (; m_vdp->VDP_Lines.currentLine < m_vdp->VDP_Lines.totalDisplayLines;
+	     m_vdp->VDP_Lines.currentLine++)
+	{
+		m_vdp->renderLine();
+		if (m_vdp->VDP_Lines.currentLine < count) {
+			status[m_vdp->VDP_Lines.currentLine] =
+				(m_vdp->readCtrlMD() & mask);
+		}
+	}
+}
+
+/**
+ * Check that threaded rendering sets SOVR and COL
+ * on the same lines as unthreaded rendering.
+ * Status register reads only wait for the worker
+ * if a line might set COL, so this checks that
+ * SOVR is set by the emulation thread and that
+ * no COL is missed.
+ */
+TEST_P(VdpSpriteMaskingTest, spriteStatusThreaded)
+{
+	static const int lines = 313;
+	uint16_t expected[lines], actual[lines];
+
+	// Render a frame without threaded rendering.
+	runStatusFrame(expected, lines);
+
+	// Reset the VDP and render the same frame with threaded rendering.
+	TearDown();
+	SetUp();
+	m_vdp->setThreadedRendering(true);
+	ASSERT_TRUE(m_vdp->isThreadedRendering());
+	runStatusFrame(actual, lines);
+
+	for (int line = 0; line < lines; line++) {
+		EXPECT_EQ(expected[line], actual[line]) <<
+			"Status bits differ after line " << line << ".";
+	}
+}
+
 // Test cases.
 // NOTE: Test case numbers start with 0 in Google Test.
 // TODO: Add a dummy test 0?
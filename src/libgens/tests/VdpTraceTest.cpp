@@ -0,0 +1,151 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * VdpTraceTest.cpp: VDP port write trace test.                            *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+
+// LibGens VDP.
+#include "Vdp/Vdp.hpp"
+#include "Vdp/VdpTrace.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+class VdpTraceTest : public ::testing::Test
+{
+	protected:
+		VdpTraceTest()
+			: ::testing::Test() { }
+		virtual ~VdpTraceTest() { }
+};
+
+/**
+ * Entries are returned oldest first.
+ */
+TEST_F(VdpTraceTest, record)
+{
+	VdpTrace trace;
+	vector<VdpTrace::Entry_t> buf(VdpTrace::TRACE_SIZE);
+	EXPECT_EQ(0U, trace.snapshot(buf.data()));
+
+	trace.record(VdpTrace::PORT_CTRL, 0x01, 10, 1000, 0x8154);
+	trace.nextFrame();
+	trace.record(VdpTrace::PORT_DATA, 0x03, 20, 2000, 0x0EEE);
+	EXPECT_EQ(2U, trace.recorded());
+	ASSERT_EQ(2U, trace.snapshot(buf.data()));
+
+	EXPECT_EQ(0U, buf[0].frame);
+	EXPECT_EQ(10U, buf[0].line);
+	EXPECT_EQ(VdpTrace::PORT_CTRL, buf[0].port);
+	EXPECT_EQ(0x01U, buf[0].code);
+	EXPECT_EQ(1000U, buf[0].mclk);
+	EXPECT_EQ(0x8154U, buf[0].value);
+
+	EXPECT_EQ(1U, buf[1].frame);
+	EXPECT_EQ(20U, buf[1].line);
+	EXPECT_EQ(VdpTrace::PORT_DATA, buf[1].port);
+	EXPECT_EQ(0x03U, buf[1].code);
+	EXPECT_EQ(2000U, buf[1].mclk);
+	EXPECT_EQ(0x0EEEU, buf[1].value);
+}
+
+/**
+ * Old entries are overwritten when the buffer is full.
+ */
+TEST_F(VdpTraceTest, wraparound)
+{
+	VdpTrace trace;
+	const unsigned int total = VdpTrace::TRACE_SIZE + 1000;
+	for (unsigned int i = 0; i < total; i++) {
+		trace.record(VdpTrace::PORT_DATA, 0x01, 0, 0, i);
+	}
+	EXPECT_EQ(total, trace.recorded());
+
+	// The oldest slot is the next one to be written,
+	// so it isn't included in the snapshot.
+	vector<VdpTrace::Entry_t> buf(VdpTrace::TRACE_SIZE);
+	const unsigned int count = trace.snapshot(buf.data());
+	ASSERT_EQ(VdpTrace::TRACE_SIZE - 1, count);
+	for (unsigned int i = 0; i < count; i++) {
+		ASSERT_EQ(total - count + i, buf[i].value) << "at entry " << i;
+	}
+}
+
+/**
+ * Vdp records control and data port writes when tracing is enabled.
+ */
+TEST_F(VdpTraceTest, vdpPorts)
+{
+	Vdp vdp;
+	EXPECT_FALSE(vdp.isTracing());
+	EXPECT_EQ(nullptr, vdp.trace());
+	vdp.writeCtrlMD(0x8154);
+
+	vdp.setTracing(true);
+	ASSERT_TRUE(vdp.isTracing());
+	ASSERT_NE(nullptr, vdp.trace());
+
+	// Write a CRam word.
+	vdp.writeCtrlMD(0xC000);
+	vdp.writeCtrlMD(0x0000);
+	vdp.writeDataMD(0x0EEE);
+
+	vector<VdpTrace::Entry_t> buf(VdpTrace::TRACE_SIZE);
+	ASSERT_EQ(3U, vdp.trace()->snapshot(buf.data()));
+	EXPECT_EQ(VdpTrace::PORT_CTRL, buf[0].port);
+	EXPECT_EQ(0xC000U, buf[0].value);
+	EXPECT_EQ(VdpTrace::PORT_CTRL, buf[1].port);
+	EXPECT_EQ(0x0000U, buf[1].value);
+	EXPECT_EQ(VdpTrace::PORT_DATA, buf[2].port);
+	EXPECT_EQ(0x03U, buf[2].code);
+	EXPECT_EQ(0x0EEEU, buf[2].value);
+
+	vdp.setTracing(false);
+	EXPECT_FALSE(vdp.isTracing());
+	EXPECT_EQ(nullptr, vdp.trace());
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: VDP port write trace test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -35,9 +35,8 @@ using namespace std;
 // NOTE: This test suite uses mdZ80 directly.
 // The Z80 class is currently hard-coded for MD only.
 
-// NOTE: Due to limitations in mdZ80 right now,
-// the first 8 KB must be RAM, and must be
-// accessible as Ram_Z80.
+// NOTE: mdZ80_x86.asm reads Ram_Z80 directly for $0000-$3FFF,
+// so it must be defined here. (The C executor doesn't use it.)
 extern "C" {
 	uint8_t Ram_Z80[65536];
 }
@@ -50,7 +49,8 @@ class Z80Tests : public ::testing::Test
 		Z80Tests()
 			: ::testing::Test()
 			, m_Z80(nullptr)
-			, halt(false) { }
+			, halt(false)
+			, error(false) { }
 		virtual ~Z80Tests() { }
 
 		virtual void SetUp(void) override;
@@ -62,6 +62,7 @@ class Z80Tests : public ::testing::Test
 
 		// System state.
 		bool halt;
+		bool error;	// Set if the program printed an error.
 
 		// FIXME: Pass the context in these functions.
 		static uint8_t FASTCALL Z80_ReadB_static(uint32_t adr) {
@@ -93,6 +94,7 @@ void Z80Tests::SetUp()
 	// Set the current Z80Tests.
 	curZ80Tests = this;
 	halt = false;
+	error = false;
 
 	// Initialize Z80 memory.
 	memset(Ram_Z80, 0, sizeof(Ram_Z80));
@@ -132,6 +134,7 @@ void Z80Tests::TearDown(void)
 
 	curZ80Tests = nullptr;
 	halt = false;
+	error = false;
 }
 
 // Memory read/write functions.
@@ -160,7 +163,10 @@ void Z80Tests::Z80_OutB(uint32_t adr, uint8_t data)
 	switch (adr & 0xFF) {
 		case 0x01:
 			// stdout
-			// TODO: Lines beginning with '*' should be in red and trigger an error.
+			// ZEXDOC/ZEXALL print "ERROR ****" if a test fails.
+			// TODO: Print error lines in red.
+			if (data == '*')
+				error = true;
 			fputc(data, stdout);
 			break;
 
@@ -202,7 +208,7 @@ TEST_F(Z80Tests, zexdoc)
 	}
 	printf("\n");
 
-	// TODO: If any errors occurred, fail the test.
+	EXPECT_FALSE(error);
 }
 
 /**
@@ -228,7 +234,7 @@ TEST_F(Z80Tests, zexall)
 	}
 	printf("\n");
 
-	// TODO: If any errors occurred, fail the test.
+	EXPECT_FALSE(error);
 }
 
 } }
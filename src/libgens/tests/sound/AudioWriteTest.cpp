@@ -100,8 +100,7 @@ void AudioWriteTest::SetUp(void)
 	buf = (int16_t*)aligned_malloc(16, samples * 2 * sizeof(*buf));
 
 	// Copy the test data into SoundMgr.
-	memcpy(SoundMgr::ms_SegBufL, AudioWriteTest_Input_L, sizeof(AudioWriteTest_Input_L));
-	memcpy(SoundMgr::ms_SegBufR, AudioWriteTest_Input_R, sizeof(AudioWriteTest_Input_R));
+	AudioWriteTest_copyInput();
 }
 
 /**
@@ -157,15 +156,28 @@ INSTANTIATE_TEST_CASE_P(AudioWriteTest_NoFlags, AudioWriteTest,
 	::testing::Values(AudioWriteTest_flags(0, 0)
 ));
 
-// NOTE: SoundMgr only implements MMX/SSE2 using GNU assembler.
+// NOTE: On ARM, NEON is selected at compile time,
+// so the NoFlags test uses NEON if it's available.
+// (The NEON writers have not been built or tested on ARM yet.)
+// MSVC doesn't support MMX intrinsics on 64-bit.
 #if defined(__GNUC__) && \
-    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__)) || \
+    defined(_M_IX86)
 INSTANTIATE_TEST_CASE_P(AudioWriteTest_MMX, AudioWriteTest,
-	::testing::Values(AudioWriteTest_flags(MDP_CPUFLAG_X86_MMX, 0)
-));
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_MMX",
+		MDP_CPUFLAG_X86_MMX, 0))
+);
+#endif
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
 INSTANTIATE_TEST_CASE_P(AudioWriteTest_SSE2, AudioWriteTest,
-	::testing::Values(AudioWriteTest_flags(MDP_CPUFLAG_X86_SSE2, MDP_CPUFLAG_X86_SSE2SLOW)
-));
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_SSE2",
+		MDP_CPUFLAG_X86_SSE2, MDP_CPUFLAG_X86_SSE2SLOW))
+);
+INSTANTIATE_TEST_CASE_P(AudioWriteTest_AVX2, AudioWriteTest,
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_AVX2",
+		MDP_CPUFLAG_X86_AVX2, 0))
+);
 #endif
 
 } }
@@ -24,6 +24,19 @@
 
 // C includes.
 #include <stdint.h>
+#include <stdio.h>
+
+// C++ includes.
+#include <vector>
+
+// CPU flags.
+#include "libcompat/cpuflags.h"
+
+// Sound Manager
+#include "sound/SoundMgr.hpp"
+
+// Test data.
+#include "AudioWriteTest_data.h"
 
 namespace LibGens { namespace Tests {
 
@@ -38,6 +51,44 @@ struct AudioWriteTest_flags {
 	}
 };
 
+/**
+ * Get the test parameters for a set of CPU flags.
+ * gtest evaluates the parameter generators in InitGoogleTest(),
+ * after LibGens::Init() has set CPU_Flags.
+ * If the CPU doesn't support the flags, no parameters are
+ * returned, so the tests aren't instantiated.
+ * @param name Test case name.
+ * @param cpuFlags Required CPU flags.
+ * @param cpuFlags_slow CPU flags that indicate the CPU is slow with cpuFlags.
+ * @return Test parameters.
+ */
+static inline std::vector<AudioWriteTest_flags> AudioWriteTest_params(
+	const char *name, uint32_t cpuFlags, uint32_t cpuFlags_slow)
+{
+	std::vector<AudioWriteTest_flags> params;
+	if (cpuFlags != 0 && !(CPU_Flags & (cpuFlags | cpuFlags_slow))) {
+		fprintf(stderr, "NOTE: CPU does not support the required flags for %s.\n"
+			"These tests will not be run.\n", name);
+	} else {
+		params.push_back(AudioWriteTest_flags(cpuFlags, cpuFlags_slow));
+	}
+	return params;
+}
+
+/**
+ * Copy the test data into SoundMgr.
+ * The test data has separate L and R channels,
+ * but the segment buffer is interleaved.
+ */
+static inline void AudioWriteTest_copyInput(void)
+{
+	static const int samples = (int)(sizeof(AudioWriteTest_Input_L) / sizeof(AudioWriteTest_Input_L[0]));
+	for (int i = 0; i < samples; i++) {
+		SoundMgr::ms_SegBuf[i*2] = AudioWriteTest_Input_L[i];
+		SoundMgr::ms_SegBuf[i*2+1] = AudioWriteTest_Input_R[i];
+	}
+}
+
 } }
 
 #endif /* __LIBGENS_TESTS_SOUND_AUDIOWRITETEST_HPP__ */
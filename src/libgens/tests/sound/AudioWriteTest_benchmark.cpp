@@ -130,8 +130,7 @@ TEST_P(AudioWriteTest_benchmark, writeStereo)
 		// Copy the test data into SoundMgr.
 		// Note that this has to be done here instead of in SetUp(),
 		// since the segment buffer is erased after every iteration.
-		memcpy(SoundMgr::ms_SegBufL, AudioWriteTest_Input_L, sizeof(AudioWriteTest_Input_L));
-		memcpy(SoundMgr::ms_SegBufR, AudioWriteTest_Input_R, sizeof(AudioWriteTest_Input_R));
+		AudioWriteTest_copyInput();
 
 		int ret = SoundMgr::writeStereo(buf, samples);
 		ASSERT_EQ(samples, ret);
@@ -148,8 +147,7 @@ TEST_P(AudioWriteTest_benchmark, writeMono)
 		// Copy the test data into SoundMgr.
 		// Note that this has to be done here instead of in SetUp(),
 		// since the segment buffer is erased after every iteration.
-		memcpy(SoundMgr::ms_SegBufL, AudioWriteTest_Input_L, sizeof(AudioWriteTest_Input_L));
-		memcpy(SoundMgr::ms_SegBufR, AudioWriteTest_Input_R, sizeof(AudioWriteTest_Input_R));
+		AudioWriteTest_copyInput();
 
 		int ret = SoundMgr::writeMono(buf, samples);
 		ASSERT_EQ(samples, ret);
@@ -160,15 +158,27 @@ INSTANTIATE_TEST_CASE_P(AudioWriteTest_benchmark_NoFlags, AudioWriteTest_benchma
 	::testing::Values(AudioWriteTest_flags(0, 0)
 ));
 
-// NOTE: SoundMgr only implements MMX/SSE2 using GNU assembler.
+// NOTE: On ARM, NEON is selected at compile time,
+// so the NoFlags test uses NEON if it's available.
+// MSVC doesn't support MMX intrinsics on 64-bit.
 #if defined(__GNUC__) && \
-    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
+    (defined(__i386__) || defined(__amd64__) || defined(__x86_64__)) || \
+    defined(_M_IX86)
 INSTANTIATE_TEST_CASE_P(AudioWriteTest_benchmark_MMX, AudioWriteTest_benchmark,
-	::testing::Values(AudioWriteTest_flags(MDP_CPUFLAG_X86_MMX, 0)
-));
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_benchmark_MMX",
+		MDP_CPUFLAG_X86_MMX, 0))
+);
+#endif
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
 INSTANTIATE_TEST_CASE_P(AudioWriteTest_benchmark_SSE2, AudioWriteTest_benchmark,
-	::testing::Values(AudioWriteTest_flags(MDP_CPUFLAG_X86_SSE2, MDP_CPUFLAG_X86_SSE2SLOW)
-));
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_benchmark_SSE2",
+		MDP_CPUFLAG_X86_SSE2, MDP_CPUFLAG_X86_SSE2SLOW))
+);
+INSTANTIATE_TEST_CASE_P(AudioWriteTest_benchmark_AVX2, AudioWriteTest_benchmark,
+	::testing::ValuesIn(AudioWriteTest_params("AudioWriteTest_benchmark_AVX2",
+		MDP_CPUFLAG_X86_AVX2, 0))
+);
 #endif
 
 } }
@@ -0,0 +1,381 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * PsgBlepTest.cpp: PSG band-limited step synthesis test.                  *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "libcompat/cpuflags.h"
+#include "cpu/M68K.hpp"
+
+// LibGens PSG.
+#include "sound/Psg.hpp"
+#include "sound/SoundMgr.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace LibGens { namespace Tests {
+
+class PsgBlepTest : public ::testing::Test
+{
+	protected:
+		PsgBlepTest()
+			: ::testing::Test()
+			, m_psg(nullptr) { }
+		virtual ~PsgBlepTest() { }
+
+		virtual void SetUp(void) override;
+		virtual void TearDown(void) override;
+
+	protected:
+		Psg *m_psg;
+
+		static const int rate = 44100;
+
+		/**
+		 * Reinitialize the PSG.
+		 * Psg::reset() doesn't reset the counters,
+		 * so reInit() is used to get the same state for each run.
+		 * @param bandLimited If true, enable band-limited step synthesis.
+		 */
+		void reInit(bool bandLimited);
+
+		// Output delay of band-limited step synthesis.
+		// (BLEP_WIDTH / 2)
+		static const int delay = 8;
+
+		/**
+		 * Render PSG audio.
+		 * @param length Number of samples.
+		 * @param audio Audio output. (left channel)
+		 */
+		void render(int length, vector<int32_t> &audio);
+
+		/**
+		 * Count the samples that match the legacy output.
+		 * Band-limited output is compared after removing the delay.
+		 * Samples within delay of a legacy transition are skipped.
+		 * @param legacy Legacy output.
+		 * @param blep Band-limited output.
+		 * @param compared Number of samples compared.
+		 * @return Number of mismatched samples.
+		 */
+		static int countMismatches(const vector<int32_t> &legacy,
+					   const vector<int32_t> &blep, int *compared);
+
+		/**
+		 * Get the power of a frequency using the Goertzel algorithm.
+		 * @param audio Audio.
+		 * @param freq Frequency, in Hz.
+		 * @return Power.
+		 */
+		static double power(const vector<int32_t> &audio, double freq);
+};
+
+/**
+ * Set up the PSG for testing.
+ */
+void PsgBlepTest::SetUp(void)
+{
+	m_psg = new Psg((int)((double)CLOCK_NTSC / 15.0), rate);
+}
+
+/**
+ * Reinitialize the PSG.
+ * Psg::reset() doesn't reset the counters,
+ * so reInit() is used to get the same state for each run.
+ * @param bandLimited If true, enable band-limited step synthesis.
+ */
+void PsgBlepTest::reInit(bool bandLimited)
+{
+	m_psg->setBandLimited(bandLimited);
+	m_psg->reInit((int)((double)CLOCK_NTSC / 15.0), rate);
+}
+
+void PsgBlepTest::TearDown(void)
+{
+	delete m_psg;
+	m_psg = nullptr;
+}
+
+/**
+ * Render PSG audio.
+ * @param length Number of samples.
+ * @param audio Audio output. (left channel)
+ */
+void PsgBlepTest::render(int length, vector<int32_t> &audio)
+{
+	// The PSG renders into the Sound Manager's segment buffers.
+	assert(length <= SoundMgr::MAX_SEGMENT_SIZE);
+	memset(SoundMgr::ms_SegBuf, 0, length * 2 * sizeof(SoundMgr::ms_SegBuf[0]));
+	m_psg->resetBufferPtrs();
+	m_psg->addWriteLen(length);
+	m_psg->specialUpdate();
+	for (int i = 0; i < length; i++) {
+		EXPECT_EQ(SoundMgr::ms_SegBuf[i*2], SoundMgr::ms_SegBuf[i*2+1]);
+		audio.push_back(SoundMgr::ms_SegBuf[i*2]);
+	}
+}
+
+/**
+ * Count the samples that match the legacy output.
+ * Band-limited output is compared after removing the delay.
+ * Samples within delay of a legacy transition are skipped.
+ * @param legacy Legacy output.
+ * @param blep Band-limited output.
+ * @param compared Number of samples compared.
+ * @return Number of mismatched samples.
+ */
+int PsgBlepTest::countMismatches(const vector<int32_t> &legacy,
+				 const vector<int32_t> &blep, int *compared)
+{
+	int mismatches = 0;
+	*compared = 0;
+	const int size = (int)legacy.size();
+	for (int i = delay + 1; i < size - (delay * 2); i++) {
+		bool steady = true;
+		for (int j = i - delay - 1; j <= i + delay; j++) {
+			if (legacy[j] != legacy[i]) {
+				steady = false;
+				break;
+			}
+		}
+		if (!steady)
+			continue;
+
+		(*compared)++;
+		if (blep[i + delay] != legacy[i]) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * Get the power of a frequency using the Goertzel algorithm.
+ * @param audio Audio.
+ * @param freq Frequency, in Hz.
+ * @return Power.
+ */
+double PsgBlepTest::power(const vector<int32_t> &audio, double freq)
+{
+	const double w = 2.0 * M_PI * freq / (double)rate;
+	const double coeff = 2.0 * cos(w);
+	const int size = (int)audio.size();
+	double s1 = 0.0, s2 = 0.0;
+	for (int i = 0; i < size; i++) {
+		// Hann window to reduce leakage.
+		const double win = 0.5 - 0.5 * cos(2.0 * M_PI * i / (size - 1));
+		const double s0 = (audio[i] * win) + (coeff * s1) - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	return (s1 * s1) + (s2 * s2) - (coeff * s1 * s2);
+}
+
+/**
+ * Band-limited step synthesis is disabled by default.
+ */
+TEST_F(PsgBlepTest, defaultDisabled)
+{
+	EXPECT_FALSE(m_psg->bandLimited());
+	m_psg->setBandLimited(true);
+	EXPECT_TRUE(m_psg->bandLimited());
+	m_psg->setBandLimited(false);
+	EXPECT_FALSE(m_psg->bandLimited());
+}
+
+/**
+ * Low-pitched tones with tone and volume changes match the legacy output.
+ * Updates have varying lengths to test the delta buffer carry-over.
+ * NOTE: Channels are tested separately. If two channels have
+ * opposite transitions in the same sample, the legacy output
+ * doesn't change, but the band-limited output has a short pulse.
+ */
+TEST_F(PsgBlepTest, toneMatchesLegacy)
+{
+	for (int chn = 0; chn < 3; chn++) {
+		vector<int32_t> audio[2];
+		for (int mode = 0; mode < 2; mode++) {
+			reInit(mode != 0);
+
+			const uint8_t chnReg = 0x80 | (chn << 5);
+			m_psg->write(chnReg | 0x0E);	// Tone: 0x0FE (440 Hz)
+			m_psg->write(0x0F);
+			m_psg->write(chnReg | 0x10);	// Volume: 0x0 (full)
+
+			for (int blk = 0; blk < 120; blk++) {
+				if (blk % 10 == 5) {
+					// Tone: 0x1A0-0x1AF (around 267 Hz)
+					m_psg->write(chnReg | (blk & 0xF));
+					m_psg->write(0x1A);
+				}
+				if (blk % 17 == 3) {
+					// Volume. (including off)
+					m_psg->write(chnReg | 0x10 | ((blk / 17) * 5 & 0xF));
+				}
+
+				render(1 + ((blk * 37) % 400), audio[mode]);
+			}
+		}
+
+		ASSERT_EQ(audio[0].size(), audio[1].size());
+		int compared;
+		const int mismatches = countMismatches(audio[0], audio[1], &compared);
+		EXPECT_GT(compared, (int)audio[0].size() / 4) << "channel " << chn;
+		EXPECT_EQ(0, mismatches) << "channel " << chn <<
+			", out of " << compared << " samples compared";
+	}
+}
+
+/**
+ * Noise matches the legacy output.
+ */
+TEST_F(PsgBlepTest, noiseMatchesLegacy)
+{
+	for (int noise = 0; noise < 8; noise++) {
+		vector<int32_t> audio[2];
+		for (int mode = 0; mode < 2; mode++) {
+			reInit(mode != 0);
+
+			m_psg->write(0xC0);	// Channel 2 tone: 0x080 (for noise type 3)
+			m_psg->write(0x08);
+			m_psg->write(0xE0 | noise);	// Noise type
+			m_psg->write(0xF1);	// Noise volume: 0x1
+
+			for (int blk = 0; blk < 40; blk++) {
+				if (blk == 20) {
+					// Mute the noise channel, then restore it.
+					m_psg->write(0xFF);
+					render(100, audio[mode]);
+					m_psg->write(0xF1);
+				}
+				render(1 + ((blk * 53) % 500), audio[mode]);
+			}
+		}
+
+		ASSERT_EQ(audio[0].size(), audio[1].size());
+		int compared;
+		const int mismatches = countMismatches(audio[0], audio[1], &compared);
+		EXPECT_GT(compared, 0) << "noise type " << noise;
+		EXPECT_EQ(0, mismatches) << "noise type " << noise <<
+			", out of " << compared << " samples compared";
+	}
+}
+
+/**
+ * High-pitched tones have much less aliasing.
+ */
+TEST_F(PsgBlepTest, highToneAliasing)
+{
+	// Channel 0 tone: 0x007 (15,980 Hz)
+	const double freq = ((double)CLOCK_NTSC / 15.0) / (32.0 * 7.0);
+	// The 3rd harmonic is above Nyquist, and aliases to:
+	const double alias = (freq * 3.0) - rate;
+
+	vector<int32_t> audio[2];
+	for (int mode = 0; mode < 2; mode++) {
+		reInit(mode != 0);
+
+		m_psg->write(0x87);
+		m_psg->write(0x00);
+		m_psg->write(0x90);	// Channel 0 volume: 0x0 (full)
+		for (int blk = 0; blk < 12; blk++) {
+			render(735, audio[mode]);
+		}
+	}
+
+	const double fundLegacy = power(audio[0], freq);
+	const double fundBlep = power(audio[1], freq);
+	const double aliasLegacy = power(audio[0], alias);
+	const double aliasBlep = power(audio[1], alias);
+
+	// The fundamental is kept.
+	EXPECT_GT(fundBlep, fundLegacy * 0.25);
+	// The alias is reduced by at least 20 dB.
+	EXPECT_LT(aliasBlep, aliasLegacy * 0.01);
+}
+
+/**
+ * The SSE2 integrator's output is the same as the C integrator.
+ */
+TEST_F(PsgBlepTest, sse2MatchesNoasm)
+{
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
+	if (!(CPU_Flags & MDP_CPUFLAG_X86_SSE2)) {
+		printf("WARNING: CPU does not support SSE2.\n"
+		       "Both runs will use the C integrator.\n");
+	}
+#endif
+
+	vector<int32_t> audio[2];
+	const uint32_t cpuFlags_old = CPU_Flags;
+	for (int mode = 0; mode < 2; mode++) {
+		CPU_Flags = (mode == 0 ? cpuFlags_old : 0);
+		reInit(true);
+
+		m_psg->write(0x85);	// Channel 0 tone: 0x015
+		m_psg->write(0x01);
+		m_psg->write(0x90);	// Channel 0 volume: 0x0 (full)
+		m_psg->write(0xE4);	// White noise
+		m_psg->write(0xF3);	// Noise volume: 0x3
+		for (int blk = 0; blk < 50; blk++) {
+			render(1 + ((blk * 29) % 300), audio[mode]);
+		}
+	}
+	CPU_Flags = cpuFlags_old;
+
+	ASSERT_EQ(audio[0].size(), audio[1].size());
+	for (size_t i = 0; i < audio[0].size(); i++) {
+		ASSERT_EQ(audio[1][i], audio[0][i]) << "at sample " << i;
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: PSG band-limited step synthesis test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
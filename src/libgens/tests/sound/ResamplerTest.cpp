@@ -0,0 +1,371 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * ResamplerTest.cpp: Polyphase audio resampler test.                      *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "libcompat/cpuflags.h"
+#include "libcompat/aligned_malloc.h"
+
+// Resampler.
+#include "sound/Resampler.hpp"
+#include "sound/SoundMgr.hpp"
+
+// C includes. (C++ namespace)
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace LibGens { namespace Tests {
+
+class ResamplerTest : public ::testing::TestWithParam<int>
+{
+	protected:
+		ResamplerTest()
+			: ::testing::TestWithParam<int>() { }
+		virtual ~ResamplerTest() { }
+
+	protected:
+		// NTSC native-rate synthesis: 888 samples per frame.
+		static const int inLen = 888;
+		static const int frames = 8;
+
+		/**
+		 * Get the output segment length for the current test.
+		 * @return Output segment length.
+		 */
+		int outLen(void) const
+		{
+			return (int)ceil((double)GetParam() / 60.0);
+		}
+
+		/**
+		 * Resample a sine wave.
+		 * @param period Period, in input samples.
+		 * @param amplitude Amplitude.
+		 * @param audio Resampled output.
+		 */
+		void resampleSine(double period, double amplitude, vector<int32_t> &audio);
+};
+
+const int ResamplerTest::inLen;
+const int ResamplerTest::frames;
+
+/**
+ * Resample a sine wave.
+ * @param period Period, in input samples.
+ * @param amplitude Amplitude.
+ * @param audio Resampled output.
+ */
+void ResamplerTest::resampleSine(double period, double amplitude, vector<int32_t> &audio)
+{
+	const int out = outLen();
+	Resampler resampler;
+	resampler.setLengths(inLen, out);
+
+	audio.clear();
+	int32_t buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < inLen; i++) {
+			const double t = (double)(frame * inLen + i);
+			buf[i*2] = (int32_t)lrint(amplitude * sin(2.0 * M_PI * t / period));
+			buf[i*2+1] = -buf[i*2];
+		}
+		resampler.process(buf);
+		for (int i = 0; i < out; i++) {
+			EXPECT_EQ(-buf[i*2], buf[i*2+1]);
+			audio.push_back(buf[i*2]);
+		}
+	}
+}
+
+/**
+ * DC input is passed through with unity gain.
+ */
+TEST_P(ResamplerTest, dcGain)
+{
+	const int out = outLen();
+	Resampler resampler;
+	resampler.setLengths(inLen, out);
+
+	int32_t buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < inLen; i++) {
+			buf[i*2] = 10000;
+			buf[i*2+1] = -20000;
+		}
+		resampler.process(buf);
+
+		// The first frame includes the filter's startup delay.
+		if (frame == 0)
+			continue;
+		for (int i = 0; i < out; i++) {
+			ASSERT_NEAR(10000, buf[i*2], 1) << "frame " << frame << ", sample " << i;
+			ASSERT_NEAR(-20000, buf[i*2+1], 1) << "frame " << frame << ", sample " << i;
+		}
+	}
+}
+
+/**
+ * A 1 kHz sine wave keeps its amplitude and phase.
+ * The output is delayed by taps() / 2 input samples.
+ */
+TEST_P(ResamplerTest, sinePassband)
+{
+	const double period = 53280.0 / 1000.0;
+	const double amplitude = 16384.0;
+	vector<int32_t> audio;
+	resampleSine(period, amplitude, audio);
+
+	const int out = outLen();
+	Resampler resampler;
+	resampler.setLengths(inLen, out);
+	const int delay = resampler.taps() / 2;
+	for (size_t j = out; j < audio.size(); j++) {
+		const double t = (double)j * inLen / out - delay;
+		const double expected = amplitude * sin(2.0 * M_PI * t / period);
+		ASSERT_NEAR(expected, audio[j], amplitude * 0.005) << "at sample " << j;
+	}
+}
+
+/**
+ * Frequencies above the output Nyquist frequency are removed.
+ */
+TEST_P(ResamplerTest, stopband)
+{
+	const int out = outLen();
+	if (out >= inLen) {
+		// Upsampling. Nothing to remove.
+		return;
+	}
+
+	// 25 kHz is above 48 kHz output's Nyquist frequency.
+	const double period = 53280.0 / 25000.0;
+	const double amplitude = 16384.0;
+	vector<int32_t> audio;
+	resampleSine(period, amplitude, audio);
+
+	for (size_t j = out; j < audio.size(); j++) {
+		ASSERT_LT(abs(audio[j]), (int)(amplitude * 0.02)) << "at sample " << j;
+	}
+}
+
+/**
+ * The SSE2 and AVX resamplers' output is the same as the C resampler.
+ */
+TEST_P(ResamplerTest, matchesNoasm)
+{
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
+	if (!(CPU_Flags & MDP_CPUFLAG_X86_AVX)) {
+		printf("WARNING: CPU does not support AVX.\n"
+		       "The AVX resampler will not be tested.\n");
+	}
+	if (!(CPU_Flags & MDP_CPUFLAG_X86_SSE2)) {
+		printf("WARNING: CPU does not support SSE2.\n"
+		       "The SSE2 resampler will not be tested.\n");
+	}
+
+	// AVX, SSE2, and C.
+	const uint32_t cpuFlags_old = CPU_Flags;
+	const uint32_t cpuFlags[3] = {
+		CPU_Flags,
+		CPU_Flags & ~MDP_CPUFLAG_X86_AVX,
+		0
+	};
+#else
+	const uint32_t cpuFlags_old = CPU_Flags;
+	const uint32_t cpuFlags[3] = {0, 0, 0};
+#endif
+
+	const int out = outLen();
+	Resampler resampler[3];
+	for (int m = 0; m < 3; m++) {
+		resampler[m].setLengths(inLen, out);
+	}
+
+	srand(0x5A5A);
+	int32_t buf[3][SoundMgr::MAX_SEGMENT_SIZE * 2];
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < inLen * 2; i++) {
+			buf[0][i] = buf[1][i] = buf[2][i] = (rand() % 65536) - 32768;
+		}
+
+		for (int m = 0; m < 3; m++) {
+			CPU_Flags = cpuFlags[m];
+			resampler[m].process(buf[m]);
+		}
+		CPU_Flags = cpuFlags_old;
+
+		// NOTE: The C version uses the same summation order,
+		// but the compiler may contract it into FMA instructions.
+		for (int m = 0; m < 2; m++) {
+			for (int i = 0; i < out * 2; i++) {
+				ASSERT_NEAR(buf[2][i], buf[m][i], 1) <<
+					"mode " << m << ", frame " << frame << ", sample " << (i / 2);
+			}
+		}
+	}
+}
+
+/**
+ * Silent segments are skipped once the history is silent.
+ * The output must be the same as if they were resampled.
+ */
+TEST_P(ResamplerTest, silentSegments)
+{
+	const int out = outLen();
+	Resampler resampler[2];
+	resampler[0].setLengths(inLen, out);
+	resampler[1].setLengths(inLen, out);
+
+	// Resampler 0: noise, two silent segments, then noise.
+	// Resampler 1: only the last segment.
+	srand(0xA5A5);
+	int32_t buf[2][SoundMgr::MAX_SEGMENT_SIZE * 2];
+	for (int frame = 0; frame < 4; frame++) {
+		const bool silent = (frame == 1 || frame == 2);
+		for (int i = 0; i < inLen * 2; i++) {
+			buf[0][i] = (silent ? 0 : (rand() % 65536) - 32768);
+		}
+		resampler[0].process(buf[0]);
+
+		if (frame == 2) {
+			// The history is silent, so the output is silent.
+			for (int i = 0; i < out * 2; i++) {
+				ASSERT_EQ(0, buf[0][i]) << "sample " << (i / 2);
+			}
+		}
+	}
+	srand(0xA5A5);
+	for (int i = 0; i < inLen * 2; i++) {
+		rand();
+	}
+	for (int i = 0; i < inLen * 2; i++) {
+		buf[1][i] = (rand() % 65536) - 32768;
+	}
+	resampler[1].process(buf[1]);
+
+	for (int i = 0; i < out * 2; i++) {
+		ASSERT_EQ(buf[1][i], buf[0][i]) << "sample " << (i / 2);
+	}
+}
+
+/**
+ * Native-rate mode writes the output rate's segment length,
+ * while the PSG and YM2612 fill a full native-rate segment.
+ */
+TEST_P(ResamplerTest, soundMgrSegLength)
+{
+	const int rate = GetParam();
+	SoundMgr::SetNativeRate(true, false);
+	SoundMgr::ReInit(rate, false);
+
+	EXPECT_EQ(outLen(), SoundMgr::GetSegLength());
+	EXPECT_EQ(inLen, SoundMgr::GetWritePos(261) + SoundMgr::GetWriteLen(261));
+
+	// Fill the synthesis segment with DC.
+	SoundMgr::ResetPtrsAndLens();
+	for (int i = 0; i < inLen * 2; i++) {
+		SoundMgr::ms_SegBuf[i] = 1000;
+	}
+	SoundMgr::SpecialUpdate();
+	int16_t ALIGN(16) buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+	EXPECT_EQ(outLen(), SoundMgr::writeStereo(buf, SoundMgr::MAX_SEGMENT_SIZE));
+
+	// The buffers must be cleared for the next frame.
+	for (int i = 0; i < inLen * 2; i++) {
+		ASSERT_EQ(0, SoundMgr::ms_SegBuf[i]);
+	}
+
+	SoundMgr::SetNativeRate(false, false);
+	EXPECT_EQ(outLen(), SoundMgr::GetSegLength());
+	EXPECT_EQ(outLen(), SoundMgr::GetWritePos(261) + SoundMgr::GetWriteLen(261));
+}
+
+/**
+ * The segment is resampled at the end of every frame,
+ * so clearing it instead of writing it doesn't leave
+ * stale samples in the resampler's history.
+ */
+TEST_P(ResamplerTest, clearBuffersKeepsHistory)
+{
+	const int rate = GetParam();
+	SoundMgr::SetNativeRate(true, false);
+
+	// Run 0 writes every frame.
+	// Run 1 clears the buffer on all but the first and last frames.
+	int16_t ALIGN(16) buf[2][SoundMgr::MAX_SEGMENT_SIZE * 2];
+	for (int run = 0; run < 2; run++) {
+		SoundMgr::ReInit(rate, false, false);
+		for (int frame = 0; frame < frames; frame++) {
+			SoundMgr::ResetPtrsAndLens();
+			for (int i = 0; i < inLen; i++) {
+				const int32_t sample = (((frame * inLen + i) % 100) * 200) - 10000;
+				SoundMgr::ms_SegBuf[i*2] = sample;
+				SoundMgr::ms_SegBuf[i*2+1] = -sample;
+			}
+			SoundMgr::SpecialUpdate();
+
+			if (run == 1 && frame > 0 && frame < frames - 1) {
+				SoundMgr::clearBuffers();
+			} else {
+				EXPECT_EQ(outLen(), SoundMgr::writeStereo(buf[run], SoundMgr::MAX_SEGMENT_SIZE));
+			}
+		}
+	}
+
+	for (int i = 0; i < outLen() * 2; i++) {
+		ASSERT_EQ(buf[0][i], buf[1][i]) << "sample " << (i / 2);
+	}
+
+	SoundMgr::SetNativeRate(false, false);
+}
+
+INSTANTIATE_TEST_CASE_P(ResamplerTest, ResamplerTest,
+	::testing::Values(11025, 44100, 48000, 96000));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: Polyphase audio resampler test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
@@ -0,0 +1,422 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * Ym2612BatchTest.cpp: YM2612 batched synthesis test.                     *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "EmuContext/Scheduler.hpp"
+
+// Sound Manager
+#include "sound/SoundMgr.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+class Ym2612BatchTest : public ::testing::Test
+{
+	protected:
+		Ym2612BatchTest()
+			: ::testing::Test() { }
+		virtual ~Ym2612BatchTest() { }
+
+		virtual void TearDown(void) override;
+
+	protected:
+		static const int rate = 44100;
+		static const int lines = 262;
+		static const int frames = 8;
+
+		/**
+		 * Write a YM2612 register.
+		 * @param bank Register bank. (0 or 1)
+		 * @param reg Register number.
+		 * @param data Register data.
+		 * @param mclk Master clock cycles from the start of the frame.
+		 */
+		static void writeReg(int bank, uint8_t reg, uint8_t data, int mclk);
+
+		/**
+		 * Write the FM and DAC enable registers for a line.
+		 * @param frame Frame number.
+		 * @param line Line number.
+		 * @param mclk Master clock cycles from the start of the frame.
+		 */
+		static void writeLineRegs(int frame, int line, int mclk);
+
+		/**
+		 * Add samples to the current line.
+		 * @param writePos Start of the line in the segment buffer.
+		 * @param linePos Number of samples already added. (updated)
+		 * @param end Number of samples to add up to.
+		 */
+		static void addLineSamples(int writePos, int &linePos, int end);
+
+		/**
+		 * Emulate the YM2612 for several frames.
+		 *
+		 * If midLine is false, registers are written at the end
+		 * of each line, which is where immediate mode applies them.
+		 *
+		 * If midLine is true, the FM registers and DAC data are
+		 * written partway through each line. In immediate mode,
+		 * the line is split at each write, so the write is applied
+		 * at the same sample position as a timestamped write.
+		 * Timer registers are still written at the end of the line.
+		 *
+		 * @param batched If true, enable batched synthesis.
+		 * @param midLine If true, write registers partway through each line.
+		 * @param audio Audio output.
+		 * @param status Status register, read at the end of each line.
+		 */
+		static void run(bool batched, bool midLine, vector<int16_t> &audio, vector<uint8_t> &status);
+
+		/**
+		 * Check that batched synthesis matches immediate synthesis.
+		 * @param midLine If true, write registers partway through each line.
+		 */
+		static void checkMatchesImmediate(bool midLine);
+};
+
+/**
+ * Tear down the YM2612 after testing.
+ */
+void Ym2612BatchTest::TearDown(void)
+{
+	SoundMgr::ms_Ym2612.setBatched(false);
+	SoundMgr::ReInit(rate, false);
+}
+
+/**
+ * Write a YM2612 register.
+ * @param bank Register bank. (0 or 1)
+ * @param reg Register number.
+ * @param data Register data.
+ * @param mclk Master clock cycles from the start of the frame.
+ */
+void Ym2612BatchTest::writeReg(int bank, uint8_t reg, uint8_t data, int mclk)
+{
+	Ym2612 &ym = SoundMgr::ms_Ym2612;
+	ym.write(bank * 2, reg, mclk, lines);
+	ym.write(bank * 2 + 1, data, mclk, lines);
+}
+
+/**
+ * Write the FM and DAC enable registers for a line.
+ * @param frame Frame number.
+ * @param line Line number.
+ * @param mclk Master clock cycles from the start of the frame.
+ */
+void Ym2612BatchTest::writeLineRegs(int frame, int line, int mclk)
+{
+	if (line % 40 == 0) {
+		// Key on.
+		writeReg(0, 0x28, 0xF0, mclk);
+		writeReg(0, 0x28, 0xF1, mclk);
+		writeReg(0, 0x28, 0xF4, mclk);
+	} else if (line % 40 == 25) {
+		// Key off.
+		writeReg(0, 0x28, 0x00, mclk);
+		writeReg(0, 0x28, 0x01, mclk);
+		writeReg(0, 0x28, 0x04, mclk);
+	}
+	if (line % 13 == 5) {
+		// Channel 1, operator 4 TL.
+		writeReg(0, 0x4C, (line + frame) & 0x3F, mclk);
+	}
+	if (line % 50 == 7) {
+		// Channel 2 frequency.
+		writeReg(0, 0xA5, 0x1A + (line / 50), mclk);
+		writeReg(0, 0xA1, (uint8_t)(line * 3), mclk);
+	}
+
+	// DAC on frames 2 and 3.
+	if (frame == 2 && line == 0) {
+		writeReg(0, 0x2B, 0x80, mclk);
+	} else if (frame == 3 && line == 200) {
+		writeReg(0, 0x2B, 0x00, mclk);
+	}
+}
+
+/**
+ * Add samples to the current line.
+ * @param writePos Start of the line in the segment buffer.
+ * @param linePos Number of samples already added. (updated)
+ * @param end Number of samples to add up to.
+ */
+void Ym2612BatchTest::addLineSamples(int writePos, int &linePos, int end)
+{
+	if (end <= linePos)
+		return;
+
+	Ym2612 &ym = SoundMgr::ms_Ym2612;
+	ym.updateDacAndTimers(&SoundMgr::ms_SegBuf[(writePos + linePos) * 2], end - linePos);
+	ym.addWriteLen(end - linePos);
+	linePos = end;
+}
+
+/**
+ * Emulate the YM2612 for several frames.
+ * @param batched If true, enable batched synthesis.
+ * @param midLine If true, write registers partway through each line.
+ * @param audio Audio output.
+ * @param status Status register, read at the end of each line.
+ */
+void Ym2612BatchTest::run(bool batched, bool midLine, vector<int16_t> &audio, vector<uint8_t> &status)
+{
+	SoundMgr::ReInit(rate, false);
+	Ym2612 &ym = SoundMgr::ms_Ym2612;
+	ym.setBatched(batched);
+
+	audio.clear();
+	status.clear();
+	int16_t buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+
+	for (int frame = 0; frame < frames; frame++) {
+		SoundMgr::ResetPtrsAndLens();
+
+		if (frame == 0) {
+			// Set up channels 1, 2, and 4 before any audio is rendered.
+			static const int channels[3][2] = {{0, 0}, {0, 1}, {1, 0}};
+			writeReg(0, 0x22, 0x0B, 0);	// LFO
+			for (int i = 0; i < 3; i++) {
+				const int bank = channels[i][0];
+				const int ch = channels[i][1];
+				for (int op = 0; op < 16; op += 4) {
+					writeReg(bank, 0x30 + op + ch, 0x01 + op/4 + i, 0);	// DT/MUL
+					writeReg(bank, 0x40 + op + ch, 0x18 + op, 0);		// TL
+					writeReg(bank, 0x50 + op + ch, 0x1F, 0);		// KS/AR
+					writeReg(bank, 0x60 + op + ch, 0x85, 0);		// AM/D1R
+					writeReg(bank, 0x70 + op + ch, 0x02, 0);		// D2R
+					writeReg(bank, 0x80 + op + ch, 0x26, 0);		// SL/RR
+				}
+				writeReg(bank, 0xB0 + ch, 0x30 | (i * 3), 0);	// FB/ALGO
+				writeReg(bank, 0xB4 + ch, 0xC0 | (i * 0x11), 0);	// L/R/AMS/FMS
+				writeReg(bank, 0xA4 + ch, 0x22 + i, 0);		// Block/Fnum (high)
+				writeReg(bank, 0xA0 + ch, 0x69, 0);		// Fnum (low)
+			}
+
+			// Timer A.
+			writeReg(0, 0x24, 0xF8, 0);
+			writeReg(0, 0x25, 0x01, 0);
+			writeReg(0, 0x27, 0x15, 0);
+		}
+
+		for (int line = 0; line < lines; line++) {
+			const int writePos = SoundMgr::GetWritePos(line);
+			const int writeLen = SoundMgr::GetWriteLen(line);
+			int linePos = 0;
+
+			if (batched) {
+				// Batched writes are timestamped,
+				// so the whole line can be added first.
+				addLineSamples(writePos, linePos, writeLen);
+			}
+
+			if (midLine) {
+				// FM registers and the first DAC write are somewhere
+				// in the first half of the line. The second DAC write
+				// is a third of a line later.
+				const int lineStart = line * Scheduler::MCLK_PER_LINE;
+				const int offset[2] = {
+					(line * 1367) % (Scheduler::MCLK_PER_LINE / 2),
+					(line * 1367) % (Scheduler::MCLK_PER_LINE / 2) + (Scheduler::MCLK_PER_LINE / 3)
+				};
+				for (int i = 0; i < 2; i++) {
+					// Same conversion as Ym2612::write().
+					addLineSamples(writePos, linePos,
+						offset[i] * writeLen / Scheduler::MCLK_PER_LINE);
+					const int mclk = lineStart + offset[i];
+					if (i == 0) {
+						writeLineRegs(frame, line, mclk);
+					}
+					if (frame == 2 || frame == 3) {
+						writeReg(0, 0x2A, (uint8_t)((line * 8) + (i * 0x40)), mclk);
+					}
+				}
+			}
+
+			addLineSamples(writePos, linePos, writeLen);
+			status.push_back(ym.read());
+
+			// Writes occur at the end of the line,
+			// which is where immediate mode applies them.
+			if (line == lines - 1)
+				continue;
+			const int mclk = (line + 1) * Scheduler::MCLK_PER_LINE;
+
+			if (!midLine) {
+				writeLineRegs(frame, line, mclk);
+				if (frame == 2 || frame == 3) {
+					// DAC sawtooth.
+					writeReg(0, 0x2A, (uint8_t)(line * 8), mclk);
+				}
+			}
+			if (line % 30 == 29) {
+				// Reset the timer A flag.
+				writeReg(0, 0x27, 0x15, mclk);
+			}
+		}
+
+		ym.specialUpdate();
+		const int samples = SoundMgr::writeStereo(buf, SoundMgr::MAX_SEGMENT_SIZE);
+		audio.insert(audio.end(), buf, buf + samples * 2);
+	}
+}
+
+/**
+ * Check that batched synthesis matches immediate synthesis.
+ * @param midLine If true, write registers partway through each line.
+ */
+void Ym2612BatchTest::checkMatchesImmediate(bool midLine)
+{
+	vector<int16_t> audioImmediate, audioBatched;
+	vector<uint8_t> statusImmediate, statusBatched;
+	run(false, midLine, audioImmediate, statusImmediate);
+	run(true, midLine, audioBatched, statusBatched);
+
+	// Make sure the test actually produced sound.
+	int peak = 0;
+	for (size_t i = 0; i < audioImmediate.size(); i++) {
+		const int sample = audioImmediate[i];
+		if (sample > peak)
+			peak = sample;
+	}
+	EXPECT_GT(peak, 1024);
+
+	ASSERT_EQ(audioImmediate.size(), audioBatched.size());
+	for (size_t i = 0; i < audioImmediate.size(); i++) {
+		ASSERT_EQ(audioImmediate[i], audioBatched[i]) << "at sample " << (i / 2);
+	}
+}
+
+/**
+ * Batched synthesis matches immediate synthesis
+ * if all writes occur at the end of a line.
+ */
+TEST_F(Ym2612BatchTest, matchesImmediate)
+{
+	checkMatchesImmediate(false);
+}
+
+/**
+ * Batched synthesis matches immediate synthesis with
+ * FM and DAC writes partway through each line, if
+ * immediate mode splits the line at each write.
+ */
+TEST_F(Ym2612BatchTest, matchesImmediateMidLine)
+{
+	checkMatchesImmediate(true);
+}
+
+/**
+ * Batched writes that are logged before reset()
+ * are discarded, and don't affect the next frame.
+ */
+TEST_F(Ym2612BatchTest, resetClearsLog)
+{
+	vector<int16_t> audioReset, audioClean;
+	vector<uint8_t> status;
+	Ym2612 &ym = SoundMgr::ms_Ym2612;
+	int16_t buf[SoundMgr::MAX_SEGMENT_SIZE * 2];
+
+	for (int pass = 0; pass < 2; pass++) {
+		vector<int16_t> &audio = (pass == 0 ? audioReset : audioClean);
+		SoundMgr::ReInit(rate, false);
+		ym.setBatched(true);
+		SoundMgr::ResetPtrsAndLens();
+
+		int linePos = 0;
+		addLineSamples(SoundMgr::GetWritePos(0), linePos, SoundMgr::GetWriteLen(0));
+		if (pass == 0) {
+			// Key on channel 1 with a loud DAC, then reset.
+			writeReg(0, 0x2B, 0x80, 100);
+			writeReg(0, 0x2A, 0xFF, 200);
+			writeReg(0, 0x40, 0x00, 300);
+			writeReg(0, 0x28, 0xF0, 400);
+			ym.reset();
+		}
+
+		for (int line = 1; line < lines; line++) {
+			linePos = 0;
+			addLineSamples(SoundMgr::GetWritePos(line), linePos, SoundMgr::GetWriteLen(line));
+		}
+		ym.specialUpdate();
+		const int samples = SoundMgr::writeStereo(buf, SoundMgr::MAX_SEGMENT_SIZE);
+		audio.assign(buf, buf + samples * 2);
+	}
+
+	ASSERT_EQ(audioClean.size(), audioReset.size());
+	for (size_t i = 0; i < audioClean.size(); i++) {
+		ASSERT_EQ(audioClean[i], audioReset[i]) << "at sample " << (i / 2);
+	}
+}
+
+/**
+ * Timer status is updated when the write occurs,
+ * not when the batch is synthesized.
+ */
+TEST_F(Ym2612BatchTest, timerStatus)
+{
+	vector<int16_t> audioImmediate, audioBatched;
+	vector<uint8_t> statusImmediate, statusBatched;
+	run(false, false, audioImmediate, statusImmediate);
+	run(true, false, audioBatched, statusBatched);
+
+	// Timer A should have overflowed at least once.
+	int overflows = 0;
+	for (size_t i = 0; i < statusImmediate.size(); i++) {
+		if (statusImmediate[i] & 1)
+			overflows++;
+	}
+	EXPECT_GT(overflows, 0);
+	EXPECT_LT(overflows, (int)statusImmediate.size());
+
+	ASSERT_EQ(statusImmediate.size(), statusBatched.size());
+	for (size_t i = 0; i < statusImmediate.size(); i++) {
+		ASSERT_EQ(statusImmediate[i], statusBatched[i]) << "at line " << i;
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: YM2612 batched synthesis test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"
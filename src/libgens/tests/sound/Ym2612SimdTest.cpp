@@ -0,0 +1,221 @@
+/***************************************************************************
+ * libgens/tests: Gens Emulation Library. (Test Suite)                     *
+ * Ym2612SimdTest.cpp: YM2612 SIMD FM engine test.                         *
+ *                                                                         *
+ * Copyright (c) 2016 by David Korth.                                      *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// LibGens.
+#include "lg_main.hpp"
+#include "libcompat/cpuflags.h"
+#include "cpu/M68K.hpp"
+
+// YM2612.
+#include "sound/Ym2612.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibGens { namespace Tests {
+
+class Ym2612SimdTest : public ::testing::TestWithParam<int>
+{
+	protected:
+		Ym2612SimdTest()
+			: ::testing::TestWithParam<int>() { }
+		virtual ~Ym2612SimdTest() { }
+
+	protected:
+		static const int blocks = 240;
+
+		/**
+		 * Write a YM2612 register.
+		 * @param ym YM2612.
+		 * @param bank Register bank. (0 or 1)
+		 * @param reg Register number.
+		 * @param data Register data.
+		 */
+		static void writeReg(Ym2612 &ym, int bank, uint8_t reg, uint8_t data);
+
+		/**
+		 * Synthesize a sequence of register writes.
+		 * @param simd If true, use the SIMD FM engine.
+		 * @param rate Sample rate.
+		 * @param audio Audio output. (interleaved stereo)
+		 */
+		static void run(bool simd, int rate, vector<int32_t> &audio);
+};
+
+/**
+ * Write a YM2612 register.
+ * @param ym YM2612.
+ * @param bank Register bank. (0 or 1)
+ * @param reg Register number.
+ * @param data Register data.
+ */
+void Ym2612SimdTest::writeReg(Ym2612 &ym, int bank, uint8_t reg, uint8_t data)
+{
+	ym.write(bank * 2, reg);
+	ym.write(bank * 2 + 1, data);
+}
+
+/**
+ * Synthesize a sequence of register writes.
+ * @param simd If true, use the SIMD FM engine.
+ * @param rate Sample rate.
+ * @param audio Audio output. (interleaved stereo)
+ */
+void Ym2612SimdTest::run(bool simd, int rate, vector<int32_t> &audio)
+{
+	Ym2612 ym((int)((double)CLOCK_NTSC / 7.0), rate);
+	ym.setSimdEngine(simd);
+	audio.clear();
+
+	// Set up all six channels.
+	for (int c = 0; c < 6; c++) {
+		const int bank = c / 3;
+		const int ch = c % 3;
+		for (int op = 0; op < 16; op += 4) {
+			writeReg(ym, bank, 0x30 + op + ch, ((op * 5) & 0x70) | (1 + op/4 + c));	// DT/MUL
+			writeReg(ym, bank, 0x40 + op + ch, 0x10 + op + c * 2);	// TL
+			writeReg(ym, bank, 0x50 + op + ch, 0x1C + (c & 3));	// KS/AR
+			writeReg(ym, bank, 0x60 + op + ch, 0x88 + c);		// AM/D1R
+			writeReg(ym, bank, 0x70 + op + ch, 0x04 + op/4);	// D2R
+			writeReg(ym, bank, 0x80 + op + ch, 0x35 + c * 0x10);	// SL/RR
+		}
+		writeReg(ym, bank, 0xB0 + ch, (c << 3) | c);		// FB/ALGO
+		writeReg(ym, bank, 0xB4 + ch, 0xC0 | (c * 0x09));	// L/R/AMS/FMS
+		writeReg(ym, bank, 0xA4 + ch, 0x12 + c * 4);		// Block/Fnum (high)
+		writeReg(ym, bank, 0xA0 + ch, 0x44 + c * 0x21);		// Fnum (low)
+	}
+
+	// SSG-EG on channel 2.
+	writeReg(ym, 0, 0x91, 0x08);
+	writeReg(ym, 0, 0x99, 0x0E);
+
+	int32_t buf[1024 * 2];
+	for (int blk = 0; blk < blocks; blk++) {
+		if (blk % 40 == 0) {
+			// Key on.
+			for (int c = 0; c < 6; c++) {
+				writeReg(ym, 0, 0x28, 0xF0 | ((c / 3) << 2) | (c % 3));
+			}
+		} else if (blk % 40 == 30) {
+			// Key off channels 1-4.
+			for (int c = 0; c < 4; c++) {
+				writeReg(ym, 0, 0x28, ((c / 3) << 2) | (c % 3));
+			}
+		}
+
+		if (blk == 60) {
+			// LFO on.
+			writeReg(ym, 0, 0x22, 0x0C);
+		} else if (blk == 160) {
+			// LFO off.
+			writeReg(ym, 0, 0x22, 0x00);
+		}
+
+		if (blk == 80) {
+			// Algorithms 6 and 7 on channels 1 and 2.
+			writeReg(ym, 0, 0xB0, 0x3E);
+			writeReg(ym, 0, 0xB1, 0x17);
+			// Full volume on channel 2 to test the output limit.
+			for (int op = 0; op < 16; op += 4) {
+				writeReg(ym, 0, 0x41 + op, 0x00);
+			}
+		} else if (blk == 100) {
+			// DAC on. Channel 6 isn't updated by the FM engine.
+			writeReg(ym, 0, 0x2B, 0x80);
+		} else if (blk == 120) {
+			// DAC off.
+			writeReg(ym, 0, 0x2B, 0x00);
+		}
+
+		if (blk % 7 == 3) {
+			// Channel 4 frequency.
+			writeReg(ym, 1, 0xA4, 0x0A + (blk % 0x18));
+			writeReg(ym, 1, 0xA0, (uint8_t)(blk * 13));
+		}
+
+		// Vary the block length to test the interpolation state.
+		const int length = 1 + ((blk * 97) % 700);
+		memset(buf, 0, length * 2 * sizeof(buf[0]));
+		ym.update(buf, length);
+		audio.insert(audio.end(), buf, buf + (length * 2));
+	}
+}
+
+/**
+ * The SIMD FM engine's output is identical to the scalar FM engine.
+ */
+TEST_P(Ym2612SimdTest, matchesScalar)
+{
+	if (!(CPU_Flags & MDP_CPUFLAG_X86_AVX2)) {
+		printf("WARNING: CPU does not support AVX2.\n"
+		       "Both runs will use the scalar FM engine.\n");
+	}
+
+	const int rate = GetParam();
+	vector<int32_t> audioScalar, audioSimd;
+	run(false, rate, audioScalar);
+	run(true, rate, audioSimd);
+
+	// Make sure the test actually produced sound.
+	int peak = 0;
+	for (size_t i = 0; i < audioScalar.size(); i++) {
+		const int sample = audioScalar[i];
+		if (sample > peak)
+			peak = sample;
+	}
+	EXPECT_GT(peak, 1024);
+
+	ASSERT_EQ(audioScalar.size(), audioSimd.size());
+	for (size_t i = 0; i < audioScalar.size(); i++) {
+		ASSERT_EQ(audioScalar[i], audioSimd[i]) << "at sample " << (i / 2);
+	}
+}
+
+// 44,100 Hz uses interpolated output.
+// 96,000 Hz is above the YM2612's internal rate, so it doesn't.
+INSTANTIATE_TEST_CASE_P(Ym2612SimdTest, Ym2612SimdTest,
+	::testing::Values(44100, 96000));
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_main.inc.cpp's main().
+ */
+static int test_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibGens test suite: YM2612 SIMD FM engine test.\n\n");
+	LibGens::Init();
+	fflush(nullptr);
+
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+#include "libcompat/tests/gtest_main.inc.cpp"